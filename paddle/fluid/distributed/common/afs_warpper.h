@@ -65,6 +65,11 @@ class FsReadChannel {
     return 0;
   }
 
+  // read exactly size bytes, for binary files
+  inline int read(char* data, size_t size) {
+    return fread(data, 1, size, _file.get()) == size ? 0 : -1;
+  }
+
  private:
   uint32_t _buffer_size;
   FsChannelConfig _config;
@@ -113,6 +118,11 @@ class FsWriteChannel {
     return write_line(data.c_str(), data.size());
   }
 
+  // write without line break, for binary files
+  inline int write(const char* data, size_t size) {
+    return fwrite_unlocked(data, 1, size, _file.get()) == size ? 0 : -1;
+  }
+
  private:
   uint32_t _buffer_size;
   FsChannelConfig _config;
@@ -407,6 +407,8 @@ void FleetWrapper::PushSparseVarsAsync(
       platform::errors::InvalidArgument(
           "can not find table: %s, please check your config", table_id));
   communicator->Send(varnames, scope);
+  // the push of the gradients ends the training step of the table
+  communicator->_worker_ptr->advance_sparse_pull_cache_step(table_id);
 }
 
 void FleetWrapper::PushSparseVarsWithLabelAsync(
@@ -565,6 +567,7 @@ void FleetWrapper::PushSparseFromTensorAsync(
   auto status = communicator->_worker_ptr->push_sparse(
       table_id, push_keys.data(), (const float**)push_g_vec.data(),
       push_keys.size());
+  communicator->_worker_ptr->advance_sparse_pull_cache_step(table_id);
 }
 
 void FleetWrapper::LoadModel(const std::string& path, const int mode) {
@@ -207,6 +207,7 @@ int32_t BrpcPsClient::initialize() {
       _push_sparse_task_queue_map[table_id] =
           paddle::framework::MakeChannel<SparseAsyncTask *>();
       _push_sparse_merge_count_map[table_id] = 0;
+      init_sparse_value_codec(worker_param.downpour_table_param(i));
     }
   }
 
@@ -225,6 +226,67 @@ int32_t BrpcPsClient::initialize() {
   return 0;
 }
 
+void BrpcPsClient::init_sparse_value_codec(const TableParameter &table_param) {
+  auto table_id = table_param.table_id();
+  auto *accessor = table_accessor(table_id);
+  if (accessor == NULL) {
+    return;
+  }
+  if (table_param.pull_value_type() != SPARSE_VALUE_FP32) {
+    _pull_value_codecs[table_id] = std::make_shared<SparseValueCodec>(
+        table_param.pull_value_type(), accessor->select_dim(),
+        accessor->select_quant_begin());
+  }
+  if (table_param.push_value_type() != SPARSE_VALUE_FP32) {
+    auto codec = std::make_shared<SparseValueCodec>(
+        table_param.push_value_type(), accessor->update_dim(),
+        accessor->update_quant_begin());
+    _push_value_codecs[table_id] = codec;
+    _push_value_residuals[table_id] = std::make_shared<SparseValueResidual>(
+        codec->dim(), table_param.push_residual_capacity(),
+        table_param.push_residual_threshold());
+  }
+  VLOG(1) << "table " << table_id << " pulls sparse values as "
+          << SparseValueType_Name(table_param.pull_value_type())
+          << ", pushes as "
+          << SparseValueType_Name(table_param.push_value_type());
+}
+
+void BrpcPsClient::fill_push_sparse_request(size_t table_id,
+                                            const uint64_t *keys,
+                                            const float *const *values,
+                                            size_t num,
+                                            PsRequestMessage *request) {
+  auto *accessor = table_accessor(table_id);
+  auto codec_itr = _push_value_codecs.find(table_id);
+  SparseValueCodec *codec = codec_itr == _push_value_codecs.end()
+                                ? NULL
+                                : codec_itr->second.get();
+  size_t value_size =
+      codec == NULL ? accessor->update_size() : codec->encoded_size();
+  /*
+  Push Content:
+  |---keysData---|---valuesData---|
+  |---8*{num}B---|----------------|
+  */
+  auto *push_data = request->mutable_data();
+  push_data->resize(num * (sizeof(uint64_t) + value_size));
+  char *push_data_ptr = const_cast<char *>(push_data->data());
+  memcpy(push_data_ptr, keys, num * sizeof(uint64_t));
+  push_data_ptr += num * sizeof(uint64_t);
+  if (codec == NULL) {
+    for (size_t i = 0; i < num; ++i) {
+      memcpy(push_data_ptr, values[i], value_size);
+      push_data_ptr += value_size;
+    }
+    return;
+  }
+  uint32_t type = codec->type();
+  request->add_params(reinterpret_cast<char *>(&type), sizeof(uint32_t));
+  _push_value_residuals[table_id]->encode(*codec, keys, values, num,
+                                          push_data_ptr);
+}
+
 int DownpourBrpcClosure::check_response(size_t request_idx, int cmd_id) {
   if (_cntls[request_idx]->Failed()) {
     LOG(ERROR) << "resquest cmd_id:" << cmd_id << " failed, "
@@ -292,6 +354,12 @@ std::future<int32_t> BrpcPsClient::print_table_stat(uint32_t table_id) {
                   << ", feasign size: " << feasign_size
                   << ", mf size: " << mf_size << std::endl;
       });
+  auto *cache = sparse_pull_cache(table_id);
+  if (cache != NULL) {
+    std::cout << "table id: " << table_id
+              << ", sparse pull cache size: " << cache->size() << ", "
+              << cache->stats().to_string() << std::endl;
+  }
   auto promise = std::make_shared<std::promise<int32_t>>();
   closure->add_promise(promise);
   std::future<int> fut = promise->get_future();
@@ -383,16 +451,19 @@ std::future<int32_t> BrpcPsClient::send_save_cmd(
 
 std::future<int32_t> BrpcPsClient::shrink(uint32_t table_id,
                                           const std::string threshold) {
+  clear_sparse_pull_cache(table_id);
   return send_cmd(table_id, PS_SHRINK_TABLE, {threshold});
 }
 
 std::future<int32_t> BrpcPsClient::load(const std::string &epoch,
                                         const std::string &mode) {
+  clear_sparse_pull_cache(-1);
   return send_cmd(-1, PS_LOAD_ALL_TABLE, {epoch, mode});
 }
 std::future<int32_t> BrpcPsClient::load(uint32_t table_id,
                                         const std::string &epoch,
                                         const std::string &mode) {
+  clear_sparse_pull_cache(table_id);
   return send_cmd(table_id, PS_LOAD_ONE_TABLE, {epoch, mode});
 }
 
@@ -410,9 +481,19 @@ std::future<int32_t> BrpcPsClient::save(uint32_t table_id,
 }
 
 std::future<int32_t> BrpcPsClient::clear() {
+  clear_sparse_pull_cache(-1);
   return send_cmd(-1, PS_CLEAR_ALL_TABLE, {});
 }
 std::future<int32_t> BrpcPsClient::clear(uint32_t table_id) {
+  clear_sparse_pull_cache(table_id);
+  auto residual_itr = _push_value_residuals.find(table_id);
+  if (residual_itr != _push_value_residuals.end()) {
+    residual_itr->second->clear();
+  }
+  auto *compressor = dense_grad_compressor(table_id);
+  if (compressor != NULL) {
+    compressor->clear();
+  }
   return send_cmd(table_id, PS_CLEAR_ONE_TABLE, {});
 }
 
@@ -783,16 +864,8 @@ std::future<int32_t> BrpcPsClient::push_sparse_raw_gradient(
     push_request->set_table_id(table_id);
     push_request->set_client_id(_client_id);
     push_request->add_params((char *)&kv_size, sizeof(uint32_t));  // NOLINT
-    auto *push_data = push_request->mutable_data();
-    push_data->resize(kv_size * (sizeof(uint64_t) + accessor->update_size()));
-    char *push_data_ptr = const_cast<char *>(push_data->data());
-    memcpy(push_data_ptr, kvs.data(), kv_size * sizeof(uint64_t));
-    push_data_ptr += kv_size * sizeof(uint64_t);
-
-    for (int i = 0; i < kv_size; ++i) {
-      memcpy(push_data_ptr, value_ptr[i], accessor->update_size());
-      push_data_ptr += accessor->update_size();
-    }
+    fill_push_sparse_request(table_id, kvs.data(), value_ptr.data(), kv_size,
+                             push_request);
     PsService_Stub rpc_stub(get_sparse_channel(shard_idx));
     closure->cntl(shard_idx)->set_request_compress_type(
         (brpc::CompressType)FLAGS_pserver_communicate_compress_type);
@@ -802,6 +875,38 @@ std::future<int32_t> BrpcPsClient::push_sparse_raw_gradient(
   return fut;
 }
 
+void BrpcPsClient::fill_push_dense_requests(size_t table_id,
+                                            const float *total_send_data,
+                                            uint32_t num_per_shard,
+                                            DownpourBrpcClosure *closure) {
+  size_t request_call_num = _server_channels.size();
+  std::vector<uint32_t> indices;
+  std::vector<float> values;
+  auto *compressor = dense_grad_compressor(table_id);
+  bool compressed =
+      compressor != NULL &&
+      compressor->compress(total_send_data, num_per_shard * request_call_num,
+                           &indices, &values);
+  for (size_t i = 0; i < request_call_num; ++i) {
+    closure->request(i)->set_cmd_id(compressed ? PS_PUSH_COMPRESSED_DENSE_TABLE
+                                               : PS_PUSH_DENSE_TABLE);
+    closure->request(i)->set_table_id(table_id);
+    closure->request(i)->set_client_id(_client_id);
+    auto *push_data = closure->request(i)->mutable_data();
+    push_data->clear();
+    if (compressed) {
+      EncodeCompressedDenseShard(indices, values, i * num_per_shard,
+                                 (i + 1) * num_per_shard, push_data);
+      continue;
+    }
+    push_data->resize(sizeof(uint32_t) + num_per_shard * sizeof(float));
+    char *push_data_ptr = const_cast<char *>(push_data->data());
+    memcpy(push_data_ptr, &num_per_shard, sizeof(uint32_t));
+    memcpy(push_data_ptr + sizeof(uint32_t),
+           total_send_data + i * num_per_shard, num_per_shard * sizeof(float));
+  }
+}
+
 std::future<int32_t> BrpcPsClient::push_dense_raw_gradient(
     int table_id, float *total_send_data, size_t total_send_data_size,
     void *done) {
@@ -813,17 +918,8 @@ std::future<int32_t> BrpcPsClient::push_dense_raw_gradient(
   auto *accessor = table_accessor(table_id);
   uint32_t num_per_shard =
       dense_dim_per_shard(accessor->fea_dim(), request_call_num);
+  fill_push_dense_requests(table_id, total_send_data, num_per_shard, closure);
   for (size_t i = 0; i < request_call_num; ++i) {
-    closure->request(i)->set_cmd_id(PS_PUSH_DENSE_TABLE);
-    closure->request(i)->set_table_id(table_id);
-    closure->request(i)->set_client_id(_client_id);
-    auto *push_data = closure->request(i)->mutable_data();
-    push_data->clear();
-    push_data->resize(sizeof(uint32_t) + num_per_shard * sizeof(float));
-    char *push_data_ptr = const_cast<char *>(push_data->data());
-    memcpy(push_data_ptr, &num_per_shard, sizeof(uint32_t));
-    memcpy(push_data_ptr + sizeof(uint32_t),
-           total_send_data + i * num_per_shard, num_per_shard * sizeof(float));
     // closure->cntl(i)->set_request_compress_type(
     //     (brpc::CompressType)FLAGS_pserver_communicate_compress_type);
     PsService_Stub rpc_stub(get_dense_channel(i));
@@ -865,6 +961,24 @@ std::future<int32_t> BrpcPsClient::pull_sparse(float **select_values,
                                                size_t table_id,
                                                const uint64_t *keys, size_t num,
                                                bool is_training) {
+  auto *cache = sparse_pull_cache(table_id);
+  if (cache == NULL) {
+    return pull_sparse_from_server(select_values, table_id, keys, num,
+                                   is_training);
+  }
+  return cache->pull_sparse(
+      select_values, keys, num,
+      [this, table_id, is_training](
+          float **values, const uint64_t *miss_keys, size_t miss_num,
+          const SparsePullCache::PullDone &done) {
+        return pull_sparse_from_server(values, table_id, miss_keys, miss_num,
+                                       is_training, done);
+      });
+}
+
+std::future<int32_t> BrpcPsClient::pull_sparse_from_server(
+    float **select_values, size_t table_id, const uint64_t *keys, size_t num,
+    bool is_training, const SparsePullCache::PullDone &pull_done) {
   size_t request_call_num = _server_channels.size();
 
   auto shard_sorted_kvs = std::make_shared<
@@ -888,11 +1002,20 @@ std::future<int32_t> BrpcPsClient::pull_sparse(float **select_values,
 
   auto *accessor = table_accessor(table_id);
   size_t value_size = accessor->select_size();
+  // the values are received in the wire format of the table if any
+  std::shared_ptr<SparseValueCodec> codec;
+  auto codec_itr = _pull_value_codecs.find(table_id);
+  if (codec_itr != _pull_value_codecs.end()) {
+    codec = codec_itr->second;
+  }
 
   DownpourBrpcClosure *closure = new DownpourBrpcClosure(
-      request_call_num, [shard_sorted_kvs, value_size](void *done) {
+      request_call_num,
+      [shard_sorted_kvs, value_size, codec, pull_done](void *done) {
         int ret = 0;
         auto *closure = reinterpret_cast<DownpourBrpcClosure *>(done);
+        size_t encoded_size = codec ? codec->encoded_size() : value_size;
+        std::vector<char> encoded(codec ? encoded_size : 0);
         for (size_t i = 0; i < shard_sorted_kvs->size(); ++i) {
           if (closure->check_response(i, PS_PULL_SPARSE_TABLE) != 0) {
             ret = -1;
@@ -913,16 +1036,24 @@ std::future<int32_t> BrpcPsClient::pull_sparse(float **select_values,
             } else {
               last_key = kv_pair->first;
               last_value_data = kv_pair->second;
-              if (value_size !=
-                  io_buffer_itr.copy_and_forward(
-                      reinterpret_cast<void *>(last_value_data), value_size)) {
+              void *recv_data = codec
+                                    ? reinterpret_cast<void *>(encoded.data())
+                                    : reinterpret_cast<void *>(last_value_data);
+              if (encoded_size !=
+                  io_buffer_itr.copy_and_forward(recv_data, encoded_size)) {
                 LOG(WARNING) << "res data is lack or not in format";
                 ret = -1;
                 break;
               }
+              if (codec) {
+                codec->decode(encoded.data(), last_value_data);
+              }
             }
           }
         }
+        if (pull_done) {
+          pull_done(ret);
+        }
         closure->set_promise_value(ret);
       });
 
@@ -972,6 +1103,11 @@ std::future<int32_t> BrpcPsClient::pull_sparse(float **select_values,
       closure->request(i)->set_client_id(_client_id);
       closure->request(i)->add_params((char *)&kv_request_count,  // NOLINT
                                       sizeof(uint32_t));
+      if (codec) {
+        uint32_t type = codec->type();
+        closure->request(i)->add_params(reinterpret_cast<char *>(&type),
+                                        sizeof(uint32_t));
+      }
       PsService_Stub rpc_stub(get_cmd_channel(i));
       closure->cntl(i)->set_log_id(butil::gettimeofday_ms());
       rpc_stub.service(closure->cntl(i), closure->request(i),
@@ -1072,8 +1208,9 @@ int32_t BrpcPsClient::recv_and_save_table(const uint64_t table_id,
     save_vec.push_back(save_huge_vec.data() + i * var_shape);
   }
 
-  auto status = pull_sparse(reinterpret_cast<float **>(save_vec.data()),
-                            table_id, save_key.data(), save_key.size(), true);
+  auto status =
+      pull_sparse_from_server(reinterpret_cast<float **>(save_vec.data()),
+                              table_id, save_key.data(), save_key.size(), true);
   status.wait();
 
   // create lod tensor
@@ -1426,20 +1563,14 @@ int BrpcPsClient::push_sparse_async_shard_push(
   push_request->set_client_id(_client_id);
   push_request->add_params(reinterpret_cast<char *>(&merged_kv_count),
                            sizeof(uint32_t));  // NOLINT
-  auto *push_data = push_request->mutable_data();
-  push_data->resize(merged_kv_count *
-                    (sizeof(uint64_t) + accessor->update_size()));
-  char *push_data_ptr = const_cast<char *>(push_data->data());
-  memcpy(push_data_ptr, merged_key_list.data(),
-         merged_kv_count * sizeof(uint64_t));
-  push_data_ptr += merged_kv_count * sizeof(uint64_t);
-  for (int i = 0; i < merged_kv_count; ++i) {
-    const char *task_data_ptr = merged_value_list[i].data();
-
-    memcpy(push_data_ptr, (float *)(task_data_ptr),  // NOLINT
-           accessor->update_size());
-    push_data_ptr += accessor->update_size();
+  std::vector<const float *> merged_value_ptrs(merged_kv_count);
+  for (size_t i = 0; i < merged_kv_count; ++i) {
+    merged_value_ptrs[i] =
+        reinterpret_cast<const float *>(merged_value_list[i].data());
   }
+  fill_push_sparse_request(table_id, merged_key_list.data(),
+                           merged_value_ptrs.data(), merged_kv_count,
+                           push_request);
   PsService_Stub rpc_stub(get_sparse_channel(shard_idx));
   closure->cntl(shard_idx)->set_request_compress_type(
       (brpc::CompressType)FLAGS_pserver_communicate_compress_type);
@@ -1603,17 +1734,9 @@ void BrpcPsClient::push_dense_raw_gradient(
   closure->add_timer(timer);
   uint32_t num_per_shard =
       dense_dim_per_shard(accessor->fea_dim(), request_call_num);
+  fill_push_dense_requests(task->table_id(), total_send_data, num_per_shard,
+                           closure);
   for (size_t i = 0; i < request_call_num; ++i) {
-    closure->request(i)->set_cmd_id(PS_PUSH_DENSE_TABLE);
-    closure->request(i)->set_table_id(task->table_id());
-    closure->request(i)->set_client_id(_client_id);
-    auto *push_data = closure->request(i)->mutable_data();
-    push_data->clear();
-    push_data->resize(sizeof(uint32_t) + num_per_shard * sizeof(float));
-    char *push_data_ptr = const_cast<char *>(push_data->data());
-    memcpy(push_data_ptr, &num_per_shard, sizeof(uint32_t));
-    memcpy(push_data_ptr + sizeof(uint32_t),
-           total_send_data + i * num_per_shard, num_per_shard * sizeof(float));
     closure->cntl(i)->set_request_compress_type(
         (brpc::CompressType)FLAGS_pserver_communicate_compress_type);
     PsService_Stub rpc_stub(get_dense_channel(i));
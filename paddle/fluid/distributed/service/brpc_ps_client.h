@@ -24,6 +24,7 @@
 #include "brpc/server.h"
 #include "paddle/fluid/distributed/service/brpc_utils.h"
 #include "paddle/fluid/distributed/service/ps_client.h"
+#include "paddle/fluid/distributed/service/sparse_value_codec.h"
 #include "paddle/fluid/framework/channel.h"
 #include "paddle/fluid/framework/lod_tensor.h"
 #include "paddle/fluid/framework/scope.h"
@@ -242,6 +243,24 @@ class BrpcPsClient : public PSClient {
   std::future<int32_t> send_cmd(uint32_t table_id, int cmd_id,
                                 const std::vector<std::string> &param);
 
+  // creates the wire format of the values of a sparse table
+  void init_sparse_value_codec(const TableParameter &table_param);
+  // fills the keys and values of a push_sparse request
+  void fill_push_sparse_request(size_t table_id, const uint64_t *keys,
+                                const float *const *values, size_t num,
+                                PsRequestMessage *request);
+  // fills the shards of the dense grads into the requests of the closure,
+  // compressed when the table has a DenseGradCompressor out of its warmup
+  void fill_push_dense_requests(size_t table_id, const float *total_send_data,
+                                uint32_t num_per_shard,
+                                DownpourBrpcClosure *closure);
+
+  // pulls the values of the keys from the servers, bypassing the cache, and
+  // calls pull_done if any with the status before the future is ready
+  std::future<int32_t> pull_sparse_from_server(
+      float **select_values, size_t table_id, const uint64_t *keys, size_t num,
+      bool is_training, const SparsePullCache::PullDone &pull_done = nullptr);
+
   std::future<int32_t> send_save_cmd(uint32_t table_id, int cmd_id,
                                      const std::vector<std::string> &param);
 
@@ -261,6 +280,14 @@ class BrpcPsClient : public PSClient {
       _push_sparse_task_queue_map;
   std::unordered_map<uint32_t, uint32_t> _push_sparse_merge_count_map;
 
+  // the wire formats of the sparse tables not sent in fp32
+  std::unordered_map<uint32_t, std::shared_ptr<SparseValueCodec>>
+      _pull_value_codecs;
+  std::unordered_map<uint32_t, std::shared_ptr<SparseValueCodec>>
+      _push_value_codecs;
+  std::unordered_map<uint32_t, std::shared_ptr<SparseValueResidual>>
+      _push_value_residuals;
+
   std::thread _print_thread;
 
   int push_sparse_async_shard_merge(
@@ -15,6 +15,7 @@
 #include "paddle/fluid/distributed/service/brpc_ps_server.h"
 #include <thread>  // NOLINT
 #include "butil/object_pool.h"
+#include "paddle/fluid/distributed/service/sparse_value_codec.h"
 #include "paddle/fluid/distributed/table/depends/sparse_utils.h"
 #include "paddle/fluid/distributed/table/table.h"
 #include "paddle/fluid/framework/archive.h"
@@ -99,6 +100,8 @@ int32_t BrpcPsService::initialize() {
   _service_handler_map[PS_STOP_SERVER] = &BrpcPsService::stop_server;
   _service_handler_map[PS_PULL_DENSE_TABLE] = &BrpcPsService::pull_dense;
   _service_handler_map[PS_PUSH_DENSE_TABLE] = &BrpcPsService::push_dense;
+  _service_handler_map[PS_PUSH_COMPRESSED_DENSE_TABLE] =
+      &BrpcPsService::push_compressed_dense;
   _service_handler_map[PS_PULL_SPARSE_TABLE] = &BrpcPsService::pull_sparse;
   _service_handler_map[PS_PUSH_SPARSE_TABLE] = &BrpcPsService::push_sparse;
   _service_handler_map[PS_SAVE_ONE_TABLE] = &BrpcPsService::save_one_table;
@@ -261,6 +264,39 @@ int32_t BrpcPsService::push_dense(Table *table, const PsRequestMessage &request,
   return 0;
 }
 
+int32_t BrpcPsService::push_compressed_dense(Table *table,
+                                             const PsRequestMessage &request,
+                                             PsResponseMessage &response,
+                                             brpc::Controller *cntl) {
+  platform::RecordEvent record_event("PsService->push_compressed_dense");
+  CHECK_TABLE_EXIST(table, request, response)
+  /*
+  Push Content:
+  |--num--|---indicesData---|---valuesData---|
+  |--4B---|----4*{num}B-----|----4*{num}B----|
+  */
+  const char *data = request.data().data();
+  auto req_buffer_size = request.data().size();
+  if (req_buffer_size < sizeof(uint32_t)) {
+    set_response_code(response, -1, "push compressed dense data is empty");
+    return 0;
+  }
+  uint32_t num = *(const uint32_t *)data;
+  if (req_buffer_size !=
+      sizeof(uint32_t) + num * (sizeof(uint32_t) + sizeof(float))) {
+    set_response_code(response, -1,
+                      "invalid size of the compressed dense data");
+    return 0;
+  }
+  const uint32_t *indices = (const uint32_t *)(data + sizeof(uint32_t));
+  const float *values =
+      (const float *)(data + sizeof(uint32_t) * (1 + num));
+  if (table->push_dense_compressed(indices, values, num) != 0) {
+    set_response_code(response, -1, "push_compressed_dense failed");
+  }
+  return 0;
+}
+
 int32_t BrpcPsService::barrier(Table *table, const PsRequestMessage &request,
                                PsResponseMessage &response,
                                brpc::Controller *cntl) {
@@ -334,6 +370,23 @@ int32_t BrpcPsService::pull_geo_param(Table *table,
   return 0;
 }
 
+// Reads the wire format of the sparse values named by the client in the
+// second param, returns false if it is not a known SparseValueType.
+static bool parse_sparse_value_type(const PsRequestMessage &request,
+                                    SparseValueType *type) {
+  auto &param = request.params(1);
+  uint32_t value = 0;
+  if (param.size() != sizeof(uint32_t)) {
+    return false;
+  }
+  memcpy(&value, param.data(), sizeof(uint32_t));
+  if (!SparseValueType_IsValid(static_cast<int>(value))) {
+    return false;
+  }
+  *type = static_cast<SparseValueType>(value);
+  return true;
+}
+
 int32_t BrpcPsService::pull_sparse(Table *table,
                                    const PsRequestMessage &request,
                                    PsResponseMessage &response,
@@ -358,6 +411,12 @@ int32_t BrpcPsService::pull_sparse(Table *table,
 
   uint32_t num = *(uint32_t *)(request.params(0).c_str());
   auto dim = table->value_accesor()->select_dim();
+  // the client may ask for the values in a reduced precision
+  SparseValueType type = SPARSE_VALUE_FP32;
+  if (request.params_size() > 1 && !parse_sparse_value_type(request, &type)) {
+    set_response_code(response, -1, "unknown sparse value type of pull");
+    return 0;
+  }
 
   thread_local std::string req_buffer;
   req_buffer.reserve(req_buffer_size);
@@ -373,8 +432,21 @@ int32_t BrpcPsService::pull_sparse(Table *table,
   res_data->resize(num * dim);
   table->pull_sparse(res_data->data(), value);
 
-  cntl->response_attachment().append((char *)(res_data->data()),
-                                     res_data->size() * sizeof(float));
+  if (type != SPARSE_VALUE_FP32) {
+    SparseValueCodec codec(type, dim,
+                           table->value_accesor()->select_quant_begin());
+    auto encoded = butil::get_object<std::vector<char>>();
+    encoded->resize(num * codec.encoded_size());
+    for (size_t i = 0; i < num; ++i) {
+      codec.encode(res_data->data() + i * dim,
+                   encoded->data() + i * codec.encoded_size());
+    }
+    cntl->response_attachment().append(encoded->data(), encoded->size());
+    butil::return_object(encoded);
+  } else {
+    cntl->response_attachment().append((char *)(res_data->data()),
+                                       res_data->size() * sizeof(float));
+  }
   butil::return_object(res_data);
   return 0;
 }
@@ -405,6 +477,30 @@ int32_t BrpcPsService::push_sparse(Table *table,
   const uint64_t *keys = (const uint64_t *)push_data.data();
   const float *values =
       (const float *)(push_data.data() + sizeof(uint64_t) * num);
+  // the values may be sent in a reduced precision
+  std::vector<float> decoded_values;
+  if (request.params_size() > 1) {
+    SparseValueType type = SPARSE_VALUE_FP32;
+    if (!parse_sparse_value_type(request, &type)) {
+      set_response_code(response, -1, "unknown sparse value type of push");
+      return 0;
+    }
+    auto *accessor = table->value_accesor().get();
+    SparseValueCodec codec(type, accessor->update_dim(),
+                           accessor->update_quant_begin());
+    if (push_data.size() !=
+        num * (sizeof(uint64_t) + codec.encoded_size())) {
+      set_response_code(response, -1, "push sparse data is not in format");
+      return 0;
+    }
+    const char *encoded = push_data.data() + sizeof(uint64_t) * num;
+    decoded_values.resize(num * codec.dim());
+    for (size_t i = 0; i < num; ++i) {
+      codec.decode(encoded + i * codec.encoded_size(),
+                   decoded_values.data() + i * codec.dim());
+    }
+    values = decoded_values.data();
+  }
   if (table->push_sparse(keys, values, num) != 0) {
     set_response_code(response, -1, "push_sparse error");
   }
@@ -86,6 +86,9 @@ class BrpcPsService : public PsBaseService {
                      PsResponseMessage &response, brpc::Controller *cntl);
   int32_t push_dense_param(Table *table, const PsRequestMessage &request,
                            PsResponseMessage &response, brpc::Controller *cntl);
+  int32_t push_compressed_dense(Table *table, const PsRequestMessage &request,
+                                PsResponseMessage &response,
+                                brpc::Controller *cntl);
   int32_t push_sparse_param(Table *table, const PsRequestMessage &request,
                             PsResponseMessage &response,
                             brpc::Controller *cntl);
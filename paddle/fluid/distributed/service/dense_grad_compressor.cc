@@ -0,0 +1,149 @@
+// Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/distributed/service/dense_grad_compressor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <sstream>
+#include <unordered_set>
+
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace distributed {
+
+std::string DenseGradCompressorStats::to_string() const {
+  std::stringstream ss;
+  ss << "push_num: " << push_num
+     << ", compressed_push_num: " << compressed_push_num
+     << ", dense_dim_num: " << dense_dim_num
+     << ", sent_dim_num: " << sent_dim_num << ", sent_ratio: " << sent_ratio();
+  return ss.str();
+}
+
+DenseGradCompressor::DenseGradCompressor(const DenseCompressParameter &param)
+    : _param(param), _rng(std::random_device()()) {
+  PADDLE_ENFORCE_NE(param.type(), DENSE_COMPRESS_NONE,
+                    platform::errors::InvalidArgument(
+                        "The dense grads are not to be compressed."));
+  PADDLE_ENFORCE_EQ(
+      param.ratio() > 0. && param.ratio() <= 1., true,
+      platform::errors::InvalidArgument(
+          "The ratio of the dense dims sent should be in (0, 1], but got %f.",
+          param.ratio()));
+}
+
+bool DenseGradCompressor::compress(const float *grad, size_t dim,
+                                   std::vector<uint32_t> *indices,
+                                   std::vector<float> *values) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  ++_stats.push_num;
+  _stats.dense_dim_num += dim;
+  if (_stats.push_num <= _param.warmup_steps()) {
+    _stats.sent_dim_num += dim;
+    return false;
+  }
+
+  if (_residual.size() != dim) {
+    _residual.assign(dim, 0.);
+  }
+  for (size_t i = 0; i < dim; ++i) {
+    _residual[i] += grad[i];
+  }
+  size_t k = std::min(
+      dim, std::max<size_t>(1, static_cast<size_t>(
+                                   std::ceil(_param.ratio() * dim))));
+  if (_param.type() == DENSE_COMPRESS_TOPK) {
+    select_topk(k, indices);
+  } else {
+    select_randomk(dim, k, indices);
+  }
+  std::sort(indices->begin(), indices->end());
+
+  values->resize(indices->size());
+  for (size_t i = 0; i < indices->size(); ++i) {
+    auto &residual = _residual[(*indices)[i]];
+    (*values)[i] = residual;
+    residual = 0.;
+  }
+  if (!_param.error_feedback()) {
+    std::fill(_residual.begin(), _residual.end(), 0.);
+  }
+  ++_stats.compressed_push_num;
+  _stats.sent_dim_num += indices->size();
+  return true;
+}
+
+void DenseGradCompressor::select_topk(size_t k,
+                                      std::vector<uint32_t> *indices) {
+  _order.resize(_residual.size());
+  for (size_t i = 0; i < _order.size(); ++i) {
+    _order[i] = i;
+  }
+  const float *residual = _residual.data();
+  std::nth_element(_order.begin(), _order.begin() + (k - 1), _order.end(),
+                   [residual](uint32_t a, uint32_t b) {
+                     return std::fabs(residual[a]) > std::fabs(residual[b]);
+                   });
+  indices->assign(_order.begin(), _order.begin() + k);
+}
+
+void DenseGradCompressor::select_randomk(size_t dim, size_t k,
+                                         std::vector<uint32_t> *indices) {
+  // Floyd's sampling of k distinct dims
+  std::unordered_set<uint32_t> selected;
+  selected.reserve(k);
+  for (size_t j = dim - k; j < dim; ++j) {
+    uint32_t t = std::uniform_int_distribution<uint32_t>(0, j)(_rng);
+    if (!selected.insert(t).second) {
+      selected.insert(j);
+    }
+  }
+  indices->assign(selected.begin(), selected.end());
+}
+
+void DenseGradCompressor::clear() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  std::fill(_residual.begin(), _residual.end(), 0.);
+}
+
+DenseGradCompressorStats DenseGradCompressor::stats() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _stats;
+}
+
+void EncodeCompressedDenseShard(const std::vector<uint32_t> &indices,
+                                const std::vector<float> &values,
+                                uint32_t begin, uint32_t end,
+                                std::string *data) {
+  size_t first =
+      std::lower_bound(indices.begin(), indices.end(), begin) - indices.begin();
+  size_t last =
+      std::lower_bound(indices.begin(), indices.end(), end) - indices.begin();
+  uint32_t num = last - first;
+  data->resize(sizeof(uint32_t) + num * (sizeof(uint32_t) + sizeof(float)));
+  char *ptr = const_cast<char *>(data->data());
+  memcpy(ptr, &num, sizeof(uint32_t));
+  uint32_t *shard_indices = reinterpret_cast<uint32_t *>(ptr + sizeof(uint32_t));
+  for (size_t i = first; i < last; ++i) {
+    shard_indices[i - first] = indices[i] - begin;
+  }
+  memcpy(ptr + sizeof(uint32_t) * (1 + num), values.data() + first,
+         num * sizeof(float));
+}
+
+}  // namespace distributed
+}  // namespace paddle
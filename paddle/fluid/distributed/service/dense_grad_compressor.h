@@ -0,0 +1,90 @@
+// Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <mutex>  // NOLINT
+#include <random>
+#include <string>
+#include <vector>
+
+#include "paddle/fluid/distributed/ps.pb.h"
+
+namespace paddle {
+namespace distributed {
+
+struct DenseGradCompressorStats {
+  uint64_t push_num = 0;
+  // the pushes sent compressed, the others were in the warmup
+  uint64_t compressed_push_num = 0;
+  uint64_t dense_dim_num = 0;
+  uint64_t sent_dim_num = 0;
+
+  double sent_ratio() const {
+    return dense_dim_num == 0 ? 0.
+                              : static_cast<double>(sent_dim_num) /
+                                    dense_dim_num;
+  }
+  std::string to_string() const;
+};
+
+/*
+ * Compresses the dense grads pushed to a table into the indices and values
+ * of a part of their dims, the top-k by magnitude or a random-k. With error
+ * feedback the dims not sent are kept in a residual on the worker and added
+ * to the next grad, so that every dim of the grads is applied eventually.
+ *
+ * The selected dims are sent to the server of their shard as
+ *
+ *   |--num--|---indices - shard begin---|---values---|
+ *   |--4B---|---------4*{num}B----------|--4*{num}B--|
+ *
+ * and CommonDenseTable applies them as a dense grad zero elsewhere.
+ */
+class DenseGradCompressor {
+ public:
+  explicit DenseGradCompressor(const DenseCompressParameter &param);
+
+  // Selects the dims of the grad and the residual to send into the sorted
+  // indices and their values, and keeps the others in the residual. Returns
+  // false in the warmup, in which the whole grad is to be sent instead.
+  bool compress(const float *grad, size_t dim, std::vector<uint32_t> *indices,
+                std::vector<float> *values);
+
+  const DenseCompressParameter &param() const { return _param; }
+  void clear();
+  DenseGradCompressorStats stats();
+
+ private:
+  void select_topk(size_t k, std::vector<uint32_t> *indices);
+  void select_randomk(size_t dim, size_t k, std::vector<uint32_t> *indices);
+
+  DenseCompressParameter _param;
+  std::mutex _mutex;
+  // grad + residual of the push being compressed, then the new residual
+  std::vector<float> _residual;
+  std::vector<uint32_t> _order;
+  std::mt19937 _rng;
+  DenseGradCompressorStats _stats;
+};
+
+// Writes the selected dims in [begin, end) of the sorted indices into data in
+// the format above.
+void EncodeCompressedDenseShard(const std::vector<uint32_t> &indices,
+                                const std::vector<float> &values,
+                                uint32_t begin, uint32_t end,
+                                std::string *data);
+
+}  // namespace distributed
+}  // namespace paddle
@@ -14,11 +14,21 @@
 
 #include "paddle/fluid/distributed/service/ps_client.h"
 #include "glog/logging.h"
+#include "paddle/fluid/distributed/common/cost_timer.h"
 #include "paddle/fluid/distributed/service/brpc_ps_client.h"
 #include "paddle/fluid/distributed/service/graph_brpc_client.h"
 #include "paddle/fluid/distributed/service/ps_local_client.h"
 #include "paddle/fluid/distributed/table/table.h"
 
+DEFINE_int32(pserver_sparse_pull_cache_capacity, 0,
+             "the number of feasigns cached by the client for every sparse "
+             "table, 0 to disable the cache");
+DEFINE_int32(pserver_sparse_pull_cache_shard_num, 64,
+             "the shard num of the sparse pull cache");
+DEFINE_int32(pserver_sparse_pull_cache_staleness, 16,
+             "the number of training steps, i.e. sparse pushes of a table by "
+             "the trainer, for which a cached value is served");
+
 namespace paddle {
 namespace distributed {
 REGISTER_PSCORE_CLASS(PSClient, BrpcPsClient);
@@ -51,9 +61,67 @@ int32_t PSClient::configure(
     _table_accessors[work_param.downpour_table_param(i).table_id()].reset(
         accessor);
   }
+  for (size_t i = 0; i < work_param.downpour_table_param_size(); ++i) {
+    const auto &table_param = work_param.downpour_table_param(i);
+    if (table_param.type() == PS_DENSE_TABLE &&
+        table_param.dense_compress_param().type() != DENSE_COMPRESS_NONE) {
+      _dense_grad_compressors[table_param.table_id()] =
+          std::make_shared<DenseGradCompressor>(
+              table_param.dense_compress_param());
+      VLOG(1) << "compress the dense grads of table "
+              << table_param.table_id() << " by "
+              << DenseCompressType_Name(
+                     table_param.dense_compress_param().type())
+              << ", ratio: " << table_param.dense_compress_param().ratio();
+    }
+  }
+  if (FLAGS_pserver_sparse_pull_cache_capacity > 0) {
+    SparsePullCacheConfig cache_config;
+    cache_config.capacity = FLAGS_pserver_sparse_pull_cache_capacity;
+    cache_config.shard_num = FLAGS_pserver_sparse_pull_cache_shard_num;
+    cache_config.staleness = FLAGS_pserver_sparse_pull_cache_staleness;
+    for (size_t i = 0; i < work_param.downpour_table_param_size(); ++i) {
+      const auto &table_param = work_param.downpour_table_param(i);
+      if (table_param.type() == PS_SPARSE_TABLE) {
+        enable_sparse_pull_cache(table_param.table_id(), cache_config);
+      }
+    }
+  }
   return initialize();
 }
 
+void PSClient::enable_sparse_pull_cache(size_t table_id,
+                                        const SparsePullCacheConfig &config) {
+  auto *accessor = table_accessor(table_id);
+  PADDLE_ENFORCE_NOT_NULL(
+      accessor, platform::errors::NotFound(
+                    "The accessor of table %d is not found.", table_id));
+  _sparse_pull_caches[table_id] =
+      std::make_shared<SparsePullCache>(config, accessor->select_size());
+  // Registered before any pull, the profiler map is not thread safe.
+  CostProfiler::instance().register_profiler(
+      "pserver_client_pull_sparse_cache_lookup");
+  VLOG(1) << "enable sparse pull cache of table " << table_id
+          << ", capacity: " << config.capacity
+          << ", staleness: " << config.staleness;
+}
+
+void PSClient::advance_sparse_pull_cache_step(int table_id) {
+  for (auto &cache : _sparse_pull_caches) {
+    if (table_id < 0 || cache.first == static_cast<uint32_t>(table_id)) {
+      cache.second->advance_step();
+    }
+  }
+}
+
+void PSClient::clear_sparse_pull_cache(int table_id) {
+  for (auto &cache : _sparse_pull_caches) {
+    if (table_id < 0 || cache.first == static_cast<uint32_t>(table_id)) {
+      cache.second->clear();
+    }
+  }
+}
+
 PSClient *PSClientFactory::create(const PSParameter &ps_config) {
   const auto &config = ps_config.server_param();
   if (!config.has_downpour_server_param()) {
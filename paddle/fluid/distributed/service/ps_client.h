@@ -22,8 +22,10 @@
 #include <vector>
 #include "paddle/fluid/distributed/common/cost_timer.h"
 #include "paddle/fluid/distributed/ps.pb.h"
+#include "paddle/fluid/distributed/service/dense_grad_compressor.h"
 #include "paddle/fluid/distributed/service/env.h"
 #include "paddle/fluid/distributed/service/sendrecv.pb.h"
+#include "paddle/fluid/distributed/service/sparse_pull_cache.h"
 #include "paddle/fluid/distributed/table/accessor.h"
 #include "paddle/fluid/distributed/table/graph/graph_node.h"
 #include "paddle/fluid/platform/timer.h"
@@ -204,6 +206,31 @@ class PSClient {
     return itr->second.get();
   }
 
+  // Serves the pull_sparse of the table through a SparsePullCache, so that
+  // the values of hot feasigns are pulled once per staleness steps.
+  void enable_sparse_pull_cache(size_t table_id,
+                                const SparsePullCacheConfig &config);
+  // starts the next training step of the sparse pull cache of the table, or
+  // of all tables for -1
+  void advance_sparse_pull_cache_step(int table_id);
+  SparsePullCache *sparse_pull_cache(size_t table_id) {
+    auto itr = _sparse_pull_caches.find(table_id);
+    if (itr == _sparse_pull_caches.end()) {
+      return NULL;
+    }
+    return itr->second.get();
+  }
+
+  // the compressor of the grads pushed to a dense table whose
+  // dense_compress_param is set, NULL otherwise
+  DenseGradCompressor *dense_grad_compressor(size_t table_id) {
+    auto itr = _dense_grad_compressors.find(table_id);
+    if (itr == _dense_grad_compressors.end()) {
+      return NULL;
+    }
+    return itr->second.get();
+  }
+
   virtual size_t get_server_nums() = 0;
 
   virtual std::future<int32_t> push_dense_raw_gradient(
@@ -229,12 +256,19 @@ class PSClient {
 
  protected:
   virtual int32_t initialize() = 0;
+  // drops the cached values of the table, or of all tables for -1, once the
+  // values on the servers are replaced
+  void clear_sparse_pull_cache(int table_id);
   size_t _client_id;
   PSParameter _config;
   std::map<uint64_t, std::vector<paddle::distributed::Region>>
       _dense_pull_regions;
   PSEnvironment *_env;
   std::unordered_map<uint32_t, std::shared_ptr<ValueAccessor>> _table_accessors;
+  std::unordered_map<uint32_t, std::shared_ptr<SparsePullCache>>
+      _sparse_pull_caches;
+  std::unordered_map<uint32_t, std::shared_ptr<DenseGradCompressor>>
+      _dense_grad_compressors;
   std::unordered_map<int32_t, MsgHandlerFunc>
       _msg_handler_map;  // 处理client2client消息
 };
@@ -25,9 +25,10 @@ int32_t PsLocalClient::initialize() {
   for (size_t i = 0; i < downpour_param.downpour_table_param_size(); ++i) {
     auto* table = CREATE_PSCORE_CLASS(
         Table, downpour_param.downpour_table_param(i).table_class());
+    // the shard num is used by the initialization of the sparse tables
+    table->set_shard(0, 1);
     table->initialize(downpour_param.downpour_table_param(i),
                       _config.fs_client_param());
-    table->set_shard(0, 1);
     _table_map[downpour_param.downpour_table_param(i).table_id()].reset(table);
   }
   return 0;
@@ -51,6 +52,7 @@ int32_t PsLocalClient::initialize() {
                                            const std::string& epoch,
                                            const std::string& mode) {
   // TODO
+  clear_sparse_pull_cache(table_id);
   auto* table_ptr = table(table_id);
   table_ptr->load(epoch, mode);
   return done();
@@ -80,6 +82,7 @@ int32_t PsLocalClient::initialize() {
 }
 ::std::future<int32_t> PsLocalClient::clear(uint32_t table_id) {
   // TODO
+  clear_sparse_pull_cache(table_id);
   return done();
 }
 
@@ -165,7 +168,17 @@ int32_t PsLocalClient::initialize() {
 
   auto* table_ptr = table(table_id);
 
-  table_ptr->push_dense(total_send_data, total_send_data_size);
+  std::vector<uint32_t> indices;
+  std::vector<float> values;
+  auto* compressor = dense_grad_compressor(table_id);
+  if (compressor != NULL &&
+      compressor->compress(total_send_data, total_send_data_size, &indices,
+                           &values)) {
+    table_ptr->push_dense_compressed(indices.data(), values.data(),
+                                     indices.size());
+  } else {
+    table_ptr->push_dense(total_send_data, total_send_data_size);
+  }
   delete closure;
   return done();
 }
@@ -195,35 +208,60 @@ int32_t PsLocalClient::initialize() {
   return done();
 }
 
-//::std::future<int32_t> PsLocalClient::pull_sparse(float** select_values,
-//                                                  size_t table_id,
-//                                                  const uint64_t* keys,
-//                                                  size_t num) {
-//  // FIXME
-//  // auto timer =
-//  // std::make_shared<CostTimer>("pslib_downpour_client_pull_sparse");
-//  // auto local_timer =
-//  // std::make_shared<CostTimer>("pslib_downpour_client_pull_sparse_local");
-//  //将key拆分到各shard请求，并记录原始对应value指针
-//  auto* accessor = table_accessor(table_id);
-//  auto* table_ptr = table(table_id);
-//  size_t value_size = accessor->select_size();
-//
-//  // table_ptr->pull_sparse(keys, num);
-//  std::vector<float> res_data;
-//  res_data.resize(num * value_size / sizeof(float));
-//  table_ptr->pull_sparse(res_data.data(), keys, num);
-//  // memcpy(select_values[0], res_data->data(), res_data->size() *
-//  // sizeof(float));
-//  size_t offset = 0;
-//  for (int i = 0; i < num; ++i) {
-//    memcpy(select_values[i], (char*)res_data.data() + offset, value_size);
-//    offset += value_size;
-//  }
-//
-//  // return fut;
-//  return done();
-//}
+::std::future<int32_t> PsLocalClient::pull_sparse(float** select_values,
+                                                  size_t table_id,
+                                                  const uint64_t* keys,
+                                                  size_t num,
+                                                  bool is_training) {
+  auto* cache = sparse_pull_cache(table_id);
+  if (cache == NULL) {
+    pull_sparse_from_table(select_values, table_id, keys, num, is_training);
+    return done();
+  }
+  return cache->pull_sparse(
+      select_values, keys, num,
+      [this, table_id, is_training](
+          float** values, const uint64_t* miss_keys, size_t miss_num,
+          const SparsePullCache::PullDone& done) {
+        int32_t ret = pull_sparse_from_table(values, table_id, miss_keys,
+                                             miss_num, is_training);
+        done(ret);
+        std::promise<int32_t> prom;
+        prom.set_value(ret);
+        return prom.get_future();
+      });
+}
+
+int32_t PsLocalClient::pull_sparse_from_table(float** select_values,
+                                              size_t table_id,
+                                              const uint64_t* keys, size_t num,
+                                              bool is_training) {
+  auto* accessor = table_accessor(table_id);
+  auto* table_ptr = table(table_id);
+  size_t value_size = accessor->select_size();
+
+  std::vector<uint64_t> feasigns(keys, keys + num);
+  std::vector<uint32_t> frequencies(num, 1);
+  PullSparseValue value(feasigns, frequencies, value_size / sizeof(float));
+  value.is_training_ = is_training;
+  std::vector<float> res_data(num * value_size / sizeof(float));
+  int32_t ret = table_ptr->pull_sparse(res_data.data(), value);
+  const char* res = reinterpret_cast<const char*>(res_data.data());
+  for (size_t i = 0; i < num; ++i) {
+    memcpy(select_values[i], res + i * value_size, value_size);
+  }
+  return ret;
+}
+
+::std::future<int32_t> PsLocalClient::print_table_stat(uint32_t table_id) {
+  auto* cache = sparse_pull_cache(table_id);
+  if (cache != NULL) {
+    std::cout << "table id: " << table_id
+              << ", sparse pull cache size: " << cache->size() << ", "
+              << cache->stats().to_string() << std::endl;
+  }
+  return done();
+}
 
 ::std::future<int32_t> PsLocalClient::pull_sparse_ptr(char** select_values,
                                                       size_t table_id,
@@ -65,26 +65,14 @@ class PsLocalClient : public PSClient {
   virtual ::std::future<int32_t> pull_sparse(float** select_values,
                                              size_t table_id,
                                              const uint64_t* keys, size_t num,
-                                             bool is_training) {
-    std::promise<int32_t> prom;
-    std::future<int32_t> fut = prom.get_future();
-    prom.set_value(0);
-
-    return fut;
-  }
+                                             bool is_training);
 
   virtual ::std::future<int32_t> pull_sparse_ptr(char** select_values,
                                                  size_t table_id,
                                                  const uint64_t* keys,
                                                  size_t num);
 
-  virtual ::std::future<int32_t> print_table_stat(uint32_t table_id) {
-    std::promise<int32_t> prom;
-    std::future<int32_t> fut = prom.get_future();
-    prom.set_value(0);
-
-    return fut;
-  }
+  virtual ::std::future<int32_t> print_table_stat(uint32_t table_id);
   virtual ::std::future<int32_t> push_sparse(size_t table_id,
                                              const uint64_t* keys,
                                              const float** update_values,
@@ -194,6 +182,11 @@ class PsLocalClient : public PSClient {
     return fut;
   }
 
+  // pulls the values of the keys from the table, bypassing the cache
+  int32_t pull_sparse_from_table(float** select_values, size_t table_id,
+                                 const uint64_t* keys, size_t num,
+                                 bool is_training);
+
   inline uint32_t dense_dim_per_shard(uint32_t dense_dim_total,
                                       uint32_t shard_num) {
     return dense_dim_total / shard_num + 1;
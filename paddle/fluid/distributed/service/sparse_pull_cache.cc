@@ -0,0 +1,262 @@
+// Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/distributed/service/sparse_pull_cache.h"
+
+#include <cstring>
+#include <sstream>
+#include <unordered_map>
+
+#include "paddle/fluid/distributed/common/cost_timer.h"
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace distributed {
+
+// the frequency counter of a feasign saturates at it
+static constexpr uint8_t kMaxFrequency = 7;
+
+std::string SparsePullCacheStats::to_string() const {
+  std::ostringstream os;
+  os << "lookup: " << lookup_num << ", hit: " << hit_num
+     << ", expired: " << expired_num << ", evict: " << evict_num
+     << ", hit ratio: " << hit_ratio() << ", saved bytes: " << saved_bytes();
+  return os.str();
+}
+
+struct SparsePullCache::Shard {
+  std::mutex mutex;
+  std::unordered_map<uint64_t, uint32_t> index;
+  // the slots of the feasigns
+  std::vector<uint64_t> keys;
+  std::vector<uint64_t> steps;
+  std::vector<uint8_t> frequencies;
+  std::vector<char> values;
+  // the CLOCK hand
+  uint32_t hand = 0;
+
+  // Returns a free slot, evicting a feasign once all slots are used.
+  uint32_t alloc_slot(size_t capacity, size_t value_size, bool *evicted) {
+    *evicted = false;
+    if (keys.size() < capacity) {
+      keys.push_back(0);
+      steps.push_back(0);
+      frequencies.push_back(0);
+      values.resize(keys.size() * value_size);
+      return keys.size() - 1;
+    }
+    // every sweep decrements the counters, so that a feasign hit often
+    // survives more sweeps
+    while (true) {
+      if (hand >= keys.size()) {
+        hand = 0;
+      }
+      if (frequencies[hand] == 0) {
+        index.erase(keys[hand]);
+        *evicted = true;
+        return hand++;
+      }
+      --frequencies[hand];
+      ++hand;
+    }
+  }
+};
+
+SparsePullCache::SparsePullCache(const SparsePullCacheConfig &config,
+                                 size_t value_size)
+    : _config(config), _value_size(value_size) {
+  PADDLE_ENFORCE_GT(
+      _config.shard_num, 0,
+      platform::errors::InvalidArgument(
+          "The shard num of the sparse pull cache should be greater than 0."));
+  PADDLE_ENFORCE_GE(
+      _config.capacity, _config.shard_num,
+      platform::errors::InvalidArgument(
+          "The capacity %d of the sparse pull cache should be no less than "
+          "its shard num %d.",
+          _config.capacity, _config.shard_num));
+  _shard_capacity =
+      (_config.capacity + _config.shard_num - 1) / _config.shard_num;
+  for (size_t i = 0; i < _config.shard_num; ++i) {
+    _shards.emplace_back(new Shard());
+  }
+}
+
+SparsePullCache::~SparsePullCache() {}
+
+void SparsePullCache::shard_keys(const uint64_t *keys, size_t num,
+                                 std::vector<size_t> *offsets,
+                                 std::vector<size_t> *indices) const {
+  // counting sort of the key indices by shard
+  size_t shard_num = _shards.size();
+  offsets->assign(shard_num + 1, 0);
+  for (size_t i = 0; i < num; ++i) {
+    ++(*offsets)[keys[i] % shard_num + 1];
+  }
+  for (size_t i = 0; i < shard_num; ++i) {
+    (*offsets)[i + 1] += (*offsets)[i];
+  }
+  std::vector<size_t> cursors(offsets->begin(), offsets->end() - 1);
+  indices->resize(num);
+  for (size_t i = 0; i < num; ++i) {
+    (*indices)[cursors[keys[i] % shard_num]++] = i;
+  }
+}
+
+void SparsePullCache::lookup(float **select_values, const uint64_t *keys,
+                             size_t num, uint64_t step,
+                             std::vector<uint64_t> *miss_keys,
+                             std::vector<float *> *miss_values) {
+  std::vector<size_t> offsets;
+  std::vector<size_t> indices;
+  shard_keys(keys, num, &offsets, &indices);
+  uint64_t hit_num = 0;
+  uint64_t expired_num = 0;
+  for (size_t s = 0; s < _shards.size(); ++s) {
+    if (offsets[s] == offsets[s + 1]) {
+      continue;
+    }
+    auto &shard = *_shards[s];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    for (size_t j = offsets[s]; j < offsets[s + 1]; ++j) {
+      size_t i = indices[j];
+      auto itr = shard.index.find(keys[i]);
+      if (itr != shard.index.end()) {
+        uint32_t slot = itr->second;
+        if (step - shard.steps[slot] <= _config.staleness) {
+          memcpy(select_values[i], shard.values.data() + slot * _value_size,
+                 _value_size);
+          if (shard.frequencies[slot] < kMaxFrequency) {
+            ++shard.frequencies[slot];
+          }
+          ++hit_num;
+          continue;
+        }
+        ++expired_num;
+      }
+      miss_keys->push_back(keys[i]);
+      miss_values->push_back(select_values[i]);
+    }
+  }
+  _lookup_num += num;
+  _hit_num += hit_num;
+  _expired_num += expired_num;
+}
+
+void SparsePullCache::insert(float *const *values, const uint64_t *keys,
+                             size_t num, uint64_t step, uint64_t generation) {
+  std::vector<size_t> offsets;
+  std::vector<size_t> indices;
+  shard_keys(keys, num, &offsets, &indices);
+  uint64_t evict_num = 0;
+  for (size_t s = 0; s < _shards.size(); ++s) {
+    if (offsets[s] == offsets[s + 1]) {
+      continue;
+    }
+    auto &shard = *_shards[s];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    // clear() bumps the generation before it clears the shards, so the
+    // values pulled before it are either dropped here or cleared by it
+    if (generation != _generation) {
+      break;
+    }
+    for (size_t j = offsets[s]; j < offsets[s + 1]; ++j) {
+      size_t i = indices[j];
+      uint32_t slot = 0;
+      auto itr = shard.index.find(keys[i]);
+      if (itr != shard.index.end()) {
+        slot = itr->second;
+        // a later pull may have refreshed it already
+        if (shard.steps[slot] > step) {
+          continue;
+        }
+      } else {
+        bool evicted = false;
+        slot = shard.alloc_slot(_shard_capacity, _value_size, &evicted);
+        evict_num += evicted;
+        shard.index[keys[i]] = slot;
+        shard.keys[slot] = keys[i];
+        shard.frequencies[slot] = 0;
+      }
+      shard.steps[slot] = step;
+      if (shard.frequencies[slot] < kMaxFrequency) {
+        ++shard.frequencies[slot];
+      }
+      memcpy(shard.values.data() + slot * _value_size, values[i], _value_size);
+    }
+  }
+  _evict_num += evict_num;
+}
+
+std::future<int32_t> SparsePullCache::pull_sparse(float **select_values,
+                                                  const uint64_t *keys,
+                                                  size_t num,
+                                                  const PullFunc &pull_func) {
+  uint64_t step = _step;
+  uint64_t generation = _generation;
+  auto miss_keys = std::make_shared<std::vector<uint64_t>>();
+  auto miss_values = std::make_shared<std::vector<float *>>();
+  {
+    CostTimer timer("pserver_client_pull_sparse_cache_lookup");
+    lookup(select_values, keys, num, step, miss_keys.get(), miss_values.get());
+  }
+  if (miss_keys->empty()) {
+    std::promise<int32_t> promise;
+    promise.set_value(0);
+    return promise.get_future();
+  }
+  return pull_func(
+      miss_values->data(), miss_keys->data(), miss_keys->size(),
+      [this, step, generation, miss_keys, miss_values](int32_t ret) {
+        if (ret == 0) {
+          insert(miss_values->data(), miss_keys->data(), miss_keys->size(),
+                 step, generation);
+        }
+      });
+}
+
+size_t SparsePullCache::size() const {
+  size_t size = 0;
+  for (auto &shard : _shards) {
+    std::lock_guard<std::mutex> lock(shard->mutex);
+    size += shard->index.size();
+  }
+  return size;
+}
+
+void SparsePullCache::clear() {
+  ++_generation;
+  for (auto &shard : _shards) {
+    std::lock_guard<std::mutex> lock(shard->mutex);
+    shard->index.clear();
+    shard->keys.clear();
+    shard->steps.clear();
+    shard->frequencies.clear();
+    shard->values.clear();
+    shard->hand = 0;
+  }
+}
+
+SparsePullCacheStats SparsePullCache::stats() const {
+  SparsePullCacheStats stats;
+  stats.lookup_num = _lookup_num;
+  stats.hit_num = _hit_num;
+  stats.expired_num = _expired_num;
+  stats.evict_num = _evict_num;
+  stats.value_size = _value_size;
+  return stats;
+}
+
+}  // namespace distributed
+}  // namespace paddle
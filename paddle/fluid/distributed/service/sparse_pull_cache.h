@@ -0,0 +1,127 @@
+// Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <future>  // NOLINT
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <vector>
+
+namespace paddle {
+namespace distributed {
+
+struct SparsePullCacheConfig {
+  // the number of cached feasigns
+  size_t capacity = 1 << 20;
+  size_t shard_num = 64;
+  // a cached value is served by the pulls within staleness training steps
+  // after the step which fetched it
+  uint32_t staleness = 16;
+};
+
+struct SparsePullCacheStats {
+  uint64_t lookup_num = 0;
+  uint64_t hit_num = 0;
+  // lookups which found a value older than the staleness
+  uint64_t expired_num = 0;
+  uint64_t evict_num = 0;
+  size_t value_size = 0;
+
+  double hit_ratio() const {
+    return lookup_num == 0 ? 0. : static_cast<double>(hit_num) / lookup_num;
+  }
+  // the key sent and the value received for every hit
+  uint64_t saved_bytes() const {
+    return hit_num * (sizeof(uint64_t) + value_size);
+  }
+  std::string to_string() const;
+};
+
+/*
+ * A client side cache of the values pulled from a sparse table, for the hot
+ * feasigns pulled by most batches. The trainer advances the training step of
+ * the cache once per batch: the keys whose values were fetched within the
+ * staleness bound are served locally, and only the others are pulled from the
+ * servers, however many pulls a step makes.
+ *
+ * clear() starts a new generation of the cache, so that the values of the
+ * pulls in flight when the table is reloaded are not inserted.
+ *
+ * The feasigns are sharded by key, each shard is guarded by its own mutex and
+ * evicts by CLOCK with a small frequency counter per feasign, which keeps the
+ * frequently hit feasigns like LFU.
+ */
+class SparsePullCache {
+ public:
+  typedef std::function<void(int32_t)> PullDone;
+  // pulls the values of num keys from the servers, and calls done with the
+  // status once the values are written, before the future is ready
+  typedef std::function<std::future<int32_t>(float **, const uint64_t *,
+                                             size_t, const PullDone &)>
+      PullFunc;
+
+  SparsePullCache(const SparsePullCacheConfig &config, size_t value_size);
+  ~SparsePullCache();
+
+  // Fills select_values like PSClient::pull_sparse, pulling the missed keys
+  // with pull_func. The pulled values are inserted into the cache when the
+  // pull completes.
+  std::future<int32_t> pull_sparse(float **select_values, const uint64_t *keys,
+                                   size_t num, const PullFunc &pull_func);
+
+  // Copies the cached values fresh at step, and appends the missed keys and
+  // their value buffers to miss_keys and miss_values.
+  void lookup(float **select_values, const uint64_t *keys, size_t num,
+              uint64_t step, std::vector<uint64_t> *miss_keys,
+              std::vector<float *> *miss_values);
+  // Inserts the values fetched at step, unless the cache was cleared since
+  // the generation.
+  void insert(float *const *values, const uint64_t *keys, size_t num,
+              uint64_t step, uint64_t generation);
+
+  // starts the next training step, which ages the cached values
+  void advance_step() { ++_step; }
+  uint64_t step() const { return _step; }
+  uint64_t generation() const { return _generation; }
+  size_t size() const;
+  void clear();
+  SparsePullCacheStats stats() const;
+
+ private:
+  struct Shard;
+
+  // groups the indices of the keys by shard
+  void shard_keys(const uint64_t *keys, size_t num,
+                  std::vector<size_t> *offsets,
+                  std::vector<size_t> *indices) const;
+
+  SparsePullCacheConfig _config;
+  size_t _value_size;
+  size_t _shard_capacity;
+  std::vector<std::unique_ptr<Shard>> _shards;
+  std::atomic<uint64_t> _step{0};
+  std::atomic<uint64_t> _generation{0};
+
+  std::atomic<uint64_t> _lookup_num{0};
+  std::atomic<uint64_t> _hit_num{0};
+  std::atomic<uint64_t> _expired_num{0};
+  std::atomic<uint64_t> _evict_num{0};
+};
+
+}  // namespace distributed
+}  // namespace paddle
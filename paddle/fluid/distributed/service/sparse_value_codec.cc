@@ -0,0 +1,278 @@
+// Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/distributed/service/sparse_value_codec.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "paddle/fluid/platform/bfloat16.h"
+#include "paddle/fluid/platform/enforce.h"
+#include "paddle/fluid/platform/float16.h"
+
+namespace paddle {
+namespace distributed {
+
+template <typename T>
+static void EncodeHalf(const float *value, size_t num, char *data) {
+  for (size_t i = 0; i < num; ++i) {
+    T half(value[i]);
+    memcpy(data + i * sizeof(T), &half, sizeof(T));
+  }
+}
+
+template <typename T>
+static void DecodeHalf(const char *data, size_t num, float *value) {
+  for (size_t i = 0; i < num; ++i) {
+    T half;
+    memcpy(&half, data + i * sizeof(T), sizeof(T));
+    value[i] = static_cast<float>(half);
+  }
+}
+
+SparseValueCodec::SparseValueCodec(SparseValueType type, size_t dim,
+                                   size_t quant_begin)
+    : _type(type), _dim(dim), _quant_begin(std::min(quant_begin, dim)) {
+  size_t quant_dim = _dim - _quant_begin;
+  _encoded_size = _quant_begin * sizeof(float);
+  switch (_type) {
+    case SPARSE_VALUE_FP32:
+      _encoded_size += quant_dim * sizeof(float);
+      break;
+    case SPARSE_VALUE_FP16:
+    case SPARSE_VALUE_BF16:
+      _encoded_size += quant_dim * sizeof(uint16_t);
+      break;
+    case SPARSE_VALUE_INT8:
+      if (quant_dim > 0) {
+        _encoded_size += sizeof(float) + quant_dim * sizeof(int8_t);
+      }
+      break;
+    default:
+      PADDLE_THROW(platform::errors::InvalidArgument(
+          "Unsupported sparse value type %d.", static_cast<int>(_type)));
+  }
+}
+
+void SparseValueCodec::encode(const float *value, char *data) const {
+  memcpy(data, value, _quant_begin * sizeof(float));
+  data += _quant_begin * sizeof(float);
+  value += _quant_begin;
+  size_t quant_dim = _dim - _quant_begin;
+  switch (_type) {
+    case SPARSE_VALUE_FP32:
+      memcpy(data, value, quant_dim * sizeof(float));
+      break;
+    case SPARSE_VALUE_FP16:
+      EncodeHalf<platform::float16>(value, quant_dim, data);
+      break;
+    case SPARSE_VALUE_BF16:
+      EncodeHalf<platform::bfloat16>(value, quant_dim, data);
+      break;
+    case SPARSE_VALUE_INT8: {
+      if (quant_dim == 0) {
+        break;
+      }
+      float max_abs = 0.;
+      for (size_t i = 0; i < quant_dim; ++i) {
+        max_abs = std::max(max_abs, std::fabs(value[i]));
+      }
+      float scale = max_abs / 127.;
+      memcpy(data, &scale, sizeof(float));
+      int8_t *quant = reinterpret_cast<int8_t *>(data + sizeof(float));
+      for (size_t i = 0; i < quant_dim; ++i) {
+        quant[i] = scale == 0. ? 0 : static_cast<int8_t>(
+                                         std::round(value[i] / scale));
+      }
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+void SparseValueCodec::decode(const char *data, float *value) const {
+  memcpy(value, data, _quant_begin * sizeof(float));
+  data += _quant_begin * sizeof(float);
+  value += _quant_begin;
+  size_t quant_dim = _dim - _quant_begin;
+  switch (_type) {
+    case SPARSE_VALUE_FP32:
+      memcpy(value, data, quant_dim * sizeof(float));
+      break;
+    case SPARSE_VALUE_FP16:
+      DecodeHalf<platform::float16>(data, quant_dim, value);
+      break;
+    case SPARSE_VALUE_BF16:
+      DecodeHalf<platform::bfloat16>(data, quant_dim, value);
+      break;
+    case SPARSE_VALUE_INT8: {
+      if (quant_dim == 0) {
+        break;
+      }
+      float scale = 0.;
+      memcpy(&scale, data, sizeof(float));
+      const int8_t *quant =
+          reinterpret_cast<const int8_t *>(data + sizeof(float));
+      for (size_t i = 0; i < quant_dim; ++i) {
+        value[i] = quant[i] * scale;
+      }
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+void SparseValueCodec::encode_with_feedback(const float *value,
+                                            float *residual,
+                                            char *data) const {
+  std::vector<float> compensated(_dim);
+  for (size_t i = 0; i < _dim; ++i) {
+    compensated[i] = value[i] + residual[i];
+  }
+  encode(compensated.data(), data);
+  std::vector<float> decoded(_dim);
+  decode(data, decoded.data());
+  for (size_t i = 0; i < _dim; ++i) {
+    residual[i] = compensated[i] - decoded[i];
+  }
+}
+
+SparseValueResidual::SparseValueResidual(size_t dim, size_t capacity,
+                                         float drop_threshold,
+                                         size_t shard_num)
+    : _dim(dim), _drop_threshold(drop_threshold) {
+  PADDLE_ENFORCE_GT(shard_num, 0,
+                    platform::errors::InvalidArgument(
+                        "The shard num of the residuals should be greater "
+                        "than 0."));
+  PADDLE_ENFORCE_GT(capacity, 0,
+                    platform::errors::InvalidArgument(
+                        "The capacity of the residuals should be greater "
+                        "than 0."));
+  _shard_capacity = (capacity + shard_num - 1) / shard_num;
+  for (size_t i = 0; i < shard_num; ++i) {
+    _shards.emplace_back(new Shard());
+  }
+}
+
+bool SparseValueResidual::negligible(const std::vector<float> &residual) const {
+  for (auto x : residual) {
+    if (std::fabs(x) > _drop_threshold) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void SparseValueResidual::insert(Shard *shard, uint64_t key,
+                                 const std::vector<float> &residual) {
+  size_t pos = shard->entries.size();
+  if (pos < _shard_capacity) {
+    shard->entries.push_back({key, true, residual});
+  } else {
+    // give every key pushed since the last sweep a second chance
+    while (shard->entries[shard->hand].referenced) {
+      shard->entries[shard->hand].referenced = false;
+      shard->hand = (shard->hand + 1) % shard->entries.size();
+    }
+    pos = shard->hand;
+    auto &entry = shard->entries[pos];
+    shard->index.erase(entry.key);
+    entry.key = key;
+    entry.referenced = true;
+    entry.residual = residual;
+    shard->hand = (shard->hand + 1) % shard->entries.size();
+    ++shard->evicted_num;
+  }
+  shard->index[key] = pos;
+}
+
+void SparseValueResidual::erase(Shard *shard, size_t pos) {
+  shard->index.erase(shard->entries[pos].key);
+  if (pos + 1 != shard->entries.size()) {
+    shard->entries[pos] = std::move(shard->entries.back());
+    shard->index[shard->entries[pos].key] = pos;
+  }
+  shard->entries.pop_back();
+  if (shard->hand >= shard->entries.size()) {
+    shard->hand = 0;
+  }
+}
+
+void SparseValueResidual::encode(const SparseValueCodec &codec,
+                                 const uint64_t *keys,
+                                 const float *const *values, size_t num,
+                                 char *data) {
+  PADDLE_ENFORCE_EQ(codec.dim(), _dim,
+                    platform::errors::InvalidArgument(
+                        "The dim %d of the codec does not match the dim %d "
+                        "of the residuals.",
+                        codec.dim(), _dim));
+  std::vector<float> residual(_dim);
+  for (size_t i = 0; i < num; ++i) {
+    auto &shard = *_shards[keys[i] % _shards.size()];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto itr = shard.index.find(keys[i]);
+    if (itr == shard.index.end()) {
+      // a new key takes a place only if its error is worth keeping
+      std::fill(residual.begin(), residual.end(), 0.);
+      codec.encode_with_feedback(values[i], residual.data(), data);
+      if (!negligible(residual)) {
+        insert(&shard, keys[i], residual);
+      }
+    } else {
+      auto &entry = shard.entries[itr->second];
+      codec.encode_with_feedback(values[i], entry.residual.data(), data);
+      if (negligible(entry.residual)) {
+        erase(&shard, itr->second);
+      } else {
+        entry.referenced = true;
+      }
+    }
+    data += codec.encoded_size();
+  }
+}
+
+size_t SparseValueResidual::size() {
+  size_t size = 0;
+  for (auto &shard : _shards) {
+    std::lock_guard<std::mutex> lock(shard->mutex);
+    size += shard->entries.size();
+  }
+  return size;
+}
+
+size_t SparseValueResidual::evicted_num() {
+  size_t evicted_num = 0;
+  for (auto &shard : _shards) {
+    std::lock_guard<std::mutex> lock(shard->mutex);
+    evicted_num += shard->evicted_num;
+  }
+  return evicted_num;
+}
+
+void SparseValueResidual::clear() {
+  for (auto &shard : _shards) {
+    std::lock_guard<std::mutex> lock(shard->mutex);
+    shard->index.clear();
+    shard->entries.clear();
+    shard->hand = 0;
+  }
+}
+
+}  // namespace distributed
+}  // namespace paddle
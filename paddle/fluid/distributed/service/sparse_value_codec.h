@@ -0,0 +1,110 @@
+// Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <memory>
+#include <mutex>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "paddle/fluid/distributed/ps.pb.h"
+
+namespace paddle {
+namespace distributed {
+
+/*
+ * The wire format of the sparse values of a table. The first quant_begin
+ * dims of a value are sent in fp32 and the others in the precision of the
+ * type:
+ *
+ *   |---fp32 * {quant_begin}---|---[scale, int8 only]---|---quantized dims---|
+ *
+ * The servers always keep the fp32 values, only the transfer is lossy.
+ */
+class SparseValueCodec {
+ public:
+  SparseValueCodec(SparseValueType type, size_t dim, size_t quant_begin);
+
+  SparseValueType type() const { return _type; }
+  size_t dim() const { return _dim; }
+  // the bytes of an encoded value
+  size_t encoded_size() const { return _encoded_size; }
+
+  void encode(const float *value, char *data) const;
+  void decode(const char *data, float *value) const;
+  // Encodes value + residual, and keeps the error of the encoding in the
+  // residual, so that it is sent with the next value of the key.
+  void encode_with_feedback(const float *value, float *residual,
+                            char *data) const;
+
+ private:
+  SparseValueType _type;
+  size_t _dim;
+  size_t _quant_begin;
+  size_t _encoded_size;
+};
+
+/*
+ * The encoding errors of the values pushed for every key, the error feedback
+ * of a lossy push. The keys are sharded, each shard guarded by its own mutex.
+ *
+ * The errors are bounded in memory: an error not larger than drop_threshold
+ * in every dim is not kept, and a shard holds at most capacity / shard_num
+ * keys, beyond which the CLOCK hand drops the error of a key not pushed
+ * since its last sweep. A dropped error is lost rather than pushed alone,
+ * since a push without the show, click and slot of the key would change
+ * them on the server.
+ */
+class SparseValueResidual {
+ public:
+  SparseValueResidual(size_t dim, size_t capacity = 1 << 20,
+                      float drop_threshold = 0., size_t shard_num = 64);
+
+  // Encodes the values of the keys into data one after another.
+  void encode(const SparseValueCodec &codec, const uint64_t *keys,
+              const float *const *values, size_t num, char *data);
+
+  size_t size();
+  // the number of errors dropped by the capacity
+  size_t evicted_num();
+  void clear();
+
+ private:
+  struct Entry {
+    uint64_t key;
+    bool referenced;
+    std::vector<float> residual;
+  };
+
+  struct Shard {
+    std::mutex mutex;
+    std::unordered_map<uint64_t, size_t> index;
+    std::vector<Entry> entries;
+    size_t hand = 0;
+    size_t evicted_num = 0;
+  };
+
+  bool negligible(const std::vector<float> &residual) const;
+  void insert(Shard *shard, uint64_t key, const std::vector<float> &residual);
+  void erase(Shard *shard, size_t pos);
+
+  size_t _dim;
+  size_t _shard_capacity;
+  float _drop_threshold;
+  std::vector<std::unique_ptr<Shard>> _shards;
+};
+
+}  // namespace distributed
+}  // namespace paddle
@@ -91,6 +91,11 @@ class ValueAccessor {
   virtual size_t update_dim_size(size_t dim) = 0;
   // push value各维度相加总size
   virtual size_t update_size() = 0;
+  // the dims of the pull value from select_quant_begin() on may be sent in a
+  // reduced precision, the former ones are always sent in fp32
+  virtual size_t select_quant_begin() { return select_dim(); }
+  // the same for the push value
+  virtual size_t update_quant_begin() { return update_dim(); }
   // fea total for dense
   virtual size_t fea_dim() { return _config.fea_dim(); }
   // converter for save
@@ -164,6 +164,21 @@ int32_t CommonDenseTable::push_dense(const float* values, size_t num) {
   return 0;
 }
 
+int32_t CommonDenseTable::push_dense_compressed(const uint32_t* indices,
+                                                const float* values,
+                                                size_t num) {
+  // applied as a dense grad, so that the optimizer updates every dim like an
+  // uncompressed push
+  std::vector<float> dense_values(param_dim_, 0.);
+  for (size_t i = 0; i < num; ++i) {
+    // the dims beyond param_dim_ are the padding of the last shard
+    if (indices[i] < static_cast<uint32_t>(param_dim_)) {
+      dense_values[indices[i]] = values[i];
+    }
+  }
+  return push_dense(dense_values.data(), dense_values.size());
+}
+
 int32_t CommonDenseTable::_push_dense(const float* values, size_t num) {
   PADDLE_ENFORCE_GE(
       num, param_dim_,
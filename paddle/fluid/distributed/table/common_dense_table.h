@@ -43,6 +43,8 @@ class CommonDenseTable : public DenseTable {
   int32_t pull_dense(float* pull_values, size_t num) override;
   int32_t push_dense_param(const float* values, size_t num) override;
   int32_t push_dense(const float* values, size_t num) override;
+  int32_t push_dense_compressed(const uint32_t* indices, const float* values,
+                                size_t num) override;
   int32_t pour() override;
   int32_t set_global_lr(float* lr) override;
 
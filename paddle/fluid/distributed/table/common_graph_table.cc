@@ -38,6 +38,80 @@ std::vector<Node *> GraphShard::get_batch(int start, int end, int step) {
 
 size_t GraphShard::get_size() { return bucket.size(); }
 
+std::vector<uint64_t> GraphShard::get_ids_by_step(int start, int end,
+                                                  int step) {
+  if (start < 0) start = 0;
+  std::vector<uint64_t> res;
+  int size = std::min(end, (int)bucket.size());
+  auto csr = get_csr();
+  int csr_size = csr != nullptr ? (int)csr->node_num() : 0;
+  for (int pos = start; pos < size; pos += step) {
+    res.push_back(pos < csr_size ? csr->node_id(pos) : bucket[pos]->get_id());
+  }
+  return res;
+}
+
+void GraphShard::freeze(bool is_weighted) {
+  if (csr != nullptr) return;
+  auto new_csr = std::make_shared<GraphCSR>();
+  new_csr->build(bucket, is_weighted);
+  for (auto node : bucket) {
+    node->release_edges();
+  }
+  csr = new_csr;
+}
+
+void GraphShard::thaw() {
+  if (csr == nullptr) return;
+  std::string sample_type = csr->is_weighted() ? "weighted" : "random";
+  // the nodes without neighbors get their edges back too, they may be
+  // sampled or get new neighbors
+  for (size_t i = 0; i < csr->node_num(); i++) {
+    int degree = csr->degree(i);
+    Node *node = bucket[i];
+    node->build_edges(csr->is_weighted());
+    for (int j = 0; j < degree; j++) {
+      node->add_edge(csr->get_neighbor_id(i, j),
+                     csr->get_neighbor_weight(i, j));
+    }
+    node->build_sampler(sample_type);
+  }
+  // the samplers still holding it free it
+  csr.reset();
+}
+
+void GraphShard::build_csr(bool is_weighted) {
+  std::lock_guard<std::mutex> lock(csr_mutex);
+  freeze(is_weighted);
+}
+
+void GraphShard::release_csr() {
+  std::lock_guard<std::mutex> lock(csr_mutex);
+  thaw();
+}
+
+bool GraphShard::is_frozen() {
+  std::lock_guard<std::mutex> lock(csr_mutex);
+  return csr != nullptr;
+}
+
+std::shared_ptr<const GraphCSR> GraphShard::get_csr() {
+  std::lock_guard<std::mutex> lock(csr_mutex);
+  return csr;
+}
+
+std::shared_ptr<const GraphCSR> GraphShard::get_csr_row(uint64_t id,
+                                                        bool is_weighted,
+                                                        int *row) {
+  std::lock_guard<std::mutex> lock(csr_mutex);
+  freeze(is_weighted);
+  auto iter = node_location.find(id);
+  *row = iter == node_location.end() || iter->second >= (int)csr->node_num()
+             ? -1
+             : iter->second;
+  return csr;
+}
+
 int32_t GraphTable::add_graph_node(std::vector<uint64_t> &id_list,
                                    std::vector<bool> &is_weight_list) {
   size_t node_size = id_list.size();
@@ -56,12 +130,13 @@ int32_t GraphTable::add_graph_node(std::vector<uint64_t> &id_list,
     tasks.push_back(_shards_task_pool[i]->enqueue([&batch, i, this]() -> int {
       for (auto &p : batch[i]) {
         size_t index = p.first % this->shard_num - this->shard_start;
-        this->shards[index]->add_graph_node(p.first)->build_edges(p.second);
+        this->shards[index]->add_graph_node(p.first, p.second);
       }
       return 0;
     }));
   }
   for (size_t i = 0; i < tasks.size(); i++) tasks[i].get();
+  // the changed shards are frozen again by their next sample
   return 0;
 }
 
@@ -89,6 +164,8 @@ int32_t GraphTable::remove_graph_node(std::vector<uint64_t> &id_list) {
 }
 
 void GraphShard::clear() {
+  std::lock_guard<std::mutex> lock(csr_mutex);
+  csr.reset();
   for (size_t i = 0; i < bucket.size(); i++) {
     delete bucket[i];
   }
@@ -99,8 +176,10 @@ void GraphShard::clear() {
 GraphShard::~GraphShard() { clear(); }
 
 void GraphShard::delete_node(uint64_t id) {
+  std::lock_guard<std::mutex> lock(csr_mutex);
   auto iter = node_location.find(id);
   if (iter == node_location.end()) return;
+  thaw();
   int pos = iter->second;
   delete bucket[pos];
   if (pos != (int)bucket.size() - 1) {
@@ -110,15 +189,21 @@ void GraphShard::delete_node(uint64_t id) {
   node_location.erase(id);
   bucket.pop_back();
 }
-GraphNode *GraphShard::add_graph_node(uint64_t id) {
+GraphNode *GraphShard::add_graph_node(uint64_t id, bool is_weighted) {
+  std::lock_guard<std::mutex> lock(csr_mutex);
+  thaw();
   if (node_location.find(id) == node_location.end()) {
     node_location[id] = bucket.size();
     bucket.push_back(new GraphNode(id));
   }
-  return (GraphNode *)bucket[node_location[id]];
+  auto node = (GraphNode *)bucket[node_location[id]];
+  node->build_edges(is_weighted);
+  return node;
 }
 
 GraphNode *GraphShard::add_graph_node(Node *node) {
+  std::lock_guard<std::mutex> lock(csr_mutex);
+  thaw();
   auto id = node->get_id();
   if (node_location.find(id) == node_location.end()) {
     node_location[id] = bucket.size();
@@ -127,6 +212,8 @@ GraphNode *GraphShard::add_graph_node(Node *node) {
   return (GraphNode *)bucket[node_location[id]];
 }
 FeatureNode *GraphShard::add_feature_node(uint64_t id) {
+  // appended to the bucket without a row, the csr stays valid
+  std::lock_guard<std::mutex> lock(csr_mutex);
   if (node_location.find(id) == node_location.end()) {
     node_location[id] = bucket.size();
     bucket.push_back(new FeatureNode(id));
@@ -135,6 +222,8 @@ FeatureNode *GraphShard::add_feature_node(uint64_t id) {
 }
 
 void GraphShard::add_neighbor(uint64_t id, uint64_t dst_id, float weight) {
+  std::lock_guard<std::mutex> lock(csr_mutex);
+  thaw();
   find_node(id)->add_edge(dst_id, weight);
 }
 
@@ -222,6 +311,8 @@ int32_t GraphTable::get_nodes_ids_by_ranges(
 }
 
 int32_t GraphTable::load_nodes(const std::string &path, std::string node_type) {
+  // the shards are frozen again once all the nodes are added
+  release_csr();
   auto paths = paddle::string::split_string<std::string>(path, ";");
   int64_t count = 0;
   int64_t valid_count = 0;
@@ -272,10 +363,13 @@ int32_t GraphTable::load_nodes(const std::string &path, std::string node_type) {
 
   VLOG(0) << valid_count << "/" << count << " nodes in type " << node_type
           << " are loaded successfully in " << path;
-  return 0;
+  return use_csr ? build_csr() : 0;
 }
 
 int32_t GraphTable::load_edges(const std::string &path, bool reverse_edge) {
+  // every node needs its edges for the neighbors, samplers and relocation
+  // below, the shards are frozen again at the end
+  release_csr();
   auto paths = paddle::string::split_string<std::string>(path, ";");
   int64_t count = 0;
   std::string sample_type = "random";
@@ -319,7 +413,7 @@ int32_t GraphTable::load_edges(const std::string &path, bool reverse_edge) {
           extra_alloc_index %= task_pool_size_;
           extra_nodes_to_thread_index[src_id] = index;
         }
-        extra_shards[index]->add_graph_node(src_id)->build_edges(is_weighted);
+        extra_shards[index]->add_graph_node(src_id, is_weighted);
         extra_shards[index]->add_neighbor(src_id, dst_id, weight);
         valid_count++;
         continue;
@@ -330,7 +424,7 @@ int32_t GraphTable::load_edges(const std::string &path, bool reverse_edge) {
       }
 
       size_t index = src_shard_id - shard_start;
-      shards[index]->add_graph_node(src_id)->build_edges(is_weighted);
+      shards[index]->add_graph_node(src_id, is_weighted);
       shards[index]->add_neighbor(src_id, dst_id, weight);
       valid_count++;
     }
@@ -357,8 +451,9 @@ int32_t GraphTable::load_edges(const std::string &path, bool reverse_edge) {
       bucket[i]->build_sampler(sample_type);
     }
   }
+  csr_is_weighted = is_weighted;
   int size = extra_nodes_to_thread_index.size();
-  if (size == 0) return 0;
+  if (size == 0) return use_csr ? build_csr() : 0;
   std::vector<int> index;
   for (int i = 0; i < used.size(); i++) index.push_back(i);
   sort(index.begin(), index.end(),
@@ -424,10 +519,10 @@ int32_t GraphTable::load_edges(const std::string &path, bool reverse_edge) {
     delete extra_shards[i];
     extra_shards[i] = extra_shards_copy[i];
   }
-  return 0;
+  return use_csr ? build_csr() : 0;
 }
 
-Node *GraphTable::find_node(uint64_t id) {
+GraphShard *GraphTable::find_shard(uint64_t id) {
   size_t shard_id = id % shard_num;
   if (shard_id >= shard_end || shard_id < shard_start) {
     if (use_duplicate_nodes == false || extra_nodes_to_thread_index.size() == 0)
@@ -436,12 +531,54 @@ Node *GraphTable::find_node(uint64_t id) {
     if (iter == extra_nodes_to_thread_index.end())
       return nullptr;
     else {
-      return extra_shards[iter->second]->find_node(id);
+      return extra_shards[iter->second];
     }
   }
   size_t index = shard_id - shard_start;
-  Node *node = shards[index]->find_node(id);
-  return node;
+  return shards[index];
+}
+
+Node *GraphTable::find_node(uint64_t id) {
+  GraphShard *shard = find_shard(id);
+  return shard == nullptr ? nullptr : shard->find_node(id);
+}
+
+int32_t GraphTable::build_csr() {
+  std::vector<std::future<int>> tasks;
+  for (size_t i = 0; i < shards.size(); i++) {
+    tasks.push_back(
+        _shards_task_pool[i % task_pool_size_]->enqueue([this, i]() -> int {
+          this->shards[i]->build_csr(csr_is_weighted);
+          return 0;
+        }));
+  }
+  for (size_t i = 0; i < extra_shards.size(); i++) {
+    tasks.push_back(_shards_task_pool[i]->enqueue([this, i]() -> int {
+      this->extra_shards[i]->build_csr(csr_is_weighted);
+      return 0;
+    }));
+  }
+  for (size_t i = 0; i < tasks.size(); i++) tasks[i].get();
+  return 0;
+}
+
+int32_t GraphTable::release_csr() {
+  std::vector<std::future<int>> tasks;
+  for (size_t i = 0; i < shards.size(); i++) {
+    tasks.push_back(
+        _shards_task_pool[i % task_pool_size_]->enqueue([this, i]() -> int {
+          this->shards[i]->release_csr();
+          return 0;
+        }));
+  }
+  for (size_t i = 0; i < extra_shards.size(); i++) {
+    tasks.push_back(_shards_task_pool[i]->enqueue([this, i]() -> int {
+      this->extra_shards[i]->release_csr();
+      return 0;
+    }));
+  }
+  for (size_t i = 0; i < tasks.size(); i++) tasks[i].get();
+  return 0;
 }
 uint32_t GraphTable::get_thread_pool_index(uint64_t node_id) {
   if (use_duplicate_nodes == false || extra_nodes_to_thread_index.size() == 0)
@@ -584,15 +721,28 @@ int32_t GraphTable::random_sample_neighbors(
           index++;
         } else {
           node_id = id_list[i][k].node_key;
-          Node *node = find_node(node_id);
+          GraphShard *shard = find_shard(node_id);
           idx = seq_id[i][k];
           int &actual_size = actual_sizes[idx];
-          if (node == nullptr) {
+          // the csr shards sample from the rows of the csr, frozen again
+          // if a change thawed them; feature nodes have no row and no edges
+          int pos = -1;
+          Node *node = nullptr;
+          std::shared_ptr<const GraphCSR> csr;
+          if (shard != nullptr && use_csr) {
+            csr = shard->get_csr_row(node_id, csr_is_weighted, &pos);
+          } else if (shard != nullptr) {
+            pos = shard->find_node_pos(node_id);
+            node = shard->find_node(node_id);
+          }
+          if (pos < 0) {
             actual_size = 0;
             continue;
           }
           std::shared_ptr<char> &buffer = buffers[idx];
-          std::vector<int> res = node->sample_k(sample_size, rng);
+          std::vector<int> res =
+              csr != nullptr ? csr->sample_k(pos, sample_size, rng)
+                             : node->sample_k(sample_size, rng);
           actual_size =
               res.size() * (need_weight ? (Node::id_size + Node::weight_size)
                                         : Node::id_size);
@@ -608,11 +758,13 @@ int32_t GraphTable::random_sample_neighbors(
             buffer.reset(buffer_addr, char_del);
           }
           for (int &x : res) {
-            id = node->get_neighbor_id(x);
+            id = csr != nullptr ? csr->get_neighbor_id(pos, x)
+                                : node->get_neighbor_id(x);
             memcpy(buffer_addr + offset, &id, Node::id_size);
             offset += Node::id_size;
             if (need_weight) {
-              weight = node->get_neighbor_weight(x);
+              weight = csr != nullptr ? csr->get_neighbor_weight(pos, x)
+                                      : node->get_neighbor_weight(x);
               memcpy(buffer_addr + offset, &weight, Node::weight_size);
               offset += Node::weight_size;
             }
@@ -729,6 +881,9 @@ int32_t GraphTable::pull_graph_list(int start, int total_size,
                                     int &actual_size, bool need_feature,
                                     int step) {
   if (start < 0) start = 0;
+  if (!need_feature) {
+    return pull_graph_id_list(start, total_size, buffer, actual_size, step);
+  }
   int size = 0, cur_size;
   std::vector<std::future<std::vector<Node *>>> tasks;
   for (size_t i = 0; i < shards.size() && total_size > 0; i++) {
@@ -771,6 +926,51 @@ int32_t GraphTable::pull_graph_list(int start, int total_size,
   return 0;
 }
 
+// Without features a node is its id and a zero feature number, the ids are
+// taken from the csr of frozen shards instead of the nodes.
+int32_t GraphTable::pull_graph_id_list(int start, int total_size,
+                                       std::unique_ptr<char[]> &buffer,
+                                       int &actual_size, int step) {
+  int size = 0, cur_size;
+  std::vector<std::future<std::vector<uint64_t>>> tasks;
+  for (size_t i = 0; i < shards.size() && total_size > 0; i++) {
+    cur_size = shards[i]->get_size();
+    if (size + cur_size <= start) {
+      size += cur_size;
+      continue;
+    }
+    int count = std::min(1 + (size + cur_size - start - 1) / step, total_size);
+    int end = start + (count - 1) * step + 1;
+    tasks.push_back(_shards_task_pool[i % task_pool_size_]->enqueue(
+        [this, i, start, end, step, size]() -> std::vector<uint64_t> {
+          return this->shards[i]->get_ids_by_step(start - size, end - size,
+                                                  step);
+        }));
+    start += count * step;
+    total_size -= count;
+    size += cur_size;
+  }
+  std::vector<std::vector<uint64_t>> res;
+  size_t node_num = 0;
+  for (size_t i = 0; i < tasks.size(); i++) {
+    res.push_back(tasks[i].get());
+    node_num += res.back().size();
+  }
+  int node_size = Node::id_size + Node::int_size;
+  actual_size = node_num * node_size;
+  char *buffer_addr = new char[actual_size];
+  buffer.reset(buffer_addr);
+  int feat_num = 0;
+  for (auto &ids : res) {
+    for (auto id : ids) {
+      memcpy(buffer_addr, &id, Node::id_size);
+      memcpy(buffer_addr + Node::id_size, &feat_num, Node::int_size);
+      buffer_addr += node_size;
+    }
+  }
+  return 0;
+}
+
 int32_t GraphTable::get_server_index_by_id(uint64_t id) {
   return id % shard_num / shard_num_per_server;
 }
@@ -820,6 +1020,7 @@ int32_t GraphTable::initialize() {
     shards.push_back(new GraphShard());
   }
   use_duplicate_nodes = false;
+  use_csr = _config.use_graph_csr();
   for (int i = 0; i < task_pool_size_; i++) {
     extra_shards.push_back(new GraphShard());
   }
@@ -38,6 +38,7 @@
 #include <vector>
 #include "paddle/fluid/distributed/table/accessor.h"
 #include "paddle/fluid/distributed/table/common_table.h"
+#include "paddle/fluid/distributed/table/graph/graph_csr.h"
 #include "paddle/fluid/distributed/table/graph/graph_node.h"
 #include "paddle/fluid/framework/rw_lock.h"
 #include "paddle/fluid/string/string_helper.h"
@@ -51,14 +52,12 @@ class GraphShard {
   std::vector<Node *> &get_bucket() { return bucket; }
   std::vector<Node *> get_batch(int start, int end, int step);
   std::vector<uint64_t> get_ids_by_range(int start, int end) {
-    std::vector<uint64_t> res;
-    for (int i = start; i < end && i < (int)bucket.size(); i++) {
-      res.push_back(bucket[i]->get_id());
-    }
-    return res;
+    return get_ids_by_step(start, end, 1);
   }
+  std::vector<uint64_t> get_ids_by_step(int start, int end, int step);
 
-  GraphNode *add_graph_node(uint64_t id);
+  // adds the node if missing, with its edges built under the csr_mutex
+  GraphNode *add_graph_node(uint64_t id, bool is_weighted);
   GraphNode *add_graph_node(Node *node);
   FeatureNode *add_feature_node(uint64_t id);
   Node *find_node(uint64_t id);
@@ -68,10 +67,37 @@ class GraphShard {
   std::unordered_map<uint64_t, int> &get_node_location() {
     return node_location;
   }
+  int find_node_pos(uint64_t id) {
+    auto iter = node_location.find(id);
+    return iter == node_location.end() ? -1 : iter->second;
+  }
+
+  // Moves the edges of the nodes to a GraphCSR, the shard stays readable.
+  // A node or edge change moves the edges back to the nodes, and the CSR is
+  // built again by the next sample or build_csr, so a batch of changes
+  // rebuilds it once. The samplers hold the CSR by shared_ptr, a release
+  // does not free it under them.
+  void build_csr(bool is_weighted);
+  void release_csr();
+  bool is_frozen();
+  // the CSR, nullptr if the shard is not frozen
+  std::shared_ptr<const GraphCSR> get_csr();
+  // Freezes the shard if it is not, and returns the CSR with the row of the
+  // node in row, -1 if the node has no row.
+  std::shared_ptr<const GraphCSR> get_csr_row(uint64_t id, bool is_weighted,
+                                              int *row);
 
  private:
+  // both need csr_mutex
+  void freeze(bool is_weighted);
+  void thaw();
+
   std::unordered_map<uint64_t, int> node_location;
   std::vector<Node *> bucket;
+  // guards the csr and the node changes which thaw it
+  std::mutex csr_mutex;
+  // row i is the node of bucket[i], nodes added later have no row
+  std::shared_ptr<const GraphCSR> csr;
 };
 
 enum LRUResponse { ok = 0, blocked = 1, err = 2 };
@@ -360,6 +386,10 @@ class GraphTable : public SparseTable {
                                   int &actual_size, bool need_feature,
                                   int step);
 
+  int32_t pull_graph_id_list(int start, int size,
+                             std::unique_ptr<char[]> &buffer, int &actual_size,
+                             int step);
+
   virtual int32_t random_sample_neighbors(
       uint64_t *node_ids, int sample_size,
       std::vector<std::shared_ptr<char>> &buffers,
@@ -385,8 +415,16 @@ class GraphTable : public SparseTable {
   int32_t remove_graph_node(std::vector<uint64_t> &id_list);
 
   int32_t get_server_index_by_id(uint64_t id);
+  GraphShard *find_shard(uint64_t id);
   Node *find_node(uint64_t id);
 
+  // freezes the edges of all shards into GraphCSR, done after load_edges and
+  // load_nodes when use_graph_csr is set in the table config, which release
+  // it first; the shards thawed by other changes are frozen by their next
+  // sample
+  int32_t build_csr();
+  int32_t release_csr();
+
   virtual int32_t pull_sparse(float *values,
                               const PullSparseValue &pull_value) {
     return 0;
@@ -452,6 +490,7 @@ class GraphTable : public SparseTable {
   std::unordered_set<uint64_t> extra_nodes;
   std::unordered_map<uint64_t, size_t> extra_nodes_to_thread_index;
   bool use_cache, use_duplicate_nodes;
+  bool use_csr = false, csr_is_weighted = false;
   mutable std::mutex mutex_;
 };
 }  // namespace distributed
@@ -251,14 +251,36 @@ int32_t CtrCommonAccessor::update(float** update_values,
         (push_show - push_click) * _config.ctr_accessor_param().nonclk_coeff() +
         push_click * _config.ctr_accessor_param().click_coeff();
     update_value[common_feature_value.unseen_days_index()] = 0;
-    _embed_sgd_rule->update_value(
-        update_value + common_feature_value.embed_w_index(),
-        update_value + common_feature_value.embed_g2sum_index(),
-        push_value + CtrCommonPushValue::embed_g_index());
-    _embedx_sgd_rule->update_value(
-        update_value + common_feature_value.embedx_w_index(),
-        update_value + common_feature_value.embedx_g2sum_index(),
-        push_value + CtrCommonPushValue::embedx_g_index());
+    if (num == 1) {
+      _embed_sgd_rule->update_value(
+          update_value + common_feature_value.embed_w_index(),
+          update_value + common_feature_value.embed_g2sum_index(),
+          push_value + CtrCommonPushValue::embed_g_index());
+      _embedx_sgd_rule->update_value(
+          update_value + common_feature_value.embedx_w_index(),
+          update_value + common_feature_value.embedx_g2sum_index(),
+          push_value + CtrCommonPushValue::embedx_g_index());
+    }
+  }
+  if (num > 1) {
+    // the sgd rules update the embeddings of all the values at once
+    std::vector<float*> w(num);
+    std::vector<float*> sgd(num);
+    std::vector<const float*> grad(num);
+    for (size_t i = 0; i < num; ++i) {
+      w[i] = update_values[i] + common_feature_value.embed_w_index();
+      sgd[i] = update_values[i] + common_feature_value.embed_g2sum_index();
+      grad[i] = push_values[i] + CtrCommonPushValue::embed_g_index();
+    }
+    _embed_sgd_rule->update_value_batch(w.data(), sgd.data(), grad.data(),
+                                        num);
+    for (size_t i = 0; i < num; ++i) {
+      w[i] = update_values[i] + common_feature_value.embedx_w_index();
+      sgd[i] = update_values[i] + common_feature_value.embedx_g2sum_index();
+      grad[i] = push_values[i] + CtrCommonPushValue::embedx_g_index();
+    }
+    _embedx_sgd_rule->update_value_batch(w.data(), sgd.data(), grad.data(),
+                                         num);
   }
   return 0;
 }
@@ -146,6 +146,15 @@ class CtrCommonAccessor : public ValueAccessor {
   virtual size_t update_dim_size(size_t dim);
   // push value各维度相加总size
   virtual size_t update_size();
+  // embedx_w of the pull value may be sent in a reduced precision
+  virtual size_t select_quant_begin() {
+    return CtrCommonPullValue::embedx_w_index();
+  }
+  // the gradients of the push value may be sent in a reduced precision, the
+  // slot, show and click are kept exact
+  virtual size_t update_quant_begin() {
+    return CtrCommonPushValue::embed_g_index();
+  }
   // 判断该value是否进行shrink
   virtual bool shrink(float* value);
   // 判断该value是否保存到ssd
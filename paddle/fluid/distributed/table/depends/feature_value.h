@@ -15,6 +15,8 @@
 #pragma once
 
 #include <ThreadPool.h>
+#include <algorithm>
+#include <cstring>
 #include <functional>
 #include <future>  // NOLINT
 #include <memory>
@@ -117,6 +119,11 @@ class SparseTableShard {
     }
   }
 
+  map_type::iterator erase(size_t bucket, map_type::iterator iter) {
+    butil::return_object(iter->second);
+    return values_[bucket].erase(iter);
+  }
+
   void clear() {}
 
   size_t compute_bucket(size_t hash) {
@@ -163,5 +170,266 @@ class SparseTableShard {
   std::hash<uint64_t> hasher_;
 };
 
+// FeatureValueSlab hands out rows of a fixed number of floats carved from
+// large slabs, so that a feature costs neither a heap allocation nor a
+// vector header. Freed rows are chained into an intrusive free list and
+// reused by the next Alloc. Rows never move once allocated.
+class FeatureValueSlab {
+ public:
+  explicit FeatureValueSlab(size_t row_dim, size_t rows_per_slab = 8192)
+      : row_dim_(std::max(row_dim, sizeof(float *) / sizeof(float))),
+        rows_per_slab_(rows_per_slab) {}
+
+  FeatureValueSlab(const FeatureValueSlab &) = delete;
+  FeatureValueSlab &operator=(const FeatureValueSlab &) = delete;
+
+  float *Alloc() {
+    ++used_rows_;
+    if (free_rows_ != nullptr) {
+      float *row = free_rows_;
+      memcpy(&free_rows_, row, sizeof(float *));
+      return row;
+    }
+    if (slabs_.empty() || next_row_ == rows_per_slab_) {
+      slabs_.emplace_back(new float[row_dim_ * rows_per_slab_]);
+      next_row_ = 0;
+    }
+    return slabs_.back().get() + row_dim_ * next_row_++;
+  }
+
+  void Free(float *row) {
+    --used_rows_;
+    memcpy(row, &free_rows_, sizeof(float *));
+    free_rows_ = row;
+  }
+
+  size_t used_rows() const { return used_rows_; }
+
+  size_t mem_size() const {
+    return slabs_.size() * rows_per_slab_ * row_dim_ * sizeof(float);
+  }
+
+ private:
+  const size_t row_dim_;
+  const size_t rows_per_slab_;
+  size_t next_row_{0};
+  size_t used_rows_{0};
+  float *free_rows_{nullptr};
+  std::vector<std::unique_ptr<float[]>> slabs_;
+};
+
+// FeatureValueSlabs keeps the rows of a bucket in two size classes: rows of
+// the values without their mf part and rows of the values extended to the
+// full value dim, so that a value only takes the floats of its class. Each
+// row has one more float for the header of SlabFeatureValue.
+class FeatureValueSlabs {
+ public:
+  FeatureValueSlabs(size_t value_dim, size_t mf_dim)
+      : value_dim_(value_dim),
+        small_dim_(value_dim - mf_dim),
+        small_(value_dim - mf_dim + 1),
+        full_(value_dim + 1) {}
+
+  size_t value_dim() const { return value_dim_; }
+  // the capacity of the rows holding values of size floats
+  size_t row_capacity(size_t size) const {
+    return size <= small_dim_ ? small_dim_ : value_dim_;
+  }
+  float *Alloc(size_t capacity) {
+    return capacity == small_dim_ ? small_.Alloc() : full_.Alloc();
+  }
+  void Free(float *row, size_t capacity) {
+    if (capacity == small_dim_) {
+      small_.Free(row);
+    } else {
+      full_.Free(row);
+    }
+  }
+
+  size_t mem_size() const { return small_.mem_size() + full_.mem_size(); }
+
+ private:
+  const size_t value_dim_;
+  const size_t small_dim_;
+  FeatureValueSlab small_;
+  FeatureValueSlab full_;
+};
+
+// A feature value living in a row of FeatureValueSlabs. The first float of
+// the row holds the used size and the capacity of the row, the data follows.
+// It exposes the same data()/size()/resize() interface as FixedFeatureValue,
+// operator-> lets the table code treat both of them as pointers. A resize()
+// into the other size class moves the value to a new row, so the pointer
+// returned by data() is only valid until the next resize().
+class SlabFeatureValue {
+ public:
+  SlabFeatureValue() {}
+  explicit SlabFeatureValue(FeatureValueSlabs *slabs) : slabs_(slabs) {
+    size_t capacity = slabs_->row_capacity(0);
+    row_ = slabs_->Alloc(capacity);
+    set_header(0, capacity);
+  }
+
+  float *data() { return row_ + 1; }
+  size_t size() { return header() & 0xFFFF; }
+  size_t capacity() { return header() >> 16; }
+  void resize(size_t size) {
+    PADDLE_ENFORCE_LE(
+        size, slabs_->value_dim(),
+        paddle::platform::errors::OutOfRange(
+            "SlabFeatureValue can hold at most %d floats, but got %d.",
+            slabs_->value_dim(), size));
+    size_t capacity = slabs_->row_capacity(size);
+    if (capacity != this->capacity()) {
+      float *row = slabs_->Alloc(capacity);
+      memcpy(row + 1, data(), std::min(size, this->size()) * sizeof(float));
+      slabs_->Free(row_, this->capacity());
+      row_ = row;
+    }
+    set_header(size, capacity);
+  }
+  void shrink_to_fit() {}
+  // returns the row to the slabs, the value is empty afterwards
+  void release() {
+    slabs_->Free(row_, capacity());
+    row_ = nullptr;
+  }
+
+  float *row() { return row_; }
+  SlabFeatureValue *operator->() { return this; }
+
+ private:
+  uint32_t header() {
+    uint32_t header;
+    memcpy(&header, row_, sizeof(header));
+    return header;
+  }
+  void set_header(size_t size, size_t capacity) {
+    uint32_t header = static_cast<uint32_t>((capacity << 16) | size);
+    memcpy(row_, &header, sizeof(header));
+  }
+
+  float *row_{nullptr};
+  FeatureValueSlabs *slabs_{nullptr};
+};
+
+// SlabSparseTableShard is the slab layout of SparseTableShard: the values of
+// each bucket are rows of the FeatureValueSlabs of the bucket, sized to the
+// value dim without and with the mf_dim floats of the mf part. The hash map
+// holds the values in nodes that never move, so the SlabFeatureValue pointer
+// returned by Init() and GetValue() stays valid until its key is erased.
+class SlabSparseTableShard {
+ public:
+  typedef typename robin_hood::unordered_node_map<uint64_t, SlabFeatureValue>
+      map_type;
+  SlabSparseTableShard(size_t value_dim, size_t mf_dim) {
+    PADDLE_ENFORCE_LT(value_dim, 1 << 16,
+                      paddle::platform::errors::InvalidArgument(
+                          "SlabSparseTableShard supports value dim less than "
+                          "65536, but got %d.",
+                          value_dim));
+    PADDLE_ENFORCE_LE(mf_dim, value_dim,
+                      paddle::platform::errors::InvalidArgument(
+                          "The mf dim %d of SlabSparseTableShard is larger "
+                          "than the value dim %d.",
+                          mf_dim, value_dim));
+    for (size_t i = 0; i < CTR_SPARSE_SHARD_BUCKET_NUM; ++i) {
+      slabs_[i].reset(new FeatureValueSlabs(value_dim, mf_dim));
+    }
+  }
+  ~SlabSparseTableShard() {}
+
+  SlabFeatureValue *Init(const uint64_t &id) {
+    size_t hash = hasher_(id);
+    size_t bucket = compute_bucket(hash);
+    auto &table = values_[bucket];
+
+    auto &value = table[id];
+    if (value.row() == nullptr) {
+      value = SlabFeatureValue(slabs_[bucket].get());
+    }
+    return &value;
+  }
+
+  // dont judge if (has(id))
+  float *Get(const uint64_t &id) {
+    size_t hash = hasher_(id);
+    size_t bucket = compute_bucket(hash);
+    auto &table = values_[bucket];
+
+    auto res = table.find(id);
+    return res->second.data();
+  }
+
+  // for load, to reset count, unseen_days
+  SlabFeatureValue *GetValue(const uint64_t &id) {
+    size_t hash = hasher_(id);
+    size_t bucket = compute_bucket(hash);
+
+    auto &table = values_[bucket];
+    auto res = table.find(id);
+    return &res->second;
+  }
+
+  void erase(uint64_t feasign) {
+    size_t hash = hasher_(feasign);
+    size_t bucket = compute_bucket(hash);
+    auto &table = values_[bucket];
+
+    auto iter = table.find(feasign);
+    if (iter != table.end()) {
+      erase(bucket, iter);
+    }
+  }
+
+  map_type::iterator erase(size_t bucket, map_type::iterator iter) {
+    iter->second.release();
+    return values_[bucket].erase(iter);
+  }
+
+  void clear() {}
+
+  size_t compute_bucket(size_t hash) {
+    if (CTR_SPARSE_SHARD_BUCKET_NUM == 1) {
+      return 0;
+    } else {
+      return hash >> (sizeof(size_t) * 8 - CTR_SPARSE_SHARD_BUCKET_NUM_BITS);
+    }
+  }
+
+  map_type::iterator end() {
+    return values_[CTR_SPARSE_SHARD_BUCKET_NUM - 1].end();
+  }
+
+  map_type::iterator Find(uint64_t id) {
+    size_t hash = hasher_(id);
+    size_t bucket = compute_bucket(hash);
+    auto &table = values_[bucket];
+
+    auto got = table.find(id);
+    if (got == table.end()) {
+      return end();
+    } else {
+      return got;
+    }
+  }
+
+  // bytes held by the slabs, including the free rows
+  size_t slab_mem_size() const {
+    size_t mem_size = 0;
+    for (auto &slab : slabs_) {
+      mem_size += slab->mem_size();
+    }
+    return mem_size;
+  }
+
+ public:
+  map_type values_[CTR_SPARSE_SHARD_BUCKET_NUM];
+  std::hash<uint64_t> hasher_;
+
+ private:
+  std::unique_ptr<FeatureValueSlabs> slabs_[CTR_SPARSE_SHARD_BUCKET_NUM];
+};
+
 }  // namespace distributed
 }  // namespace paddle
@@ -0,0 +1,279 @@
+// Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "glog/logging.h"
+
+// Binary shard file of a sparse table:
+//
+//   SparseBinaryFileHeader
+//   record_num records of sparse_binary_record_size(value_dim) bytes:
+//     uint64_t key, uint32_t value_size, float value[value_dim], padding
+//   optional index of bucket_num + 1 uint64_t: the records of shard bucket b
+//     are [index[b], index[b + 1])
+//
+// All fields are stored in host byte order, records are 8-byte aligned so
+// that a mapped file can be read in place.
+
+namespace paddle {
+namespace distributed {
+
+static const char SPARSE_BINARY_FILE_MAGIC[8] = {'P', 'D', 'S', 'P',
+                                                 'B', 'I', 'N', '\0'};
+static const uint32_t SPARSE_BINARY_FILE_VERSION = 1;
+static const char SPARSE_BINARY_FILE_SUFFIX[] = ".bin";
+
+struct SparseBinaryFileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t value_dim;  // floats reserved for each value
+  uint32_t fea_dim;    // accessor dims, checked on load
+  uint32_t embedx_dim;
+  uint32_t bucket_num;  // 0 if the file has no index
+  uint32_t reserved;
+  uint64_t record_num;
+};
+
+inline size_t sparse_binary_record_size(size_t value_dim) {
+  size_t size = sizeof(uint64_t) + sizeof(uint32_t) + value_dim * sizeof(float);
+  return (size + 7) / 8 * 8;
+}
+
+inline void init_sparse_binary_header(SparseBinaryFileHeader* header,
+                                      uint32_t value_dim, uint32_t fea_dim,
+                                      uint32_t embedx_dim) {
+  memset(header, 0, sizeof(SparseBinaryFileHeader));
+  memcpy(header->magic, SPARSE_BINARY_FILE_MAGIC, sizeof(header->magic));
+  header->version = SPARSE_BINARY_FILE_VERSION;
+  header->value_dim = value_dim;
+  header->fea_dim = fea_dim;
+  header->embedx_dim = embedx_dim;
+}
+
+inline bool is_sparse_binary_header(const SparseBinaryFileHeader& header) {
+  return memcmp(header.magic, SPARSE_BINARY_FILE_MAGIC,
+                sizeof(header.magic)) == 0 &&
+         header.version == SPARSE_BINARY_FILE_VERSION;
+}
+
+// part-000-00000.bin or part-000-00000.bin.gz
+inline bool is_sparse_binary_path(const std::string& path) {
+  auto pos = path.rfind(SPARSE_BINARY_FILE_SUFFIX);
+  if (pos == std::string::npos) {
+    return false;
+  }
+  auto tail = path.substr(pos + strlen(SPARSE_BINARY_FILE_SUFFIX));
+  return tail.empty() || tail == ".gz";
+}
+
+// Writes a binary shard file through write_fn, which returns 0 on success.
+// The number of records must be known before the first one is written, so
+// that the file can be produced through a pipe (e.g. afs with converter).
+class SparseBinaryFileWriter {
+ public:
+  typedef std::function<int(const char* data, size_t size)> WriteFunc;
+
+  SparseBinaryFileWriter(const SparseBinaryFileHeader& header,
+                         WriteFunc write_fn)
+      : header_(header),
+        write_fn_(std::move(write_fn)),
+        record_(sparse_binary_record_size(header.value_dim), 0) {}
+
+  int write_header() {
+    return write_fn_(reinterpret_cast<const char*>(&header_),
+                     sizeof(header_));
+  }
+
+  int write_record(uint64_t key, const float* value, uint32_t value_size) {
+    if (value_size > header_.value_dim) {
+      LOG(ERROR) << "sparse binary file value size " << value_size
+                 << " exceeds value dim " << header_.value_dim;
+      return -1;
+    }
+    char* record = &record_[0];
+    memcpy(record, &key, sizeof(key));
+    memcpy(record + sizeof(key), &value_size, sizeof(value_size));
+    memcpy(record + sizeof(key) + sizeof(value_size), value,
+           value_size * sizeof(float));
+    ++written_num_;
+    return write_fn_(record, record_.size());
+  }
+
+  // bucket_offsets has bucket_num + 1 entries
+  int write_index(const std::vector<uint64_t>& bucket_offsets) {
+    return write_fn_(reinterpret_cast<const char*>(bucket_offsets.data()),
+                     bucket_offsets.size() * sizeof(uint64_t));
+  }
+
+  uint64_t written_num() const { return written_num_; }
+
+ private:
+  SparseBinaryFileHeader header_;
+  WriteFunc write_fn_;
+  std::string record_;
+  uint64_t written_num_{0};
+};
+
+// Reads a binary shard file record by record through read_fn, which fills
+// exactly size bytes and returns 0, or returns -1 at end of file or error.
+class SparseBinaryFileReader {
+ public:
+  typedef std::function<int(char* data, size_t size)> ReadFunc;
+
+  explicit SparseBinaryFileReader(ReadFunc read_fn)
+      : read_fn_(std::move(read_fn)) {}
+
+  int read_header() {
+    if (read_fn_(reinterpret_cast<char*>(&header_), sizeof(header_)) != 0 ||
+        !is_sparse_binary_header(header_)) {
+      LOG(ERROR) << "not a sparse binary file";
+      return -1;
+    }
+    record_.resize(sparse_binary_record_size(header_.value_dim));
+    return 0;
+  }
+
+  // returns -1 after the last record
+  int read_record(uint64_t* key, const float** value, uint32_t* value_size) {
+    if (read_num_ == header_.record_num ||
+        read_fn_(&record_[0], record_.size()) != 0) {
+      return -1;
+    }
+    ++read_num_;
+    memcpy(key, record_.data(), sizeof(uint64_t));
+    memcpy(value_size, record_.data() + sizeof(uint64_t), sizeof(uint32_t));
+    *value = reinterpret_cast<const float*>(record_.data() + sizeof(uint64_t) +
+                                            sizeof(uint32_t));
+    return 0;
+  }
+
+  const SparseBinaryFileHeader& header() const { return header_; }
+
+ private:
+  ReadFunc read_fn_;
+  SparseBinaryFileHeader header_;
+  std::string record_;
+  uint64_t read_num_{0};
+};
+
+// Maps a local binary shard file read-only, records are accessed in place.
+class SparseBinaryFileMapping {
+ public:
+  SparseBinaryFileMapping() {}
+  ~SparseBinaryFileMapping() { close(); }
+
+  SparseBinaryFileMapping(const SparseBinaryFileMapping&) = delete;
+  SparseBinaryFileMapping& operator=(const SparseBinaryFileMapping&) = delete;
+
+  int open(const std::string& path) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      LOG(ERROR) << "open sparse binary file failed, path: " << path;
+      return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 ||
+        static_cast<size_t>(st.st_size) < sizeof(SparseBinaryFileHeader)) {
+      ::close(fd);
+      LOG(ERROR) << "sparse binary file is too small, path: " << path;
+      return -1;
+    }
+    size_ = st.st_size;
+    void* addr = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+      LOG(ERROR) << "mmap sparse binary file failed, path: " << path;
+      size_ = 0;
+      return -1;
+    }
+    data_ = reinterpret_cast<const char*>(addr);
+    madvise(addr, size_, MADV_SEQUENTIAL);
+
+    memcpy(&header_, data_, sizeof(header_));
+    record_size_ = sparse_binary_record_size(header_.value_dim);
+    size_t expect_size = sizeof(header_) + header_.record_num * record_size_;
+    if (header_.bucket_num > 0) {
+      expect_size += (header_.bucket_num + 1) * sizeof(uint64_t);
+    }
+    if (!is_sparse_binary_header(header_) || expect_size != size_) {
+      LOG(ERROR) << "broken sparse binary file, path: " << path;
+      close();
+      return -1;
+    }
+    return 0;
+  }
+
+  void close() {
+    if (data_ != nullptr) {
+      munmap(const_cast<char*>(data_), size_);
+      data_ = nullptr;
+      size_ = 0;
+    }
+  }
+
+  const SparseBinaryFileHeader& header() const { return header_; }
+
+  uint64_t key(size_t i) const {
+    uint64_t key;
+    memcpy(&key, record(i), sizeof(key));
+    return key;
+  }
+
+  uint32_t value_size(size_t i) const {
+    uint32_t value_size;
+    memcpy(&value_size, record(i) + sizeof(uint64_t), sizeof(value_size));
+    return value_size;
+  }
+
+  const float* value(size_t i) const {
+    return reinterpret_cast<const float*>(record(i) + sizeof(uint64_t) +
+                                          sizeof(uint32_t));
+  }
+
+  bool has_index() const { return header_.bucket_num > 0; }
+
+  // records [first, second) were saved from the given shard bucket
+  std::pair<uint64_t, uint64_t> bucket_range(size_t bucket) const {
+    const char* index =
+        data_ + sizeof(header_) + header_.record_num * record_size_;
+    uint64_t range[2];
+    memcpy(range, index + bucket * sizeof(uint64_t), sizeof(range));
+    return {range[0], range[1]};
+  }
+
+ private:
+  const char* record(size_t i) const {
+    return data_ + sizeof(header_) + i * record_size_;
+  }
+
+  const char* data_{nullptr};
+  size_t size_{0};
+  size_t record_size_{0};
+  SparseBinaryFileHeader header_;
+};
+
+}  // namespace distributed
+}  // namespace paddle
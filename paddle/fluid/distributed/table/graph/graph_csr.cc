@@ -0,0 +1,204 @@
+// Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/distributed/table/graph/graph_csr.h"
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+namespace paddle {
+namespace distributed {
+
+void GraphCSR::build(const std::vector<Node *> &bucket, bool is_weighted) {
+  clear();
+  is_weighted_ = is_weighted;
+  node_ids_.resize(bucket.size());
+  offsets_.resize(bucket.size() + 1);
+  offsets_[0] = 0;
+  for (size_t i = 0; i < bucket.size(); i++) {
+    node_ids_[i] = bucket[i]->get_id();
+    offsets_[i + 1] = offsets_[i] + bucket[i]->get_neighbor_size();
+  }
+  neighbors_.resize(offsets_.back());
+  if (is_weighted_) {
+    weights_.resize(offsets_.back());
+    alias_prob_.resize(offsets_.back());
+    alias_idx_.resize(offsets_.back());
+  }
+  for (size_t i = 0; i < bucket.size(); i++) {
+    int degree = this->degree(i);
+    for (int j = 0; j < degree; j++) {
+      neighbors_[offsets_[i] + j] = bucket[i]->get_neighbor_id(j);
+      if (is_weighted_) {
+        weights_[offsets_[i] + j] = bucket[i]->get_neighbor_weight(j);
+      }
+    }
+    if (is_weighted_) {
+      build_alias(i);
+    }
+  }
+}
+
+void GraphCSR::clear() {
+  // swap to release the memory, clear() keeps the capacity
+  std::vector<uint64_t>().swap(node_ids_);
+  std::vector<uint64_t>().swap(offsets_);
+  std::vector<uint64_t>().swap(neighbors_);
+  std::vector<float>().swap(weights_);
+  std::vector<float>().swap(alias_prob_);
+  std::vector<uint32_t>().swap(alias_idx_);
+}
+
+size_t GraphCSR::mem_size() const {
+  return (node_ids_.capacity() + offsets_.capacity() + neighbors_.capacity()) *
+             sizeof(uint64_t) +
+         (weights_.capacity() + alias_prob_.capacity()) * sizeof(float) +
+         alias_idx_.capacity() * sizeof(uint32_t);
+}
+
+// Vose's alias method, column j keeps j with probability alias_prob_[j] and
+// alias_idx_[j] otherwise.
+void GraphCSR::build_alias(size_t row) {
+  int n = degree(row);
+  if (n == 0) return;
+  const float *weight = weights_.data() + offsets_[row];
+  float *prob = alias_prob_.data() + offsets_[row];
+  uint32_t *alias = alias_idx_.data() + offsets_[row];
+
+  double sum = 0;
+  for (int i = 0; i < n; i++) sum += weight[i];
+  std::vector<double> scaled(n);
+  std::vector<uint32_t> small, large;
+  for (int i = 0; i < n; i++) {
+    scaled[i] = sum > 0 ? weight[i] * n / sum : 1.;
+    alias[i] = i;
+    if (scaled[i] < 1.) {
+      small.push_back(i);
+    } else {
+      large.push_back(i);
+    }
+  }
+  while (!small.empty() && !large.empty()) {
+    uint32_t s = small.back(), l = large.back();
+    small.pop_back();
+    prob[s] = scaled[s];
+    alias[s] = l;
+    scaled[l] -= 1. - scaled[s];
+    if (scaled[l] < 1.) {
+      large.pop_back();
+      small.push_back(l);
+    }
+  }
+  // the rest are 1 up to rounding errors
+  for (auto i : small) prob[i] = 1.;
+  for (auto i : large) prob[i] = 1.;
+}
+
+std::vector<int> GraphCSR::sample_k(
+    size_t row, int k, const std::shared_ptr<std::mt19937_64> rng) const {
+  int n = degree(row);
+  if (k >= n) {
+    std::vector<int> sample_result(n);
+    for (int i = 0; i < n; i++) sample_result[i] = i;
+    return sample_result;
+  }
+  return is_weighted_ ? weighted_sample_k(row, k, rng)
+                      : random_sample_k(row, k, rng);
+}
+
+std::vector<int> GraphCSR::random_sample_k(
+    size_t row, int k, const std::shared_ptr<std::mt19937_64> rng) const {
+  int n = degree(row);
+  std::vector<int> sample_result;
+  sample_result.reserve(k);
+  if (k <= 32 && k * 2 <= n) {
+    std::uniform_int_distribution<int> column_distrib(0, n - 1);
+    // few duplicates are drawn, rejecting them beats the map below
+    while (static_cast<int>(sample_result.size()) < k) {
+      int rand_int = column_distrib(*rng);
+      if (std::find(sample_result.begin(), sample_result.end(), rand_int) ==
+          sample_result.end()) {
+        sample_result.push_back(rand_int);
+      }
+    }
+    return sample_result;
+  }
+  // partial Fisher-Yates over a virtual index array, as RandomSampler
+  std::unordered_map<int, int> replace_map;
+  while (k--) {
+    std::uniform_int_distribution<int> distrib(0, n - 1);
+    int rand_int = distrib(*rng);
+    auto iter = replace_map.find(rand_int);
+    sample_result.push_back(iter == replace_map.end() ? rand_int
+                                                      : iter->second);
+    iter = replace_map.find(n - 1);
+    replace_map[rand_int] = iter == replace_map.end() ? n - 1 : iter->second;
+    --n;
+  }
+  return sample_result;
+}
+
+std::vector<int> GraphCSR::weighted_sample_k(
+    size_t row, int k, const std::shared_ptr<std::mt19937_64> rng) const {
+  // Sampling without replacement as WeightedSampler does: every pick is
+  // proportional to the weight left. An alias draw that hits a picked
+  // neighbor is rejected, which keeps that distribution; after a few
+  // rejections in a row the pick scans the remaining weights instead.
+  const int max_reject = 8;
+  int n = degree(row);
+  const float *weight = weights_.data() + offsets_[row];
+  const float *prob = alias_prob_.data() + offsets_[row];
+  const uint32_t *alias = alias_idx_.data() + offsets_[row];
+
+  std::vector<int> sample_result;
+  sample_result.reserve(k);
+  std::unordered_set<int> picked;
+  // a linear search is cheaper than hashing for the usual small k
+  bool use_set = k > 32;
+  auto is_picked = [&](int idx) {
+    if (use_set) return picked.count(idx) > 0;
+    return std::find(sample_result.begin(), sample_result.end(), idx) !=
+           sample_result.end();
+  };
+  std::uniform_int_distribution<int> column_distrib(0, n - 1);
+  std::uniform_real_distribution<float> distrib(0, 1.0);
+  while (static_cast<int>(sample_result.size()) < k) {
+    int idx = -1;
+    for (int t = 0; t < max_reject; t++) {
+      int column = column_distrib(*rng);
+      int candidate = distrib(*rng) < prob[column] ? column : alias[column];
+      if (!is_picked(candidate)) {
+        idx = candidate;
+        break;
+      }
+    }
+    if (idx < 0) {
+      double left = 0;
+      for (int i = 0; i < n; i++) {
+        if (!is_picked(i)) left += weight[i];
+      }
+      double query_weight = distrib(*rng) * left;
+      for (int i = 0; i < n; i++) {
+        if (is_picked(i)) continue;
+        idx = i;
+        query_weight -= weight[i];
+        if (query_weight < 0) break;
+      }
+    }
+    sample_result.push_back(idx);
+    if (use_set) picked.insert(idx);
+  }
+  return sample_result;
+}
+}  // namespace distributed
+}  // namespace paddle
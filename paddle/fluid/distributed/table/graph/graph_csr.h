@@ -0,0 +1,76 @@
+// Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <vector>
+#include "paddle/fluid/distributed/table/graph/graph_node.h"
+namespace paddle {
+namespace distributed {
+
+// Immutable CSR copy of the edges of a GraphShard. Row i holds the
+// neighbors of the i-th node of the shard bucket, so that a node is found
+// through the node_location of the shard. Weighted rows carry a Walker
+// alias table for O(1) draws.
+class GraphCSR {
+ public:
+  GraphCSR() {}
+  ~GraphCSR() {}
+
+  void build(const std::vector<Node *> &bucket, bool is_weighted);
+  void clear();
+
+  bool is_weighted() const { return is_weighted_; }
+  size_t node_num() const { return node_ids_.size(); }
+  size_t edge_num() const { return neighbors_.size(); }
+  size_t mem_size() const;
+
+  uint64_t node_id(size_t row) const { return node_ids_[row]; }
+  const uint64_t *node_ids() const { return node_ids_.data(); }
+  int degree(size_t row) const {
+    return static_cast<int>(offsets_[row + 1] - offsets_[row]);
+  }
+  uint64_t get_neighbor_id(size_t row, int idx) const {
+    return neighbors_[offsets_[row] + idx];
+  }
+  float get_neighbor_weight(size_t row, int idx) const {
+    return is_weighted_ ? weights_[offsets_[row] + idx] : 1.;
+  }
+
+  // returns k distinct neighbor indices of the row, same as
+  // Sampler::sample_k of the node
+  std::vector<int> sample_k(size_t row, int k,
+                            const std::shared_ptr<std::mt19937_64> rng) const;
+
+ private:
+  void build_alias(size_t row);
+  std::vector<int> random_sample_k(
+      size_t row, int k, const std::shared_ptr<std::mt19937_64> rng) const;
+  std::vector<int> weighted_sample_k(
+      size_t row, int k, const std::shared_ptr<std::mt19937_64> rng) const;
+
+  bool is_weighted_ = false;
+  std::vector<uint64_t> node_ids_;
+  std::vector<uint64_t> offsets_;
+  std::vector<uint64_t> neighbors_;
+  std::vector<float> weights_;
+  // alias table, indices are local to the row
+  std::vector<float> alias_prob_;
+  std::vector<uint32_t> alias_idx_;
+};
+}  // namespace distributed
+}  // namespace paddle
@@ -17,7 +17,9 @@
 namespace paddle {
 namespace distributed {
 
-GraphNode::~GraphNode() {
+GraphNode::~GraphNode() { release_edges(); }
+
+void GraphNode::release_edges() {
   if (sampler != nullptr) {
     delete sampler;
     sampler = nullptr;
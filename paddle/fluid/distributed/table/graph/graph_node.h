@@ -40,6 +40,9 @@ class Node {
   }
   virtual uint64_t get_neighbor_id(int idx) { return 0; }
   virtual float get_neighbor_weight(int idx) { return 1.; }
+  virtual int get_neighbor_size() { return 0; }
+  // drops the edges and the sampler once they are copied to a GraphCSR
+  virtual void release_edges() {}
 
   virtual int get_size(bool need_feature);
   virtual void to_buffer(char *buffer, bool need_feature);
@@ -70,6 +73,10 @@ class GraphNode : public Node {
   }
   virtual uint64_t get_neighbor_id(int idx) { return edges->get_id(idx); }
   virtual float get_neighbor_weight(int idx) { return edges->get_weight(idx); }
+  virtual int get_neighbor_size() {
+    return edges == nullptr ? 0 : edges->size();
+  }
+  virtual void release_edges();
 
  protected:
   Sampler *sampler;
@@ -82,6 +82,13 @@ void WeightedSampler::build(GraphEdgeBlob *edges) {
     delete right;
     right = nullptr;
   }
+  // a node without neighbors samples nothing
+  if (edges->size() == 0) {
+    this->edges = edges;
+    count = 0;
+    weight = 0;
+    return;
+  }
   return build_one((WeightedGraphEdgeBlob *)edges, 0, edges->size());
 }
 
@@ -29,7 +29,11 @@ bool FLAGS_pslib_create_value_when_push = false;
 int FLAGS_pslib_table_save_max_retry = 3;
 bool FLAGS_pslib_enable_create_feasign_randomly = false;
 
-int32_t MemorySparseTable::initialize() {
+// the number of values a push_sparse shard task updates at once
+static const size_t kPushSparseBatchNum = 64;
+
+template <typename ShardType>
+int32_t MemorySparseTableBase<ShardType>::initialize() {
   shards_task_pool_.resize(task_pool_size_);
   for (int i = 0; i < shards_task_pool_.size(); ++i) {
     shards_task_pool_[i].reset(new ::ThreadPool(1));
@@ -39,7 +43,8 @@ int32_t MemorySparseTable::initialize() {
   return 0;
 }
 
-int32_t MemorySparseTable::initialize_value() {
+template <typename ShardType>
+int32_t MemorySparseTableBase<ShardType>::initialize_value() {
   sparse_table_shard_num_ = static_cast<int>(_config.shard_num());
   avg_local_shard_num_ =
       SparseTable::sparse_local_shard_num(sparse_table_shard_num_, _shard_num);
@@ -57,14 +62,15 @@ int32_t MemorySparseTable::initialize_value() {
   shard_values_.reserve(real_local_shard_num_);
 
   for (int x = 0; x < real_local_shard_num_; ++x) {
-    auto shard = std::make_shared<SparseTableShard>();
+    auto shard = create_shard();
     shard_values_.emplace_back(shard);
   }
   return 0;
 }
 
-int32_t MemorySparseTable::load(const std::string& path,
-                                const std::string& param) {
+template <typename ShardType>
+int32_t MemorySparseTableBase<ShardType>::load(const std::string& path,
+                                                const std::string& param) {
   std::string table_path = table_dir(path);
   auto file_list = _afs_client.list(table_path);
 
@@ -97,6 +103,7 @@ int32_t MemorySparseTable::load(const std::string& path,
     channel_config.path = file_list[file_start_idx + i];
     VLOG(1) << "MemorySparseTable::load begin load " << channel_config.path
             << " into local shard " << i;
+    bool is_binary = is_sparse_binary_path(channel_config.path);
     channel_config.converter = _value_accesor->converter(load_param).converter;
     channel_config.deconverter =
         _value_accesor->converter(load_param).deconverter;
@@ -112,19 +119,30 @@ int32_t MemorySparseTable::load(const std::string& path,
       char* end = NULL;
       auto& shard = shard_values_[i];
       try {
-        while (read_channel->read_line(line_data) == 0 &&
-               line_data.size() > 1) {
-          uint64_t key = std::strtoul(line_data.data(), &end, 10);
-          auto* value = shard->Init(key);
-          value->resize(feature_value_size);
-          int parse_size =
-              _value_accesor->parse_from_string(++end, value->data());
-          value->resize(parse_size);
-
-          // for debug
-          for (int ii = 0; ii < parse_size; ++ii) {
-            VLOG(2) << "MemorySparseTable::load key: " << key << " value " << ii
-                    << ": " << value->data()[ii] << " local_shard: " << i;
+        if (is_binary) {
+          SparseBinaryFileReader reader([&read_channel](char* data,
+                                                        size_t size) {
+            return read_channel->read(data, size);
+          });
+          if (load_binary_shard(shard.get(), &reader) != 0) {
+            err_no = -1;
+          }
+        } else {
+          while (read_channel->read_line(line_data) == 0 &&
+                 line_data.size() > 1) {
+            uint64_t key = std::strtoul(line_data.data(), &end, 10);
+            auto* value = shard->Init(key);
+            value->resize(feature_value_size);
+            int parse_size =
+                _value_accesor->parse_from_string(++end, value->data());
+            value->resize(parse_size);
+
+            // for debug
+            for (int ii = 0; ii < parse_size; ++ii) {
+              VLOG(2) << "MemorySparseTable::load key: " << key << " value "
+                      << ii << ": " << value->data()[ii]
+                      << " local_shard: " << i;
+            }
           }
         }
         read_channel->close();
@@ -153,10 +171,12 @@ int32_t MemorySparseTable::load(const std::string& path,
   return 0;
 }
 
-int32_t MemorySparseTable::load_local_fs(const std::string& path,
-                                         const std::string& param) {
+template <typename ShardType>
+int32_t MemorySparseTableBase<ShardType>::load_local_fs(
+    const std::string& path, const std::string& param) {
   std::string table_path = table_dir(path);
   auto file_list = paddle::framework::localfs_list(table_path);
+  std::sort(file_list.begin(), file_list.end());
 
   int load_param = atoi(param.c_str());
   auto expect_shard_num = sparse_table_shard_num_;
@@ -172,6 +192,10 @@ int32_t MemorySparseTable::load_local_fs(const std::string& path,
 
   size_t file_start_idx = _shard_idx * avg_local_shard_num_;
 
+  if (is_sparse_binary_path(file_list[file_start_idx])) {
+    return load_local_fs_binary(file_list, file_start_idx);
+  }
+
   size_t feature_value_size = _value_accesor->size() / sizeof(float);
 
   // int thread_num = shard_values_.size() < 15 ? shard_values_.size() : 15;
@@ -225,8 +249,9 @@ int32_t MemorySparseTable::load_local_fs(const std::string& path,
   return 0;
 }
 
-int32_t MemorySparseTable::save(const std::string& dirname,
-                                const std::string& param) {
+template <typename ShardType>
+int32_t MemorySparseTableBase<ShardType>::save(const std::string& dirname,
+                                                const std::string& param) {
   VLOG(0) << "MemorySparseTable::save dirname: " << dirname;
   int save_param =
       atoi(param.c_str());  // checkpoint:0  xbox delta:1  xbox base:2
@@ -241,16 +266,18 @@ int32_t MemorySparseTable::save(const std::string& dirname,
   // TODO(zhaocaibei123): openmp
   // omp_set_num_threads(thread_num);
   // #pragma omp parallel for schedule(dynamic)
+  const char* suffix =
+      _config.save_in_binary() ? SPARSE_BINARY_FILE_SUFFIX : "";
   for (size_t i = 0; i < real_local_shard_num_; ++i) {
     FsChannelConfig channel_config;
     if (_config.compress_in_save() && (save_param == 0 || save_param == 3)) {
       channel_config.path = paddle::string::format_string(
-          "%s/part-%03d-%05d.gz", table_path.c_str(), _shard_idx,
-          file_start_idx + i);
+          "%s/part-%03d-%05d%s.gz", table_path.c_str(), _shard_idx,
+          file_start_idx + i, suffix);
     } else {
-      channel_config.path =
-          paddle::string::format_string("%s/part-%03d-%05d", table_path.c_str(),
-                                        _shard_idx, file_start_idx + i);
+      channel_config.path = paddle::string::format_string(
+          "%s/part-%03d-%05d%s", table_path.c_str(), _shard_idx,
+          file_start_idx + i, suffix);
     }
     channel_config.converter = _value_accesor->converter(save_param).converter;
     channel_config.deconverter =
@@ -266,7 +293,25 @@ int32_t MemorySparseTable::save(const std::string& dirname,
       is_write_failed = false;
       auto write_channel =
           _afs_client.open_w(channel_config, 1024 * 1024 * 40, &err_no);
+      if (_config.save_in_binary()) {
+        auto saved_num = save_binary_shard(
+            shard.get(), save_param,
+            [&write_channel](const char* data, size_t size) {
+              return write_channel->write(data, size);
+            });
+        if (saved_num < 0) {
+          ++retry_num;
+          is_write_failed = true;
+          LOG(ERROR) << "MemorySparseTable save prefix failed, retry it! path:"
+                     << channel_config.path << " , retry_num=" << retry_num;
+        } else {
+          feasign_size = saved_num;
+        }
+      }
       for (auto& table : shard->values_) {
+        if (_config.save_in_binary()) {
+          break;
+        }
         for (auto& value : table) {
           if (_value_accesor->save(value.second->data(), save_param)) {
             std::string format_value = _value_accesor->parse_to_string(
@@ -315,9 +360,10 @@ int32_t MemorySparseTable::save(const std::string& dirname,
   return 0;
 }
 
-int32_t MemorySparseTable::save_local_fs(const std::string& dirname,
-                                         const std::string& param,
-                                         const std::string& prefix) {
+template <typename ShardType>
+int32_t MemorySparseTableBase<ShardType>::save_local_fs(
+    const std::string& dirname, const std::string& param,
+    const std::string& prefix) {
   int save_param =
       atoi(param.c_str());  // checkpoint:0  xbox delta:1  xbox base:2
   std::string table_path = table_dir(dirname);
@@ -329,6 +375,24 @@ int32_t MemorySparseTable::save_local_fs(const std::string& dirname,
     std::string file_name = paddle::string::format_string(
         "%s/part-%s-%03d-%05d", table_path.c_str(), prefix.c_str(), _shard_idx,
         file_start_idx + i);
+    if (_config.save_in_binary()) {
+      file_name += SPARSE_BINARY_FILE_SUFFIX;
+      std::ofstream os(file_name, std::ios::binary);
+      feasign_cnt = save_binary_shard(
+          shard.get(), save_param, [&os](const char* data, size_t size) {
+            os.write(data, size);
+            return os.good() ? 0 : -1;
+          });
+      os.close();
+      if (feasign_cnt < 0) {
+        LOG(ERROR) << "MemorySparseTable save binary failed, path:"
+                   << file_name;
+        return -1;
+      }
+      LOG(INFO) << "MemorySparseTable save prefix success, path:" << file_name
+                << "feasign_cnt: " << feasign_cnt;
+      continue;
+    }
     std::ofstream os;
     os.open(file_name);
     for (auto& table : shard->values_) {
@@ -351,7 +415,142 @@ int32_t MemorySparseTable::save_local_fs(const std::string& dirname,
   return 0;
 }
 
-std::pair<int64_t, int64_t> MemorySparseTable::print_table_stat() {
+template <typename ShardType>
+bool MemorySparseTableBase<ShardType>::check_binary_header(
+    const SparseBinaryFileHeader& header) {
+  size_t value_dim = _value_accesor->size() / sizeof(float);
+  if (header.value_dim != value_dim ||
+      header.embedx_dim != _config.accessor().embedx_dim()) {
+    LOG(ERROR) << "MemorySparseTable binary file has value dim "
+               << header.value_dim << " embedx dim " << header.embedx_dim
+               << ", but the accessor has value dim " << value_dim
+               << " embedx dim " << _config.accessor().embedx_dim();
+    return false;
+  }
+  return true;
+}
+
+template <typename ShardType>
+int64_t MemorySparseTableBase<ShardType>::save_binary_shard(
+    ShardType* shard, int save_param,
+    SparseBinaryFileWriter::WriteFunc write_fn) {
+  // the records are grouped by bucket, the counting pass gives both the
+  // record number of the header and the bucket index
+  std::vector<uint64_t> bucket_offsets(CTR_SPARSE_SHARD_BUCKET_NUM + 1, 0);
+  for (size_t bucket = 0; bucket < CTR_SPARSE_SHARD_BUCKET_NUM; ++bucket) {
+    uint64_t bucket_size = 0;
+    for (auto& value : shard->values_[bucket]) {
+      if (_value_accesor->save(value.second->data(), save_param)) {
+        ++bucket_size;
+      }
+    }
+    bucket_offsets[bucket + 1] = bucket_offsets[bucket] + bucket_size;
+  }
+
+  SparseBinaryFileHeader header;
+  init_sparse_binary_header(&header, _value_accesor->size() / sizeof(float),
+                            _value_accesor->fea_dim(),
+                            _config.accessor().embedx_dim());
+  header.bucket_num = CTR_SPARSE_SHARD_BUCKET_NUM;
+  header.record_num = bucket_offsets.back();
+
+  SparseBinaryFileWriter writer(header, std::move(write_fn));
+  if (writer.write_header() != 0) {
+    return -1;
+  }
+  for (auto& table : shard->values_) {
+    for (auto& value : table) {
+      if (_value_accesor->save(value.second->data(), save_param)) {
+        if (writer.write_record(value.first, value.second->data(),
+                                value.second->size()) != 0) {
+          return -1;
+        }
+      }
+    }
+  }
+  if (writer.write_index(bucket_offsets) != 0) {
+    return -1;
+  }
+  return writer.written_num();
+}
+
+template <typename ShardType>
+int32_t MemorySparseTableBase<ShardType>::load_binary_shard(
+    ShardType* shard, SparseBinaryFileReader* reader) {
+  if (reader->read_header() != 0 || !check_binary_header(reader->header())) {
+    return -1;
+  }
+  uint64_t key = 0;
+  const float* data = nullptr;
+  uint32_t data_size = 0;
+  while (reader->read_record(&key, &data, &data_size) == 0) {
+    auto* value = shard->Init(key);
+    value->resize(data_size);
+    memcpy(value->data(), data, data_size * sizeof(float));
+  }
+  return 0;
+}
+
+template <typename ShardType>
+int32_t MemorySparseTableBase<ShardType>::load_binary_shard(
+    ShardType* shard, const SparseBinaryFileMapping& file) {
+  auto& header = file.header();
+  if (!check_binary_header(header)) {
+    return -1;
+  }
+  // the buckets of the saving shard are the buckets here, size them once
+  if (file.has_index() && header.bucket_num == CTR_SPARSE_SHARD_BUCKET_NUM) {
+    for (size_t bucket = 0; bucket < CTR_SPARSE_SHARD_BUCKET_NUM; ++bucket) {
+      auto range = file.bucket_range(bucket);
+      auto& table = shard->values_[bucket];
+      table.reserve(table.size() + range.second - range.first);
+    }
+  }
+  for (uint64_t i = 0; i < header.record_num; ++i) {
+    auto data_size = file.value_size(i);
+    auto* value = shard->Init(file.key(i));
+    value->resize(data_size);
+    memcpy(value->data(), file.value(i), data_size * sizeof(float));
+  }
+  return 0;
+}
+
+template <typename ShardType>
+int32_t MemorySparseTableBase<ShardType>::load_local_fs_binary(
+    const std::vector<std::string>& file_list, size_t file_start_idx) {
+  // one task per shard, each maps its own file
+  std::vector<std::future<int>> tasks(real_local_shard_num_);
+  for (size_t i = 0; i < real_local_shard_num_; ++i) {
+    tasks[i] = shards_task_pool_[i % task_pool_size_]->enqueue(
+        [this, i, &file_list, file_start_idx]() -> int {
+          SparseBinaryFileMapping file;
+          const auto& path = file_list[file_start_idx + i];
+          if (file.open(path) != 0 ||
+              load_binary_shard(shard_values_[i].get(), file) != 0) {
+            LOG(ERROR) << "MemorySparseTable load binary failed, path:"
+                       << path;
+            return -1;
+          }
+          return 0;
+        });
+  }
+  int32_t ret = 0;
+  for (auto& task : tasks) {
+    if (task.get() != 0) {
+      ret = -1;
+    }
+  }
+  if (ret == 0) {
+    LOG(INFO) << "MemorySparseTable load success, path from "
+              << file_list[file_start_idx] << " to "
+              << file_list[file_start_idx + real_local_shard_num_ - 1];
+  }
+  return ret;
+}
+
+template <typename ShardType>
+std::pair<int64_t, int64_t>
+MemorySparseTableBase<ShardType>::print_table_stat() {
   int64_t feasign_size = 0;
   int64_t mf_size = 0;
 
@@ -364,8 +563,9 @@ std::pair<int64_t, int64_t> MemorySparseTable::print_table_stat() {
   return {feasign_size, mf_size};
 }
 
-int32_t MemorySparseTable::pull_sparse(float* pull_values,
-                                       const PullSparseValue& pull_value) {
+template <typename ShardType>
+int32_t MemorySparseTableBase<ShardType>::pull_sparse(
+    float* pull_values, const PullSparseValue& pull_value) {
   std::vector<std::future<int>> tasks(real_local_shard_num_);
 
   const size_t value_size = _value_accesor->size() / sizeof(float);
@@ -432,13 +632,17 @@ int32_t MemorySparseTable::pull_sparse(float* pull_values,
   return 0;
 }
 
-int32_t MemorySparseTable::pull_sparse_ptr(char** pull_values,
-                                           const uint64_t* keys, size_t num) {
+template <typename ShardType>
+int32_t MemorySparseTableBase<ShardType>::pull_sparse_ptr(char** pull_values,
+                                                           const uint64_t* keys,
+                                                           size_t num) {
   return 0;
 }
 
-int32_t MemorySparseTable::push_sparse(const uint64_t* keys,
-                                       const float* values, size_t num) {
+template <typename ShardType>
+int32_t MemorySparseTableBase<ShardType>::push_sparse(const uint64_t* keys,
+                                                       const float* values,
+                                                       size_t num) {
   std::vector<std::future<int>> tasks(real_local_shard_num_);
   std::vector<std::vector<std::pair<uint64_t, int>>> task_keys(
       real_local_shard_num_);
@@ -459,6 +663,18 @@ int32_t MemorySparseTable::push_sparse(const uint64_t* keys,
           auto& local_shard = shard_values_[shard_id];
           float data_buffer[value_col];  // NOLINT
           float* data_buffer_ptr = data_buffer;
+          // the values extended to the full size are updated in place by
+          // batches, which the sgd rules run vectorized
+          std::vector<float*> batch_values;
+          std::vector<const float*> batch_updates;
+          batch_values.reserve(kPushSparseBatchNum);
+          batch_updates.reserve(kPushSparseBatchNum);
+          auto update_batch = [&]() {
+            _value_accesor->update(batch_values.data(), batch_updates.data(),
+                                   batch_values.size());
+            batch_values.clear();
+            batch_updates.clear();
+          };
 
           for (int i = 0; i < keys.size(); ++i) {
             uint64_t key = keys[i].first;
@@ -483,12 +699,16 @@ int32_t MemorySparseTable::push_sparse(const uint64_t* keys,
               VLOG(2) << "sparse table debug push_sparse: " << key << " found!";
             }
 
-            auto* feature_value = itr->second;
+            auto& feature_value = itr->second;
             float* value_data = feature_value->data();
             size_t value_size = feature_value->size();
 
             if (value_size == value_col) {  // 已拓展到最大size, 则就地update
-              _value_accesor->update(&value_data, &update_data, 1);
+              batch_values.push_back(value_data);
+              batch_updates.push_back(update_data);
+              if (batch_values.size() == kPushSparseBatchNum) {
+                update_batch();
+              }
             } else {
               // 拷入buffer区进行update，然后再回填，不需要的mf则回填时抛弃了
               memcpy(data_buffer_ptr, value_data, value_size * sizeof(float));
@@ -502,6 +722,9 @@ int32_t MemorySparseTable::push_sparse(const uint64_t* keys,
               memcpy(value_data, data_buffer_ptr, value_size * sizeof(float));
             }
           }
+          if (!batch_values.empty()) {
+            update_batch();
+          }
           return 0;
         });
   }
@@ -512,14 +735,18 @@ int32_t MemorySparseTable::push_sparse(const uint64_t* keys,
   return 0;
 }
 
-int32_t MemorySparseTable::push_sparse(const uint64_t* keys,
-                                       const float** values, size_t num) {
+template <typename ShardType>
+int32_t MemorySparseTableBase<ShardType>::push_sparse(const uint64_t* keys,
+                                                       const float** values,
+                                                       size_t num) {
   _push_sparse(keys, values, num);
   return 0;
 }
 
-int32_t MemorySparseTable::_push_sparse(const uint64_t* keys,
-                                        const float** values, size_t num) {
+template <typename ShardType>
+int32_t MemorySparseTableBase<ShardType>::_push_sparse(const uint64_t* keys,
+                                                        const float** values,
+                                                        size_t num) {
   std::vector<std::future<int>> tasks(real_local_shard_num_);
   std::vector<std::vector<std::pair<uint64_t, int>>> task_keys(
       real_local_shard_num_);
@@ -540,6 +767,18 @@ int32_t MemorySparseTable::_push_sparse(const uint64_t* keys,
           auto& local_shard = shard_values_[shard_id];
           float data_buffer[value_col];  // NOLINT
           float* data_buffer_ptr = data_buffer;
+          // the values extended to the full size are updated in place by
+          // batches, which the sgd rules run vectorized
+          std::vector<float*> batch_values;
+          std::vector<const float*> batch_updates;
+          batch_values.reserve(kPushSparseBatchNum);
+          batch_updates.reserve(kPushSparseBatchNum);
+          auto update_batch = [&]() {
+            _value_accesor->update(batch_values.data(), batch_updates.data(),
+                                   batch_values.size());
+            batch_values.clear();
+            batch_updates.clear();
+          };
 
           for (int i = 0; i < keys.size(); ++i) {
             uint64_t key = keys[i].first;
@@ -559,11 +798,15 @@ int32_t MemorySparseTable::_push_sparse(const uint64_t* keys,
                      value_size * sizeof(float));
               itr = local_shard->Find(key);
             }
-            auto* feature_value = itr->second;
+            auto& feature_value = itr->second;
             float* value_data = feature_value->data();
             size_t value_size = feature_value->size();
             if (value_size == value_col) {  // 已拓展到最大size, 则就地update
-              _value_accesor->update(&value_data, &update_data, 1);
+              batch_values.push_back(value_data);
+              batch_updates.push_back(update_data);
+              if (batch_values.size() == kPushSparseBatchNum) {
+                update_batch();
+              }
             } else {
               // 拷入buffer区进行update，然后再回填，不需要的mf则回填时抛弃了
               memcpy(data_buffer_ptr, value_data, value_size * sizeof(float));
@@ -576,6 +819,9 @@ int32_t MemorySparseTable::_push_sparse(const uint64_t* keys,
               memcpy(value_data, data_buffer_ptr, value_size * sizeof(float));
             }
           }
+          if (!batch_values.empty()) {
+            update_batch();
+          }
           return 0;
         });
   }
@@ -586,20 +832,22 @@ int32_t MemorySparseTable::_push_sparse(const uint64_t* keys,
   return 0;
 }
 
-int32_t MemorySparseTable::flush() { return 0; }
+template <typename ShardType>
+int32_t MemorySparseTableBase<ShardType>::flush() { return 0; }
 
-int32_t MemorySparseTable::shrink(const std::string& param) {
+template <typename ShardType>
+int32_t MemorySparseTableBase<ShardType>::shrink(const std::string& param) {
   VLOG(0) << "MemorySparseTable::shrink";
   // TODO(zhaocaibei123): implement with multi-thread
   for (int shard_id = 0; shard_id < real_local_shard_num_; ++shard_id) {
     // shrink
     auto& shard = shard_values_[shard_id];
-    for (auto& table : shard->values_) {
+    for (size_t bucket = 0; bucket < CTR_SPARSE_SHARD_BUCKET_NUM; ++bucket) {
+      auto& table = shard->values_[bucket];
       for (auto iter = table.begin(); iter != table.end();) {
         if (_value_accesor->shrink(iter->second->data())) {
-          butil::return_object(iter->second);
-          iter = table.erase(iter);
           VLOG(1) << "shrink erase key: " << iter->first;
+          iter = shard->erase(bucket, iter);
         } else {
           ++iter;
         }
@@ -609,7 +857,24 @@ int32_t MemorySparseTable::shrink(const std::string& param) {
   return 0;
 }
 
-void MemorySparseTable::clear() { VLOG(0) << "clear coming soon"; }
+template <typename ShardType>
+void MemorySparseTableBase<ShardType>::clear() {
+  VLOG(0) << "clear coming soon";
+}
+
+std::pair<int64_t, int64_t> MemorySlabSparseTable::print_table_stat() {
+  auto stat = MemorySparseTableBase<SlabSparseTableShard>::print_table_stat();
+  size_t slab_mem_size = 0;
+  for (auto& shard : shard_values_) {
+    slab_mem_size += shard->slab_mem_size();
+  }
+  VLOG(0) << "MemorySlabSparseTable feasign size: " << stat.first
+          << " slab memory size: " << slab_mem_size;
+  return stat;
+}
+
+template class MemorySparseTableBase<SparseTableShard>;
+template class MemorySparseTableBase<SlabSparseTableShard>;
 
 }  // namespace distributed
 }  // namespace paddle
@@ -27,6 +27,7 @@
 #include "paddle/fluid/distributed/table/accessor.h"
 #include "paddle/fluid/distributed/table/common_table.h"
 #include "paddle/fluid/distributed/table/depends/feature_value.h"
+#include "paddle/fluid/distributed/table/depends/sparse_binary_file.h"
 #include "paddle/fluid/string/string_helper.h"
 
 #define PSERVER_SAVE_SUFFIX ".shard"
@@ -34,10 +35,12 @@
 namespace paddle {
 namespace distributed {
 
-class MemorySparseTable : public SparseTable {
+// ShardType is SparseTableShard or SlabSparseTableShard, see feature_value.h
+template <typename ShardType>
+class MemorySparseTableBase : public SparseTable {
  public:
-  MemorySparseTable() {}
-  virtual ~MemorySparseTable() {}
+  MemorySparseTableBase() {}
+  virtual ~MemorySparseTableBase() {}
 
   // unused method begin
   virtual int32_t pull_dense(float* pull_values, size_t num) { return 0; }
@@ -76,6 +79,18 @@ class MemorySparseTable : public SparseTable {
   virtual void clear();
 
  protected:
+  virtual std::shared_ptr<ShardType> create_shard() = 0;
+
+  // binary shard files, see depends/sparse_binary_file.h
+  int64_t save_binary_shard(ShardType* shard, int save_param,
+                            SparseBinaryFileWriter::WriteFunc write_fn);
+  int32_t load_binary_shard(ShardType* shard, SparseBinaryFileReader* reader);
+  int32_t load_binary_shard(ShardType* shard,
+                            const SparseBinaryFileMapping& file);
+  int32_t load_local_fs_binary(const std::vector<std::string>& file_list,
+                               size_t file_start_idx);
+  bool check_binary_header(const SparseBinaryFileHeader& header);
+
   virtual int32_t _push_sparse(const uint64_t* keys, const float** values,
                                size_t num);
 
@@ -85,7 +100,37 @@ class MemorySparseTable : public SparseTable {
   size_t real_local_shard_num_;
   size_t sparse_table_shard_num_;
   std::vector<std::shared_ptr<::ThreadPool>> shards_task_pool_;
-  std::vector<std::shared_ptr<SparseTableShard>> shard_values_;
+  std::vector<std::shared_ptr<ShardType>> shard_values_;
+};
+
+class MemorySparseTable : public MemorySparseTableBase<SparseTableShard> {
+ public:
+  MemorySparseTable() {}
+  virtual ~MemorySparseTable() {}
+
+ protected:
+  virtual std::shared_ptr<SparseTableShard> create_shard() {
+    return std::make_shared<SparseTableShard>();
+  }
+};
+
+// MemorySlabSparseTable keeps the values in per-bucket slabs, a value takes a
+// row of the accessor's value size with or without the mf part, see
+// SlabSparseTableShard.
+class MemorySlabSparseTable
+    : public MemorySparseTableBase<SlabSparseTableShard> {
+ public:
+  MemorySlabSparseTable() {}
+  virtual ~MemorySlabSparseTable() {}
+
+  virtual std::pair<int64_t, int64_t> print_table_stat();
+
+ protected:
+  virtual std::shared_ptr<SlabSparseTableShard> create_shard() {
+    return std::make_shared<SlabSparseTableShard>(
+        _value_accesor->size() / sizeof(float),
+        _value_accesor->mf_size() / sizeof(float));
+  }
 };
 
 }  // namespace distributed
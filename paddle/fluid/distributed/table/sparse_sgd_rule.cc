@@ -14,13 +14,211 @@
 
 #include "paddle/fluid/distributed/table/sparse_sgd_rule.h"
 #include <gflags/gflags.h>
+#include <cmath>
 #include "glog/logging.h"
+#include "paddle/fluid/platform/cpu_info.h"
 
 DEFINE_bool(enable_show_scale_gradient, true, "enable show scale gradient");
 
 namespace paddle {
 namespace distributed {
 
+namespace {
+
+// The float lanes of an ISA, the batched kernels are written once over them
+// and run the tail of the dims with the scalar lanes.
+template <platform::cpu_isa_t isa>
+struct FloatLanes {
+  typedef float type;
+  static constexpr size_t size = 1;
+  static type load(const float* x) { return *x; }
+  static void store(float* x, type v) { *x = v; }
+  static type set1(float v) { return v; }
+  static type add(type a, type b) { return a + b; }
+  static type sub(type a, type b) { return a - b; }
+  static type mul(type a, type b) { return a * b; }
+  static type div(type a, type b) { return a / b; }
+  static type sqrt(type a) { return std::sqrt(a); }
+  // the bounds of bound_value, a NaN becomes the lower bound
+  static type bound(type v, type lower, type upper) {
+    v = v >= lower ? v : lower;
+    return v <= upper ? v : upper;
+  }
+  static float sum(type v) { return v; }
+};
+
+#ifdef __AVX__
+template <>
+struct FloatLanes<platform::avx> {
+  typedef __m256 type;
+  static constexpr size_t size = 8;
+  static type load(const float* x) { return _mm256_loadu_ps(x); }
+  static void store(float* x, type v) { _mm256_storeu_ps(x, v); }
+  static type set1(float v) { return _mm256_set1_ps(v); }
+  static type add(type a, type b) { return _mm256_add_ps(a, b); }
+  static type sub(type a, type b) { return _mm256_sub_ps(a, b); }
+  static type mul(type a, type b) { return _mm256_mul_ps(a, b); }
+  static type div(type a, type b) { return _mm256_div_ps(a, b); }
+  static type sqrt(type a) { return _mm256_sqrt_ps(a); }
+  // max and min return the second operand for a NaN
+  static type bound(type v, type lower, type upper) {
+    return _mm256_min_ps(_mm256_max_ps(v, lower), upper);
+  }
+  static float sum(type v) {
+    __m128 x = _mm_add_ps(_mm256_castps256_ps128(v),
+                          _mm256_extractf128_ps(v, 1));
+    x = _mm_add_ps(x, _mm_movehl_ps(x, x));
+    x = _mm_add_ss(x, _mm_shuffle_ps(x, x, 1));
+    return _mm_cvtss_f32(x);
+  }
+};
+#endif
+
+#ifdef __AVX512F__
+template <>
+struct FloatLanes<platform::avx512f> {
+  typedef __m512 type;
+  static constexpr size_t size = 16;
+  static type load(const float* x) { return _mm512_loadu_ps(x); }
+  static void store(float* x, type v) { _mm512_storeu_ps(x, v); }
+  static type set1(float v) { return _mm512_set1_ps(v); }
+  static type add(type a, type b) { return _mm512_add_ps(a, b); }
+  static type sub(type a, type b) { return _mm512_sub_ps(a, b); }
+  static type mul(type a, type b) { return _mm512_mul_ps(a, b); }
+  static type div(type a, type b) { return _mm512_div_ps(a, b); }
+  static type sqrt(type a) { return _mm512_sqrt_ps(a); }
+  static type bound(type v, type lower, type upper) {
+    return _mm512_min_ps(_mm512_max_ps(v, lower), upper);
+  }
+  static float sum(type v) { return _mm512_reduce_add_ps(v); }
+};
+#endif
+
+// the rows of the key this many keys ahead are prefetched
+constexpr size_t kPrefetchDistance = 4;
+
+inline void PrefetchRow(const float* row, size_t dim) {
+  for (size_t i = 0; i < dim; i += 64 / sizeof(float)) {
+    __builtin_prefetch(row + i);
+  }
+}
+
+// The kernels update the dims [begin, dim) of a key by full lanes and return
+// where they stopped.
+
+template <typename L>
+size_t NaiveRow(float* w, const float* g, size_t begin, size_t dim, float lr,
+                float min_bound, float max_bound) {
+  auto lr_v = L::set1(lr);
+  auto lower = L::set1(min_bound);
+  auto upper = L::set1(max_bound);
+  size_t i = begin;
+  for (; i + L::size <= dim; i += L::size) {
+    auto w_v = L::sub(L::load(w + i), L::mul(lr_v, L::load(g + i)));
+    L::store(w + i, L::bound(w_v, lower, upper));
+  }
+  return i;
+}
+
+template <typename L>
+size_t AdaGradRow(float* w, const float* g, size_t begin, size_t dim,
+                  float ratio, float scale, float min_bound, float max_bound,
+                  float* add_g2sum) {
+  auto ratio_v = L::set1(ratio);
+  auto scale_v = L::set1(scale);
+  auto lower = L::set1(min_bound);
+  auto upper = L::set1(max_bound);
+  auto add_g2sum_v = L::set1(0.);
+  size_t i = begin;
+  for (; i + L::size <= dim; i += L::size) {
+    auto scaled_grad = L::div(L::load(g + i), scale_v);
+    auto w_v = L::sub(L::load(w + i), L::mul(ratio_v, scaled_grad));
+    L::store(w + i, L::bound(w_v, lower, upper));
+    add_g2sum_v = L::add(add_g2sum_v, L::mul(scaled_grad, scaled_grad));
+  }
+  *add_g2sum += L::sum(add_g2sum_v);
+  return i;
+}
+
+template <typename L>
+size_t StdAdaGradRow(float* w, float* g2sum, const float* g, size_t begin,
+                     size_t dim, float lr, float initial_g2sum, float scale,
+                     float min_bound, float max_bound) {
+  auto lr_v = L::set1(lr);
+  auto initial_g2sum_v = L::set1(initial_g2sum);
+  auto scale_v = L::set1(scale);
+  auto lower = L::set1(min_bound);
+  auto upper = L::set1(max_bound);
+  size_t i = begin;
+  for (; i + L::size <= dim; i += L::size) {
+    auto g2sum_v = L::load(g2sum + i);
+    auto scaled_grad = L::div(L::load(g + i), scale_v);
+    auto ratio = L::sqrt(
+        L::div(initial_g2sum_v, L::add(initial_g2sum_v, g2sum_v)));
+    auto w_v =
+        L::sub(L::load(w + i), L::mul(lr_v, L::mul(scaled_grad, ratio)));
+    L::store(w + i, L::bound(w_v, lower, upper));
+    L::store(g2sum + i, L::add(g2sum_v, L::mul(scaled_grad, scaled_grad)));
+  }
+  return i;
+}
+
+template <typename L>
+size_t AdamRow(float* w, float* gsum, float* g2sum, const float* g,
+               size_t begin, size_t dim, float lr, float beta1, float beta2,
+               float epsilon, float min_bound, float max_bound) {
+  auto lr_v = L::set1(lr);
+  auto beta1_v = L::set1(beta1);
+  auto beta2_v = L::set1(beta2);
+  auto one_minus_beta1 = L::set1(1 - beta1);
+  auto one_minus_beta2 = L::set1(1 - beta2);
+  auto epsilon_v = L::set1(epsilon);
+  auto lower = L::set1(min_bound);
+  auto upper = L::set1(max_bound);
+  size_t i = begin;
+  for (; i + L::size <= dim; i += L::size) {
+    auto g_v = L::load(g + i);
+    auto gsum_v = L::add(L::mul(beta1_v, L::load(gsum + i)),
+                         L::mul(one_minus_beta1, g_v));
+    auto g2sum_v = L::add(L::mul(beta2_v, L::load(g2sum + i)),
+                          L::mul(one_minus_beta2, L::mul(g_v, g_v)));
+    auto w_v = L::sub(
+        L::load(w + i),
+        L::mul(lr_v, L::div(gsum_v, L::add(L::sqrt(g2sum_v), epsilon_v))));
+    L::store(gsum + i, gsum_v);
+    L::store(g2sum + i, g2sum_v);
+    L::store(w + i, L::bound(w_v, lower, upper));
+  }
+  return i;
+}
+
+// Runs kernel(lanes, key) on every key with the widest lanes of the CPU.
+template <typename Kernel>
+void RunBatch(size_t num, const Kernel& kernel) {
+  typedef FloatLanes<platform::isa_any> ScalarLanes;
+#ifdef __AVX512F__
+  if (platform::MayIUse(platform::avx512f)) {
+    for (size_t k = 0; k < num; ++k) {
+      kernel(FloatLanes<platform::avx512f>(), ScalarLanes(), k);
+    }
+    return;
+  }
+#endif
+#ifdef __AVX__
+  if (platform::MayIUse(platform::avx)) {
+    for (size_t k = 0; k < num; ++k) {
+      kernel(FloatLanes<platform::avx>(), ScalarLanes(), k);
+    }
+    return;
+  }
+#endif
+  for (size_t k = 0; k < num; ++k) {
+    kernel(ScalarLanes(), ScalarLanes(), k);
+  }
+}
+
+}  // namespace
+
 void SparseNaiveSGDRule::load_config(const SparseCommonSGDRuleParameter& param,
                                      size_t emb_dim) {
   _embedding_dim = emb_dim;
@@ -48,6 +246,24 @@ void SparseNaiveSGDRule::update_value_work(float* w, float* sgd,
   }
 }
 
+void SparseNaiveSGDRule::update_value_batch_work(
+    float* const* w, float* const* sgd, const float* const* push_value,
+    size_t num, float scale) {
+  size_t dim = _embedding_dim;
+  RunBatch(num, [&](auto lanes, auto scalar_lanes, size_t k) {
+    typedef decltype(lanes) L;
+    typedef decltype(scalar_lanes) S;
+    if (k + kPrefetchDistance < num) {
+      PrefetchRow(w[k + kPrefetchDistance], dim);
+      PrefetchRow(push_value[k + kPrefetchDistance], dim);
+    }
+    size_t i = NaiveRow<L>(w[k], push_value[k], 0, dim, learning_rate_,
+                           _min_bound, _max_bound);
+    NaiveRow<S>(w[k], push_value[k], i, dim, learning_rate_, _min_bound,
+                _max_bound);
+  });
+}
+
 void SparseNaiveSGDRule::init_value_work(float* value, float* sgd,
                                          bool zero_init) {
   if (zero_init) {
@@ -100,6 +316,30 @@ void SparseAdaGradSGDRule::update_value_work(float* w, float* sgd,
   g2sum += add_g2sum / _embedding_dim;
 }
 
+void SparseAdaGradSGDRule::update_value_batch_work(
+    float* const* w, float* const* sgd, const float* const* push_value,
+    size_t num, float scale) {
+  size_t dim = _embedding_dim;
+  RunBatch(num, [&](auto lanes, auto scalar_lanes, size_t k) {
+    typedef decltype(lanes) L;
+    typedef decltype(scalar_lanes) S;
+    if (k + kPrefetchDistance < num) {
+      PrefetchRow(w[k + kPrefetchDistance], dim);
+      PrefetchRow(sgd[k + kPrefetchDistance], 1);
+      PrefetchRow(push_value[k + kPrefetchDistance], dim);
+    }
+    float& g2sum = sgd[k][g2sum_index()];
+    float ratio = learning_rate_ *
+                  std::sqrt(_initial_g2sum / (_initial_g2sum + g2sum));
+    float add_g2sum = 0;
+    size_t i = AdaGradRow<L>(w[k], push_value[k], 0, dim, ratio, scale,
+                             _min_bound, _max_bound, &add_g2sum);
+    AdaGradRow<S>(w[k], push_value[k], i, dim, ratio, scale, _min_bound,
+                  _max_bound, &add_g2sum);
+    g2sum += add_g2sum / dim;
+  });
+}
+
 void SparseAdaGradSGDRule::init_value_work(float* value, float* sgd,
                                            bool zero_init) {
   for (int i = 0; i < _embedding_dim; ++i) {
@@ -150,6 +390,27 @@ void StdAdaGradSGDRule::update_value_work(float* w, float* sgd,
   }
 }
 
+void StdAdaGradSGDRule::update_value_batch_work(
+    float* const* w, float* const* sgd, const float* const* push_value,
+    size_t num, float scale) {
+  size_t dim = _embedding_dim;
+  RunBatch(num, [&](auto lanes, auto scalar_lanes, size_t k) {
+    typedef decltype(lanes) L;
+    typedef decltype(scalar_lanes) S;
+    if (k + kPrefetchDistance < num) {
+      PrefetchRow(w[k + kPrefetchDistance], dim);
+      PrefetchRow(sgd[k + kPrefetchDistance], dim);
+      PrefetchRow(push_value[k + kPrefetchDistance], dim);
+    }
+    float* g2sum = sgd[k] + g2sum_index();
+    size_t i =
+        StdAdaGradRow<L>(w[k], g2sum, push_value[k], 0, dim, learning_rate_,
+                         _initial_g2sum, scale, _min_bound, _max_bound);
+    StdAdaGradRow<S>(w[k], g2sum, push_value[k], i, dim, learning_rate_,
+                     _initial_g2sum, scale, _min_bound, _max_bound);
+  });
+}
+
 void StdAdaGradSGDRule::init_value_work(float* value, float* sgd,
                                         bool zero_init) {
   for (int i = 0; i < _embedding_dim; ++i) {
@@ -216,6 +477,36 @@ void SparseAdamSGDRule::update_value_work(float* w, float* sgd,
   (*beta2_pow) *= _beta2_decay_rate;
 }
 
+void SparseAdamSGDRule::update_value_batch_work(
+    float* const* w, float* const* sgd, const float* const* push_value,
+    size_t num, float scale) {
+  size_t dim = _embedding_dim;
+  RunBatch(num, [&](auto lanes, auto scalar_lanes, size_t k) {
+    typedef decltype(lanes) L;
+    typedef decltype(scalar_lanes) S;
+    if (k + kPrefetchDistance < num) {
+      PrefetchRow(w[k + kPrefetchDistance], dim);
+      PrefetchRow(sgd[k + kPrefetchDistance], this->dim());
+      PrefetchRow(push_value[k + kPrefetchDistance], dim);
+    }
+    float* gsum = sgd[k] + gsum_index();
+    float* g2sum = sgd[k] + g2sum_index();
+    float* beta1_pow = sgd[k] + beta1_pow_index();
+    float* beta2_pow = sgd[k] + beta2_pow_index();
+    // lr not change in one update
+    float lr =
+        learning_rate_ * std::sqrt(1 - *beta2_pow) / (1 - *beta1_pow);
+    size_t i = AdamRow<L>(w[k], gsum, g2sum, push_value[k], 0, dim, lr,
+                          _beta1_decay_rate, _beta2_decay_rate, _ada_epsilon,
+                          _min_bound, _max_bound);
+    AdamRow<S>(w[k], gsum, g2sum, push_value[k], i, dim, lr,
+               _beta1_decay_rate, _beta2_decay_rate, _ada_epsilon, _min_bound,
+               _max_bound);
+    (*beta1_pow) *= _beta1_decay_rate;
+    (*beta2_pow) *= _beta2_decay_rate;
+  });
+}
+
 void SparseAdamSGDRule::init_value_work(float* value, float* sgd,
                                         bool zero_init) {
   for (int i = 0; i < _embedding_dim; ++i) {
@@ -45,6 +45,22 @@ class SparseValueSGDRule {
                     float scale = 1) {
     update_value_work(w, sgd, push_value, scale);
   }
+  // Updates the values of num keys at once, the same as calling update_value
+  // on every key in order.
+  void update_value_batch(float* const* w, float* const* sgd,
+                          const float* const* push_value, size_t num,
+                          float scale = 1) {
+    update_value_batch_work(w, sgd, push_value, num, scale);
+  }
+  // The rules override it with kernels vectorized over the embedding dims,
+  // update_value_work stays the reference.
+  virtual void update_value_batch_work(float* const* w, float* const* sgd,
+                                       const float* const* push_value,
+                                       size_t num, float scale) {
+    for (size_t i = 0; i < num; ++i) {
+      update_value_work(w[i], sgd[i], push_value[i], scale);
+    }
+  }
   template <class T>
   void bound_value(T& w) {  // NOLINT
     if (!(w >= _min_bound)) {
@@ -74,6 +90,9 @@ class SparseNaiveSGDRule : public SparseValueSGDRule {
                            size_t emb_dim);
   virtual void update_value_work(float* w, float* sgd, const float* push_value,
                                  float scale);
+  virtual void update_value_batch_work(float* const* w, float* const* sgd,
+                                       const float* const* push_value,
+                                       size_t num, float scale);
   virtual void init_value_work(float* value, float* sgd, bool zero_init);
   virtual size_t dim() { return 0; }
 
@@ -87,6 +106,9 @@ class SparseAdaGradSGDRule : public SparseValueSGDRule {
                            size_t emb_dim);
   virtual void update_value_work(float* w, float* sgd, const float* push_value,
                                  float scale);
+  virtual void update_value_batch_work(float* const* w, float* const* sgd,
+                                       const float* const* push_value,
+                                       size_t num, float scale);
   virtual void init_value_work(float* value, float* sgd, bool zero_init);
   virtual size_t dim() { return 1; }
   size_t g2sum_index() { return 0; }
@@ -102,6 +124,9 @@ class StdAdaGradSGDRule : public SparseValueSGDRule {
                            size_t emb_dim);
   virtual void update_value_work(float* w, float* sgd, const float* push_value,
                                  float scale);
+  virtual void update_value_batch_work(float* const* w, float* const* sgd,
+                                       const float* const* push_value,
+                                       size_t num, float scale);
   virtual void init_value_work(float* value, float* sgd, bool zero_init);
   virtual size_t dim() { return _embedding_dim; }
   size_t g2sum_index() { return 0; }
@@ -117,6 +142,9 @@ class SparseAdamSGDRule : public SparseValueSGDRule {
                            size_t emb_dim);
   virtual void update_value_work(float* w, float* sgd, const float* push_value,
                                  float scale);
+  virtual void update_value_batch_work(float* const* w, float* const* sgd,
+                                       const float* const* push_value,
+                                       size_t num, float scale);
   virtual void init_value_work(float* value, float* sgd, bool zero_init);
   virtual size_t dim() { return _embedding_dim * 2 + 2; }
   size_t gsum_index() { return 0; }
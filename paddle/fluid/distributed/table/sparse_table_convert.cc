@@ -0,0 +1,94 @@
+// Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/distributed/table/sparse_table_convert.h"
+
+#include <fstream>
+#include <vector>
+
+#include "glog/logging.h"
+#include "paddle/fluid/distributed/table/depends/sparse_binary_file.h"
+#include "paddle/fluid/string/string_helper.h"
+
+namespace paddle {
+namespace distributed {
+
+int64_t sparse_text_to_binary(ValueAccessor* accessor,
+                              const TableAccessorParameter& config,
+                              const std::string& input,
+                              const std::string& output) {
+  size_t value_dim = accessor->size() / sizeof(float);
+  std::vector<uint64_t> keys;
+  std::vector<float> values;
+  std::vector<uint32_t> sizes;
+
+  // the number of records goes to the header, so the text is parsed first
+  std::ifstream is(input);
+  std::string line;
+  std::vector<float> value(value_dim);
+  while (std::getline(is, line)) {
+    if (line.size() <= 1) {
+      continue;
+    }
+    char* end = nullptr;
+    keys.push_back(std::strtoul(line.data(), &end, 10));
+    int parse_size = accessor->parse_from_string(++end, value.data());
+    sizes.push_back(parse_size);
+    values.insert(values.end(), value.begin(), value.begin() + parse_size);
+  }
+
+  SparseBinaryFileHeader header;
+  init_sparse_binary_header(&header, value_dim, accessor->fea_dim(),
+                            config.embedx_dim());
+  header.record_num = keys.size();
+
+  std::ofstream os(output, std::ios::binary);
+  SparseBinaryFileWriter writer(header, [&os](const char* data, size_t size) {
+    os.write(data, size);
+    return os.good() ? 0 : -1;
+  });
+  if (writer.write_header() != 0) {
+    return -1;
+  }
+  const float* data = values.data();
+  for (size_t i = 0; i < keys.size(); ++i) {
+    if (writer.write_record(keys[i], data, sizes[i]) != 0) {
+      return -1;
+    }
+    data += sizes[i];
+  }
+  return writer.written_num();
+}
+
+int64_t sparse_binary_to_text(ValueAccessor* accessor,
+                              const std::string& input,
+                              const std::string& output) {
+  SparseBinaryFileMapping file;
+  if (file.open(input) != 0) {
+    return -1;
+  }
+  std::ofstream os(output);
+  uint64_t record_num = file.header().record_num;
+  for (uint64_t i = 0; i < record_num; ++i) {
+    std::string format_value =
+        accessor->parse_to_string(file.value(i), file.value_size(i));
+    os << paddle::string::format_string("%lu %s", file.key(i),
+                                        format_value.c_str())
+       << "\n";
+  }
+  return os.good() ? record_num : -1;
+}
+
+}  // namespace distributed
+}  // namespace paddle
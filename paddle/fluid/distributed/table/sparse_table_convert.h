@@ -0,0 +1,41 @@
+// Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <string>
+
+#include "paddle/fluid/distributed/ps.pb.h"
+#include "paddle/fluid/distributed/table/accessor.h"
+
+namespace paddle {
+namespace distributed {
+
+// Converts a local shard file of MemorySparseTable from the text format
+// ("key value,value,...") to the binary format of sparse_binary_file.h.
+// The accessor is the one of the table that saved the file, config is its
+// TableAccessorParameter. Returns the number of records, or -1 on failure.
+int64_t sparse_text_to_binary(ValueAccessor* accessor,
+                              const TableAccessorParameter& config,
+                              const std::string& input,
+                              const std::string& output);
+
+// Converts a local shard file of MemorySparseTable from the binary format to
+// the text format. Returns the number of records, or -1 on failure.
+int64_t sparse_binary_to_text(ValueAccessor* accessor,
+                              const std::string& input,
+                              const std::string& output);
+
+}  // namespace distributed
+}  // namespace paddle
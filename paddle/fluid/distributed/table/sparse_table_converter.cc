@@ -0,0 +1,104 @@
+// Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Converts a local shard file of MemorySparseTable between the text format
+// ("key value,value,...") and the binary format of sparse_binary_file.h, see
+// sparse_table_convert.h:
+//
+//   sparse_table_converter --accessor_config=accessor.prototxt
+//       --input=part-000-00000 --output=part-000-00000.bin --to_binary
+//
+// The accessor config is a TableAccessorParameter in protobuf text format,
+// the same as the accessor of the table that saved the file.
+
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "google/protobuf/text_format.h"
+#include "paddle/fluid/distributed/common/registerer.h"
+#include "paddle/fluid/distributed/ps.pb.h"
+#include "paddle/fluid/distributed/table/accessor.h"
+#include "paddle/fluid/distributed/table/ctr_accessor.h"
+#include "paddle/fluid/distributed/table/sparse_table_convert.h"
+#include "paddle/fluid/distributed/table/table.h"
+
+DEFINE_string(accessor_config, "",
+              "TableAccessorParameter of the table, in protobuf text format");
+DEFINE_string(input, "", "the shard file to convert");
+DEFINE_string(output, "", "the converted shard file");
+DEFINE_bool(to_binary, true,
+            "convert text to binary if true, binary to text otherwise");
+
+namespace paddle {
+namespace distributed {
+
+static std::shared_ptr<ValueAccessor> create_accessor(
+    const std::string& config_path, TableAccessorParameter* config) {
+  std::ifstream is(config_path);
+  std::string config_text((std::istreambuf_iterator<char>(is)),
+                          std::istreambuf_iterator<char>());
+  if (!google::protobuf::TextFormat::ParseFromString(config_text, config)) {
+    LOG(ERROR) << "parse accessor config failed, path: " << config_path;
+    return nullptr;
+  }
+  auto* accessor = CREATE_PSCORE_CLASS(ValueAccessor, config->accessor_class());
+  if (accessor == nullptr) {
+    LOG(ERROR) << "accessor is unregistered, accessor_name: "
+               << config->accessor_class();
+    return nullptr;
+  }
+  std::shared_ptr<ValueAccessor> result(accessor);
+  if (accessor->configure(*config) != 0 || accessor->initialize() != 0) {
+    LOG(ERROR) << "accessor initialize failed, accessor_name: "
+               << config->accessor_class();
+    return nullptr;
+  }
+  return result;
+}
+
+}  // namespace distributed
+}  // namespace paddle
+
+int main(int argc, char** argv) {
+  google::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+
+  paddle::distributed::TableAccessorParameter config;
+  auto accessor =
+      paddle::distributed::create_accessor(FLAGS_accessor_config, &config);
+  if (accessor == nullptr || FLAGS_input.empty() || FLAGS_output.empty()) {
+    LOG(ERROR) << "usage: sparse_table_converter --accessor_config=<file> "
+               << "--input=<file> --output=<file> [--to_binary=true|false]";
+    return -1;
+  }
+
+  int64_t record_num =
+      FLAGS_to_binary
+          ? paddle::distributed::sparse_text_to_binary(
+                accessor.get(), config, FLAGS_input, FLAGS_output)
+          : paddle::distributed::sparse_binary_to_text(
+                accessor.get(), FLAGS_input, FLAGS_output);
+  if (record_num < 0) {
+    LOG(ERROR) << "convert " << FLAGS_input << " to " << FLAGS_output
+               << " failed";
+    return -1;
+  }
+  LOG(INFO) << "convert " << FLAGS_input << " to " << FLAGS_output
+            << " success, record_num: " << record_num;
+  return 0;
+}
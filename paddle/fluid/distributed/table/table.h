@@ -48,6 +48,11 @@ class Table {
   virtual int32_t push_dense_param(const float *values, size_t num) {
     return 0;
   }
+  // for the compressed dense grads, the indices and values of the dims sent
+  virtual int32_t push_dense_compressed(const uint32_t *indices,
+                                        const float *values, size_t num) {
+    return -1;
+  }
 
   virtual int32_t pull_sparse_ptr(char **pull_values, const uint64_t *keys,
                                   size_t num) {
@@ -0,0 +1,277 @@
+/* Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cmath>
+#include <string>
+#include <thread>  // NOLINT
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/distributed/ps.pb.h"
+#include "paddle/fluid/distributed/service/brpc_ps_client.h"
+#include "paddle/fluid/distributed/service/brpc_ps_server.h"
+#include "paddle/fluid/distributed/service/env.h"
+#include "paddle/fluid/distributed/service/sparse_value_codec.h"
+#include "paddle/fluid/framework/program_desc.h"
+
+namespace framework = paddle::framework;
+namespace distributed = paddle::distributed;
+
+// Pulls and pushes the embeddings of a CTR table through a local brpc server
+// in every sparse value type, and reports the bytes per key and the latency
+// of the pulls.
+
+static const int kEmbedxDim = 16;
+static const size_t kKeyNum = 10000;
+static const int kRepeat = 20;
+
+void GetCtrSparseTableProto(distributed::TableParameter* table_proto,
+                            distributed::SparseValueType pull_type,
+                            distributed::SparseValueType push_type) {
+  table_proto->set_table_id(0);
+  table_proto->set_table_class("MemorySparseTable");
+  table_proto->set_shard_num(16);
+  table_proto->set_type(distributed::PS_SPARSE_TABLE);
+  table_proto->set_pull_value_type(pull_type);
+  table_proto->set_push_value_type(push_type);
+
+  auto* accessor_proto = table_proto->mutable_accessor();
+  accessor_proto->set_accessor_class("CtrCommonAccessor");
+  accessor_proto->set_fea_dim(3 + 3 + 3 + kEmbedxDim + 1);
+  accessor_proto->set_embedx_dim(kEmbedxDim);
+  accessor_proto->set_embedx_threshold(0);
+  auto* ctr_param = accessor_proto->mutable_ctr_accessor_param();
+  ctr_param->set_nonclk_coeff(0.1);
+  ctr_param->set_click_coeff(1);
+  ctr_param->set_base_threshold(0);
+  ctr_param->set_delta_threshold(0);
+  ctr_param->set_delta_keep_days(16);
+  ctr_param->set_show_click_decay_rate(0.99);
+  for (auto* sgd_param : {accessor_proto->mutable_embed_sgd_param(),
+                          accessor_proto->mutable_embedx_sgd_param()}) {
+    sgd_param->set_name("SparseNaiveSGDRule");
+    auto* naive_param = sgd_param->mutable_naive();
+    naive_param->set_learning_rate(0.1);
+    naive_param->set_initial_range(0.3);
+    naive_param->add_weight_bounds(-10.0);
+    naive_param->add_weight_bounds(10.0);
+  }
+}
+
+void GetServiceProto(distributed::ServerServiceParameter* service_proto) {
+  service_proto->set_service_class("BrpcPsService");
+  service_proto->set_server_class("BrpcPsServer");
+  service_proto->set_client_class("BrpcPsClient");
+  service_proto->set_start_server_port(0);
+  service_proto->set_server_thread_num(12);
+}
+
+distributed::PSParameter GetServerProto() {
+  distributed::PSParameter server_fleet_desc;
+  auto* downpour_server_proto =
+      server_fleet_desc.mutable_server_param()->mutable_downpour_server_param();
+  GetServiceProto(downpour_server_proto->mutable_service_param());
+  GetCtrSparseTableProto(downpour_server_proto->add_downpour_table_param(),
+                         distributed::SPARSE_VALUE_FP32,
+                         distributed::SPARSE_VALUE_FP32);
+  return server_fleet_desc;
+}
+
+// The client asks for the types, the server keeps the fp32 values.
+distributed::PSParameter GetWorkerProto(
+    distributed::SparseValueType pull_type,
+    distributed::SparseValueType push_type) {
+  distributed::PSParameter worker_fleet_desc;
+  GetCtrSparseTableProto(worker_fleet_desc.mutable_worker_param()
+                             ->mutable_downpour_worker_param()
+                             ->add_downpour_table_param(),
+                         pull_type, push_type);
+  auto* downpour_server_proto =
+      worker_fleet_desc.mutable_server_param()->mutable_downpour_server_param();
+  GetServiceProto(downpour_server_proto->mutable_service_param());
+  GetCtrSparseTableProto(downpour_server_proto->add_downpour_table_param(),
+                         pull_type, push_type);
+  return worker_fleet_desc;
+}
+
+/*-------------------------------------------------------------------------*/
+
+std::string ip_ = "127.0.0.1";
+uint32_t port_ = 4215;
+
+std::vector<std::string> host_sign_list_;
+
+std::shared_ptr<distributed::PSServer> pserver_ptr_;
+
+void RunServer() {
+  distributed::PSParameter server_proto = GetServerProto();
+
+  auto _ps_env = distributed::PaddlePSEnvironment();
+  _ps_env.set_ps_servers(&host_sign_list_, 1);
+  pserver_ptr_ = std::shared_ptr<distributed::PSServer>(
+      distributed::PSServerFactory::create(server_proto));
+  std::vector<framework::ProgramDesc> empty_vec;
+  framework::ProgramDesc empty_prog;
+  empty_vec.push_back(empty_prog);
+  pserver_ptr_->configure(server_proto, _ps_env, 0, empty_vec);
+  pserver_ptr_->start(ip_, port_);
+}
+
+std::shared_ptr<distributed::PSClient> RunClient(
+    distributed::SparseValueType pull_type,
+    distributed::SparseValueType push_type) {
+  distributed::PSParameter worker_proto =
+      GetWorkerProto(pull_type, push_type);
+  distributed::PaddlePSEnvironment _ps_env;
+  _ps_env.set_ps_servers(&host_sign_list_, host_sign_list_.size());
+  std::map<uint64_t, std::vector<distributed::Region>> dense_regions;
+  auto worker_ptr = std::shared_ptr<distributed::PSClient>(
+      distributed::PSClientFactory::create(worker_proto));
+  worker_ptr->configure(worker_proto, dense_regions, _ps_env, 0);
+  return worker_ptr;
+}
+
+// Returns the pull latencies in ms.
+std::vector<double> PullSparse(distributed::PSClient* worker,
+                               const std::vector<uint64_t>& keys,
+                               std::vector<float>* values) {
+  size_t dim = worker->table_accessor(0)->select_dim();
+  values->resize(keys.size() * dim);
+  std::vector<float*> value_ptrs(keys.size());
+  for (size_t i = 0; i < keys.size(); ++i) {
+    value_ptrs[i] = values->data() + i * dim;
+  }
+  std::vector<double> latencies;
+  for (int i = 0; i < kRepeat; ++i) {
+    auto start = std::chrono::steady_clock::now();
+    auto status =
+        worker->pull_sparse(value_ptrs.data(), 0, keys.data(), keys.size(),
+                            /*is_training=*/false);
+    EXPECT_EQ(status.get(), 0);
+    std::chrono::duration<double, std::milli> cost =
+        std::chrono::steady_clock::now() - start;
+    latencies.push_back(cost.count());
+  }
+  std::sort(latencies.begin(), latencies.end());
+  return latencies;
+}
+
+void RunBrpcSparseCodec() {
+  setenv("http_proxy", "", 1);
+  setenv("https_proxy", "", 1);
+  auto ph_host = distributed::PSHost(ip_, port_, 0);
+  host_sign_list_.push_back(ph_host.serialize_to_string());
+
+  std::thread server_thread(RunServer);
+  sleep(1);
+
+  std::vector<uint64_t> keys(kKeyNum);
+  for (size_t i = 0; i < keys.size(); ++i) {
+    keys[i] = i * 7919;
+  }
+
+  // the fp32 values for reference
+  auto fp32_worker =
+      RunClient(distributed::SPARSE_VALUE_FP32, distributed::SPARSE_VALUE_FP32);
+  std::vector<float> fp32_values;
+  PullSparse(fp32_worker.get(), keys, &fp32_values);
+
+  std::vector<std::pair<distributed::SparseValueType, float>> types = {
+      {distributed::SPARSE_VALUE_FP32, 0.},
+      {distributed::SPARSE_VALUE_FP16, 1e-3},
+      {distributed::SPARSE_VALUE_BF16, 1e-2},
+      {distributed::SPARSE_VALUE_INT8, 1e-2}};
+  for (auto& type : types) {
+    auto worker = RunClient(type.first, distributed::SPARSE_VALUE_FP32);
+    auto* accessor = worker->table_accessor(0);
+    distributed::SparseValueCodec codec(type.first, accessor->select_dim(),
+                                        accessor->select_quant_begin());
+
+    std::vector<float> values;
+    auto latencies = PullSparse(worker.get(), keys, &values);
+    ASSERT_EQ(values.size(), fp32_values.size());
+    for (size_t i = 0; i < values.size(); ++i) {
+      ASSERT_NEAR(values[i], fp32_values[i], type.second);
+    }
+    LOG(INFO) << distributed::SparseValueType_Name(type.first)
+              << " pull bytes/key: " << sizeof(uint64_t) + codec.encoded_size()
+              << ", latency of " << kKeyNum
+              << " keys p50: " << latencies[latencies.size() / 2]
+              << " ms, max: " << latencies.back() << " ms";
+    worker->finalize_worker();
+  }
+
+  // the fp16 gradients are applied like the fp32 ones
+  auto fp16_worker =
+      RunClient(distributed::SPARSE_VALUE_FP32, distributed::SPARSE_VALUE_FP16);
+  size_t update_dim = fp16_worker->table_accessor(0)->update_dim();
+  std::vector<float> grads(keys.size() * update_dim, 0.);
+  std::vector<const float*> grad_ptrs(keys.size());
+  for (size_t i = 0; i < keys.size(); ++i) {
+    float* grad = grads.data() + i * update_dim;
+    // slot, show, click and embed_g
+    grad[0] = 1;
+    grad[1] = 1;
+    grad[3] = 0.5;
+    grad_ptrs[i] = grad;
+  }
+  fp16_worker->push_sparse(0, keys.data(), grad_ptrs.data(), keys.size())
+      .wait();
+  fp16_worker->flush().wait();
+  std::vector<float> updated_values;
+  PullSparse(fp16_worker.get(), keys, &updated_values);
+  size_t select_dim = fp16_worker->table_accessor(0)->select_dim();
+  for (size_t i = 0; i < keys.size(); ++i) {
+    // embed_w -= learning_rate * embed_g
+    ASSERT_NEAR(updated_values[i * select_dim],
+                fp32_values[i * select_dim] - 0.1 * 0.5, 1e-5);
+  }
+
+  // the server answers a wire format it does not know with an error
+  brpc::Channel channel;
+  brpc::ChannelOptions options;
+  ASSERT_EQ(channel.Init((ip_ + ":" + std::to_string(port_)).c_str(),
+                         &options),
+            0);
+  distributed::PsService_Stub stub(&channel);
+  for (int cmd_id : {distributed::PS_PULL_SPARSE_TABLE,
+                     distributed::PS_PUSH_SPARSE_TABLE}) {
+    distributed::PsRequestMessage request;
+    distributed::PsResponseMessage response;
+    brpc::Controller cntl;
+    request.set_cmd_id(cmd_id);
+    request.set_table_id(0);
+    request.set_client_id(0);
+    uint32_t num = 1;
+    uint32_t unknown_type = 100;
+    request.add_params(reinterpret_cast<char*>(&num), sizeof(uint32_t));
+    request.add_params(reinterpret_cast<char*>(&unknown_type),
+                       sizeof(uint32_t));
+    cntl.request_attachment().append(&keys[0], sizeof(uint64_t));
+    request.set_data(std::string(reinterpret_cast<char*>(&keys[0]),
+                                 sizeof(uint64_t)));
+    stub.service(&cntl, &request, &response, NULL);
+    ASSERT_FALSE(cntl.Failed());
+    ASSERT_EQ(response.err_code(), -1);
+  }
+
+  fp16_worker->stop_server();
+  fp16_worker->finalize_worker();
+  fp32_worker->finalize_worker();
+  server_thread.join();
+}
+
+TEST(RunBrpcSparseCodec, Run) { RunBrpcSparseCodec(); }
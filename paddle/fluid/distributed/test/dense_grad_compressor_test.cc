@@ -0,0 +1,171 @@
+/* Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/distributed/service/dense_grad_compressor.h"
+
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace paddle {
+namespace distributed {
+
+static DenseCompressParameter GetParam(DenseCompressType type, float ratio,
+                                       bool error_feedback,
+                                       uint32_t warmup_steps) {
+  DenseCompressParameter param;
+  param.set_type(type);
+  param.set_ratio(ratio);
+  param.set_error_feedback(error_feedback);
+  param.set_warmup_steps(warmup_steps);
+  return param;
+}
+
+static std::vector<float> RandomGrad(size_t dim, std::mt19937 *rng) {
+  std::uniform_real_distribution<float> dist(-1., 1.);
+  std::vector<float> grad(dim);
+  for (auto &x : grad) {
+    x = dist(*rng);
+  }
+  return grad;
+}
+
+TEST(DenseGradCompressor, TopK) {
+  DenseGradCompressor compressor(
+      GetParam(DENSE_COMPRESS_TOPK, 0.25, false, 0));
+  std::vector<float> grad = {0.1, -4., 0.2, 0.3, 3., -0.1, 0.05, 0.};
+  std::vector<uint32_t> indices;
+  std::vector<float> values;
+  ASSERT_TRUE(compressor.compress(grad.data(), grad.size(), &indices, &values));
+  ASSERT_EQ(indices, std::vector<uint32_t>({1, 4}));
+  ASSERT_EQ(values, std::vector<float>({-4., 3.}));
+
+  // the dims not sent are dropped without the error feedback
+  std::vector<float> zeros(grad.size(), 0.);
+  ASSERT_TRUE(
+      compressor.compress(zeros.data(), zeros.size(), &indices, &values));
+  for (auto value : values) {
+    ASSERT_EQ(value, 0.);
+  }
+}
+
+TEST(DenseGradCompressor, RandomK) {
+  const size_t dim = 1000;
+  DenseGradCompressor compressor(
+      GetParam(DENSE_COMPRESS_RANDOMK, 0.013, true, 0));
+  std::mt19937 rng(0);
+  std::vector<uint32_t> indices;
+  std::vector<float> values;
+  for (int i = 0; i < 10; ++i) {
+    auto grad = RandomGrad(dim, &rng);
+    ASSERT_TRUE(compressor.compress(grad.data(), dim, &indices, &values));
+    ASSERT_EQ(indices.size(), 13UL);
+    ASSERT_EQ(values.size(), 13UL);
+    for (size_t j = 1; j < indices.size(); ++j) {
+      ASSERT_LT(indices[j - 1], indices[j]);
+    }
+    ASSERT_LT(indices.back(), dim);
+  }
+}
+
+TEST(DenseGradCompressor, ErrorFeedback) {
+  const size_t dim = 64;
+  std::mt19937 rng(0);
+  for (auto type : {DENSE_COMPRESS_TOPK, DENSE_COMPRESS_RANDOMK}) {
+    DenseGradCompressor compressor(GetParam(type, 0.1, true, 0));
+    std::vector<double> sent_sum(dim, 0.);
+    std::vector<double> grad_sum(dim, 0.);
+    std::vector<uint32_t> indices;
+    std::vector<float> values;
+    for (int i = 0; i < 200; ++i) {
+      auto grad = RandomGrad(dim, &rng);
+      ASSERT_TRUE(compressor.compress(grad.data(), dim, &indices, &values));
+      for (size_t j = 0; j < indices.size(); ++j) {
+        sent_sum[indices[j]] += values[j];
+      }
+      for (size_t j = 0; j < dim; ++j) {
+        grad_sum[j] += grad[j];
+      }
+    }
+    // flushes the residual by a push of zeros with every dim sent
+    std::vector<float> zeros(dim, 0.);
+    DenseGradCompressorStats stats = compressor.stats();
+    for (int i = 0; i < 300; ++i) {
+      compressor.compress(zeros.data(), dim, &indices, &values);
+      for (size_t j = 0; j < indices.size(); ++j) {
+        sent_sum[indices[j]] += values[j];
+      }
+    }
+    for (size_t j = 0; j < dim; ++j) {
+      ASSERT_NEAR(sent_sum[j], grad_sum[j], 1e-3);
+    }
+    ASSERT_EQ(stats.push_num, 200UL);
+    ASSERT_EQ(stats.compressed_push_num, 200UL);
+    ASSERT_EQ(stats.sent_dim_num, 200UL * 7);
+  }
+}
+
+TEST(DenseGradCompressor, Warmup) {
+  const size_t dim = 16;
+  DenseGradCompressor compressor(
+      GetParam(DENSE_COMPRESS_TOPK, 0.5, true, 3));
+  std::vector<float> grad(dim, 1.);
+  std::vector<uint32_t> indices;
+  std::vector<float> values;
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_FALSE(compressor.compress(grad.data(), dim, &indices, &values));
+  }
+  // nothing of the warmup is kept in the residual
+  ASSERT_TRUE(compressor.compress(grad.data(), dim, &indices, &values));
+  ASSERT_EQ(indices.size(), dim / 2);
+  for (auto value : values) {
+    ASSERT_EQ(value, 1.);
+  }
+  auto stats = compressor.stats();
+  ASSERT_EQ(stats.push_num, 4UL);
+  ASSERT_EQ(stats.compressed_push_num, 1UL);
+  ASSERT_EQ(stats.sent_dim_num, 3 * dim + dim / 2);
+  ASSERT_EQ(stats.sent_ratio(), (3 * dim + dim / 2) / (4. * dim));
+}
+
+TEST(DenseGradCompressor, EncodeShard) {
+  std::vector<uint32_t> indices = {1, 5, 9, 10, 15};
+  std::vector<float> values = {1., 5., 9., 10., 15.};
+  std::string data;
+  EncodeCompressedDenseShard(indices, values, 8, 16, &data);
+  ASSERT_EQ(data.size(), sizeof(uint32_t) + 3 * 8);
+  uint32_t num = 0;
+  memcpy(&num, data.data(), sizeof(uint32_t));
+  ASSERT_EQ(num, 3U);
+  const uint32_t *shard_indices =
+      reinterpret_cast<const uint32_t *>(data.data() + sizeof(uint32_t));
+  const float *shard_values =
+      reinterpret_cast<const float *>(data.data() + 4 * sizeof(uint32_t));
+  ASSERT_EQ(shard_indices[0], 1U);
+  ASSERT_EQ(shard_indices[1], 2U);
+  ASSERT_EQ(shard_indices[2], 7U);
+  ASSERT_EQ(shard_values[0], 9.);
+  ASSERT_EQ(shard_values[2], 15.);
+
+  // a shard without a selected dim
+  EncodeCompressedDenseShard(indices, values, 16, 24, &data);
+  ASSERT_EQ(data.size(), sizeof(uint32_t));
+}
+
+}  // namespace distributed
+}  // namespace paddle
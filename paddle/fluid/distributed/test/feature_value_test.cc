@@ -15,6 +15,8 @@ limitations under the License. */
 #include <ThreadPool.h>
 
 #include <unistd.h>
+#include <chrono>
+#include <cstdlib>
 #include <string>
 #include <thread>  // NOLINT
 #include <vector>
@@ -51,5 +53,135 @@ TEST(BENCHMARK, LargeScaleKV) {
   ASSERT_FLOAT_EQ(value_data[3], 0.3);
 }
 
+TEST(SlabSparseTableShard, InitFindErase) {
+  std::shared_ptr<SlabSparseTableShard> shard =
+      std::make_shared<SlabSparseTableShard>(4, 2);
+  uint64_t key = 1;
+  auto itr = shard->Find(key);
+  ASSERT_TRUE(itr == shard->end());
+
+  std::vector<float> vec = {0.0, 0.1, 0.2};
+
+  auto* feature_value = shard->Init(key);
+  feature_value->resize(vec.size());
+  memcpy(feature_value->data(), vec.data(), vec.size() * sizeof(float));
+
+  itr = shard->Find(key);
+  ASSERT_TRUE(itr != shard->end());
+  ASSERT_EQ(itr->second->size(), vec.size());
+  float* value_data = itr->second->data();
+  ASSERT_FLOAT_EQ(value_data[0], 0.0);
+  ASSERT_FLOAT_EQ(value_data[1], 0.1);
+  ASSERT_FLOAT_EQ(value_data[2], 0.2);
+
+  // the freed row is reused by the next feature of its size class
+  float* row = itr->second.row();
+  shard->erase(key);
+  ASSERT_TRUE(shard->Find(key) == shard->end());
+  feature_value = shard->Init(key + 1);
+  feature_value->resize(vec.size());
+  ASSERT_EQ(feature_value->row(), row);
+}
+
+TEST(SlabSparseTableShard, SizeClass) {
+  SlabSparseTableShard shard(4, 2);
+  auto* feature_value = shard.Init(1);
+  feature_value->resize(2);
+  ASSERT_EQ(feature_value->capacity(), 2UL);
+  feature_value->data()[0] = 1.0;
+  feature_value->data()[1] = 2.0;
+
+  // extending the mf part moves the value to a full row and keeps the data
+  feature_value->resize(4);
+  ASSERT_EQ(feature_value->capacity(), 4UL);
+  ASSERT_EQ(feature_value->size(), 4UL);
+  ASSERT_FLOAT_EQ(feature_value->data()[0], 1.0);
+  ASSERT_FLOAT_EQ(feature_value->data()[1], 2.0);
+
+  feature_value->resize(1);
+  ASSERT_EQ(feature_value->capacity(), 2UL);
+  ASSERT_FLOAT_EQ(feature_value->data()[0], 1.0);
+  ASSERT_THROW(feature_value->resize(5), paddle::platform::EnforceNotMet);
+}
+
+TEST(SlabSparseTableShard, StableValue) {
+  SlabSparseTableShard shard(4, 2);
+  auto* feature_value = shard.Init(0);
+  feature_value->resize(3);
+  feature_value->data()[2] = 3.0;
+  // the value stays in place while the map grows, until it is erased
+  for (uint64_t key = 1; key < 10000; ++key) {
+    shard.Init(key)->resize(key % 5);
+  }
+  ASSERT_EQ(shard.GetValue(0), feature_value);
+  ASSERT_EQ(feature_value->size(), 3UL);
+  ASSERT_FLOAT_EQ(feature_value->data()[2], 3.0);
+  for (uint64_t key = 1; key < 10000; ++key) {
+    ASSERT_EQ(shard.GetValue(key)->size(), key % 5);
+  }
+}
+
+// Compares the two shard layouts with the access pattern of
+// MemorySparseTable: create every key, then a pull (copy out) and a push
+// (in-place update) over all of them. Set FEATURE_VALUE_BENCHMARK_KEY_NUM
+// to 100000000 for the full-size comparison.
+template <typename ShardType>
+void BenchmarkShard(ShardType* shard, size_t key_num, size_t dim) {
+  std::vector<float> buffer(dim, 0.0);
+  auto start = std::chrono::steady_clock::now();
+  for (uint64_t key = 0; key < key_num; ++key) {
+    auto* value = shard->Init(key);
+    value->resize(dim);
+    memcpy(value->data(), buffer.data(), dim * sizeof(float));
+  }
+  auto create_end = std::chrono::steady_clock::now();
+  for (uint64_t key = 0; key < key_num; ++key) {
+    auto itr = shard->Find(key * 7919 % key_num);
+    memcpy(buffer.data(), itr->second->data(),
+           itr->second->size() * sizeof(float));
+  }
+  auto pull_end = std::chrono::steady_clock::now();
+  for (uint64_t key = 0; key < key_num; ++key) {
+    auto itr = shard->Find(key * 7919 % key_num);
+    float* data = itr->second->data();
+    for (size_t i = 0; i < dim; ++i) {
+      data[i] += 0.1;
+    }
+  }
+  auto push_end = std::chrono::steady_clock::now();
+  auto ms = [](std::chrono::steady_clock::time_point begin,
+               std::chrono::steady_clock::time_point end) {
+    return std::chrono::duration<double, std::milli>(end - begin).count();
+  };
+  LOG(INFO) << "keys: " << key_num << " dim: " << dim
+            << " create: " << ms(start, create_end)
+            << "ms pull: " << ms(create_end, pull_end)
+            << "ms push: " << ms(pull_end, push_end) << "ms";
+}
+
+TEST(BENCHMARK, SlabSparseTableShard) {
+  size_t key_num = 1000000;
+  const char* env_key_num = std::getenv("FEATURE_VALUE_BENCHMARK_KEY_NUM");
+  if (env_key_num != nullptr) {
+    key_num = std::strtoull(env_key_num, nullptr, 10);
+  }
+  const size_t dim = 17;
+
+  {
+    SparseTableShard shard;
+    LOG(INFO) << "SparseTableShard";
+    BenchmarkShard(&shard, key_num, dim);
+  }
+  {
+    SlabSparseTableShard shard(dim, 0);
+    LOG(INFO) << "SlabSparseTableShard";
+    BenchmarkShard(&shard, key_num, dim);
+    LOG(INFO) << "slab memory: " << shard.slab_mem_size()
+              << " bytes, vector layout value memory at least: "
+              << key_num * (sizeof(FixedFeatureValue) + dim * sizeof(float))
+              << " bytes";
+  }
+}
+
 }  // namespace distributed
 }  // namespace paddle
@@ -0,0 +1,275 @@
+/* Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <set>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/distributed/ps.pb.h"
+#include "paddle/fluid/distributed/table/common_graph_table.h"
+
+namespace paddle {
+namespace distributed {
+
+const int node_num = 10000;
+const int degree = 50;
+
+void prepare_edge_file(const std::string &file_name, bool is_weighted) {
+  std::ofstream ofile(file_name);
+  for (int src = 0; src < node_num; src++) {
+    for (int j = 0; j < degree; j++) {
+      ofile << src << "\t" << (src * 7 + j * 13) % node_num;
+      if (is_weighted) {
+        ofile << "\t" << 1 + j % 5;
+      }
+      ofile << std::endl;
+    }
+  }
+  ofile.close();
+}
+
+std::shared_ptr<GraphTable> create_graph_table(bool use_csr) {
+  TableParameter table_config;
+  table_config.set_table_id(0);
+  table_config.set_table_class("GraphTable");
+  table_config.set_shard_num(127);
+  table_config.set_type(PS_SPARSE_TABLE);
+  table_config.set_use_graph_csr(use_csr);
+  table_config.mutable_accessor()->set_accessor_class("CommMergeAccessor");
+  FsClientParameter fs_config;
+
+  auto table = std::make_shared<GraphTable>();
+  table->set_shard(0, 1);
+  EXPECT_EQ(table->initialize(table_config, fs_config), 0);
+  return table;
+}
+
+std::vector<std::set<uint64_t>> sample_neighbors(GraphTable *table,
+                                                 std::vector<uint64_t> &ids,
+                                                 int sample_size) {
+  std::vector<std::shared_ptr<char>> buffers(ids.size());
+  std::vector<int> actual_sizes(ids.size(), 0);
+  table->random_sample_neighbors(ids.data(), sample_size, buffers,
+                                 actual_sizes, false);
+  std::vector<std::set<uint64_t>> res(ids.size());
+  for (size_t i = 0; i < ids.size(); i++) {
+    auto *neighbors = reinterpret_cast<uint64_t *>(buffers[i].get());
+    for (size_t j = 0; j < actual_sizes[i] / sizeof(uint64_t); j++) {
+      res[i].insert(neighbors[j]);
+    }
+  }
+  return res;
+}
+
+TEST(GraphTable, CSRSample) {
+  std::string file_name = "graph_csr_edges.txt";
+  prepare_edge_file(file_name, true);
+  auto table = create_graph_table(true);
+  ASSERT_EQ(table->load(file_name, "e>"), 0);
+
+  std::vector<uint64_t> ids = {0, 1, 2, 9999, node_num + 1};
+  // the whole neighborhood comes back when the sample size exceeds it
+  auto all = sample_neighbors(table.get(), ids, degree + 1);
+  for (size_t i = 0; i < ids.size(); i++) {
+    ASSERT_EQ(all[i].size(), ids[i] < node_num ? degree : 0);
+  }
+  auto res = sample_neighbors(table.get(), ids, 10);
+  for (size_t i = 0; i + 1 < ids.size(); i++) {
+    ASSERT_EQ(res[i].size(), 10);
+    for (auto id : res[i]) {
+      ASSERT_TRUE(all[i].count(id));
+    }
+  }
+
+  // removing a node goes back to the node edges and freezes them again
+  std::vector<uint64_t> remove_ids = {1};
+  table->remove_graph_node(remove_ids);
+  res = sample_neighbors(table.get(), ids, 10);
+  ASSERT_EQ(res[0].size(), 10);
+  ASSERT_EQ(res[1].size(), 0);
+
+  std::unique_ptr<char[]> buffer;
+  int actual_size = 0;
+  table->pull_graph_list(0, node_num, buffer, actual_size, false, 1);
+  ASSERT_EQ(actual_size, (node_num - 1) * (Node::id_size + Node::int_size));
+}
+
+TEST(GraphTable, CSRReload) {
+  // the nodes 50 to 99 have neighbors in both files
+  std::vector<std::string> file_names = {"graph_csr_edges_0.txt",
+                                         "graph_csr_edges_1.txt"};
+  std::vector<std::set<uint64_t>> expected(150);
+  for (size_t f = 0; f < file_names.size(); f++) {
+    std::ofstream ofile(file_names[f]);
+    for (uint64_t src = f * 50; src < f * 50 + 100; src++) {
+      for (uint64_t j = 0; j < 5; j++) {
+        uint64_t dst = 1000 + f * 100 + (src + j) % 100;
+        ofile << src << "\t" << dst << "\t" << 1 + j << std::endl;
+        expected[src].insert(dst);
+      }
+    }
+    ofile.close();
+  }
+
+  auto table = create_graph_table(true);
+  // a node without neighbors is frozen with the others
+  std::vector<uint64_t> isolated_ids = {500};
+  std::vector<bool> is_weighted = {true};
+  ASSERT_EQ(table->add_graph_node(isolated_ids, is_weighted), 0);
+  for (auto &file_name : file_names) {
+    ASSERT_EQ(table->load(file_name, "e>"), 0);
+  }
+
+  std::vector<uint64_t> ids;
+  for (uint64_t id = 0; id < expected.size(); id++) {
+    ids.push_back(id);
+  }
+  ids.push_back(500);
+  auto all = sample_neighbors(table.get(), ids, 20);
+  for (size_t i = 0; i < expected.size(); i++) {
+    ASSERT_EQ(all[i], expected[i]);
+  }
+  ASSERT_EQ(all.back().size(), 0);
+
+  auto res = sample_neighbors(table.get(), ids, 3);
+  for (size_t i = 0; i < expected.size(); i++) {
+    ASSERT_EQ(res[i].size(), 3);
+    for (auto id : res[i]) {
+      ASSERT_TRUE(expected[i].count(id));
+    }
+  }
+}
+
+TEST(GraphTable, CSRAliasFrequency) {
+  // the neighbors of node 0 have the weights 1 to 10
+  const int neighbor_num = 10;
+  std::string file_name = "graph_csr_alias_edges.txt";
+  std::ofstream ofile(file_name);
+  for (int j = 0; j < neighbor_num; j++) {
+    ofile << 0 << "\t" << 100 + j << "\t" << j + 1 << std::endl;
+  }
+  ofile.close();
+  auto table = create_graph_table(true);
+  ASSERT_EQ(table->load(file_name, "e>"), 0);
+
+  const int batch_size = 1000, round = 50;
+  std::vector<uint64_t> ids(batch_size, 0);
+  std::vector<int> counts(neighbor_num, 0);
+  for (int r = 0; r < round; r++) {
+    std::vector<std::shared_ptr<char>> buffers(batch_size);
+    std::vector<int> actual_sizes(batch_size, 0);
+    table->random_sample_neighbors(ids.data(), 1, buffers, actual_sizes,
+                                   false);
+    for (int i = 0; i < batch_size; i++) {
+      ASSERT_EQ(actual_sizes[i], static_cast<int>(sizeof(uint64_t)));
+      uint64_t id = *reinterpret_cast<uint64_t *>(buffers[i].get());
+      ASSERT_GE(id, 100UL);
+      ASSERT_LT(id, 100UL + neighbor_num);
+      counts[id - 100]++;
+    }
+  }
+
+  // Pearson's chi-square test against the weights with 9 degrees of
+  // freedom, a sampler drawing by the weights exceeds 33.72 with
+  // probability 1e-4
+  double total = batch_size * round;
+  double weight_sum = neighbor_num * (neighbor_num + 1) / 2.;
+  double chi_square = 0;
+  for (int j = 0; j < neighbor_num; j++) {
+    double expected = total * (j + 1) / weight_sum;
+    chi_square += (counts[j] - expected) * (counts[j] - expected) / expected;
+  }
+  ASSERT_LT(chi_square, 33.72);
+}
+
+TEST(GraphTable, CSRSampleWhileUpdate) {
+  // node i has the neighbors 10000 + 10 * i to 10000 + 10 * i + 9
+  const int sample_node_num = 500, neighbor_num = 10;
+  std::string file_name = "graph_csr_update_edges.txt";
+  std::ofstream ofile(file_name);
+  for (int i = 0; i < sample_node_num; i++) {
+    for (int j = 0; j < neighbor_num; j++) {
+      ofile << i << "\t" << 10000 + i * neighbor_num + j << "\t" << 1 + j
+            << std::endl;
+    }
+  }
+  ofile.close();
+  auto table = create_graph_table(true);
+  ASSERT_EQ(table->load(file_name, "e>"), 0);
+
+  // the nodes added and removed share the shards of the sampled nodes, and
+  // thaw them under the samples
+  std::atomic<bool> done{false};
+  std::thread sampler([&]() {
+    std::vector<uint64_t> ids(sample_node_num);
+    for (int i = 0; i < sample_node_num; i++) {
+      ids[i] = i;
+    }
+    while (!done) {
+      auto res = sample_neighbors(table.get(), ids, 3);
+      for (int i = 0; i < sample_node_num; i++) {
+        ASSERT_EQ(res[i].size(), 3UL);
+        for (auto id : res[i]) {
+          ASSERT_GE(id, 10000UL + i * neighbor_num);
+          ASSERT_LT(id, 10000UL + (i + 1) * neighbor_num);
+        }
+      }
+    }
+  });
+  std::vector<bool> is_weighted = {true};
+  for (uint64_t r = 0; r < 200; r++) {
+    std::vector<uint64_t> update_ids = {sample_node_num + r};
+    EXPECT_EQ(table->add_graph_node(update_ids, is_weighted), 0);
+    EXPECT_EQ(table->remove_graph_node(update_ids), 0);
+  }
+  done = true;
+  sampler.join();
+}
+
+TEST(BENCHMARK, GraphTableSample) {
+  const int batch_size = 512, sample_size = 10, round = 200;
+  for (bool is_weighted : {false, true}) {
+    std::string file_name = "graph_bench_edges.txt";
+    prepare_edge_file(file_name, is_weighted);
+    for (bool use_csr : {false, true}) {
+      auto table = create_graph_table(use_csr);
+      ASSERT_EQ(table->load(file_name, "e>"), 0);
+      std::vector<uint64_t> ids(batch_size);
+      auto start = std::chrono::steady_clock::now();
+      for (int r = 0; r < round; r++) {
+        for (int i = 0; i < batch_size; i++) {
+          ids[i] = (r * batch_size + i) * 31 % node_num;
+        }
+        std::vector<std::shared_ptr<char>> buffers(batch_size);
+        std::vector<int> actual_sizes(batch_size, 0);
+        table->random_sample_neighbors(ids.data(), sample_size, buffers,
+                                       actual_sizes, is_weighted);
+      }
+      auto end = std::chrono::steady_clock::now();
+      std::chrono::duration<double> diff = end - start;
+      LOG(INFO) << (is_weighted ? "weighted" : "random") << " sample on "
+                << (use_csr ? "csr" : "nodes") << ": "
+                << batch_size * round / diff.count() << " samples/sec";
+    }
+  }
+}
+
+}  // namespace distributed
+}  // namespace paddle
@@ -15,14 +15,19 @@ limitations under the License. */
 #include <ThreadPool.h>
 
 #include <unistd.h>
+#include <fstream>
+#include <sstream>
 #include <string>
 #include <thread>  // NOLINT
 
 #include "google/protobuf/text_format.h"
 #include "gtest/gtest.h"
 #include "paddle/fluid/distributed/ps.pb.h"
+#include "paddle/fluid/distributed/table/depends/sparse_binary_file.h"
 #include "paddle/fluid/distributed/table/memory_sparse_table.h"
+#include "paddle/fluid/distributed/table/sparse_table_convert.h"
 #include "paddle/fluid/distributed/table/table.h"
+#include "paddle/fluid/framework/io/fs.h"
 
 namespace paddle {
 namespace distributed {
@@ -136,5 +141,141 @@ TEST(MemorySparseTable, SGD) {
   ctr_table->save_local_fs("./work/table.save", "0", "test");
 }
 
+TEST(MemorySparseTable, SaveLoadBinary) {
+  int emb_dim = 8;
+
+  TableParameter table_config;
+  table_config.set_table_class("MemorySparseTable");
+  table_config.set_shard_num(2);
+  table_config.set_save_in_binary(true);
+  FsClientParameter fs_config;
+
+  TableAccessorParameter *accessor_config = table_config.mutable_accessor();
+  accessor_config->set_accessor_class("CtrCommonAccessor");
+  accessor_config->set_fea_dim(11);
+  accessor_config->set_embedx_dim(8);
+  accessor_config->set_embedx_threshold(5);
+  accessor_config->mutable_embed_sgd_param()->set_name("SparseNaiveSGDRule");
+  auto *naive_param =
+      accessor_config->mutable_embed_sgd_param()->mutable_naive();
+  naive_param->set_learning_rate(0.1);
+  naive_param->set_initial_range(0.3);
+  accessor_config->mutable_embedx_sgd_param()->set_name("SparseNaiveSGDRule");
+  naive_param = accessor_config->mutable_embedx_sgd_param()->mutable_naive();
+  naive_param->set_learning_rate(0.1);
+  naive_param->set_initial_range(0.3);
+
+  MemorySparseTable save_table;
+  save_table.set_shard(0, 1);
+  ASSERT_EQ(save_table.initialize(table_config, fs_config), 0);
+
+  std::vector<uint64_t> keys = {0, 1, 2, 3, 4, 1000, 1001};
+  std::vector<uint32_t> fres(keys.size(), 1);
+  auto pull_value = PullSparseValue(keys, fres, emb_dim);
+  std::vector<float> saved_values(keys.size() * (emb_dim + 1));
+  save_table.pull_sparse(saved_values.data(), pull_value);
+  // save_param 0 saves every feasign of CtrCommonAccessor
+  paddle::framework::localfs_mkdir("./work/binary_table/000");
+  ASSERT_EQ(save_table.save_local_fs("./work/binary_table", "0", "test"), 0);
+
+  MemorySparseTable load_table;
+  load_table.set_shard(0, 1);
+  ASSERT_EQ(load_table.initialize(table_config, fs_config), 0);
+  ASSERT_EQ(load_table.load_local_fs("./work/binary_table", "0"), 0);
+
+  std::vector<float> loaded_values(keys.size() * (emb_dim + 1));
+  load_table.pull_sparse(loaded_values.data(), pull_value);
+  for (size_t i = 0; i < saved_values.size(); ++i) {
+    ASSERT_FLOAT_EQ(saved_values[i], loaded_values[i]);
+  }
+}
+
+static std::string read_file(const std::string &path) {
+  std::ifstream is(path);
+  std::stringstream ss;
+  ss << is.rdbuf();
+  return ss.str();
+}
+
+TEST(MemorySparseTable, ConvertTextBinary) {
+  int emb_dim = 8;
+
+  TableParameter table_config;
+  table_config.set_table_class("MemorySparseTable");
+  table_config.set_shard_num(1);
+  FsClientParameter fs_config;
+
+  // a push of a click extends the mf part, so the values have both sizes
+  TableAccessorParameter *accessor_config = table_config.mutable_accessor();
+  accessor_config->set_accessor_class("CtrCommonAccessor");
+  accessor_config->set_fea_dim(11);
+  accessor_config->set_embedx_dim(8);
+  accessor_config->set_embedx_threshold(1);
+  accessor_config->mutable_embed_sgd_param()->set_name("SparseNaiveSGDRule");
+  auto *naive_param =
+      accessor_config->mutable_embed_sgd_param()->mutable_naive();
+  naive_param->set_learning_rate(0.1);
+  naive_param->set_initial_range(0.3);
+  accessor_config->mutable_embedx_sgd_param()->set_name("SparseNaiveSGDRule");
+  naive_param = accessor_config->mutable_embedx_sgd_param()->mutable_naive();
+  naive_param->set_learning_rate(0.1);
+  naive_param->set_initial_range(0.3);
+
+  MemorySparseTable save_table;
+  save_table.set_shard(0, 1);
+  ASSERT_EQ(save_table.initialize(table_config, fs_config), 0);
+
+  std::vector<uint64_t> keys = {0, 1, 2, 3, 4, 1000, 1001};
+  std::vector<uint32_t> fres(keys.size(), 1);
+  auto pull_value = PullSparseValue(keys, fres, emb_dim);
+  std::vector<float> init_values(keys.size() * (emb_dim + 1));
+  save_table.pull_sparse(init_values.data(), pull_value);
+  std::vector<uint64_t> push_keys = {0, 2, 1000};
+  // slot, show, click, embed_g and embedx_g of every key
+  std::vector<float> push_values;
+  for (size_t i = 0; i < push_keys.size(); ++i) {
+    push_values.insert(push_values.end(), {1, 2, 1});
+    push_values.insert(push_values.end(), emb_dim + 1, 0.1);
+  }
+  ASSERT_EQ(save_table.push_sparse(push_keys.data(), push_values.data(),
+                                   push_keys.size()),
+            0);
+  std::vector<float> saved_values(keys.size() * (emb_dim + 1));
+  save_table.pull_sparse(saved_values.data(), pull_value);
+
+  // save_param 0 saves every feasign of CtrCommonAccessor
+  paddle::framework::localfs_mkdir("./work/convert_text_table/000");
+  ASSERT_EQ(
+      save_table.save_local_fs("./work/convert_text_table", "0", "test"), 0);
+  std::string text_file = "./work/convert_text_table/000/part-test-000-00000";
+  paddle::framework::localfs_mkdir("./work/convert_binary_table/000");
+  std::string binary_file =
+      std::string("./work/convert_binary_table/000/part-test-000-00000") +
+      SPARSE_BINARY_FILE_SUFFIX;
+  std::string round_trip_file = "./work/part-test-000-00000.txt";
+
+  auto accessor = save_table.value_accesor();
+  ASSERT_EQ(sparse_text_to_binary(accessor.get(), *accessor_config, text_file,
+                                  binary_file),
+            static_cast<int64_t>(keys.size()));
+  ASSERT_EQ(sparse_binary_to_text(accessor.get(), binary_file,
+                                  round_trip_file),
+            static_cast<int64_t>(keys.size()));
+  ASSERT_EQ(read_file(round_trip_file), read_file(text_file));
+
+  // the converted binary file loads as the table that saved the text
+  MemorySparseTable load_table;
+  load_table.set_shard(0, 1);
+  ASSERT_EQ(load_table.initialize(table_config, fs_config), 0);
+  ASSERT_EQ(load_table.load_local_fs("./work/convert_binary_table", "0"), 0);
+  std::vector<float> loaded_values(keys.size() * (emb_dim + 1));
+  load_table.pull_sparse(loaded_values.data(), pull_value);
+  // the text keeps 6 significant digits
+  for (size_t i = 0; i < saved_values.size(); ++i) {
+    ASSERT_NEAR(saved_values[i], loaded_values[i], 1e-5);
+  }
+  ASSERT_NE(saved_values, init_values);
+}
+
 }  // namespace distributed
 }  // namespace paddle
@@ -0,0 +1,141 @@
+/* Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <chrono>  // NOLINT
+#include <map>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/distributed/ps.pb.h"
+#include "paddle/fluid/distributed/service/brpc_ps_client.h"
+#include "paddle/fluid/distributed/service/env.h"
+#include "paddle/fluid/distributed/service/ps_local_client.h"
+
+namespace paddle {
+namespace distributed {
+
+// Pushes the dense grads of a "sum" table through a PsLocalClient in every
+// compress type, checks that the error feedback keeps the sum of the grads,
+// and reports the bytes per step and the pushes per second.
+
+static const int kDenseDim = 100000;
+static const int kSteps = 200;
+static const int kWarmupSteps = 10;
+// the dims sent by a push after the warmup, by the ratio of 0.01
+static const int kSentDim = kDenseDim / 100;
+// enough for the random-k to have sent every dim of the residual
+static const int kFlushSteps = 2000;
+
+static PSParameter GetDenseTableProto(DenseCompressType type) {
+  PSParameter ps_param;
+  auto *table_param = ps_param.mutable_server_param()
+                          ->mutable_downpour_server_param()
+                          ->add_downpour_table_param();
+  table_param->set_table_id(0);
+  table_param->set_table_class("CommonDenseTable");
+  table_param->set_shard_num(256);
+  table_param->set_type(PS_DENSE_TABLE);
+  auto *compress_param = table_param->mutable_dense_compress_param();
+  compress_param->set_type(type);
+  compress_param->set_ratio(0.01);
+  compress_param->set_warmup_steps(kWarmupSteps);
+
+  auto *accessor_param = table_param->mutable_accessor();
+  accessor_param->set_accessor_class("CommMergeAccessor");
+  accessor_param->set_fea_dim(kDenseDim);
+
+  auto *common_param = table_param->mutable_common();
+  common_param->set_name("sum");
+  common_param->set_table_name("dense_compress_test_table");
+  common_param->set_trainer_num(1);
+  common_param->add_params("Param");
+  common_param->add_dims(kDenseDim);
+  common_param->add_initializers("fill_constant&0.0");
+  return ps_param;
+}
+
+TEST(PsLocalClient, DenseCompress) {
+  std::mt19937 rng(0);
+  std::uniform_real_distribution<float> dist(-1., 1.);
+  std::vector<std::vector<float>> grads(kSteps);
+  std::vector<double> grad_sum(kDenseDim, 0.);
+  for (auto &grad : grads) {
+    grad.resize(kDenseDim);
+    for (int i = 0; i < kDenseDim; ++i) {
+      grad[i] = dist(rng);
+      grad_sum[i] += grad[i];
+    }
+  }
+
+  for (auto type :
+       {DENSE_COMPRESS_NONE, DENSE_COMPRESS_TOPK, DENSE_COMPRESS_RANDOMK}) {
+    PaddlePSEnvironment env;
+    std::map<uint64_t, std::vector<Region>> regions;
+    PsLocalClient client;
+    ASSERT_EQ(client.configure(GetDenseTableProto(type), regions, env, 0), 0);
+    auto *compressor = client.dense_grad_compressor(0);
+    ASSERT_EQ(compressor == nullptr, type == DENSE_COMPRESS_NONE);
+
+    auto start = std::chrono::steady_clock::now();
+    for (auto &grad : grads) {
+      auto *closure = new DownpourBrpcClosure(1, [](void *done) {});
+      client.push_dense_raw_gradient(0, grad.data(), grad.size(), closure)
+          .wait();
+    }
+    std::chrono::duration<double> cost =
+        std::chrono::steady_clock::now() - start;
+
+    double dense_bytes = sizeof(uint32_t) + kDenseDim * sizeof(float);
+    double bytes_per_step = dense_bytes;
+    if (compressor != nullptr) {
+      auto stats = compressor->stats();
+      ASSERT_EQ(stats.push_num, static_cast<uint64_t>(kSteps));
+      ASSERT_EQ(stats.compressed_push_num,
+                static_cast<uint64_t>(kSteps - kWarmupSteps));
+      ASSERT_EQ(stats.sent_dim_num,
+                static_cast<uint64_t>(kWarmupSteps * kDenseDim +
+                                      (kSteps - kWarmupSteps) * kSentDim));
+      // the index and the value of each dim sent after the warmup
+      bytes_per_step =
+          sizeof(uint32_t) + kSentDim * (sizeof(uint32_t) + sizeof(float));
+      LOG(INFO) << DenseCompressType_Name(type) << " " << stats.to_string();
+
+      // sends the residual left by pushes of zeros
+      std::vector<float> zeros(kDenseDim, 0.);
+      for (int i = 0; i < kFlushSteps; ++i) {
+        auto *closure = new DownpourBrpcClosure(1, [](void *done) {});
+        client.push_dense_raw_gradient(0, zeros.data(), zeros.size(), closure)
+            .wait();
+      }
+    }
+    LOG(INFO) << DenseCompressType_Name(type)
+              << " bytes/step: " << bytes_per_step
+              << " (dense: " << dense_bytes
+              << "), pushes/sec: " << kSteps / cost.count();
+
+    // the param of the sum table is the sum of the grads applied, the same
+    // as the sum of the grads pushed once the residual is sent
+    std::vector<float> param(kDenseDim);
+    std::vector<Region> pull_regions = {Region(param.data(), param.size())};
+    client.pull_dense(pull_regions.data(), pull_regions.size(), 0).wait();
+    for (int i = 0; i < kDenseDim; ++i) {
+      ASSERT_NEAR(param[i], grad_sum[i], 1e-2);
+    }
+    client.finalize_worker();
+  }
+}
+
+}  // namespace distributed
+}  // namespace paddle
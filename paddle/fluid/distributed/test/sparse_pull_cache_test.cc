@@ -0,0 +1,274 @@
+/* Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/distributed/service/sparse_pull_cache.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/distributed/ps.pb.h"
+#include "paddle/fluid/distributed/service/env.h"
+#include "paddle/fluid/distributed/service/ps_local_client.h"
+
+namespace paddle {
+namespace distributed {
+
+// A stand-in server whose value of a key is the number of times it was pulled.
+class CountingPuller {
+ public:
+  explicit CountingPuller(size_t dim) : dim_(dim) {}
+
+  SparsePullCache::PullFunc func() {
+    return [this](float **values, const uint64_t *keys, size_t num,
+                  const SparsePullCache::PullDone &done) {
+      for (size_t i = 0; i < num; ++i) {
+        float count = ++counts_[keys[i]];
+        for (size_t j = 0; j < dim_; ++j) {
+          values[i][j] = count;
+        }
+      }
+      pulled_num_ += num;
+      done(0);
+      std::promise<int32_t> promise;
+      promise.set_value(0);
+      return promise.get_future();
+    };
+  }
+
+  size_t pulled_num() const { return pulled_num_; }
+
+ private:
+  size_t dim_;
+  size_t pulled_num_ = 0;
+  std::map<uint64_t, int> counts_;
+};
+
+static std::vector<float *> ValuePtrs(std::vector<float> *values, size_t num,
+                                      size_t dim) {
+  values->resize(num * dim);
+  std::vector<float *> ptrs;
+  for (size_t i = 0; i < num; ++i) {
+    ptrs.push_back(values->data() + i * dim);
+  }
+  return ptrs;
+}
+
+static void Pull(SparsePullCache *cache, CountingPuller *puller,
+                 const std::vector<uint64_t> &keys, size_t dim,
+                 std::vector<float> *values) {
+  auto ptrs = ValuePtrs(values, keys.size(), dim);
+  auto status = cache->pull_sparse(ptrs.data(), keys.data(), keys.size(),
+                                   puller->func());
+  ASSERT_EQ(status.get(), 0);
+}
+
+TEST(SparsePullCache, Staleness) {
+  const size_t dim = 4;
+  SparsePullCacheConfig config;
+  config.capacity = 64;
+  config.shard_num = 4;
+  config.staleness = 2;
+  SparsePullCache cache(config, dim * sizeof(float));
+  CountingPuller puller(dim);
+
+  std::vector<uint64_t> keys = {1, 2, 3, 4, 5, 6};
+  std::vector<float> values;
+  Pull(&cache, &puller, keys, dim, &values);
+  ASSERT_EQ(puller.pulled_num(), keys.size());
+  ASSERT_EQ(cache.size(), keys.size());
+
+  // the pulls of one training step do not age the values, however many
+  for (int i = 0; i < 4; ++i) {
+    Pull(&cache, &puller, keys, dim, &values);
+  }
+  ASSERT_EQ(puller.pulled_num(), keys.size());
+
+  // served from the cache within the staleness
+  for (int step = 0; step < 2; ++step) {
+    cache.advance_step();
+    Pull(&cache, &puller, keys, dim, &values);
+    ASSERT_EQ(puller.pulled_num(), keys.size());
+    for (auto value : values) {
+      ASSERT_EQ(value, 1.f);
+    }
+  }
+
+  // pulled again once expired
+  cache.advance_step();
+  Pull(&cache, &puller, keys, dim, &values);
+  ASSERT_EQ(puller.pulled_num(), 2 * keys.size());
+  for (auto value : values) {
+    ASSERT_EQ(value, 2.f);
+  }
+
+  auto stats = cache.stats();
+  ASSERT_EQ(stats.lookup_num, 8 * keys.size());
+  ASSERT_EQ(stats.hit_num, 6 * keys.size());
+  ASSERT_EQ(stats.expired_num, keys.size());
+  ASSERT_EQ(stats.hit_ratio(), 0.75);
+  ASSERT_EQ(stats.saved_bytes(),
+            6 * keys.size() * (sizeof(uint64_t) + dim * sizeof(float)));
+
+  cache.clear();
+  ASSERT_EQ(cache.size(), 0UL);
+  Pull(&cache, &puller, keys, dim, &values);
+  ASSERT_EQ(puller.pulled_num(), 3 * keys.size());
+}
+
+TEST(SparsePullCache, Evict) {
+  const size_t dim = 2;
+  SparsePullCacheConfig config;
+  config.capacity = 8;
+  config.shard_num = 1;
+  config.staleness = 1000;
+  SparsePullCache cache(config, dim * sizeof(float));
+  CountingPuller puller(dim);
+
+  // the hot keys are pulled by every batch and survive the cold ones
+  std::vector<uint64_t> hot_keys = {0, 1, 2, 3};
+  std::vector<float> values;
+  for (uint64_t key = 100; key < 120; ++key) {
+    Pull(&cache, &puller, hot_keys, dim, &values);
+    Pull(&cache, &puller, {key, key + 100}, dim, &values);
+  }
+  ASSERT_EQ(cache.size(), 8UL);
+  ASSERT_GT(cache.stats().evict_num, 0UL);
+
+  size_t pulled_num = puller.pulled_num();
+  Pull(&cache, &puller, hot_keys, dim, &values);
+  ASSERT_EQ(puller.pulled_num(), pulled_num);
+}
+
+TEST(SparsePullCache, ClearDuringPull) {
+  const size_t dim = 2;
+  SparsePullCacheConfig config;
+  config.capacity = 64;
+  config.shard_num = 4;
+  SparsePullCache cache(config, dim * sizeof(float));
+
+  // the pull completes after the table is reloaded
+  std::vector<uint64_t> keys = {1, 2, 3, 4};
+  std::vector<float> values;
+  auto ptrs = ValuePtrs(&values, keys.size(), dim);
+  SparsePullCache::PullDone pending_done;
+  std::promise<int32_t> promise;
+  auto status = cache.pull_sparse(
+      ptrs.data(), keys.data(), keys.size(),
+      [&](float **, const uint64_t *, size_t,
+          const SparsePullCache::PullDone &done) {
+        pending_done = done;
+        return promise.get_future();
+      });
+  cache.clear();
+  pending_done(0);
+  promise.set_value(0);
+  ASSERT_EQ(status.get(), 0);
+  ASSERT_EQ(cache.size(), 0UL);
+
+  // the pulls of the new generation are cached
+  CountingPuller puller(dim);
+  Pull(&cache, &puller, keys, dim, &values);
+  ASSERT_EQ(cache.size(), keys.size());
+}
+
+TEST(SparsePullCache, PsLocalClient) {
+  const int emb_dim = 8;
+  PSParameter ps_param;
+  auto *server_param = ps_param.mutable_server_param()
+                           ->mutable_downpour_server_param()
+                           ->add_downpour_table_param();
+  server_param->set_table_id(0);
+  server_param->set_table_class("MemorySparseTable");
+  server_param->set_shard_num(10);
+  server_param->set_type(PS_SPARSE_TABLE);
+
+  TableAccessorParameter *accessor_config = server_param->mutable_accessor();
+  accessor_config->set_accessor_class("CtrCommonAccessor");
+  accessor_config->set_fea_dim(11);
+  accessor_config->set_embedx_dim(emb_dim);
+  accessor_config->set_embedx_threshold(5);
+  accessor_config->mutable_ctr_accessor_param()->set_nonclk_coeff(0.2);
+  accessor_config->mutable_ctr_accessor_param()->set_click_coeff(1);
+  accessor_config->mutable_ctr_accessor_param()->set_base_threshold(0.5);
+  accessor_config->mutable_ctr_accessor_param()->set_delta_threshold(0.2);
+  accessor_config->mutable_ctr_accessor_param()->set_delta_keep_days(16);
+  accessor_config->mutable_ctr_accessor_param()->set_show_click_decay_rate(
+      0.99);
+  for (auto *sgd_param : {accessor_config->mutable_embed_sgd_param(),
+                          accessor_config->mutable_embedx_sgd_param()}) {
+    sgd_param->set_name("SparseNaiveSGDRule");
+    auto *naive_param = sgd_param->mutable_naive();
+    naive_param->set_learning_rate(0.1);
+    naive_param->set_initial_range(0.3);
+    naive_param->add_weight_bounds(-10.0);
+    naive_param->add_weight_bounds(10.0);
+  }
+
+  PaddlePSEnvironment env;
+  std::map<uint64_t, std::vector<Region>> regions;
+  PsLocalClient client;
+  ASSERT_EQ(client.configure(ps_param, regions, env, 0), 0);
+
+  size_t value_size = client.table_accessor(0)->select_size();
+  size_t dim = value_size / sizeof(float);
+  std::vector<uint64_t> keys = {0, 1, 2, 3, 4, 5, 6, 7};
+  auto pull = [&](std::vector<float> *values) {
+    values->resize(keys.size() * dim);
+    std::vector<float *> ptrs;
+    for (size_t i = 0; i < keys.size(); ++i) {
+      ptrs.push_back(values->data() + i * dim);
+    }
+    client.pull_sparse(ptrs.data(), 0, keys.data(), keys.size(), true).wait();
+  };
+  std::vector<float> uncached;
+  pull(&uncached);
+
+  SparsePullCacheConfig config;
+  config.capacity = 64;
+  config.shard_num = 4;
+  config.staleness = 4;
+  client.enable_sparse_pull_cache(0, config);
+  ASSERT_NE(client.sparse_pull_cache(0), nullptr);
+
+  // the first pull misses, the later ones are served by the cache with the
+  // same values as the table
+  for (int i = 0; i < 3; ++i) {
+    std::vector<float> cached;
+    pull(&cached);
+    ASSERT_EQ(cached, uncached);
+  }
+  auto stats = client.sparse_pull_cache(0)->stats();
+  ASSERT_EQ(stats.lookup_num, 3 * keys.size());
+  ASSERT_EQ(stats.hit_num, 2 * keys.size());
+  ASSERT_EQ(stats.saved_bytes(),
+            2 * keys.size() * (sizeof(uint64_t) + value_size));
+
+  // pulled from the table again after the staleness
+  for (uint32_t i = 0; i <= config.staleness; ++i) {
+    client.advance_sparse_pull_cache_step(0);
+  }
+  std::vector<float> expired;
+  pull(&expired);
+  ASSERT_EQ(expired, uncached);
+  ASSERT_EQ(client.sparse_pull_cache(0)->stats().expired_num, keys.size());
+  client.print_table_stat(0).wait();
+
+  client.clear(0).wait();
+  ASSERT_EQ(client.sparse_pull_cache(0)->size(), 0UL);
+}
+
+}  // namespace distributed
+}  // namespace paddle
@@ -13,8 +13,12 @@ See the License for the specific language governing permissions and
 limitations under the License. */
 
 #include "paddle/fluid/distributed/table/sparse_sgd_rule.h"
+#include <algorithm>
+#include <chrono>  // NOLINT
 #include <cmath>
 #include <iostream>
+#include <memory>
+#include <random>
 #include "gtest/gtest.h"
 #include "paddle/fluid/distributed/ps.pb.h"
 
@@ -187,5 +191,123 @@ TEST(downpour_sparse_adam_test, test_init_and_update) {
     ASSERT_FLOAT_EQ(value[i], label[i]) << "i is " << i;
   }
 }
+
+// Every kind of rule with the same learning rate and bounds.
+static std::vector<std::shared_ptr<SparseValueSGDRule>> CreateRules(
+    size_t embed_dim) {
+  std::vector<std::shared_ptr<SparseValueSGDRule>> rules;
+  SparseCommonSGDRuleParameter param;
+  auto* naive_param = param.mutable_naive();
+  naive_param->set_learning_rate(0.1);
+  naive_param->add_weight_bounds(-1.0);
+  naive_param->add_weight_bounds(1.0);
+  auto* adagrad_param = param.mutable_adagrad();
+  adagrad_param->set_learning_rate(0.1);
+  adagrad_param->set_initial_g2sum(3);
+  adagrad_param->add_weight_bounds(-1.0);
+  adagrad_param->add_weight_bounds(1.0);
+  auto* adam_param = param.mutable_adam();
+  adam_param->set_learning_rate(0.1);
+  adam_param->add_weight_bounds(-1.0);
+  adam_param->add_weight_bounds(1.0);
+
+  rules.emplace_back(new SparseNaiveSGDRule());
+  rules.emplace_back(new SparseAdaGradSGDRule());
+  rules.emplace_back(new StdAdaGradSGDRule());
+  rules.emplace_back(new SparseAdamSGDRule());
+  for (auto& rule : rules) {
+    rule->load_config(param, embed_dim);
+  }
+  return rules;
+}
+
+// The values of the keys, each a row of the embedding and the rule state.
+struct SGDRuleRows {
+  SGDRuleRows(SparseValueSGDRule* rule, size_t num, size_t embed_dim)
+      : row_dim(embed_dim + rule->dim()), data(num * row_dim) {
+    for (size_t i = 0; i < num; ++i) {
+      float* row = data.data() + i * row_dim;
+      rule->init_value(row, row + embed_dim, false);
+      w.push_back(row);
+      sgd.push_back(row + embed_dim);
+    }
+  }
+
+  size_t row_dim;
+  std::vector<float> data;
+  std::vector<float*> w;
+  std::vector<float*> sgd;
+};
+
+TEST(sparse_sgd_rule_batch_test, match_update_value) {
+  // not a multiple of the lanes, to run the tails
+  const size_t embed_dim = 13;
+  const size_t num = 37;
+  std::mt19937 rng(0);
+  std::uniform_real_distribution<float> dist(-2., 2.);
+  for (auto& rule : CreateRules(embed_dim)) {
+    SGDRuleRows rows(rule.get(), num, embed_dim);
+    SGDRuleRows batch_rows(rule.get(), num, embed_dim);
+    batch_rows.data = rows.data;
+    // a key pushed twice in a batch is updated twice in order
+    rows.w[5] = rows.w[3];
+    rows.sgd[5] = rows.sgd[3];
+    batch_rows.w[5] = batch_rows.w[3];
+    batch_rows.sgd[5] = batch_rows.sgd[3];
+
+    std::vector<float> grad(num * embed_dim);
+    std::vector<const float*> grad_ptrs(num);
+    for (int step = 0; step < 3; ++step) {
+      for (size_t i = 0; i < num; ++i) {
+        for (size_t j = 0; j < embed_dim; ++j) {
+          grad[i * embed_dim + j] = dist(rng);
+        }
+        grad_ptrs[i] = grad.data() + i * embed_dim;
+      }
+      for (size_t i = 0; i < num; ++i) {
+        rule->update_value(rows.w[i], rows.sgd[i], grad_ptrs[i], 2);
+      }
+      rule->update_value_batch(batch_rows.w.data(), batch_rows.sgd.data(),
+                               grad_ptrs.data(), num, 2);
+    }
+    for (size_t i = 0; i < rows.data.size(); ++i) {
+      ASSERT_NEAR(batch_rows.data[i], rows.data[i],
+                  1e-5 * std::max(1.f, std::fabs(rows.data[i])))
+          << rule->get_name() << " " << i;
+    }
+  }
+}
+
+TEST(sparse_sgd_rule_batch_test, benchmark) {
+  const size_t embed_dim = 64;
+  const size_t num = 100000;
+  std::vector<float> grad(num * embed_dim, 0.01);
+  std::vector<const float*> grad_ptrs(num);
+  for (size_t i = 0; i < num; ++i) {
+    grad_ptrs[i] = grad.data() + i * embed_dim;
+  }
+  auto keys_per_sec = [num](std::chrono::steady_clock::time_point start) {
+    std::chrono::duration<double> cost =
+        std::chrono::steady_clock::now() - start;
+    return num / cost.count();
+  };
+  const char* names[] = {"naive", "adagrad", "std_adagrad", "adam"};
+  auto rules = CreateRules(embed_dim);
+  for (size_t r = 0; r < rules.size(); ++r) {
+    auto& rule = rules[r];
+    SGDRuleRows rows(rule.get(), num, embed_dim);
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < num; ++i) {
+      rule->update_value(rows.w[i], rows.sgd[i], grad_ptrs[i]);
+    }
+    double reference = keys_per_sec(start);
+    start = std::chrono::steady_clock::now();
+    rule->update_value_batch(rows.w.data(), rows.sgd.data(), grad_ptrs.data(),
+                             num);
+    double batch = keys_per_sec(start);
+    LOG(INFO) << names[r] << " keys/sec of a thread, update_value: "
+              << reference << ", update_value_batch: " << batch;
+  }
+}
 }  // namespace distributed
 }  // namespace paddle
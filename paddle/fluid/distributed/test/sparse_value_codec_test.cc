@@ -0,0 +1,160 @@
+/* Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/distributed/service/sparse_value_codec.h"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace paddle {
+namespace distributed {
+
+static std::vector<float> RandomValue(size_t dim, std::mt19937 *rng) {
+  std::uniform_real_distribution<float> dist(-1., 1.);
+  std::vector<float> value(dim);
+  for (auto &x : value) {
+    x = dist(*rng);
+  }
+  return value;
+}
+
+TEST(SparseValueCodec, EncodedSize) {
+  // 1 fp32 dim and 8 quantized dims, like the pull value of CtrCommonAccessor
+  ASSERT_EQ(SparseValueCodec(SPARSE_VALUE_FP32, 9, 1).encoded_size(), 36UL);
+  ASSERT_EQ(SparseValueCodec(SPARSE_VALUE_FP16, 9, 1).encoded_size(), 20UL);
+  ASSERT_EQ(SparseValueCodec(SPARSE_VALUE_BF16, 9, 1).encoded_size(), 20UL);
+  ASSERT_EQ(SparseValueCodec(SPARSE_VALUE_INT8, 9, 1).encoded_size(), 16UL);
+  // nothing to quantize
+  ASSERT_EQ(SparseValueCodec(SPARSE_VALUE_INT8, 9, 9).encoded_size(), 36UL);
+}
+
+TEST(SparseValueCodec, RoundTrip) {
+  const size_t dim = 12;
+  const size_t quant_begin = 3;
+  std::mt19937 rng(0);
+  // the largest error relative to the largest magnitude of the value
+  std::vector<std::pair<SparseValueType, float>> types = {
+      {SPARSE_VALUE_FP32, 0.},
+      {SPARSE_VALUE_FP16, 1e-3},
+      {SPARSE_VALUE_BF16, 1e-2},
+      {SPARSE_VALUE_INT8, 1. / 127}};
+  for (auto &type : types) {
+    SparseValueCodec codec(type.first, dim, quant_begin);
+    std::vector<char> data(codec.encoded_size());
+    std::vector<float> decoded(dim);
+    for (int i = 0; i < 100; ++i) {
+      auto value = RandomValue(dim, &rng);
+      codec.encode(value.data(), data.data());
+      codec.decode(data.data(), decoded.data());
+      for (size_t j = 0; j < quant_begin; ++j) {
+        ASSERT_EQ(decoded[j], value[j]);
+      }
+      for (size_t j = quant_begin; j < dim; ++j) {
+        ASSERT_LE(std::fabs(decoded[j] - value[j]), type.second);
+      }
+    }
+  }
+}
+
+TEST(SparseValueCodec, ErrorFeedback) {
+  const size_t dim = 8;
+  SparseValueCodec codec(SPARSE_VALUE_INT8, dim, 0);
+  SparseValueResidual residual(dim);
+  std::mt19937 rng(0);
+  std::vector<char> data(codec.encoded_size());
+  std::vector<float> decoded(dim);
+  std::vector<float> sent_sum(dim, 0.);
+  std::vector<float> value_sum(dim, 0.);
+  uint64_t key = 1;
+  for (int i = 0; i < 1000; ++i) {
+    auto value = RandomValue(dim, &rng);
+    // a small dim is lost by the int8 without the feedback
+    value[0] *= 1e-3;
+    const float *values[] = {value.data()};
+    residual.encode(codec, &key, values, 1, data.data());
+    codec.decode(data.data(), decoded.data());
+    for (size_t j = 0; j < dim; ++j) {
+      sent_sum[j] += decoded[j];
+      value_sum[j] += value[j];
+    }
+  }
+  ASSERT_EQ(residual.size(), 1UL);
+  // the sums only differ by the last residual
+  for (size_t j = 0; j < dim; ++j) {
+    ASSERT_NEAR(sent_sum[j], value_sum[j], 1e-2);
+  }
+  residual.clear();
+  ASSERT_EQ(residual.size(), 0UL);
+}
+
+TEST(SparseValueCodec, ResidualCapacity) {
+  const size_t dim = 4;
+  SparseValueCodec codec(SPARSE_VALUE_INT8, dim, 0);
+  // a single shard of 4 keys
+  SparseValueResidual residual(dim, 4, 0., 1);
+  std::mt19937 rng(0);
+  std::vector<char> data(codec.encoded_size());
+  auto push = [&](uint64_t key) {
+    auto value = RandomValue(dim, &rng);
+    value[0] *= 1e-3;
+    const float *values[] = {value.data()};
+    residual.encode(codec, &key, values, 1, data.data());
+  };
+  for (uint64_t key = 0; key < 4; ++key) {
+    push(key);
+  }
+  ASSERT_EQ(residual.size(), 4UL);
+  ASSERT_EQ(residual.evicted_num(), 0UL);
+  // the sweep clears every key, then drops the first one
+  push(4);
+  ASSERT_EQ(residual.size(), 4UL);
+  ASSERT_EQ(residual.evicted_num(), 1UL);
+  // key 1 is pushed again and gets a second chance over key 2
+  push(1);
+  push(5);
+  ASSERT_EQ(residual.size(), 4UL);
+  ASSERT_EQ(residual.evicted_num(), 2UL);
+  push(1);
+  ASSERT_EQ(residual.evicted_num(), 2UL);
+  push(2);
+  ASSERT_EQ(residual.evicted_num(), 3UL);
+}
+
+TEST(SparseValueCodec, ResidualThreshold) {
+  const size_t dim = 4;
+  SparseValueCodec codec(SPARSE_VALUE_FP16, dim, 0);
+  SparseValueResidual residual(dim, 16, 1e-3);
+  std::vector<char> data(codec.encoded_size());
+  uint64_t key = 1;
+  // a value exact in fp16 leaves no error to keep
+  std::vector<float> exact(dim, 0.5);
+  const float *exact_values[] = {exact.data()};
+  residual.encode(codec, &key, exact_values, 1, data.data());
+  ASSERT_EQ(residual.size(), 0UL);
+  // an error above the threshold is kept until it falls below it again
+  std::vector<float> lossy(dim, 1000.3);
+  const float *lossy_values[] = {lossy.data()};
+  residual.encode(codec, &key, lossy_values, 1, data.data());
+  ASSERT_EQ(residual.size(), 1UL);
+  std::vector<float> zero(dim, 0.);
+  const float *zero_values[] = {zero.data()};
+  residual.encode(codec, &key, zero_values, 1, data.data());
+  ASSERT_EQ(residual.size(), 0UL);
+}
+
+}  // namespace distributed
+}  // namespace paddle
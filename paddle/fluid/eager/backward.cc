@@ -13,18 +13,38 @@
 // limitations under the License.
 
 #include "paddle/fluid/eager/backward.h"
+#include <algorithm>
+#include <condition_variable>  // NOLINT
+#include <exception>
+#include <functional>
+#include <mutex>  // NOLINT
 #include <queue>
+#include <tuple>
 
+#include "paddle/fluid/eager/api/utils/global_utils.h"
 #include "paddle/fluid/eager/autograd_meta.h"
 #include "paddle/fluid/eager/grad_node_info.h"
 #include "paddle/fluid/eager/grad_tensor_holder.h"
 #include "paddle/fluid/eager/utils.h"
 
+#include "paddle/fluid/framework/threadpool.h"
+#include "paddle/fluid/platform/device/gpu/gpu_info.h"
 #include "paddle/fluid/platform/enforce.h"
 #include "paddle/fluid/platform/errors.h"
+#include "paddle/fluid/platform/flags.h"
 
 #include "glog/logging.h"
 
+PADDLE_DEFINE_EXPORTED_int32(
+    eager_backward_thread_num, 1,
+    "The number of threads running the independent grad nodes of the eager "
+    "backward. The nodes run one by one in the calling thread if it is 1.");
+PADDLE_DEFINE_EXPORTED_bool(
+    eager_backward_deterministic, true,
+    "Whether the grads of a node are summed in the same order in every run "
+    "of the parallel eager backward, so that the results are bitwise "
+    "reproducible.");
+
 namespace egr {
 
 std::unordered_map<GradNodeBase*, int> getInDegreeMap(
@@ -79,6 +99,233 @@ void RunBackwardHooks(
   grad_node->ApplyReduceHooks();
 }
 
+// A grad sent to a node in the parallel backward.
+struct PendingGrad {
+  // the id of the sending node and the rank of the grad in its outputs
+  size_t producer_id;
+  size_t producer_slot;
+  size_t producer_rank;
+  // the rank of the grad in the inputs of the receiving node
+  size_t slot;
+  size_t rank;
+  egr::EagerTensor tensor;
+};
+
+// The state of a grad node in the parallel backward.
+struct ParallelNodeState {
+  // the position of the node in the BFS from the starting nodes
+  size_t id = 0;
+  // guards in_degree, input_buffer and pending_grads
+  std::mutex mutex;
+  int in_degree = 0;
+  std::unique_ptr<GradTensorHolder> input_buffer;
+  // In the deterministic mode the grads are summed in the order of the
+  // producers once the node is ready, instead of the order they arrive.
+  std::vector<PendingGrad> pending_grads;
+};
+
+// The thread local state a grad node may read, taken from the thread calling
+// the backward and set on the worker running the node.
+struct BackwardThreadState {
+  bool has_grad;
+#if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
+  int device_id;
+#endif
+
+  static BackwardThreadState Current() {
+    BackwardThreadState state;
+    state.has_grad = egr::Controller::Instance().HasGrad();
+#if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
+    state.device_id = paddle::platform::GetCurrentDeviceId();
+#endif
+    return state;
+  }
+
+  void Apply() const {
+    egr::Controller::Instance().SetHasGrad(has_grad);
+#if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
+    paddle::platform::SetDeviceId(device_id);
+#endif
+  }
+};
+
+static std::shared_ptr<paddle::framework::ThreadPool> GetBackwardThreadPool(
+    int thread_num) {
+  static std::mutex mutex;
+  static std::shared_ptr<paddle::framework::ThreadPool> pool;
+  static int pool_thread_num = 0;
+  std::lock_guard<std::mutex> lock(mutex);
+  if (!pool || pool_thread_num != thread_num) {
+    // the backwards still running keep the previous pool alive
+    pool = std::make_shared<paddle::framework::ThreadPool>(thread_num);
+    pool_thread_num = thread_num;
+  }
+  return pool;
+}
+
+// Runs the nodes whose in-degree drops to zero on a thread pool, so that the
+// independent branches of the graph run at the same time. The grads sent to
+// a node are summed under the lock of the node. A node runs with the grad
+// mode and the current device of the calling thread.
+static void RunBackwardParallel(
+    const std::queue<GradNodeBase*>& init_queue,
+    std::unordered_map<GradNodeBase*, std::unique_ptr<GradTensorHolder>>*
+        node_input_buffers_dict,
+    const std::unordered_map<GradNodeBase*, int>& node_in_degree_map,
+    int thread_num, bool deterministic) {
+  // 1. Create the states of all the nodes up front, the map is only read
+  // while the nodes run
+  std::unordered_map<GradNodeBase*, std::unique_ptr<ParallelNodeState>> states;
+  std::vector<GradNodeBase*> ready_nodes;
+  std::queue<GradNodeBase*> queue = init_queue;
+  while (!queue.empty()) {
+    GradNodeBase* node = queue.front();
+    queue.pop();
+    if (states.count(node)) continue;
+
+    auto state = std::make_unique<ParallelNodeState>();
+    state->id = states.size();
+    auto in_degree = node_in_degree_map.find(node);
+    if (in_degree != node_in_degree_map.end()) {
+      state->in_degree = in_degree->second;
+    }
+    auto buffer = node_input_buffers_dict->find(node);
+    if (buffer != node_input_buffers_dict->end()) {
+      state->input_buffer = std::move(buffer->second);
+    }
+    if (state->in_degree == 0) {
+      ready_nodes.push_back(node);
+    }
+    states[node] = std::move(state);
+
+    for (const auto& edge_list : node->GetEdges()) {
+      for (const Edge& edge : edge_list) {
+        GradNodeBase* next_node = edge.GetMutableGradNode().get();
+        if (next_node) queue.push(next_node);
+      }
+    }
+  }
+  node_input_buffers_dict->clear();
+
+  // 2. Run the ready nodes until no node is running
+  auto pool = GetBackwardThreadPool(thread_num);
+  const BackwardThreadState caller_state = BackwardThreadState::Current();
+  std::mutex done_mutex;
+  std::condition_variable done_cond;
+  size_t running_num = 0;
+  std::exception_ptr error;
+
+  std::function<void(GradNodeBase*)> schedule;
+  auto run_node = [&](GradNodeBase* node) {
+    ParallelNodeState* state = states.at(node).get();
+    // Nothing is sent to the node once it is ready, so the buffer is only
+    // touched by this thread from now on
+    if (!state->input_buffer) {
+      state->input_buffer =
+          std::make_unique<GradTensorHolder>(node->InputMeta());
+    }
+    if (!state->pending_grads.empty()) {
+      auto& pending_grads = state->pending_grads;
+      std::sort(pending_grads.begin(), pending_grads.end(),
+                [](const PendingGrad& a, const PendingGrad& b) {
+                  return std::tie(a.producer_id, a.producer_slot,
+                                  a.producer_rank) <
+                         std::tie(b.producer_id, b.producer_slot,
+                                  b.producer_rank);
+                });
+      for (const auto& grad : pending_grads) {
+        state->input_buffer->add(grad.slot, grad.rank, grad.tensor);
+      }
+      pending_grads.clear();
+    }
+    std::unique_ptr<GradTensorHolder> node_input_buffer =
+        std::move(state->input_buffer);
+
+    RunBackwardHooks(node_input_buffer->Buffers(), node);
+    std::vector<std::vector<egr::EagerTensor>> grad_output_tensors =
+        (*node)(node_input_buffer->Buffers());
+    node_input_buffer.reset();
+
+    const std::vector<std::vector<Edge>>& edges = node->GetEdges();
+    PADDLE_ENFORCE(edges.size() == grad_output_tensors.size() || edges.empty(),
+                   paddle::platform::errors::Fatal(
+                       "Number of edges should be either empty ( for leaf node "
+                       ") or the same as number of output grad tensors"));
+    for (size_t i = 0; i < edges.size(); i++) {
+      for (size_t j = 0; j < edges[i].size(); j++) {
+        const Edge& edge = edges[i][j];
+        GradNodeBase* next_node = edge.GetMutableGradNode().get();
+        if (!next_node) continue;
+
+        auto edge_rank = edge.GetEdgeRankInfo();
+        egr::EagerTensor& grad_output_tensor = grad_output_tensors[i][j];
+        ParallelNodeState* next_state = states.at(next_node).get();
+        bool ready = false;
+        {
+          std::lock_guard<std::mutex> lock(next_state->mutex);
+          if (deterministic) {
+            next_state->pending_grads.push_back(
+                {state->id, i, j, edge_rank.first, edge_rank.second,
+                 grad_output_tensor});
+          } else {
+            if (!next_state->input_buffer) {
+              next_state->input_buffer =
+                  std::make_unique<GradTensorHolder>(next_node->InputMeta());
+            }
+            next_state->input_buffer->add(edge_rank.first, edge_rank.second,
+                                          grad_output_tensor);
+          }
+          next_state->in_degree--;
+          PADDLE_ENFORCE(next_state->in_degree >= 0,
+                         paddle::platform::errors::Fatal(
+                             "Detected in-degree value smaller than zero."
+                             "Node's in-degree cannot be negative"));
+          ready = next_state->in_degree == 0;
+        }
+        if (ready) schedule(next_node);
+      }
+    }
+  };
+
+  schedule = [&](GradNodeBase* node) {
+    {
+      std::lock_guard<std::mutex> lock(done_mutex);
+      ++running_num;
+    }
+    pool->RunAndGetException([&, node] {
+      bool failed = false;
+      {
+        std::lock_guard<std::mutex> lock(done_mutex);
+        failed = error != nullptr;
+      }
+      // the nodes after a failed one are dropped
+      if (!failed) {
+        auto worker_state = BackwardThreadState::Current();
+        caller_state.Apply();
+        try {
+          run_node(node);
+        } catch (...) {
+          std::lock_guard<std::mutex> lock(done_mutex);
+          if (!error) error = std::current_exception();
+        }
+        worker_state.Apply();
+      }
+      std::lock_guard<std::mutex> lock(done_mutex);
+      if (--running_num == 0) done_cond.notify_all();
+    });
+  };
+
+  VLOG(6) << "Run Backward on " << thread_num << " threads, "
+          << ready_nodes.size() << " of " << states.size()
+          << " nodes ready at first";
+  for (GradNodeBase* node : ready_nodes) {
+    schedule(node);
+  }
+  std::unique_lock<std::mutex> lock(done_mutex);
+  done_cond.wait(lock, [&] { return running_num == 0; });
+  if (error) std::rethrow_exception(error);
+}
+
 void RunBackward(const std::vector<egr::EagerTensor>& tensors,
                  const std::vector<egr::EagerTensor>& grad_tensors,
                  bool retain_graph) {
@@ -144,6 +391,13 @@ void RunBackward(const std::vector<egr::EagerTensor>& tensors,
   std::unordered_map<GradNodeBase*, int> node_in_degree_map =
       getInDegreeMap(queue);
 
+  if (FLAGS_eager_backward_thread_num > 1) {
+    RunBackwardParallel(queue, &node_input_buffers_dict, node_in_degree_map,
+                        FLAGS_eager_backward_thread_num,
+                        FLAGS_eager_backward_deterministic);
+    return;
+  }
+
   /* --- Topological Visit --- */
   // 1. Pop queue
   // 2. Run node
@@ -38,6 +38,7 @@ using namespace egr_utils_api;  // NOLINT
 
 // Disable pten path
 DECLARE_bool(run_pten_kernel);
+DECLARE_int32(eager_backward_thread_num);
 
 TEST(Benchmark, Init) { FLAGS_run_pten_kernel = false; }
 
@@ -180,6 +181,45 @@ TEST(Benchmark, EagerIntermediateMLPCPU) {
   }
 }
 
+TEST(Benchmark, EagerParallelBackwardCPU) {
+  // Prepare Device Contexts
+  eager_test::InitEnv(paddle::platform::CPUPlace());
+
+  // independent branches of scale ops from one leaf, whose grad nodes the
+  // parallel backward runs at the same time
+  const size_t branch_num = 32;
+  const size_t depth = 8;
+  paddle::framework::DDim ddim = paddle::framework::make_ddim({16, 16, 64, 64});
+  for (int thread_num : {1, 2, 4, 8}) {
+    FLAGS_eager_backward_thread_num = thread_num;
+    egr::EagerTensor leaf = CreateTensorWithValue(
+        ddim, paddle::platform::CPUPlace(), pten::DataType::FLOAT32,
+        pten::DataLayout::NCHW, 1.0, true);
+    RetainGradForTensor(leaf);
+    std::vector<EagerTensor> target_tensors;
+    for (size_t i = 0; i < branch_num; i++) {
+      EagerTensor out = leaf;
+      for (size_t j = 0; j < depth; j++) {
+        out = egr::scale(out, 2.0, 0.0, true /*bias_after_scale*/,
+                         true /*trace_backward*/);
+      }
+      target_tensors.emplace_back(std::move(out));
+    }
+
+    auto t_start = std::chrono::high_resolution_clock::now();
+    RunBackward(target_tensors, {});
+    auto t_end = std::chrono::high_resolution_clock::now();
+    double elapsed_time_ms =
+        std::chrono::duration<double, std::milli>(t_end - t_start).count();
+    eager_test::CompareGradTensorWithValue<float>(leaf, branch_num * 256.0);
+    std::cout << "Backward of " << branch_num << " branches of " << depth
+              << " scale ops on " << thread_num
+              << " threads, Duration: " << elapsed_time_ms << " ms"
+              << std::endl;
+  }
+  FLAGS_eager_backward_thread_num = 1;
+}
+
 USE_OP(scale);
 USE_OP(elementwise_add);
 USE_OP(matmul_v2);
@@ -12,6 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <cstring>
 #include <sstream>
 
 #include "glog/logging.h"
@@ -30,6 +31,9 @@
 #include "paddle/pten/core/dense_tensor.h"
 #include "paddle/pten/core/tensor_meta.h"
 
+DECLARE_int32(eager_backward_thread_num);
+DECLARE_bool(eager_backward_deterministic);
+
 namespace egr {
 
 TEST(Backward, SingleNodeEmptyGrad) {
@@ -315,4 +319,138 @@ TEST(Backward, WithAccumulation) {
   eager_test::CompareGradTensorWithValue<float>(leaf_tensor, 2500.0);
 }
 
+/*
+      AccumulationNode
+      |      |      |
+Node(0,D-1) ... Node(N-1,D-1)
+      |             |
+     ...           ...
+      |             |
+  Node(0,0) ... Node(N-1,0)
+      |             |
+    inp0   ...   inpN-1
+*/
+// Builds N independent chains of D scale nodes ending in the accumulation
+// node of leaf_tensor, and returns the target tensors.
+static std::vector<egr::EagerTensor> BuildWideGraph(
+    size_t branch_num, size_t depth, const paddle::framework::DDim& ddim,
+    egr::EagerTensor* leaf_tensor, float scale = 2.0) {
+  std::vector<egr::EagerTensor> target_tensors;
+  auto acc_node_ptr = std::make_shared<egr::GradNodeAccumulation>();
+  AutogradMeta* leaf_meta = EagerUtils::autograd_meta(leaf_tensor);
+  leaf_meta->SetGradNode(std::dynamic_pointer_cast<GradNodeBase>(acc_node_ptr));
+  leaf_meta->SetSingleOutRankWithSlot(0, 0);
+  egr_utils_api::RetainGradForTensor(*leaf_tensor);
+
+  for (size_t i = 0; i < branch_num; i++) {
+    target_tensors.emplace_back(egr_utils_api::CreateTensorWithValue(
+        ddim, paddle::platform::CPUPlace(), pten::DataType::FLOAT32,
+        pten::DataLayout::NCHW, 1.0 /*value*/, false /*is_leaf*/));
+    std::shared_ptr<GradNodeBase> next_node = acc_node_ptr;
+    for (size_t j = 0; j < depth; j++) {
+      auto node_ptr = std::make_shared<GradNodeScale>(1, 1);
+      node_ptr->SetAttributes_scale(scale);
+      node_ptr->SetDefaultGradInOutMeta();
+      auto meta = egr::AutogradMeta();
+      meta.SetSingleOutRankWithSlot(0, 0);
+      meta.SetGradNode(next_node);
+      node_ptr->AddEdges({&meta}, 0);
+      next_node = node_ptr;
+    }
+    AutogradMeta* auto_grad_meta =
+        EagerUtils::autograd_meta(&(target_tensors[i]));
+    auto_grad_meta->SetGradNode(next_node);
+    auto_grad_meta->SetSingleOutRankWithSlot(0, 0);
+  }
+  return target_tensors;
+}
+
+TEST(Backward, ParallelWideGraph) {
+  // Prepare Device Contexts
+  eager_test::InitEnv(paddle::platform::CPUPlace());
+  paddle::framework::DDim ddim = paddle::framework::make_ddim({4, 16, 16, 32});
+
+  for (bool deterministic : {true, false}) {
+    FLAGS_eager_backward_thread_num = 4;
+    FLAGS_eager_backward_deterministic = deterministic;
+    egr::EagerTensor leaf_tensor;
+    std::vector<egr::EagerTensor> target_tensors =
+        BuildWideGraph(16 /*branch_num*/, 3 /*depth*/, ddim, &leaf_tensor);
+    RunBackward(target_tensors, {});
+    // 16 branches of 2^3
+    eager_test::CompareGradTensorWithValue<float>(leaf_tensor, 128.0);
+  }
+  FLAGS_eager_backward_thread_num = 1;
+  FLAGS_eager_backward_deterministic = true;
+}
+
+static std::vector<float> GradData(const egr::EagerTensor& tensor) {
+  egr::AutogradMeta* meta = egr::EagerUtils::unsafe_autograd_meta(tensor);
+  auto grad_dense =
+      std::dynamic_pointer_cast<pten::DenseTensor>(meta->Grad().impl());
+  const float* ptr = grad_dense->mutable_data<float>();
+  return std::vector<float>(ptr, ptr + grad_dense->numel());
+}
+
+TEST(Backward, ParallelDeterministic) {
+  eager_test::InitEnv(paddle::platform::CPUPlace());
+  paddle::framework::DDim ddim = paddle::framework::make_ddim({4, 16});
+  const size_t branch_num = 16;
+  FLAGS_eager_backward_thread_num = 4;
+  FLAGS_eager_backward_deterministic = true;
+
+  // the grads are not exact in float, so the order of summing them at the
+  // leaf changes the result
+  std::vector<float> first_grad;
+  for (int run = 0; run < 10; run++) {
+    egr::EagerTensor leaf_tensor;
+    std::vector<egr::EagerTensor> target_tensors =
+        BuildWideGraph(branch_num, 3 /*depth*/, ddim, &leaf_tensor, 1.1);
+    std::vector<egr::EagerTensor> grad_tensors;
+    for (size_t i = 0; i < branch_num; i++) {
+      grad_tensors.emplace_back(egr_utils_api::CreateTensorWithValue(
+          ddim, paddle::platform::CPUPlace(), pten::DataType::FLOAT32,
+          pten::DataLayout::NCHW, 0.1 * (i + 1) / 7 /*value*/,
+          false /*is_leaf*/));
+    }
+    RunBackward(target_tensors, grad_tensors);
+    auto grad = GradData(leaf_tensor);
+    if (run == 0) {
+      first_grad = grad;
+      continue;
+    }
+    ASSERT_EQ(grad.size(), first_grad.size());
+    ASSERT_EQ(std::memcmp(grad.data(), first_grad.data(),
+                          grad.size() * sizeof(float)),
+              0);
+  }
+  FLAGS_eager_backward_thread_num = 1;
+}
+
+TEST(Backward, ParallelThreadState) {
+  eager_test::InitEnv(paddle::platform::CPUPlace());
+  paddle::framework::DDim ddim = paddle::framework::make_ddim({4, 16});
+  FLAGS_eager_backward_thread_num = 4;
+
+  // the nodes run on the workers in the grad mode of the caller
+  for (bool has_grad : {false, true}) {
+    egr::EagerTensor leaf_tensor;
+    std::vector<egr::EagerTensor> target_tensors =
+        BuildWideGraph(8 /*branch_num*/, 2 /*depth*/, ddim, &leaf_tensor);
+    bool hook_has_grad = !has_grad;
+    std::function<egr::EagerTensor(const egr::EagerTensor&)> hook =
+        [&](const egr::EagerTensor& grad) {
+          hook_has_grad = egr::Controller::Instance().HasGrad();
+          return grad;
+        };
+    egr_utils_api::RegisterGradientHookForTensor(leaf_tensor, hook);
+    egr::Controller::Instance().SetHasGrad(has_grad);
+    RunBackward(target_tensors, {});
+    egr::Controller::Instance().SetHasGrad(true);
+    ASSERT_EQ(hook_has_grad, has_grad);
+    eager_test::CompareGradTensorWithValue<float>(leaf_tensor, 32.0);
+  }
+  FLAGS_eager_backward_thread_num = 1;
+}
+
 }  // namespace egr
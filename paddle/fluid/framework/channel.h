@@ -21,18 +21,138 @@
 
 #include <glog/logging.h>
 #include <algorithm>
+#include <atomic>
 #include <condition_variable>  // NOLINT
+#include <cstdint>
 #include <deque>
 #include <limits>
 #include <memory>
 #include <mutex>  // NOLINT
+#include <thread>  // NOLINT
 #include <utility>
 #include <vector>
+#if defined(_M_X64) || defined(__x86_64__) || defined(_M_IX86) || \
+    defined(__i386__)
+#include <immintrin.h>
+#endif
 #include "paddle/fluid/framework/expect.h"
 
 namespace paddle {
 namespace framework {
 
+// Tells the CPU the thread is in a spin-wait loop.
+inline void ChannelCpuRelax() {
+#if defined(_M_X64) || defined(__x86_64__) || defined(_M_IX86) || \
+    defined(__i386__)
+  _mm_pause();
+#endif
+}
+
+// A bounded lock-free MPMC queue on a ring buffer (Dmitry Vyukov's bounded
+// queue). Every cell holds a sequence number that tells whether it is ready
+// for the push or the pop of a position, so pushes and pops only contend on
+// their own position with a CAS. The capacity is rounded up to a power of 2.
+template <class T>
+class ChannelRing {
+ public:
+  explicit ChannelRing(size_t capacity) {
+    size_t size = 2;
+    while (size < capacity) {
+      size <<= 1;
+    }
+    mask_ = size - 1;
+    cells_.reset(new Cell[size]);
+    for (size_t i = 0; i < size; ++i) {
+      cells_[i].seq.store(i, std::memory_order_relaxed);
+    }
+    enqueue_pos_.store(0, std::memory_order_relaxed);
+    dequeue_pos_.store(0, std::memory_order_relaxed);
+  }
+
+  size_t Capacity() const { return mask_ + 1; }
+
+  // the value is only moved from when the push succeeds
+  template <class U>
+  bool TryPush(U&& val) {
+    Cell* cell = nullptr;
+    size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    for (;;) {
+      cell = &cells_[pos & mask_];
+      size_t seq = cell->seq.load(std::memory_order_acquire);
+      intptr_t dif = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+      if (dif == 0) {
+        if (enqueue_pos_.compare_exchange_weak(pos, pos + 1,
+                                               std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (dif < 0) {
+        return false;  // full
+      } else {
+        pos = enqueue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+    cell->data = std::forward<U>(val);
+    cell->seq.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool TryPop(T* val) {
+    Cell* cell = nullptr;
+    size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+    for (;;) {
+      cell = &cells_[pos & mask_];
+      size_t seq = cell->seq.load(std::memory_order_acquire);
+      intptr_t dif =
+          static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+      if (dif == 0) {
+        if (dequeue_pos_.compare_exchange_weak(pos, pos + 1,
+                                               std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (dif < 0) {
+        return false;  // empty
+      } else {
+        pos = dequeue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+    *val = std::move(cell->data);
+    cell->seq.store(pos + mask_ + 1, std::memory_order_release);
+    return true;
+  }
+
+  // the claimed positions, a pop or push in progress is counted
+  size_t Size() const {
+    size_t dequeue_pos = dequeue_pos_.load(std::memory_order_acquire);
+    size_t enqueue_pos = enqueue_pos_.load(std::memory_order_acquire);
+    return enqueue_pos > dequeue_pos ? enqueue_pos - dequeue_pos : 0;
+  }
+
+ private:
+  struct Cell {
+    std::atomic<size_t> seq;
+    T data;
+  };
+
+  static constexpr size_t kCacheLineSize = 64;
+
+  char pad0_[kCacheLineSize];
+  size_t mask_;
+  std::unique_ptr<Cell[]> cells_;
+  char pad1_[kCacheLineSize];
+  std::atomic<size_t> enqueue_pos_;
+  char pad2_[kCacheLineSize - sizeof(std::atomic<size_t>)];
+  std::atomic<size_t> dequeue_pos_;
+  char pad3_[kCacheLineSize - sizeof(std::atomic<size_t>)];
+};
+
+// The storage of a ChannelObject. kLockFreeRing suits channels shared by many
+// reader and writer threads, its capacity must be bounded and is allocated at
+// once.
+enum class ChannelBackend {
+  kMutexDeque,
+  kLockFreeRing,
+};
+
 template <class T>
 class ChannelObject {
  public:
@@ -43,8 +163,36 @@ class ChannelObject {
     capacity_ = (std::min)(MaxCapacity(), capacity);
   }
 
-  const std::deque<T>& GetData() const { return data_; }
+  // capacity must be in [1, MaxCapacity()] for kLockFreeRing, and it is
+  // rounded up to a power of 2
+  ChannelObject(size_t capacity, ChannelBackend backend) {
+    if (backend == ChannelBackend::kLockFreeRing) {
+      CHECK(capacity >= 1 && capacity <= MaxCapacity())
+          << "capacity of a lock free channel must be in [1, "
+          << MaxCapacity() << "], but got " << capacity;
+      ring_.reset(new ChannelRing<T>(capacity));
+      capacity_ = ring_->Capacity();
+    } else {
+      capacity_ = (std::min)(MaxCapacity(), capacity);
+    }
+  }
+
+  ChannelBackend Backend() const {
+    return ring_ ? ChannelBackend::kLockFreeRing : ChannelBackend::kMutexDeque;
+  }
+
+  const std::deque<T>& GetData() const {
+    CHECK(!ring_) << "GetData is not supported by a lock free channel";
+    return data_;
+  }
   void Clear() {
+    if (ring_) {
+      T val;
+      while (ring_->TryPop(&val)) {
+      }
+      RingNotify(&full_cond_, &ring_full_waiters_);
+      return;
+    }
     std::unique_lock<std::mutex> lock(mutex_);
     data_.clear();
     data_.shrink_to_fit();
@@ -55,6 +203,7 @@ class ChannelObject {
   }
 
   void SetCapacity(size_t x) {  // capacity can be zero
+    CHECK(!ring_) << "capacity of a lock free channel can not be changed";
     std::lock_guard<std::mutex> lock(mutex_);
     capacity_ = std::min(MaxCapacity(), x);
     Notify();
@@ -72,6 +221,7 @@ class ChannelObject {
 
   template <class U>
   void InheritFrom(const std::shared_ptr<ChannelObject<U>>& other) {
+    CHECK(!ring_) << "capacity of a lock free channel can not be changed";
     std::lock_guard<std::mutex> lock(mutex_);
     capacity_ = other->Capacity();
     block_size_ = other->BlockSize();
@@ -85,22 +235,35 @@ class ChannelObject {
   void Open() {
     std::lock_guard<std::mutex> lock(mutex_);
     closed_ = false;
-    Notify();
+    if (!ring_) {
+      Notify();
+    }
   }
 
   // close channel, then no more data can be write() to channel
   void Close() {
     std::lock_guard<std::mutex> lock(mutex_);
     closed_ = true;
-    Notify();
+    if (ring_) {
+      empty_cond_.notify_all();
+      full_cond_.notify_all();
+    } else {
+      Notify();
+    }
   }
 
   size_t Size() {
+    if (ring_) {
+      return ring_->Size();
+    }
     std::lock_guard<std::mutex> lock(mutex_);
     return data_.size();
   }
 
   bool Empty() {
+    if (ring_) {
+      return ring_->Size() == 0;
+    }
     std::lock_guard<std::mutex> lock(mutex_);
     return EmptyUnlocked();
   }
@@ -114,6 +277,9 @@ class ChannelObject {
     if (n == 0) {
       return 0;
     }
+    if (ring_) {
+      return RingRead(n, p, false);
+    }
 
     std::unique_lock<std::mutex> lock(mutex_);
     size_t finished = Read(n, p, lock);
@@ -133,6 +299,9 @@ class ChannelObject {
     if (n == 0) {
       return 0;
     }
+    if (ring_) {
+      return RingWrite(n, p);
+    }
     std::unique_lock<std::mutex> lock(mutex_);
     size_t finished = Write(n, p, lock);
     Notify();
@@ -144,6 +313,9 @@ class ChannelObject {
     if (n == 0) {
       return 0;
     }
+    if (ring_) {
+      return RingWrite(n, std::make_move_iterator(p));
+    }
     std::unique_lock<std::mutex> lock(mutex_);
     size_t finished = WriteMove(n, p, lock);
     Notify();
@@ -162,6 +334,12 @@ class ChannelObject {
     if (size == 0) {
       return 0;
     }
+    if (ring_) {
+      p.resize(size);
+      size_t finished = RingRead(size, &p[0], true);
+      p.resize(finished);
+      return finished;
+    }
     std::unique_lock<std::mutex> lock(mutex_);
     p.resize(size);
     size_t finished = Read(size, &p[0], lock, true);
@@ -194,7 +372,7 @@ class ChannelObject {
  private:
   size_t capacity_ = MaxCapacity();
   size_t block_size_ = 1024;
-  bool closed_ = false;
+  std::atomic<bool> closed_{false};
   std::mutex mutex_;
   // use deque to store data
   std::deque<T> data_;
@@ -203,6 +381,11 @@ class ChannelObject {
   int full_waiters_ = 0;
   std::condition_variable empty_cond_;
   std::condition_variable full_cond_;
+  // the storage of kLockFreeRing, the mutex and the conditions are only used
+  // to park the threads waiting on it
+  std::unique_ptr<ChannelRing<T>> ring_;
+  std::atomic<int> ring_empty_waiters_{0};
+  std::atomic<int> ring_full_waiters_{0};
 
   static constexpr size_t MaxCapacity() {
     return (std::numeric_limits<size_t>::max)() / 2;
@@ -300,6 +483,96 @@ class ChannelObject {
     }
     return finished;
   }
+
+  // Spins with a growing backoff, then yields, then parks on cond until
+  // ready() or the channel is closed. Returns ready().
+  template <class Ready>
+  bool RingWait(Ready ready, std::condition_variable* cond,
+                std::atomic<int>* waiters) {
+    constexpr int kMaxSpinLoop = 64;
+    constexpr int kMaxYield = 16;
+    // spinning only delays the thread to wait for on a single core
+    static const bool spin = std::thread::hardware_concurrency() > 1;
+    for (int loop = 1; spin && loop <= kMaxSpinLoop; loop *= 2) {
+      if (ready() || closed_) {
+        return ready();
+      }
+      for (int i = 0; i < loop; ++i) {
+        ChannelCpuRelax();
+      }
+    }
+    for (int i = 0; i < kMaxYield; ++i) {
+      if (ready() || closed_) {
+        return ready();
+      }
+      std::this_thread::yield();
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    waiters->fetch_add(1);
+    // pairs with the fence of RingNotify, either the waiter sees the new
+    // state or the notifier sees the waiter
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    while (!ready() && !closed_) {
+      cond->wait(lock);
+    }
+    waiters->fetch_sub(1);
+    return ready();
+  }
+
+  void RingNotify(std::condition_variable* cond, std::atomic<int>* waiters) {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiters->load(std::memory_order_relaxed) != 0) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      cond->notify_all();
+    }
+  }
+
+  // returns 0 if the channel is closed and empty, once returns as soon as
+  // any data is read
+  size_t RingRead(size_t n, T* p, bool once) {
+    auto not_empty = [this]() { return ring_->Size() != 0; };
+    size_t finished = 0;
+    while (finished < n) {
+      if (ring_->TryPop(&p[finished])) {
+        ++finished;
+        continue;
+      }
+      if (once && finished > 0) {
+        break;
+      }
+      if (finished > 0) {
+        RingNotify(&full_cond_, &ring_full_waiters_);
+      }
+      if (!RingWait(not_empty, &empty_cond_, &ring_empty_waiters_)) {
+        break;
+      }
+    }
+    if (finished > 0) {
+      RingNotify(&full_cond_, &ring_full_waiters_);
+    }
+    return finished;
+  }
+
+  // returns value less than n if the channel is closed
+  template <class Iter>
+  size_t RingWrite(size_t n, Iter p) {
+    auto not_full = [this]() { return ring_->Size() < ring_->Capacity(); };
+    size_t finished = 0;
+    while (finished < n && !closed_) {
+      if (ring_->TryPush(p[finished])) {
+        ++finished;
+        continue;
+      }
+      if (finished > 0) {
+        RingNotify(&empty_cond_, &ring_empty_waiters_);
+      }
+      RingWait(not_full, &full_cond_, &ring_full_waiters_);
+    }
+    if (finished > 0) {
+      RingNotify(&empty_cond_, &ring_empty_waiters_);
+    }
+    return finished;
+  }
 };  // NOLINT
 
 template <class T>
@@ -310,6 +583,13 @@ Channel<T> MakeChannel(size_t capacity = (std::numeric_limits<size_t>::max)()) {
   return std::make_shared<ChannelObject<T>>(capacity);
 }
 
+// a channel on a lock free ring buffer, see ChannelBackend
+template <class T>
+Channel<T> MakeRingChannel(size_t capacity) {
+  return std::make_shared<ChannelObject<T>>(capacity,
+                                            ChannelBackend::kLockFreeRing);
+}
+
 template <class T, class U>
 Channel<T> MakeChannel(const Channel<U>& other) {
   CHECK(other != nullptr) << "channel can not be NULL";
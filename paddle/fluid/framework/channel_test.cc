@@ -0,0 +1,148 @@
+/* Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/framework/channel.h"
+
+#include <gtest/gtest.h>
+#include <chrono>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+namespace f = paddle::framework;
+
+static const f::ChannelBackend kBackends[] = {
+    f::ChannelBackend::kMutexDeque, f::ChannelBackend::kLockFreeRing};
+
+template <class T>
+static f::Channel<T> MakeChannel(size_t capacity, f::ChannelBackend backend) {
+  return std::make_shared<f::ChannelObject<T>>(capacity, backend);
+}
+
+TEST(Channel, ReadWrite) {
+  for (auto backend : kBackends) {
+    auto chan = MakeChannel<std::string>(16, backend);
+    ASSERT_EQ(chan->Backend(), backend);
+    chan->SetBlockSize(3);
+    std::vector<std::string> data = {"a", "b", "c", "d", "e"};
+    ASSERT_EQ(chan->Write(data), 5UL);
+    ASSERT_EQ(chan->Size(), 5UL);
+
+    std::vector<std::string> block;
+    ASSERT_EQ(chan->Read(block), 3UL);
+    ASSERT_EQ(block, std::vector<std::string>({"a", "b", "c"}));
+    // returns what is there without waiting for more
+    ASSERT_EQ(chan->ReadOnce(block, 10), 2UL);
+    ASSERT_EQ(block, std::vector<std::string>({"d", "e"}));
+    ASSERT_TRUE(chan->Empty());
+
+    // moves the data
+    ASSERT_EQ(chan->Write(std::move(data)), 5UL);
+    ASSERT_TRUE(data[0].empty());
+    chan->Close();
+    ASSERT_TRUE(chan->Closed());
+    ASSERT_EQ(chan->Put(std::string("f")), false);
+    std::vector<std::string> all;
+    ASSERT_EQ(chan->ReadAll(all), 5UL);
+    ASSERT_EQ(all.back(), "e");
+    ASSERT_EQ(chan->Read(block), 0UL);
+
+    chan->Open();
+    ASSERT_TRUE(chan->Put(std::string("g")));
+    chan->Clear();
+    ASSERT_TRUE(chan->Empty());
+  }
+}
+
+// Producers write the values in [0, num) in blocks, consumers read blocks
+// until the channel is closed, returns the sum of the values read.
+static uint64_t RunProducersConsumers(f::Channel<uint64_t> chan,
+                                      int producer_num, int consumer_num,
+                                      uint64_t num) {
+  std::vector<std::thread> producers;
+  std::vector<std::thread> consumers;
+  std::vector<uint64_t> sums(consumer_num, 0);
+  std::vector<uint64_t> counts(consumer_num, 0);
+  for (int i = 0; i < consumer_num; ++i) {
+    consumers.emplace_back([&, i]() {
+      std::vector<uint64_t> block;
+      while (chan->Read(block)) {
+        for (auto x : block) {
+          sums[i] += x;
+        }
+        counts[i] += block.size();
+      }
+    });
+  }
+  for (int i = 0; i < producer_num; ++i) {
+    producers.emplace_back([&, i]() {
+      std::vector<uint64_t> block;
+      for (uint64_t x = i; x < num; x += producer_num) {
+        block.push_back(x);
+        if (block.size() == chan->BlockSize()) {
+          EXPECT_EQ(chan->Write(block), block.size());
+          block.clear();
+        }
+      }
+      if (!block.empty()) {
+        EXPECT_EQ(chan->Write(block), block.size());
+      }
+    });
+  }
+  for (auto& t : producers) {
+    t.join();
+  }
+  chan->Close();
+  uint64_t sum = 0;
+  uint64_t count = 0;
+  for (int i = 0; i < consumer_num; ++i) {
+    consumers[i].join();
+    sum += sums[i];
+    count += counts[i];
+  }
+  EXPECT_EQ(count, num);
+  return sum;
+}
+
+TEST(Channel, MultiProducerMultiConsumer) {
+  const uint64_t num = 100000;
+  for (auto backend : kBackends) {
+    for (int thread_num : {1, 4, 16}) {
+      // a small capacity to block the producers
+      auto chan = MakeChannel<uint64_t>(64, backend);
+      chan->SetBlockSize(16);
+      ASSERT_EQ(RunProducersConsumers(chan, thread_num, thread_num, num),
+                num * (num - 1) / 2);
+    }
+  }
+}
+
+TEST(Channel, ContentionBenchmark) {
+  const uint64_t num = 1 << 20;
+  for (int thread_num : {1, 2, 4, 8, 16, 32, 64}) {
+    for (auto backend : kBackends) {
+      auto chan = MakeChannel<uint64_t>(1024, backend);
+      chan->SetBlockSize(8);
+      auto start = std::chrono::steady_clock::now();
+      RunProducersConsumers(chan, thread_num, thread_num, num);
+      std::chrono::duration<double> cost =
+          std::chrono::steady_clock::now() - start;
+      LOG(INFO) << (backend == f::ChannelBackend::kLockFreeRing ? "ring"
+                                                                 : "mutex")
+                << " channel, " << thread_num << " producers and "
+                << thread_num << " consumers: " << num / cost.count()
+                << " items/sec";
+    }
+  }
+}
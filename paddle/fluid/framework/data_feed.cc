@@ -1931,6 +1931,129 @@ void PaddleBoxDataFeed::PutToFeedVec(const std::vector<Record*>& ins_vec) {
 }
 
 template class InMemoryDataFeed<SlotRecord>;
+
+// Batch layout, all fields are 8 bytes and sections are padded to 8 bytes:
+//   batch_size, slot_num
+//   for each slot: value_num, value_size, offset_num, offsets, values
+SlotBatchCache::SlotBatchCache(const std::string& spill_file)
+    : spill_file_(spill_file) {
+#ifdef _LINUX
+  if (!spill_file_.empty()) {
+    fp_ = fopen(spill_file_.c_str(), "wb");
+    PADDLE_ENFORCE_NOT_NULL(
+        fp_, platform::errors::Unavailable(
+                 "Failed to open batch cache file %s.", spill_file_));
+  }
+#else
+  spill_file_.clear();
+#endif
+}
+
+SlotBatchCache::~SlotBatchCache() {
+#ifdef _LINUX
+  if (fp_ != nullptr) {
+    fclose(fp_);
+  }
+  if (!spill_file_.empty()) {
+    if (finished_ && data_size_ > 0) {
+      munmap(const_cast<char*>(data_), data_size_);
+    }
+    unlink(spill_file_.c_str());
+  }
+#endif
+}
+
+void SlotBatchCache::Append(const void* data, size_t size) {
+  buffer_.append(reinterpret_cast<const char*>(data), size);
+  size_t padding = (8 - size % 8) % 8;
+  buffer_.append(padding, '\0');
+}
+
+void SlotBatchCache::AddBatch(int batch_size, int slot_num) {
+  PADDLE_ENFORCE_EQ(finished_, false,
+                    platform::errors::PreconditionNotMet(
+                        "Batch cache is finished, no batch can be added."));
+  if (fp_ != nullptr && !buffer_.empty()) {
+    PADDLE_ENFORCE_EQ(fwrite(buffer_.data(), 1, buffer_.size(), fp_),
+                      buffer_.size(),
+                      platform::errors::Unavailable(
+                          "Failed to write batch cache file %s.", spill_file_));
+    data_size_ += buffer_.size();
+    buffer_.clear();
+  }
+  batch_pos_.push_back(data_size_ + buffer_.size());
+  uint64_t header[2] = {static_cast<uint64_t>(batch_size),
+                        static_cast<uint64_t>(slot_num)};
+  Append(header, sizeof(header));
+}
+
+void SlotBatchCache::AddSlot(const void* values, size_t value_num,
+                             size_t value_size,
+                             const std::vector<size_t>& offsets) {
+  uint64_t header[3] = {value_num, value_size, offsets.size()};
+  Append(header, sizeof(header));
+  Append(offsets.data(), offsets.size() * sizeof(size_t));
+  Append(values, value_num * value_size);
+}
+
+void SlotBatchCache::Finish() {
+  if (finished_) {
+    return;
+  }
+  finished_ = true;
+  if (fp_ == nullptr) {
+    data_size_ = buffer_.size();
+    data_ = buffer_.data();
+    return;
+  }
+#ifdef _LINUX
+  if (!buffer_.empty()) {
+    PADDLE_ENFORCE_EQ(fwrite(buffer_.data(), 1, buffer_.size(), fp_),
+                      buffer_.size(),
+                      platform::errors::Unavailable(
+                          "Failed to write batch cache file %s.", spill_file_));
+    data_size_ += buffer_.size();
+    std::string().swap(buffer_);
+  }
+  fclose(fp_);
+  fp_ = nullptr;
+  if (data_size_ == 0) {
+    return;
+  }
+  int fd = open(spill_file_.c_str(), O_RDONLY);
+  PADDLE_ENFORCE_GE(fd, 0, platform::errors::Unavailable(
+                               "Failed to open batch cache file %s.",
+                               spill_file_));
+  void* addr = mmap(NULL, data_size_, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  PADDLE_ENFORCE_NE(addr, MAP_FAILED,
+                    platform::errors::Unavailable(
+                        "Failed to mmap batch cache file %s.", spill_file_));
+  data_ = reinterpret_cast<const char*>(addr);
+#endif
+}
+
+int SlotBatchCache::GetBatch(size_t idx, std::vector<Slot>* slots) const {
+  const uint64_t* pos =
+      reinterpret_cast<const uint64_t*>(data_ + batch_pos_[idx]);
+  int batch_size = static_cast<int>(pos[0]);
+  size_t slot_num = pos[1];
+  pos += 2;
+  slots->resize(slot_num);
+  for (size_t i = 0; i < slot_num; ++i) {
+    Slot& slot = (*slots)[i];
+    slot.value_num = pos[0];
+    size_t value_size = pos[1];
+    slot.offset_num = pos[2];
+    pos += 3;
+    slot.offsets = reinterpret_cast<const size_t*>(pos);
+    pos += slot.offset_num;
+    slot.values = pos;
+    pos += (slot.value_num * value_size + 7) / 8;
+  }
+  return batch_size;
+}
+
 void SlotRecordInMemoryDataFeed::Init(const DataFeedDesc& data_feed_desc) {
   finish_init_ = false;
   finish_set_filelist_ = false;
@@ -2436,7 +2559,7 @@ void SlotRecordInMemoryDataFeed::PutToFeedVec(const SlotRecord* ins_vec,
           total_instance += fea_num;
         }
         if (fea_num == 0) {
-          batch_fea.resize(total_instance + fea_num);
+          batch_fea.resize(total_instance + 1);
           batch_fea[total_instance] = 0;
           total_instance += 1;
         }
@@ -2450,19 +2573,75 @@ void SlotRecordInMemoryDataFeed::PutToFeedVec(const SlotRecord* ins_vec,
       CopyToFeedTensor(tensor_ptr, feasign, total_instance * sizeof(int64_t));
     }
 
-    if (info.dense) {
-      if (info.inductive_shape_index != -1) {
-        info.local_shape[info.inductive_shape_index] =
-            total_instance / info.total_dims_without_inductive;
-      }
-      feed->Resize(framework::make_ddim(info.local_shape));
-    } else {
-      LoD data_lod{slot_offset};
-      feed_vec_[j]->set_lod(data_lod);
+    SetFeedShape(j, total_instance);
+  }
+}
+
+void SlotRecordInMemoryDataFeed::SetFeedShape(int slot_idx,
+                                              int total_instance) {
+  auto& info = used_slots_info_[slot_idx];
+  if (info.dense) {
+    if (info.inductive_shape_index != -1) {
+      info.local_shape[info.inductive_shape_index] =
+          total_instance / info.total_dims_without_inductive;
     }
+    feed_vec_[slot_idx]->Resize(framework::make_ddim(info.local_shape));
+  } else {
+    LoD data_lod{offset_[slot_idx]};
+    feed_vec_[slot_idx]->set_lod(data_lod);
   }
 }
 
+void SlotRecordInMemoryDataFeed::AddToBatchCache() {
+  static const std::vector<size_t> empty_offsets;
+  batch_cache_->AddBatch(batch_size_, use_slot_size_);
+  for (int j = 0; j < use_slot_size_; ++j) {
+    // PutToFeedVec leaves the batch of an unfed slot untouched
+    if (feed_vec_[j] == nullptr) {
+      batch_cache_->AddSlot(nullptr, 0, 0, empty_offsets);
+      continue;
+    }
+    if (used_slots_info_[j].type[0] == 'f') {
+      auto& batch_fea = batch_float_feasigns_[j];
+      batch_cache_->AddSlot(batch_fea.data(), batch_fea.size(), sizeof(float),
+                            offset_[j]);
+    } else if (used_slots_info_[j].type[0] == 'u') {
+      auto& batch_fea = batch_uint64_feasigns_[j];
+      batch_cache_->AddSlot(batch_fea.data(), batch_fea.size(),
+                            sizeof(uint64_t), offset_[j]);
+    }
+  }
+}
+
+int SlotRecordInMemoryDataFeed::NextFromBatchCache() {
+  if (batch_cache_index_ >= batch_cache_->BatchNum()) {
+    return 0;
+  }
+  std::vector<SlotBatchCache::Slot> slots;
+  this->batch_size_ = batch_cache_->GetBatch(batch_cache_index_++, &slots);
+  for (int j = 0; j < use_slot_size_; ++j) {
+    auto& feed = feed_vec_[j];
+    if (feed == nullptr) {
+      continue;
+    }
+    auto& slot = slots[j];
+    int total_instance = static_cast<int>(slot.value_num);
+    if (used_slots_info_[j].type[0] == 'f') {
+      float* tensor_ptr =
+          feed->mutable_data<float>({total_instance, 1}, this->place_);
+      CopyToFeedTensor(tensor_ptr, slot.values, total_instance * sizeof(float));
+    } else if (used_slots_info_[j].type[0] == 'u') {
+      int64_t* tensor_ptr =
+          feed->mutable_data<int64_t>({total_instance, 1}, this->place_);
+      CopyToFeedTensor(tensor_ptr, slot.values,
+                       total_instance * sizeof(int64_t));
+    }
+    offset_[j].assign(slot.offsets, slot.offsets + slot.offset_num);
+    SetFeedShape(j, total_instance);
+  }
+  return this->batch_size_;
+}
+
 void SlotRecordInMemoryDataFeed::ExpandSlotRecord(SlotRecord* rec) {
   SlotRecord& ins = (*rec);
   if (ins->slot_float_feasigns_.slot_offsets.empty()) {
@@ -2536,6 +2715,7 @@ bool SlotRecordInMemoryDataFeed::Start() {
     enable_heterps_ = true;
     this->offset_index_ = 0;
   }
+  batch_cache_index_ = 0;
   this->finish_start_ = true;
   return true;
 }
@@ -2543,12 +2723,21 @@ bool SlotRecordInMemoryDataFeed::Start() {
 int SlotRecordInMemoryDataFeed::Next() {
 #ifdef _LINUX
   this->CheckStart();
+  if (batch_cache_ != nullptr && batch_cache_->IsFinished()) {
+    return NextFromBatchCache();
+  }
 
   VLOG(3) << "enable heter next: " << offset_index_
           << " batch_offsets: " << batch_offsets_.size();
   if (offset_index_ >= batch_offsets_.size()) {
     VLOG(3) << "offset_index: " << offset_index_
             << " batch_offsets: " << batch_offsets_.size();
+    if (batch_cache_ != nullptr) {
+      batch_cache_->Finish();
+      VLOG(3) << "batch cache finished with " << batch_cache_->BatchNum()
+              << " batches, " << batch_cache_->MemorySize()
+              << " bytes, thread_id=" << thread_id_;
+    }
     return 0;
   }
   auto& batch = batch_offsets_[offset_index_++];
@@ -2557,6 +2746,9 @@ int SlotRecordInMemoryDataFeed::Next() {
           << ", thread_id=" << thread_id_;
   if (this->batch_size_ != 0) {
     PutToFeedVec(&records_[batch.first], this->batch_size_);
+    if (batch_cache_ != nullptr) {
+      AddToBatchCache();
+    }
   } else {
     VLOG(3) << "finish reading for heterps, batch size zero, thread_id="
             << thread_id_;
@@ -46,6 +46,8 @@ DECLARE_int32(record_pool_max_size);
 DECLARE_int32(slotpool_thread_num);
 DECLARE_bool(enable_slotpool_wait_release);
 DECLARE_bool(enable_slotrecord_reset_shrink);
+DECLARE_bool(enable_slotrecord_batch_cache);
+DECLARE_string(slotrecord_batch_cache_path);
 
 namespace paddle {
 namespace framework {
@@ -1103,6 +1105,48 @@ class MultiSlotInMemoryDataFeed : public InMemoryDataFeed<Record> {
   virtual void PutToFeedVec(const Record* ins_vec, int num);
 };
 
+// SlotBatchCache keeps the batches fed by a SlotRecordInMemoryDataFeed in
+// columnar form: for every batch, the values and the lod offsets of each used
+// slot, as PutToFeedVec builds them from the SlotValues of the records. Later
+// passes copy them into the feed tensors without parsing the data again.
+// The batches are kept in memory, or appended to spill_file and mapped once
+// the pass is finished.
+class SlotBatchCache {
+ public:
+  struct Slot {
+    const void* values;
+    size_t value_num;
+    const size_t* offsets;
+    size_t offset_num;
+  };
+
+  explicit SlotBatchCache(const std::string& spill_file = "");
+  ~SlotBatchCache();
+
+  // a batch is added as AddBatch followed by AddSlot for every used slot
+  void AddBatch(int batch_size, int slot_num);
+  void AddSlot(const void* values, size_t value_num, size_t value_size,
+               const std::vector<size_t>& offsets);
+  void Finish();
+
+  bool IsFinished() const { return finished_; }
+  size_t BatchNum() const { return batch_pos_.size(); }
+  size_t MemorySize() const { return data_size_; }
+  // returns the batch size, slots[j] is the j-th used slot
+  int GetBatch(size_t idx, std::vector<Slot>* slots) const;
+
+ private:
+  void Append(const void* data, size_t size);
+
+  std::string spill_file_;
+  FILE* fp_ = nullptr;
+  std::string buffer_;
+  std::vector<size_t> batch_pos_;
+  size_t data_size_ = 0;
+  const char* data_ = nullptr;
+  bool finished_ = false;
+};
+
 class SlotRecordInMemoryDataFeed : public InMemoryDataFeed<SlotRecord> {
  public:
   SlotRecordInMemoryDataFeed() {}
@@ -1110,6 +1154,8 @@ class SlotRecordInMemoryDataFeed : public InMemoryDataFeed<SlotRecord> {
   virtual void Init(const DataFeedDesc& data_feed_desc);
   virtual void LoadIntoMemory();
   void ExpandSlotRecord(SlotRecord* ins);
+  // records the batches into cache, or feeds them from it once finished
+  void SetBatchCache(SlotBatchCache* cache) { batch_cache_ = cache; }
 
  protected:
   virtual bool Start();
@@ -1129,6 +1175,9 @@ class SlotRecordInMemoryDataFeed : public InMemoryDataFeed<SlotRecord> {
   }
   bool ParseOneInstance(const std::string& line, SlotRecord* rec);
   virtual void PutToFeedVec(const SlotRecord* ins_vec, int num);
+  void SetFeedShape(int slot_idx, int total_instance);
+  void AddToBatchCache();
+  int NextFromBatchCache();
   float sample_rate_ = 1.0f;
   int use_slot_size_ = 0;
   int float_use_slot_size_ = 0;
@@ -1137,6 +1186,8 @@ class SlotRecordInMemoryDataFeed : public InMemoryDataFeed<SlotRecord> {
   std::vector<UsedSlotInfo> used_slots_info_;
   size_t float_total_dims_size_ = 0;
   std::vector<int> float_total_dims_without_inductives_;
+  SlotBatchCache* batch_cache_ = nullptr;
+  size_t batch_cache_index_ = 0;
 };
 
 class PaddleBoxDataFeed : public MultiSlotInMemoryDataFeed {
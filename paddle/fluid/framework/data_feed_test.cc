@@ -14,12 +14,15 @@
 
 #include "paddle/fluid/framework/data_feed.h"
 #include <fcntl.h>
+#include <algorithm>
 #include <chrono>  // NOLINT
 #include <fstream>
 #include <iostream>
 #include <map>
 #include <mutex>  // NOLINT
 #include <set>
+#include <sstream>
+#include <string>
 #include <thread>  // NOLINT
 #include <utility>
 #include <vector>
@@ -340,3 +343,170 @@ TEST(DataFeed, MultiSlotUnitTest) {
   // GetElemSetFromFile(&file_elem_set, data_feed_desc, filelist);
   // CheckIsUnorderedSame(reader_elem_set, file_elem_set);
 }
+
+void CheckSlotBatchCache(const std::string& spill_file) {
+  paddle::framework::SlotBatchCache cache(spill_file);
+  const int batch_num = 3;
+  for (int b = 0; b < batch_num; ++b) {
+    int batch_size = b + 2;
+    cache.AddBatch(batch_size, 2);
+    std::vector<uint64_t> feasigns;
+    std::vector<size_t> offsets(1, 0);
+    for (int i = 0; i < batch_size; ++i) {
+      for (int k = 0; k < i % 3; ++k) {
+        feasigns.push_back(b * 100 + i * 10 + k);
+      }
+      offsets.push_back(feasigns.size());
+    }
+    cache.AddSlot(feasigns.data(), feasigns.size(), sizeof(uint64_t), offsets);
+    std::vector<float> dense(batch_size, static_cast<float>(b));
+    cache.AddSlot(dense.data(), dense.size(), sizeof(float), {});
+  }
+  ASSERT_FALSE(cache.IsFinished());
+  cache.Finish();
+  ASSERT_TRUE(cache.IsFinished());
+  ASSERT_EQ(cache.BatchNum(), static_cast<size_t>(batch_num));
+
+  std::vector<paddle::framework::SlotBatchCache::Slot> slots;
+  for (int b = 0; b < batch_num; ++b) {
+    int batch_size = cache.GetBatch(b, &slots);
+    ASSERT_EQ(batch_size, b + 2);
+    ASSERT_EQ(slots.size(), 2UL);
+    ASSERT_EQ(slots[0].offset_num, static_cast<size_t>(batch_size + 1));
+    const uint64_t* feasigns =
+        reinterpret_cast<const uint64_t*>(slots[0].values);
+    for (int i = 0; i < batch_size; ++i) {
+      ASSERT_EQ(slots[0].offsets[i + 1] - slots[0].offsets[i],
+                static_cast<size_t>(i % 3));
+      for (size_t k = slots[0].offsets[i]; k < slots[0].offsets[i + 1]; ++k) {
+        ASSERT_EQ(feasigns[k],
+                  static_cast<uint64_t>(b * 100 + i * 10 + k -
+                                        slots[0].offsets[i]));
+      }
+    }
+    ASSERT_EQ(slots[0].value_num, slots[0].offsets[batch_size]);
+    ASSERT_EQ(slots[1].offset_num, 0UL);
+    ASSERT_EQ(slots[1].value_num, static_cast<size_t>(batch_size));
+    const float* dense = reinterpret_cast<const float*>(slots[1].values);
+    for (int i = 0; i < batch_size; ++i) {
+      ASSERT_EQ(dense[i], static_cast<float>(b));
+    }
+  }
+}
+
+TEST(SlotBatchCache, InMemory) { CheckSlotBatchCache(""); }
+
+TEST(SlotBatchCache, SpillFile) {
+  CheckSlotBatchCache("./slot_batch_cache_test.bin");
+}
+
+#ifdef _LINUX
+std::vector<std::string> ReadSlotRecordPass(
+    paddle::framework::DataFeed* feed, const paddle::framework::Scope& scope) {
+  std::vector<std::string> batches;
+  feed->Start();
+  while (int batch_size = feed->Next()) {
+    std::ostringstream os;
+    auto& sparse =
+        scope.FindVar("sparse_slot")->Get<paddle::framework::LoDTensor>();
+    os << batch_size << " " << sparse.lod() << " " << sparse.dims() << ":";
+    for (int64_t i = 0; i < sparse.numel(); ++i) {
+      os << " " << sparse.data<int64_t>()[i];
+    }
+    auto& dense =
+        scope.FindVar("dense_slot")->Get<paddle::framework::LoDTensor>();
+    os << " " << dense.dims() << ":";
+    for (int64_t i = 0; i < dense.numel(); ++i) {
+      os << " " << dense.data<float>()[i];
+    }
+    batches.push_back(os.str());
+  }
+  return batches;
+}
+
+void CheckSlotRecordBatchCache(const std::string& spill_file) {
+  const char* data_file = "./slot_record_batch_cache_data.txt";
+  const int ins_num = 7;
+  std::ofstream w_datafile(data_file);
+  for (int i = 0; i < ins_num; ++i) {
+    w_datafile << i % 3 + 1;
+    for (int k = 0; k <= i % 3; ++k) {
+      w_datafile << " " << i * 10 + k + 1;
+    }
+    w_datafile << " 2 " << i << ".5 " << i + 1 << ".25" << std::endl;
+  }
+  w_datafile.close();
+
+  paddle::framework::DataFeedDesc data_feed_desc;
+  ASSERT_TRUE(google::protobuf::TextFormat::ParseFromString(
+      "name: \"SlotRecordInMemoryDataFeed\"\n"
+      "batch_size: 3\n"
+      "pipe_command: \"cat\"\n"
+      "multi_slot_desc {\n"
+      "    slots {\n"
+      "        name: \"sparse_slot\"\n"
+      "        type: \"uint64\"\n"
+      "        is_dense: false\n"
+      "        is_used: true\n"
+      "    }\n"
+      "    slots {\n"
+      "        name: \"dense_slot\"\n"
+      "        type: \"float\"\n"
+      "        is_dense: true\n"
+      "        is_used: true\n"
+      "        shape: -1\n"
+      "        shape: 2\n"
+      "    }\n"
+      "}",
+      &data_feed_desc));
+
+  auto feed = paddle::framework::DataFeedFactory::CreateDataFeed(
+      data_feed_desc.name());
+  auto* slot_feed =
+      dynamic_cast<paddle::framework::SlotRecordInMemoryDataFeed*>(feed.get());
+  ASSERT_NE(slot_feed, nullptr);
+  feed->Init(data_feed_desc);
+  std::mutex mutex_for_pick_file;
+  size_t file_idx = 0;
+  feed->SetFileListMutex(&mutex_for_pick_file);
+  feed->SetFileListIndex(&file_idx);
+  feed->SetFileList({data_file});
+  auto channel =
+      paddle::framework::MakeChannel<paddle::framework::SlotRecord>();
+  feed->SetInputChannel(channel.get());
+  feed->LoadIntoMemory();
+  channel->Close();
+  std::vector<paddle::framework::SlotRecord> records;
+  channel->ReadAll(records);
+  ASSERT_EQ(records.size(), static_cast<size_t>(ins_num));
+  slot_feed->SetRecord(&records[0]);
+  for (int i = 0; i < ins_num; i += 3) {
+    slot_feed->AddBatchOffset({i, std::min(3, ins_num - i)});
+  }
+
+  paddle::framework::Scope scope;
+  for (auto& name : {"sparse_slot", "dense_slot"}) {
+    scope.Var(name)->GetMutable<paddle::framework::LoDTensor>();
+  }
+  feed->AssignFeedVar(scope);
+
+  // the parsed pass, the recording pass and the cached pass feed the same
+  auto parsed = ReadSlotRecordPass(feed.get(), scope);
+  ASSERT_EQ(parsed.size(), 3UL);
+  paddle::framework::SlotBatchCache cache(spill_file);
+  slot_feed->SetBatchCache(&cache);
+  ASSERT_EQ(ReadSlotRecordPass(feed.get(), scope), parsed);
+  ASSERT_TRUE(cache.IsFinished());
+  ASSERT_EQ(cache.BatchNum(), parsed.size());
+  ASSERT_EQ(ReadSlotRecordPass(feed.get(), scope), parsed);
+  paddle::framework::SlotRecordPool().put(&records);
+}
+
+TEST(SlotRecordInMemoryDataFeed, BatchCacheInMemory) {
+  CheckSlotRecordBatchCache("");
+}
+
+TEST(SlotRecordInMemoryDataFeed, BatchCacheSpillFile) {
+  CheckSlotRecordBatchCache("./slot_record_batch_cache_test.bin");
+}
+#endif
@@ -13,12 +13,14 @@
  *     limitations under the License. */
 
 #include "paddle/fluid/framework/data_set.h"
+#include <deque>
 #include "google/protobuf/text_format.h"
 #if (defined PADDLE_WITH_DISTRIBUTE) && (defined PADDLE_WITH_PSCORE)
 #include "paddle/fluid/distributed/index_dataset/index_sampler.h"
 #endif
 #include "paddle/fluid/framework/data_feed_factory.h"
 #include "paddle/fluid/framework/fleet/fleet_wrapper.h"
+#include "paddle/fluid/framework/global_shuffle_chunker.h"
 #include "paddle/fluid/framework/io/fs.h"
 #include "paddle/fluid/platform/monitor.h"
 #include "paddle/fluid/platform/timer.h"
@@ -32,6 +34,11 @@
 #define _LINUX
 #endif
 
+DECLARE_bool(enable_streaming_global_shuffle);
+DECLARE_int64(global_shuffle_chunk_bytes);
+DECLARE_int32(global_shuffle_max_inflight);
+DECLARE_int32(global_shuffle_buffer_records);
+
 USE_INT_STAT(STAT_total_feasign_num_in_mem);
 namespace paddle {
 namespace framework {
@@ -648,17 +655,19 @@ void MultiSlotDataset::GlobalShuffle(int thread_num) {
     return;
   }
 
-  // local shuffle
-  input_channel_->Close();
-  std::vector<Record> data;
-  input_channel_->ReadAll(data);
-  std::shuffle(data.begin(), data.end(), fleet_ptr->LocalRandomEngine());
-  input_channel_->Open();
-  input_channel_->Write(std::move(data));
-  data.clear();
-  data.shrink_to_fit();
-
+  // local shuffle, the streaming mode mixes the records by a shuffle buffer
+  // of every thread instead to not hold all the records at once
   input_channel_->Close();
+  if (!FLAGS_enable_streaming_global_shuffle) {
+    std::vector<Record> data;
+    input_channel_->ReadAll(data);
+    std::shuffle(data.begin(), data.end(), fleet_ptr->LocalRandomEngine());
+    input_channel_->Open();
+    input_channel_->Write(std::move(data));
+    data.clear();
+    data.shrink_to_fit();
+    input_channel_->Close();
+  }
   input_channel_->SetBlockSize(fleet_send_batch_size_);
   VLOG(3) << "MultiSlotDataset::GlobalShuffle() input_channel_ size "
           << input_channel_->Size();
@@ -718,13 +727,74 @@ void MultiSlotDataset::GlobalShuffle(int thread_num) {
     }
   };
 
+  // Every thread passes the records it reads through a shuffle buffer of
+  // FLAGS_global_shuffle_buffer_records, serializes them into an archive per
+  // trainer and sends the largest archive once they hold
+  // FLAGS_global_shuffle_chunk_bytes in total, with at most
+  // FLAGS_global_shuffle_max_inflight chunks in flight. The serialization
+  // overlaps the sending, and the memory is bounded by the buffer and the
+  // chunks instead of the send batches. The receivers shuffle every chunk
+  // before writing it into an output channel in ReceiveFromClient.
+  auto streaming_shuffle_func = [this, get_client_id]() {
+#ifdef PADDLE_WITH_PSCORE
+    auto fleet_ptr = distributed::FleetWrapper::GetInstance();
+#else
+    auto fleet_ptr = framework::FleetWrapper::GetInstance();
+#endif
+    const size_t chunk_bytes =
+        std::max<int64_t>(FLAGS_global_shuffle_chunk_bytes, 1);
+    const size_t max_inflight =
+        std::max<int32_t>(FLAGS_global_shuffle_max_inflight, 1);
+    std::deque<std::future<int32_t>> inflight;
+    GlobalShuffleChunker chunker(
+        this->trainer_num_, chunk_bytes,
+        [&](int trainer_id, std::string&& msg) {
+          if (inflight.size() >= max_inflight) {
+            inflight.front().wait();
+            inflight.pop_front();
+          }
+          inflight.push_back(
+              fleet_ptr->SendClientToClientMsg(0, trainer_id, msg));
+          if (this->fleet_send_sleep_seconds_ != 0) {
+            sleep(this->fleet_send_sleep_seconds_);
+          }
+        });
+    GlobalShuffleBuffer<Record> shuffle_buffer(
+        std::max<int32_t>(FLAGS_global_shuffle_buffer_records, 1),
+        [&](Record&& t) { chunker.Add(get_client_id(t), t); });
+    auto* engine = &fleet_ptr->LocalRandomEngine();
+    std::vector<Record> data;
+    while (this->input_channel_->Read(data)) {
+      for (auto& t : data) {
+        shuffle_buffer.Add(std::move(t), engine);
+      }
+      data.clear();
+    }
+    shuffle_buffer.Flush(engine);
+    std::vector<int> send_index(this->trainer_num_);
+    for (int i = 0; i < this->trainer_num_; ++i) {
+      send_index[i] = i;
+    }
+    std::shuffle(send_index.begin(), send_index.end(),
+                 fleet_ptr->LocalRandomEngine());
+    chunker.Flush(send_index);
+    for (auto& t : inflight) {
+      t.wait();
+    }
+  };
+
   std::vector<std::thread> global_shuffle_threads;
   if (thread_num == -1) {
     thread_num = thread_num_;
   }
-  VLOG(3) << "start global shuffle threads, num = " << thread_num;
+  VLOG(3) << "start global shuffle threads, num = " << thread_num
+          << ", streaming = " << FLAGS_enable_streaming_global_shuffle;
   for (int i = 0; i < thread_num; ++i) {
-    global_shuffle_threads.push_back(std::thread(global_shuffle_func));
+    if (FLAGS_enable_streaming_global_shuffle) {
+      global_shuffle_threads.push_back(std::thread(streaming_shuffle_func));
+    } else {
+      global_shuffle_threads.push_back(std::thread(global_shuffle_func));
+    }
   }
   for (std::thread& t : global_shuffle_threads) {
     t.join();
@@ -1038,6 +1108,11 @@ int MultiSlotDataset::ReceiveFromClient(int msg_type, int client_id,
   CHECK(ar.Cursor() == ar.Finish());
 
   auto fleet_ptr = framework::FleetWrapper::GetInstance();
+  // a chunk of the streaming global shuffle holds the records of a sender
+  // thread in the order of its shuffle buffer
+  if (FLAGS_enable_streaming_global_shuffle) {
+    std::shuffle(data.begin(), data.end(), fleet_ptr->LocalRandomEngine());
+  }
   // not use random because it doesn't perform well here.
   // to make sure each channel get data equally, we just put data to
   // channel one by one.
@@ -1685,10 +1760,16 @@ void SlotRecordDataset::ReleaseMemory() {
   STAT_SUB(STAT_total_feasign_num_in_mem, total_fea_num_);
 }
 void SlotRecordDataset::GlobalShuffle(int thread_num) {
+  DropBatchCache();
   // TODO(yaoxuefeng)
   return;
 }
 
+void SlotRecordDataset::LocalShuffle() {
+  DropBatchCache();
+  DatasetImpl<SlotRecord>::LocalShuffle();
+}
+
 void SlotRecordDataset::DynamicAdjustChannelNum(int channel_num,
                                                 bool discard_remaining_ins) {
   if (channel_num_ == channel_num) {
@@ -1708,8 +1789,83 @@ void SlotRecordDataset::DynamicAdjustChannelNum(int channel_num,
   VLOG(3) << "adjust channel num done";
 }
 
+bool SlotRecordDataset::BatchCacheReady() {
+  if (!FLAGS_enable_slotrecord_batch_cache || batch_cache_disabled_ ||
+      batch_caches_.empty() ||
+      static_cast<int>(batch_caches_.size()) != thread_num_ ||
+      batch_cache_filelist_ != filelist_) {
+    return false;
+  }
+  for (auto& cache : batch_caches_) {
+    if (!cache->IsFinished()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void SlotRecordDataset::LoadIntoMemory() {
+  load_skipped_ = BatchCacheReady();
+  if (!load_skipped_) {
+    DatasetImpl<SlotRecord>::LoadIntoMemory();
+    return;
+  }
+  VLOG(3) << "SlotRecordDataset::LoadIntoMemory() feeds from batch cache, "
+          << "skip loading " << filelist_.size() << " files";
+  if (input_channel_ != nullptr) {
+    input_channel_->Close();
+  }
+}
+
+void SlotRecordDataset::DropBatchCache() {
+  if (!FLAGS_enable_slotrecord_batch_cache || batch_cache_disabled_) {
+    return;
+  }
+  LOG(WARNING) << "SlotRecordDataset is shuffled, the batch cache is dropped "
+               << "and not recorded again";
+  batch_cache_disabled_ = true;
+  for (auto& reader : readers_) {
+    reinterpret_cast<SlotRecordInMemoryDataFeed*>(reader.get())
+        ->SetBatchCache(nullptr);
+  }
+  batch_caches_.clear();
+  batch_cache_filelist_.clear();
+  if (load_skipped_ && input_channel_ != nullptr) {
+    load_skipped_ = false;
+    {
+      std::lock_guard<std::mutex> lock(mutex_for_pick_file_);
+      file_idx_ = 0;
+    }
+    input_channel_->Open();
+    DatasetImpl<SlotRecord>::LoadIntoMemory();
+  }
+}
+
 void SlotRecordDataset::PrepareTrain() {
 #ifdef PADDLE_WITH_GLOO
+  if (BatchCacheReady()) {
+    for (int i = 0; i < thread_num_; i++) {
+      reinterpret_cast<SlotRecordInMemoryDataFeed*>(readers_[i].get())
+          ->SetBatchCache(batch_caches_[i].get());
+    }
+    return;
+  }
+  if (FLAGS_enable_slotrecord_batch_cache && !batch_cache_disabled_) {
+    // records the batches of this pass, an unfinished cache is dropped
+    batch_caches_.clear();
+    batch_cache_filelist_ = filelist_;
+    for (int i = 0; i < thread_num_; i++) {
+      std::string spill_file;
+      if (!FLAGS_slotrecord_batch_cache_path.empty()) {
+        spill_file = string::format_string(
+            "%s/slot_batch_cache_%p_%d.bin",
+            FLAGS_slotrecord_batch_cache_path.c_str(), this, i);
+      }
+      batch_caches_.push_back(std::make_shared<SlotBatchCache>(spill_file));
+      reinterpret_cast<SlotRecordInMemoryDataFeed*>(readers_[i].get())
+          ->SetBatchCache(batch_caches_[i].get());
+    }
+  }
   if (enable_heterps_) {
     if (input_records_.size() == 0 && input_channel_ != nullptr &&
         input_channel_->Size() != 0) {
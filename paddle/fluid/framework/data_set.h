@@ -375,9 +375,26 @@ class SlotRecordDataset : public DatasetImpl<SlotRecord> {
                                        bool discard_remaining_ins);
   virtual void PrepareTrain();
   virtual void DynamicAdjustReadersNum(int thread_num);
+  // skips loading when the batch cache of the filelist is complete
+  virtual void LoadIntoMemory();
+  // a shuffle turns the batch cache off, see DropBatchCache
+  virtual void LocalShuffle();
 
  protected:
+  bool BatchCacheReady();
+  // the cache replays the batches of the recorded pass in their order, so it
+  // is dropped for good once the data is shuffled, and the data of a pass
+  // that skipped loading is loaded to be shuffled
+  void DropBatchCache();
+
   bool enable_heterps_ = true;
+  // batches of each reader recorded in the first pass, kept across
+  // ReleaseMemory, see FLAGS_enable_slotrecord_batch_cache
+  std::vector<std::shared_ptr<SlotBatchCache>> batch_caches_;
+  std::vector<std::string> batch_cache_filelist_;
+  // LoadIntoMemory of this pass skipped loading for the batch cache
+  bool load_skipped_ = false;
+  bool batch_cache_disabled_ = false;
 };
 
 }  // end namespace framework
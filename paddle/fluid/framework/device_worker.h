@@ -97,6 +97,9 @@ class PullDenseWorker {
   void MergeDenseParam();
   int GetThreadIdByScope(const Scope* scope);
   void SetThreadIdByScope(const Scope* scope, int tid);
+  // In the double buffer mode, shares the dense params last pulled with the
+  // thread scope. Called by the training threads between batches.
+  void ShareDenseBuffer(int thread_id, Scope* thread_scope);
   static std::shared_ptr<PullDenseWorker> GetInstance() {
     if (NULL == s_instance_) {
       s_instance_.reset(new paddle::framework::PullDenseWorker());
@@ -107,9 +110,13 @@ class PullDenseWorker {
   static std::shared_ptr<PullDenseWorker> s_instance_;
 
  private:
-  PullDenseWorker() : root_scope_(NULL) {}
+  PullDenseWorker() : root_scope_(NULL), double_buffer_(false) {}
   void Run();
   bool CheckUpdateParam(uint64_t table_id);
+  void CreateDenseBuffer();
+  Scope* BackDenseBuffer(uint64_t table_id);
+  void PublishDenseBuffer(uint64_t table_id);
+  void MergeDenseBuffer();
 
  private:
   std::shared_ptr<paddle::framework::FleetWrapper> fleet_ptr_;
@@ -139,6 +146,20 @@ class PullDenseWorker {
   float total_batch_num_ = 0;
   std::unordered_map<const Scope*, int> scope_to_thread_id_;
 
+  // The double buffer mode pulls the dense params of a table into the back
+  // buffer and then publishes it as the front one, whose tensors the thread
+  // scopes share from their next batch on. A buffer is written again only
+  // when no thread scope shares it any more.
+  bool double_buffer_;
+  std::vector<std::unique_ptr<Scope>> dense_buffers_;
+  std::map<uint64_t, int> front_buffer_;
+  std::map<uint64_t, uint64_t> buffer_versions_;
+  // the sum of buffer_versions_, checked by the threads without the lock
+  std::atomic<uint64_t> buffer_version_{0};
+  std::vector<uint64_t> thread_buffer_version_;
+  std::vector<std::map<uint64_t, uint64_t>> thread_buffer_versions_;
+  std::mutex mutex_for_buffer_;
+
 #if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
   std::vector<gpuStream_t> copy_streams_;
 #endif
@@ -263,6 +284,9 @@ class HogwildWorker : public CPUWorkerBase {
  protected:
   void CreateThreadOperators(const ProgramDesc& program);
   void CreateThreadScope(const ProgramDesc& program);
+  // shares the dense params pulled by the PullDenseWorker of
+  // DistMultiTrainer before a batch, in its double buffer mode
+  void ShareDenseBuffer();
 
   std::vector<std::string> op_names_;
   std::vector<OperatorBase*> ops_;
@@ -326,6 +326,7 @@ void DownpourWorkerOpt::TrainFiles() {
   }
   // pre-defined for the first op run with async-pulled embedding
   while ((cur_batch = device_reader_->Next()) > 0) {
+    ShareDenseBuffer();
     if (copy_table_config_.need_copy()) {
       if (copy_table_config_.sparse_copy_by_feasign()) {
         for (size_t i = 0; i < copy_sparse_tables_.size(); ++i) {
@@ -201,22 +201,7 @@ class GlooWrapper {
     gloo::AllreduceOptions opts(context_);
     opts.setInput(sendbuf.data(), sendbuf.size());
     opts.setOutput(recvbuf.data(), recvbuf.size());
-    if (mode == "sum") {
-      opts.setReduceFunction(
-          static_cast<void (*)(void*, const void*, const void*, size_t)>(
-              &gloo::sum<T>));
-    } else if (mode == "max") {
-      opts.setReduceFunction(
-          static_cast<void (*)(void*, const void*, const void*, size_t)>(
-              &gloo::max<T>));
-    } else if (mode == "min") {
-      opts.setReduceFunction(
-          static_cast<void (*)(void*, const void*, const void*, size_t)>(
-              &gloo::min<T>));
-    } else {
-      PADDLE_ENFORCE_EQ(0, 1, paddle::platform::errors::InvalidArgument(
-                                  "AllReduce mode not known: " + mode));
-    }
+    SetReduceFunction<T>(&opts, mode);
     gloo::allreduce(opts);
 #else
     LOG(WARNING) << "AllReduce does nothing when WITH_GLOO=OFF";
@@ -224,6 +209,23 @@ class GlooWrapper {
     return recvbuf;
   }
 
+  // All-reduces the element_num elements of buf in place, without copying
+  // them into and out of vectors like AllReduce.
+  template <typename T>
+  void AllReduceInPlace(T* buf, size_t element_num,
+                        const std::string& mode = "sum") {
+    CHECK_EQ(is_initialized_, true);
+#ifdef PADDLE_WITH_GLOO
+    gloo::AllreduceOptions opts(context_);
+    // gloo reduces into the output when no input is set
+    opts.setOutput(buf, element_num);
+    SetReduceFunction<T>(&opts, mode);
+    gloo::allreduce(opts);
+#else
+    LOG(WARNING) << "AllReduceInPlace does nothing when WITH_GLOO=OFF";
+#endif
+  }
+
   template <typename T>
   std::vector<T> AllGather(T& input) {  // NOLINT
     CHECK_EQ(is_initialized_, true);
@@ -273,6 +275,29 @@ class GlooWrapper {
   }
 
  protected:
+#ifdef PADDLE_WITH_GLOO
+  template <typename T>
+  static void SetReduceFunction(gloo::AllreduceOptions* opts,
+                                const std::string& mode) {
+    if (mode == "sum") {
+      opts->setReduceFunction(
+          static_cast<void (*)(void*, const void*, const void*, size_t)>(
+              &gloo::sum<T>));
+    } else if (mode == "max") {
+      opts->setReduceFunction(
+          static_cast<void (*)(void*, const void*, const void*, size_t)>(
+              &gloo::max<T>));
+    } else if (mode == "min") {
+      opts->setReduceFunction(
+          static_cast<void (*)(void*, const void*, const void*, size_t)>(
+              &gloo::min<T>));
+    } else {
+      PADDLE_ENFORCE_EQ(0, 1, paddle::platform::errors::InvalidArgument(
+                                  "AllReduce mode not known: " + mode));
+    }
+  }
+#endif
+
   bool is_initialized_ = false;
 #ifdef PADDLE_WITH_GLOO
   std::shared_ptr<gloo::Context> context_ = nullptr;
@@ -0,0 +1,147 @@
+// Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <functional>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+#include "paddle/fluid/framework/archive.h"
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace framework {
+
+// Serializes the records of a streaming global shuffle thread into an archive
+// per trainer. Once the archives hold chunk_bytes in total, the largest one is
+// passed to the send function and its buffer is released, so a thread buffers
+// at most chunk_bytes plus the last record.
+class GlobalShuffleChunker {
+ public:
+  using SendFunc = std::function<void(int trainer_id, std::string&& msg)>;
+
+  GlobalShuffleChunker(int trainer_num, size_t chunk_bytes, SendFunc send)
+      : ars_(trainer_num), chunk_bytes_(chunk_bytes), send_(std::move(send)) {
+    PADDLE_ENFORCE_GT(trainer_num, 0,
+                      platform::errors::InvalidArgument(
+                          "The trainer num of the global shuffle should be "
+                          "greater than 0, but received %d.",
+                          trainer_num));
+    PADDLE_ENFORCE_GT(chunk_bytes, 0,
+                      platform::errors::InvalidArgument(
+                          "The chunk bytes of the global shuffle should be "
+                          "greater than 0."));
+  }
+
+  template <class T>
+  void Add(int trainer_id, const T& record) {
+    auto& ar = ars_[trainer_id];
+    size_t length = ar.Length();
+    ar << record;
+    buffered_bytes_ += ar.Length() - length;
+    if (buffered_bytes_ >= chunk_bytes_) {
+      Send(LargestArchive());
+    }
+  }
+
+  // Sends the remaining archives in the order of the trainer ids.
+  void Flush(const std::vector<int>& trainer_ids) {
+    for (int i : trainer_ids) {
+      if (ars_[i].Length() > 0) {
+        Send(i);
+      }
+    }
+  }
+
+  size_t BufferedBytes() const { return buffered_bytes_; }
+
+ private:
+  int LargestArchive() {
+    int largest = 0;
+    for (size_t i = 1; i < ars_.size(); ++i) {
+      if (ars_[i].Length() > ars_[largest].Length()) {
+        largest = i;
+      }
+    }
+    return largest;
+  }
+
+  void Send(int trainer_id) {
+    auto& ar = ars_[trainer_id];
+    std::string msg(ar.Buffer(), ar.Length());
+    buffered_bytes_ -= ar.Length();
+    // Clear() keeps the capacity, the buffer is freed instead
+    ar = BinaryArchive();
+    send_(trainer_id, std::move(msg));
+  }
+
+  std::vector<BinaryArchive> ars_;
+  size_t chunk_bytes_;
+  SendFunc send_;
+  size_t buffered_bytes_{0};
+};
+
+// Mixes the records of a streaming global shuffle thread across the blocks it
+// reads and the chunks it sends. A record takes a random slot of a buffer of
+// capacity records and the record it replaces is passed to the output
+// function. A record moves by up to about capacity records, while the
+// batched global shuffle shuffles all the local records at once.
+template <class T>
+class GlobalShuffleBuffer {
+ public:
+  using OutputFunc = std::function<void(T&& record)>;
+
+  GlobalShuffleBuffer(size_t capacity, OutputFunc output)
+      : capacity_(capacity), output_(std::move(output)) {
+    PADDLE_ENFORCE_GT(capacity, 0,
+                      platform::errors::InvalidArgument(
+                          "The shuffle buffer of the global shuffle should "
+                          "hold more than 0 records."));
+  }
+
+  template <class Engine>
+  void Add(T&& record, Engine* engine) {
+    if (records_.size() < capacity_) {
+      records_.push_back(std::move(record));
+      return;
+    }
+    std::uniform_int_distribution<size_t> slot(0, capacity_ - 1);
+    std::swap(records_[slot(*engine)], record);
+    output_(std::move(record));
+  }
+
+  // Passes the remaining records on in a random order.
+  template <class Engine>
+  void Flush(Engine* engine) {
+    std::shuffle(records_.begin(), records_.end(), *engine);
+    for (auto& record : records_) {
+      output_(std::move(record));
+    }
+    records_.clear();
+    records_.shrink_to_fit();
+  }
+
+  size_t Size() const { return records_.size(); }
+
+ private:
+  size_t capacity_;
+  OutputFunc output_;
+  std::vector<T> records_;
+};
+
+}  // namespace framework
+}  // namespace paddle
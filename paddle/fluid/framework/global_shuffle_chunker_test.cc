@@ -0,0 +1,134 @@
+// Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/global_shuffle_chunker.h"
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace paddle {
+namespace framework {
+
+static std::vector<uint64_t> ReadChunk(const std::string& msg) {
+  BinaryArchive ar;
+  ar.SetReadBuffer(const_cast<char*>(msg.data()), msg.size(), nullptr);
+  std::vector<uint64_t> records;
+  while (ar.Cursor() < ar.Finish()) {
+    uint64_t record = 0;
+    ar >> record;
+    records.push_back(record);
+  }
+  return records;
+}
+
+TEST(GlobalShuffleChunker, BoundedBuffer) {
+  const int trainer_num = 4;
+  const size_t chunk_bytes = 64;
+  std::map<int, std::vector<uint64_t>> received;
+  size_t max_buffered = 0;
+  int send_num = 0;
+  GlobalShuffleChunker* chunker_ptr = nullptr;
+  GlobalShuffleChunker chunker(
+      trainer_num, chunk_bytes, [&](int trainer_id, std::string&& msg) {
+        EXPECT_GT(msg.size(), 0UL);
+        EXPECT_LT(chunker_ptr->BufferedBytes(), chunk_bytes);
+        auto records = ReadChunk(msg);
+        for (auto record : records) {
+          EXPECT_EQ(static_cast<int>(record % trainer_num), trainer_id);
+        }
+        auto& all = received[trainer_id];
+        all.insert(all.end(), records.begin(), records.end());
+        ++send_num;
+      });
+  chunker_ptr = &chunker;
+
+  // trainer 0 receives most of the records
+  const uint64_t record_num = 1000;
+  std::map<int, std::vector<uint64_t>> expected;
+  for (uint64_t i = 0; i < record_num; ++i) {
+    uint64_t record = i % 3 == 0 ? i : i / 4 * 4;
+    int trainer_id = record % trainer_num;
+    chunker.Add(trainer_id, record);
+    expected[trainer_id].push_back(record);
+    max_buffered = std::max(max_buffered, chunker.BufferedBytes());
+  }
+  EXPECT_LT(max_buffered, chunk_bytes);
+  EXPECT_GT(send_num, 0);
+
+  chunker.Flush({3, 1, 0, 2});
+  EXPECT_EQ(chunker.BufferedBytes(), 0UL);
+  EXPECT_EQ(received, expected);
+
+  // nothing is left to send
+  int flushed_send_num = send_num;
+  chunker.Flush({0, 1, 2, 3});
+  EXPECT_EQ(send_num, flushed_send_num);
+}
+
+TEST(GlobalShuffleChunker, FlushOrder) {
+  std::vector<int> send_order;
+  GlobalShuffleChunker chunker(
+      3, 1 << 20, [&](int trainer_id, std::string&& msg) {
+        send_order.push_back(trainer_id);
+      });
+  chunker.Add(0, uint64_t(1));
+  chunker.Add(2, uint64_t(2));
+  EXPECT_TRUE(send_order.empty());
+  EXPECT_EQ(chunker.BufferedBytes(), 2 * sizeof(uint64_t));
+
+  // the empty archive of trainer 1 is skipped
+  chunker.Flush({2, 1, 0});
+  EXPECT_EQ(send_order, std::vector<int>({2, 0}));
+}
+
+TEST(GlobalShuffleBuffer, MixAcrossBlocks) {
+  const size_t capacity = 256;
+  const uint64_t record_num = 10000, block_size = 100;
+  std::vector<uint64_t> output;
+  GlobalShuffleBuffer<uint64_t> buffer(
+      capacity, [&](uint64_t&& record) { output.push_back(record); });
+  std::default_random_engine engine(0);
+  for (uint64_t i = 0; i < record_num; ++i) {
+    uint64_t record = i;
+    buffer.Add(std::move(record), &engine);
+    EXPECT_LE(buffer.Size(), capacity);
+  }
+  EXPECT_EQ(output.size(), record_num - capacity);
+  buffer.Flush(&engine);
+  EXPECT_EQ(buffer.Size(), 0UL);
+
+  // every record comes out once, and the records of the first block are
+  // spread beyond the blocks that follow it
+  ASSERT_EQ(output.size(), record_num);
+  std::vector<uint64_t> sorted = output;
+  std::sort(sorted.begin(), sorted.end());
+  for (uint64_t i = 0; i < record_num; ++i) {
+    ASSERT_EQ(sorted[i], i);
+  }
+  size_t last_pos = 0;
+  for (size_t pos = 0; pos < output.size(); ++pos) {
+    if (output[pos] < block_size) {
+      last_pos = pos;
+    }
+  }
+  EXPECT_GT(last_pos, capacity + 2 * block_size);
+  EXPECT_FALSE(std::is_sorted(output.begin(), output.end()));
+}
+
+}  // namespace framework
+}  // namespace paddle
@@ -114,6 +114,14 @@ void HogwildWorker::CreateDeviceResource(const ProgramDesc &main_prog) {
   CreateThreadOperators(main_prog);
 }
 
+void HogwildWorker::ShareDenseBuffer() {
+  // only created by the trainers with a PullDenseWorker
+  auto &pull_dense_worker = PullDenseWorker::s_instance_;
+  if (pull_dense_worker != nullptr) {
+    pull_dense_worker->ShareDenseBuffer(thread_id_, thread_scope_);
+  }
+}
+
 void HogwildWorker::TrainFilesWithProfiler() {
   platform::SetNumThreads(1);
   device_reader_->Start();
@@ -138,6 +146,7 @@ void HogwildWorker::TrainFilesWithProfiler() {
     timeline.Pause();
     read_time += timeline.ElapsedSec();
     total_time += timeline.ElapsedSec();
+    ShareDenseBuffer();
     for (size_t i = 0; i < ops_.size(); ++i) {
       bool need_skip = false;
       for (auto t = 0u; t < skip_ops_.size(); ++t) {
@@ -218,6 +227,7 @@ void HogwildWorker::TrainFiles() {
   int cur_batch;
   int batch_cnt = 0;
   while ((cur_batch = device_reader_->Next()) > 0) {
+    ShareDenseBuffer();
     for (auto &op : ops_) {
       bool need_skip = false;
       for (auto t = 0u; t < skip_ops_.size(); ++t) {
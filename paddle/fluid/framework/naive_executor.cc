@@ -13,8 +13,13 @@
 // limitations under the License.
 
 #include "paddle/fluid/framework/naive_executor.h"
+#include <algorithm>
+#include <cstring>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/framework/static_memory_plan.h"
 #include "paddle/fluid/framework/variable_helper.h"
 #include "paddle/fluid/platform/denormal.h"
 #ifdef PADDLE_WITH_MKLDNN
@@ -43,12 +48,303 @@ void NaiveExecutor::Run() {
   platform::AttachPointerHashToMKLDNNKey(this, place_);
 #endif
   platform::ScopedFlushDenormal flush;
-  for (auto &op : ops_) {
+  ShapePlan *plan = nullptr;
+  bool hit = false;
+  if (shape_cache_capacity_ > 0) {
+    plan = LookupShapePlan(&hit);
+  }
+  for (size_t i = 0; i < ops_.size(); ++i) {
+    auto &op = ops_[i];
     VLOG(4) << std::this_thread::get_id() << " run "
             << op->DebugStringEx(scope_) << " on scope " << scope_;
     op->SetIsCalledByExecutor(false);
-    op->Run(*scope_, place_);
+    if (plan != nullptr && shape_cache_vars_[i].op != nullptr) {
+      RunWithShapePlan(i, hit, &(*plan)[i]);
+    } else {
+      op->Run(*scope_, place_);
+    }
+  }
+  if (static_memory_plan_enabled_) {
+    UpdateStaticMemoryPlan();
+  }
+}
+
+void NaiveExecutor::EnableShapeCache(
+    const std::vector<std::string> &input_names, size_t capacity) {
+  PADDLE_ENFORCE_NOT_NULL(scope_,
+                          platform::errors::PreconditionNotMet(
+                              "Need to init scope in NaiveExecutor firstly."));
+  shape_cache_capacity_ = capacity;
+  shape_lru_.clear();
+  shape_plans_.clear();
+  shape_cache_stats_ = ShapeCacheStats();
+
+  shape_cache_inputs_.clear();
+  for (auto &name : input_names) {
+    shape_cache_inputs_.push_back(FindTensor(name));
+  }
+
+  auto find_tensors = [this](const VariableNameMap &var_map,
+                             std::vector<LoDTensor *> *tensors) {
+    for (auto &pair : var_map) {
+      for (auto &name : pair.second) {
+        if (name == kEmptyVarName) {
+          continue;
+        }
+        auto *var = scope_->FindVar(name);
+        if (var == nullptr || !var->IsType<LoDTensor>()) {
+          return false;
+        }
+        tensors->push_back(var->GetMutable<LoDTensor>());
+      }
+    }
+    return true;
+  };
+  shape_cache_vars_.clear();
+  shape_cache_vars_.resize(ops_.size());
+  size_t cached_op_num = 0;
+  for (size_t i = 0; i < ops_.size(); ++i) {
+    auto *op = dynamic_cast<OperatorWithKernel *>(ops_[i].get());
+    if (op == nullptr) {
+      continue;
+    }
+    auto &vars = shape_cache_vars_[i];
+    // an output which is also an input can not be resized before the run
+    if (find_tensors(op->Inputs(), &vars.inputs) &&
+        find_tensors(op->Outputs(), &vars.outputs) &&
+        std::none_of(vars.outputs.begin(), vars.outputs.end(),
+                     [&vars](LoDTensor *out) {
+                       return std::find(vars.inputs.begin(), vars.inputs.end(),
+                                        out) != vars.inputs.end();
+                     })) {
+      vars.op = op;
+      ++cached_op_num;
+    } else {
+      vars = ShapeCacheVars();
+    }
+  }
+  VLOG(3) << "NaiveExecutor caches the output dims of " << cached_op_num
+          << " of " << ops_.size() << " ops for " << capacity
+          << " input signatures";
+}
+
+NaiveExecutor::ShapePlan *NaiveExecutor::LookupShapePlan(bool *hit) {
+  ShapeSignature signature;
+  for (auto *tensor : shape_cache_inputs_) {
+    auto dims = tensor->dims();
+    signature.push_back(dims.size());
+    for (int i = 0; i < dims.size(); ++i) {
+      signature.push_back(dims[i]);
+    }
+    auto &lod = tensor->lod();
+    signature.push_back(lod.size());
+    for (auto &level : lod) {
+      signature.push_back(level.size());
+      signature.insert(signature.end(), level.begin(), level.end());
+    }
+  }
+
+  auto it = shape_plans_.find(signature);
+  if (it != shape_plans_.end()) {
+    ++shape_cache_stats_.hit_num;
+    *hit = true;
+    shape_lru_.splice(shape_lru_.begin(), shape_lru_, it->second.second);
+    return &it->second.first;
+  }
+  ++shape_cache_stats_.miss_num;
+  *hit = false;
+  if (shape_plans_.size() >= shape_cache_capacity_) {
+    shape_plans_.erase(shape_lru_.back());
+    shape_lru_.pop_back();
+  }
+  shape_lru_.push_front(signature);
+  auto &entry = shape_plans_[signature];
+  entry.first.resize(ops_.size());
+  entry.second = shape_lru_.begin();
+  return &entry.first;
+}
+
+void NaiveExecutor::RunWithShapePlan(size_t idx, bool hit,
+                                     OpShapePlan *plan) {
+  auto &vars = shape_cache_vars_[idx];
+  bool matched = hit && plan->recorded;
+  for (size_t i = 0; matched && i < vars.inputs.size(); ++i) {
+    matched = vars.inputs[i]->dims() == plan->input_dims[i] &&
+              vars.inputs[i]->lod() == plan->input_lods[i];
+  }
+  if (matched) {
+    for (size_t i = 0; i < vars.outputs.size(); ++i) {
+      vars.outputs[i]->Resize(plan->output_dims[i]);
+      vars.outputs[i]->set_lod(plan->output_lods[i]);
+    }
+    vars.op->SetSkipInferShape(true);
+    ops_[idx]->Run(*scope_, place_);
+    return;
+  }
+
+  if (hit) {
+    ++shape_cache_stats_.op_miss_num;
+  }
+  // the inputs are recorded before the run, since an output may reuse the
+  // variable of an input
+  plan->input_dims.clear();
+  plan->input_lods.clear();
+  for (auto *tensor : vars.inputs) {
+    plan->input_dims.push_back(tensor->dims());
+    plan->input_lods.push_back(tensor->lod());
+  }
+  plan->recorded = false;
+  vars.op->SetSkipInferShape(false);
+  ops_[idx]->Run(*scope_, place_);
+  plan->output_dims.clear();
+  plan->output_lods.clear();
+  for (auto *tensor : vars.outputs) {
+    plan->output_dims.push_back(tensor->dims());
+    plan->output_lods.push_back(tensor->lod());
+  }
+  plan->recorded = true;
+}
+
+// A block of the static memory arena, which keeps the arena alive.
+class StaticMemoryBlockAllocation : public memory::Allocation {
+ public:
+  StaticMemoryBlockAllocation(std::shared_ptr<memory::Allocation> arena,
+                              size_t offset, size_t size)
+      : Allocation(static_cast<uint8_t *>(arena->ptr()) + offset, size,
+                   arena->place()),
+        arena_(std::move(arena)) {}
+
+ private:
+  std::shared_ptr<memory::Allocation> arena_;
+};
+
+void NaiveExecutor::EnableStaticMemoryPlan(
+    const std::vector<std::string> &input_names,
+    const std::vector<std::string> &output_names) {
+  PADDLE_ENFORCE_NOT_NULL(scope_,
+                          platform::errors::PreconditionNotMet(
+                              "Need to init scope in NaiveExecutor firstly."));
+  if (!platform::is_cpu_place(place_)) {
+    LOG(WARNING) << "The static memory plan only supports CPU, skip it on "
+                 << place_;
+    return;
+  }
+  for (auto &op : ops_) {
+    if (op->HasAttr("sub_block")) {
+      LOG(WARNING) << "Operator " << op->Type()
+                   << " runs a sub block, skip the static memory plan";
+      return;
+    }
+  }
+
+  std::unordered_set<std::string> inputs(input_names.begin(),
+                                         input_names.end());
+  std::unordered_map<std::string, size_t> var_index;
+  static_memory_vars_.clear();
+  auto visit = [&](const VariableNameMap &var_map, int op_idx, bool written) {
+    for (auto &pair : var_map) {
+      for (auto &name : pair.second) {
+        if (name == kEmptyVarName || inputs.count(name)) {
+          continue;
+        }
+        auto it = var_index.find(name);
+        if (it != var_index.end()) {
+          static_memory_vars_[it->second].last_op = op_idx;
+          continue;
+        }
+        // the parameters and the variables fed from outside are read before
+        // written, the persistable variables are in the ancestor scopes
+        auto *var = scope_->FindLocalVar(name);
+        StaticMemoryVar memory_var;
+        memory_var.first_op = op_idx;
+        memory_var.last_op = op_idx;
+        memory_var.excluded =
+            !written || var == nullptr || !var->IsType<LoDTensor>();
+        if (!memory_var.excluded) {
+          memory_var.tensor = var->GetMutable<LoDTensor>();
+        }
+        var_index[name] = static_memory_vars_.size();
+        static_memory_vars_.push_back(memory_var);
+      }
+    }
+  };
+  for (size_t i = 0; i < ops_.size(); ++i) {
+    visit(ops_[i]->Inputs(), i, false);
+    visit(ops_[i]->Outputs(), i, true);
+  }
+  for (auto &name : output_names) {
+    auto it = var_index.find(name);
+    if (it != var_index.end()) {
+      static_memory_vars_[it->second].last_op = ops_.size();
+    }
+  }
+  static_memory_stats_ = StaticMemoryStats();
+  static_memory_plan_enabled_ = true;
+}
+
+void NaiveExecutor::UpdateStaticMemoryPlan() {
+  bool outgrown = false;
+  for (auto &var : static_memory_vars_) {
+    if (var.excluded || !var.tensor->IsInitialized() ||
+        var.tensor->Holder() == var.block) {
+      continue;
+    }
+    auto *tensor = var.tensor;
+    size_t bytes = tensor->numel() * SizeOfType(tensor->type());
+    // the kernel replaced a block large enough, or shares the memory of
+    // another tensor
+    if ((var.block != nullptr && bytes <= var.size) ||
+        (var.block == nullptr && tensor->Holder().use_count() > 1) ||
+        tensor->offset() != 0 || !platform::is_cpu_place(tensor->place())) {
+      VLOG(3) << "Exclude a tensor of " << bytes
+              << " bytes from the static memory plan";
+      var.excluded = true;
+      continue;
+    }
+    var.size = std::max(var.size, bytes);
+    outgrown = true;
+  }
+  if (!outgrown) {
+    return;
+  }
+
+  std::vector<StaticMemoryBlock> blocks;
+  std::vector<StaticMemoryVar *> planned_vars;
+  for (auto &var : static_memory_vars_) {
+    if (!var.excluded && var.size > 0) {
+      StaticMemoryBlock block;
+      block.size = var.size;
+      block.first_op = var.first_op;
+      block.last_op = var.last_op;
+      blocks.push_back(block);
+      planned_vars.push_back(&var);
+    }
+  }
+  auto &stats = static_memory_stats_;
+  stats.arena_size = PlanStaticMemory(&blocks, 64);
+  stats.live_peak_size = StaticMemoryLivePeak(blocks);
+  stats.tensor_size = 0;
+  stats.planned_num = blocks.size();
+  ++stats.plan_num;
+
+  auto arena = memory::AllocShared(place_, stats.arena_size);
+  int end_op = ops_.size();
+  for (size_t i = 0; i < blocks.size(); ++i) {
+    auto *var = planned_vars[i];
+    auto block = std::make_shared<StaticMemoryBlockAllocation>(
+        arena, blocks[i].offset, blocks[i].size);
+    // the outputs are read after the run, they do not overlap each other
+    if (var->last_op == end_op && var->tensor->IsInitialized()) {
+      std::memcpy(block->ptr(), var->tensor->Holder()->ptr(),
+                  var->tensor->numel() * SizeOfType(var->tensor->type()));
+    }
+    var->tensor->ResetHolder(block);
+    var->block = std::move(block);
+    stats.tensor_size += blocks[i].size;
   }
+  LOG(INFO) << "NaiveExecutor plans " << stats.planned_num << " tensors of "
+            << stats.tensor_size << " bytes in an arena of " << stats.arena_size
+            << " bytes, the live peak is " << stats.live_peak_size << " bytes";
 }
 
 void NaiveExecutor::CreateVariables(const ProgramDesc &desc, int block_id,
@@ -125,6 +421,14 @@ void NaiveExecutor::CleanFeedFetchOps() {
     }
   }
   ops_.swap(ops);
+  // the shape cache and the static memory plan index the former ops, enable
+  // them again if needed
+  shape_cache_capacity_ = 0;
+  shape_cache_vars_.clear();
+  shape_lru_.clear();
+  shape_plans_.clear();
+  static_memory_plan_enabled_ = false;
+  static_memory_vars_.clear();
 }
 
 NaiveExecutor::~NaiveExecutor() {
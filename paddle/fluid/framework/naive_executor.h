@@ -14,8 +14,11 @@
 
 #pragma once
 
+#include <list>
+#include <map>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "paddle/fluid/framework/operator.h"
@@ -35,6 +38,27 @@ class LoDTensor;
 class ProgramDesc;
 class Scope;
 
+struct ShapeCacheStats {
+  // Runs whose input signature was cached, or not.
+  uint64_t hit_num{0};
+  uint64_t miss_num{0};
+  // Operators of the hit runs whose input dims differed from the cached
+  // ones, which happens after an operator with data dependent output dims.
+  uint64_t op_miss_num{0};
+};
+
+struct StaticMemoryStats {
+  // The bytes of the planned tensors, which are all held at once without the
+  // plan since NaiveExecutor does not free the temporary tensors.
+  size_t tensor_size{0};
+  // The most bytes of the planned tensors alive at one operator.
+  size_t live_peak_size{0};
+  size_t arena_size{0};
+  size_t planned_num{0};
+  // Times of planning, it plans again once a tensor outgrows its block.
+  uint64_t plan_num{0};
+};
+
 class NaiveExecutor {
  public:
   explicit NaiveExecutor(const platform::Place& place) : place_(place) {}
@@ -65,6 +89,35 @@ class NaiveExecutor {
 
   void ResetTrtOps(int num);
 
+  // Cache the output dims and LoD of the operators per signature, which is the
+  // dims and LoD of the input tensors. A run whose signature is cached sets
+  // the outputs from the cache instead of calling InferShape(). An operator
+  // whose input dims differ from the cached ones, for example after an
+  // operator with data dependent output dims, still calls InferShape() and
+  // updates the cache. At most capacity signatures are kept, the least
+  // recently used one is evicted first. Call it after Prepare().
+  void EnableShapeCache(const std::vector<std::string>& input_names,
+                        size_t capacity);
+
+  const ShapeCacheStats& shape_cache_stats() const {
+    return shape_cache_stats_;
+  }
+
+  // Place the tensors written by the operators in one buffer per executor, at
+  // offsets planned from their lifetimes in the operator order and their
+  // sizes in the former runs, so that the kernels find their outputs already
+  // allocated. The plan is made after the first run, and again after a run in
+  // which a tensor outgrows its block. The tensors of output_names are kept
+  // alive after the last operator. A tensor whose memory is shared with
+  // another one is not planned. Only CPU is supported, and programs with sub
+  // blocks are not. Call it after Prepare().
+  void EnableStaticMemoryPlan(const std::vector<std::string>& input_names,
+                              const std::vector<std::string>& output_names);
+
+  const StaticMemoryStats& static_memory_stats() const {
+    return static_memory_stats_;
+  }
+
  protected:
   void CreateOps(const ProgramDesc& desc, int block_id,
                  bool with_feed_fetch_ops);
@@ -74,6 +127,53 @@ class NaiveExecutor {
   // Catch the required resource to avoid recreate.
   std::vector<std::unique_ptr<OperatorBase>> ops_;
   Scope* scope_;
+
+  // The tensors of an operator whose dims are cached, op is null if the
+  // operator does not call InferShape() or has an input or output which is
+  // not a LoDTensor.
+  struct ShapeCacheVars {
+    OperatorWithKernel* op{nullptr};
+    std::vector<LoDTensor*> inputs;
+    std::vector<LoDTensor*> outputs;
+  };
+  struct OpShapePlan {
+    bool recorded{false};
+    std::vector<DDim> input_dims;
+    std::vector<LoD> input_lods;
+    std::vector<DDim> output_dims;
+    std::vector<LoD> output_lods;
+  };
+  using ShapePlan = std::vector<OpShapePlan>;
+  using ShapeSignature = std::vector<int64_t>;
+
+  ShapePlan* LookupShapePlan(bool* hit);
+  void RunWithShapePlan(size_t idx, bool hit, OpShapePlan* plan);
+
+  size_t shape_cache_capacity_{0};
+  std::vector<LoDTensor*> shape_cache_inputs_;
+  std::vector<ShapeCacheVars> shape_cache_vars_;
+  // The signatures from the most to the least recently used.
+  std::list<ShapeSignature> shape_lru_;
+  std::map<ShapeSignature,
+           std::pair<ShapePlan, std::list<ShapeSignature>::iterator>>
+      shape_plans_;
+  ShapeCacheStats shape_cache_stats_;
+
+  struct StaticMemoryVar {
+    LoDTensor* tensor{nullptr};
+    int first_op{0};
+    int last_op{0};
+    bool excluded{false};
+    // The bytes of the block, the most of the former runs.
+    size_t size{0};
+    std::shared_ptr<memory::Allocation> block;
+  };
+
+  void UpdateStaticMemoryPlan();
+
+  bool static_memory_plan_enabled_{false};
+  std::vector<StaticMemoryVar> static_memory_vars_;
+  StaticMemoryStats static_memory_stats_;
 };
 
 }  // namespace framework
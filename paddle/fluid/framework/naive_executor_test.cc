@@ -15,8 +15,11 @@
 #include "paddle/fluid/framework/naive_executor.h"
 #include <gtest/gtest.h>
 #include <algorithm>
+#include <string>
+#include <vector>
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/framework/program_desc.h"
+#include "paddle/fluid/framework/scope.h"
 
 namespace paddle {
 namespace framework {
@@ -64,6 +67,120 @@ TEST(NaiveExecutor, Basic) {
   }
 }
 
+TEST(NaiveExecutor, ShapeCache) {
+  ProgramDesc program;
+  auto* main_block = program.MutableBlock(0);
+  for (auto name : {"a", "b", "c", "d"}) {
+    main_block->Var(name)->SetType(proto::VarType::LOD_TENSOR);
+  }
+  auto* add0 = main_block->AppendOp();
+  add0->SetType("elementwise_add");
+  add0->SetInput("X", {"a"});
+  add0->SetInput("Y", {"b"});
+  add0->SetOutput("Out", {"c"});
+  auto* add1 = main_block->AppendOp();
+  add1->SetType("elementwise_add");
+  add1->SetInput("X", {"c"});
+  add1->SetInput("Y", {"a"});
+  add1->SetOutput("Out", {"d"});
+
+  auto place = platform::CPUPlace();
+  Scope scope;
+  auto* sub_scope = &scope.NewScope();
+  NaiveExecutor exe(place);
+  exe.CreateVariables(program, 0, false, sub_scope);
+  exe.Prepare(sub_scope, program, 0, false);
+  exe.EnableShapeCache({"a", "b"}, 2);
+
+  auto run = [&](int n) {
+    auto* a_tensor = exe.FindTensor("a");
+    auto* b_tensor = exe.FindTensor("b");
+    a_tensor->Resize({n});
+    b_tensor->Resize({n});
+    auto* a_data = a_tensor->mutable_data<float>(place);
+    auto* b_data = b_tensor->mutable_data<float>(place);
+    for (int i = 0; i < n; ++i) {
+      a_data[i] = i;
+      b_data[i] = 1;
+    }
+    exe.Run();
+    auto* d_tensor = exe.FindTensor("d");
+    ASSERT_EQ(d_tensor->dims(), make_ddim({n}));
+    auto* d_data = d_tensor->data<float>();
+    for (int i = 0; i < n; ++i) {
+      EXPECT_NEAR(d_data[i], 2 * i + 1, 1e-5);
+    }
+  };
+  // the third run restores the dims of the first one from the cache, the
+  // fourth evicts the signature of the second one
+  for (int n : {4, 8, 4, 16, 8, 8}) {
+    run(n);
+  }
+  auto& stats = exe.shape_cache_stats();
+  EXPECT_EQ(stats.hit_num, 2UL);
+  EXPECT_EQ(stats.miss_num, 4UL);
+  EXPECT_EQ(stats.op_miss_num, 0UL);
+}
+
+TEST(NaiveExecutor, StaticMemoryPlan) {
+  ProgramDesc program;
+  auto* main_block = program.MutableBlock(0);
+  for (auto name : {"a", "b", "c", "d", "e"}) {
+    main_block->Var(name)->SetType(proto::VarType::LOD_TENSOR);
+  }
+  // c = a + b, d = c + a, e = d + b, so that c and e can share memory
+  std::vector<std::vector<std::string>> adds = {
+      {"a", "b", "c"}, {"c", "a", "d"}, {"d", "b", "e"}};
+  for (auto& add : adds) {
+    auto* op = main_block->AppendOp();
+    op->SetType("elementwise_add");
+    op->SetInput("X", {add[0]});
+    op->SetInput("Y", {add[1]});
+    op->SetOutput("Out", {add[2]});
+  }
+
+  auto place = platform::CPUPlace();
+  Scope scope;
+  auto* sub_scope = &scope.NewScope();
+  NaiveExecutor exe(place);
+  exe.CreateVariables(program, 0, false, sub_scope);
+  exe.Prepare(sub_scope, program, 0, false);
+  exe.EnableStaticMemoryPlan({"a", "b"}, {"e"});
+
+  auto run = [&](int n) {
+    auto* a_tensor = exe.FindTensor("a");
+    auto* b_tensor = exe.FindTensor("b");
+    a_tensor->Resize({n});
+    b_tensor->Resize({n});
+    auto* a_data = a_tensor->mutable_data<float>(place);
+    auto* b_data = b_tensor->mutable_data<float>(place);
+    for (int i = 0; i < n; ++i) {
+      a_data[i] = i;
+      b_data[i] = 1;
+    }
+    exe.Run();
+    auto* e_tensor = exe.FindTensor("e");
+    ASSERT_EQ(e_tensor->dims(), make_ddim({n}));
+    auto* e_data = e_tensor->data<float>();
+    for (int i = 0; i < n; ++i) {
+      EXPECT_NEAR(e_data[i], 2 * i + 2, 1e-5);
+    }
+  };
+  run(64);
+  run(64);
+  auto& stats = exe.static_memory_stats();
+  EXPECT_EQ(stats.plan_num, 1UL);
+  EXPECT_EQ(stats.planned_num, 3UL);
+  EXPECT_EQ(stats.tensor_size, 768UL);
+  EXPECT_EQ(stats.live_peak_size, 512UL);
+  EXPECT_EQ(stats.arena_size, 512UL);
+  // the larger tensors do not fit in the former plan
+  run(128);
+  run(32);
+  EXPECT_EQ(stats.plan_num, 2UL);
+  EXPECT_EQ(stats.arena_size, 1024UL);
+}
+
 }  // namespace framework
 }  // namespace paddle
 
@@ -18,6 +18,7 @@
 #include "paddle/fluid/framework/details/share_tensor_buffer_functor.h"
 #include "paddle/fluid/framework/new_executor/interpretercore_event_garbage_collector.h"
 #include "paddle/fluid/framework/new_executor/interpretercore_util.h"
+#include "paddle/fluid/framework/new_executor/workqueue/workqueue_utils.h"
 #include "paddle/fluid/framework/operator.h"
 #include "paddle/fluid/platform/profiler.h"
 
@@ -30,6 +31,14 @@ PADDLE_DEFINE_EXPORTED_bool(new_executor_use_inplace, true,
 PADDLE_DEFINE_EXPORTED_bool(new_executor_use_local_scope, true,
                             "Use local_scope in new executor(especially used "
                             "in UT), can turn off for better performance");
+PADDLE_DEFINE_EXPORTED_bool(
+    new_executor_use_work_stealing, false,
+    "Keep ready host ops on the worker that made them ready and only hand "
+    "them to other workers when some worker is idle (work stealing)");
+PADDLE_DEFINE_EXPORTED_bool(
+    new_executor_use_static_schedule, false,
+    "Run CPU-only programs with few parallel branches by a static schedule "
+    "of serial op chains instead of dispatching every op asynchronously");
 
 DECLARE_bool(check_nan_inf);
 DECLARE_bool(benchmark);
@@ -189,6 +198,119 @@ void InterpreterCore::BuildOperatorDependences() {
   }
 }
 
+void InterpreterCore::BuildLocalityOrder() {
+  // score each SyncRun/DirectRun successor by how many of its inputs are
+  // produced by the current instruction, the one sharing the most data with
+  // its producer is run first on the producer's thread.
+  next_instrs_by_locality_.clear();
+  next_instrs_by_locality_.resize(vec_instruction_.size());
+  for (size_t i = 0; i < vec_instruction_.size(); ++i) {
+    auto& instr = vec_instruction_[i];
+    std::unordered_set<int> outputs;
+    for (auto& item : instr.Outputs()) {
+      outputs.insert(item.second.begin(), item.second.end());
+    }
+
+    auto& next_instr = instr.NextInstructions();
+    auto next_ids = interpreter::merge_vector(next_instr.SyncRunIds(),
+                                              next_instr.DirectRunIds());
+    std::vector<std::pair<size_t, size_t>> scored;
+    scored.reserve(next_ids.size());
+    for (auto next_id : next_ids) {
+      size_t shared = 0;
+      for (auto& item : vec_instruction_[next_id].Inputs()) {
+        for (auto var_id : item.second) {
+          shared += outputs.count(var_id);
+        }
+      }
+      scored.emplace_back(shared, next_id);
+    }
+    // stable on ties, so the order of the default scheduler is kept
+    std::stable_sort(scored.begin(), scored.end(),
+                     [](const std::pair<size_t, size_t>& a,
+                        const std::pair<size_t, size_t>& b) {
+                       return a.first > b.first;
+                     });
+    auto& ordered = next_instrs_by_locality_[i];
+    ordered.reserve(scored.size());
+    for (auto& item : scored) {
+      ordered.push_back(item.second);
+    }
+  }
+}
+
+void InterpreterCore::BuildStaticSchedule() {
+  use_static_schedule_ = false;
+  for (auto& instr : vec_instruction_) {
+    if (!platform::is_cpu_place(instr.DeviceContext().GetPlace()) ||
+        instr.KernelType() != OpFuncType::kQueueSync) {
+      VLOG(4) << "Static schedule is disabled since " << instr.OpBase()->Type()
+              << " does not run on CPU synchronously";
+      return;
+    }
+  }
+
+  auto op_nums = vec_instruction_.size();
+  std::vector<std::vector<size_t>> upstream(op_nums);
+  for (size_t op = 0; op < op_nums; ++op) {
+    auto& next_instr = vec_instruction_[op].NextInstructions();
+    for (auto* ids : {&next_instr.SyncRunIds(), &next_instr.DirectRunIds(),
+                      &next_instr.EventRunIds()}) {
+      for (auto next_id : *ids) {
+        upstream[next_id].push_back(op);
+      }
+    }
+  }
+
+  // Instructions are stored in a topological order, append each of them to
+  // the chain of the first upstream instruction that is still the chain's
+  // tail, otherwise start a new chain.
+  static_chains_.clear();
+  instr_chain_pos_.assign(op_nums, {0, 0});
+  for (size_t op = 0; op < op_nums; ++op) {
+    size_t chain_id = static_chains_.size();
+    for (auto pre : upstream[op]) {
+      auto& pos = instr_chain_pos_[pre];
+      if (static_chains_[pos.first].back() == pre) {
+        chain_id = pos.first;
+        break;
+      }
+    }
+    if (chain_id == static_chains_.size()) {
+      static_chains_.emplace_back();
+    }
+    instr_chain_pos_[op] = {chain_id, static_chains_[chain_id].size()};
+    static_chains_[chain_id].push_back(op);
+  }
+
+  // A wide graph gains more from the async scheduler.
+  if (static_chains_.size() > kHostNumThreads) {
+    VLOG(4) << "Static schedule is disabled since the program has "
+            << static_chains_.size() << " parallel chains";
+    static_chains_.clear();
+    instr_chain_pos_.clear();
+    return;
+  }
+
+  join_dependecy_count_.assign(op_nums, 0);
+  cross_chain_next_.assign(op_nums, {});
+  for (size_t op = 0; op < op_nums; ++op) {
+    for (auto pre : upstream[op]) {
+      if (instr_chain_pos_[pre].first != instr_chain_pos_[op].first) {
+        cross_chain_next_[pre].push_back(op);
+        ++join_dependecy_count_[op];
+      }
+    }
+    if (join_dependecy_count_[op] > 0) {
+      ++join_dependecy_count_[op];
+    }
+  }
+
+  use_static_schedule_ = true;
+  VLOG(4) << "Static schedule with " << static_chains_.size()
+          << " chains for " << op_nums << " instructions";
+}
+
 void InterpreterCore::Convert(
     std::vector<paddle::framework::OpFuncNode>* op_func_nodes) {
   auto& vec_meta_info = global_scope_->MutableVecMetaInfo();
@@ -259,6 +381,12 @@ void InterpreterCore::Convert(
 
   BuildOperatorDependences();
 
+  BuildLocalityOrder();
+
+  if (FLAGS_new_executor_use_static_schedule) {
+    BuildStaticSchedule();
+  }
+
   for (size_t i = 0; i < vec_instruction_.size(); ++i) {
     BuildAndCacheInstructionCtx(&vec_instruction_[i]);
   }
@@ -440,6 +568,11 @@ void InterpreterCore::RunInstruction(const Instruction& instr_node) {
 
 void InterpreterCore::ExecuteInstructionList(
     const std::vector<Instruction>& vec_instr) {
+  if (use_static_schedule_) {
+    ExecuteStaticSchedule();
+    return;
+  }
+
   async_work_queue_->PrepareAtomicDeps(dependecy_count_);
   async_work_queue_->PrepareAtomicVarRef(global_scope_->VecMetaInfo());
   unfinished_op_numer_ = vec_instr.size();
@@ -472,8 +605,104 @@ void InterpreterCore::ExecuteInstructionList(
   }
 }
 
+void InterpreterCore::ExecuteStaticSchedule() {
+  async_work_queue_->PrepareAtomicDeps(join_dependecy_count_);
+  async_work_queue_->PrepareAtomicVarRef(global_scope_->VecMetaInfo());
+  unfinished_chain_num_ = static_chains_.size();
+
+  exception_holder_.Clear();
+
+  if (static_chains_.size() == 1) {
+    // fully sequential, run it in the calling thread
+    RunStaticChain(0, 0, true);
+  } else {
+    for (size_t i = 0; i < static_chains_.size(); ++i) {
+      async_work_queue_->AddTask(OpFuncType::kQueueSync,
+                                 [&, i] { RunStaticChain(i, 0, false); });
+    }
+    auto event_name = main_thread_blocker_.WaitEvent();
+    VLOG(1) << "event_name: " << event_name;
+  }
+
+  if (UNLIKELY(exception_holder_.IsCaught())) {
+    VLOG(1) << "Exception caught " << exception_holder_.Type();
+    if (static_chains_.size() > 1) {
+      async_work_queue_->Cancel();
+      async_work_queue_.reset(new interpreter::AsyncWorkQueue(
+          kHostNumThreads, &main_thread_blocker_));
+      PADDLE_ENFORCE_EQ(
+          main_thread_blocker_.Clear(), 0,
+          platform::errors::PreconditionNotMet(
+              "main_thread_blocker_.Clear() return -1, clear failed"));
+    }
+    exception_holder_.ReThrow();
+  }
+}
+
+void InterpreterCore::RunStaticChain(size_t chain_id, size_t start,
+                                     bool start_ready) {
+  auto& chain = static_chains_[chain_id];
+  auto& join_deps = async_work_queue_->AtomicDeps();
+  bool is_async = static_chains_.size() > 1;
+  const OperatorBase* op = nullptr;
+  try {
+    for (size_t i = start; i < chain.size(); ++i) {
+      size_t instr_id = chain[i];
+      // At a join point the last arriving chain runs the instruction.
+      if (join_dependecy_count_[instr_id] > 0 &&
+          !(i == start && start_ready) &&
+          join_deps[instr_id]->fetch_sub(1, std::memory_order_acq_rel) != 1) {
+        return;
+      }
+
+      auto& instr_node = vec_instruction_[instr_id];
+      op = instr_node.OpBase();
+      platform::RecordEvent instruction_event(op->Type().c_str());
+      RunInstruction(instr_node);
+      CheckGC(instr_node);
+
+      for (auto next_id : cross_chain_next_[instr_id]) {
+        if (join_deps[next_id]->fetch_sub(1, std::memory_order_acq_rel) ==
+            1) {
+          auto& pos = instr_chain_pos_[next_id];
+          async_work_queue_->AddTask(OpFuncType::kQueueSync, [&, pos] {
+            RunStaticChain(pos.first, pos.second, true);
+          });
+        }
+      }
+    }
+  } catch (platform::EnforceNotMet& ex) {
+    framework::InsertCallStackInfo(op->Type(), op->Attrs(), &ex);
+    exception_holder_.Catch(std::make_exception_ptr(std::move(ex)));
+  } catch (platform::EOFException&) {
+    exception_holder_.Catch(std::current_exception());
+  } catch (std::exception& ex) {
+    LOG(WARNING) << op->Type() << " raises an exception "
+                 << platform::demangle(typeid(ex).name()) << ", " << ex.what();
+    exception_holder_.Catch(std::current_exception());
+  } catch (...) {
+    LOG(WARNING) << op->Type() << " raises an unknown exception";
+    exception_holder_.Catch(std::current_exception());
+  }
+
+  if (UNLIKELY(exception_holder_.IsCaught())) {
+    VLOG(4) << "Exception caught";
+    if (is_async && exception_notifier_ != nullptr) {
+      exception_notifier_->NotifyEvent();
+    }
+    return;
+  }
+
+  if (is_async &&
+      unfinished_chain_num_.fetch_sub(1, std::memory_order_relaxed) == 1) {
+    if (completion_notifier_ != nullptr) {
+      completion_notifier_->NotifyEvent();
+    }
+  }
+}
+
 void InterpreterCore::RunNextInstructions(
-    const Instruction& instr, std::queue<size_t>* reserved_next_ops) {
+    const Instruction& instr, std::deque<size_t>* reserved_next_ops) {
   auto& next_instr = instr.NextInstructions();
   auto& atomic_deps = async_work_queue_->AtomicDeps();
   auto IsReady = [&](size_t next_id) {
@@ -492,12 +721,12 @@ void InterpreterCore::RunNextInstructions(
     // keep all async_ops running in current thread
     for (auto next_id : next_instr.DirectRunIds()) {
       if (IsReady(next_id)) {
-        reserved_next_ops->push(next_id);
+        reserved_next_ops->push_back(next_id);
       }
     }
     for (auto next_id : next_instr.EventRunIds()) {
       if (IsReady(next_id)) {
-        reserved_next_ops->push(next_id);
+        reserved_next_ops->push_back(next_id);
       }
     }
   } else {
@@ -525,16 +754,49 @@ void InterpreterCore::RunNextInstructions(
             [&, next_id] { RunInstructionAsync(next_id); });
       }
     }
-    if (first_op != 0) reserved_next_ops->push(first_op);
+    if (first_op != 0) reserved_next_ops->push_back(first_op);
+  }
+}
+
+void InterpreterCore::RunNextInstructionsLocally(
+    const Instruction& instr, std::deque<size_t>* reserved_next_ops) {
+  auto& next_instr = instr.NextInstructions();
+  auto& atomic_deps = async_work_queue_->AtomicDeps();
+  auto IsReady = [&](size_t next_id) {
+    return atomic_deps[next_id]->fetch_sub(1, std::memory_order_relaxed) == 1;
+  };
+
+  // move async_ops into async_thread
+  for (auto next_id : next_instr.EventRunIds()) {
+    if (IsReady(next_id)) {
+      async_work_queue_->AddTask(
+          vec_instruction_[next_id].KernelType(),
+          [&, next_id] { RunInstructionAsync(next_id); });
+    }
   }
+
+  // The op sharing the most inputs with instr runs next on this thread, and
+  // the least related ones go to the other workers while some are idle.
+  PushReadyTasks(next_instrs_by_locality_[instr.Id()], IsReady,
+                 reserved_next_ops);
+  ShareReadyTasks(
+      reserved_next_ops,
+      [this] {
+        return async_work_queue_->HasIdleThreads(OpFuncType::kQueueSync);
+      },
+      [&](size_t next_id) {
+        async_work_queue_->AddTask(
+            vec_instruction_[next_id].KernelType(),
+            [&, next_id] { RunInstructionAsync(next_id); });
+      });
 }
 
 void InterpreterCore::RunInstructionAsync(size_t instr_id) {
-  std::queue<size_t> ready_ops;
-  ready_ops.push(instr_id);
+  std::deque<size_t> ready_ops;
+  ready_ops.push_back(instr_id);
   while (!ready_ops.empty()) {
     instr_id = ready_ops.front();
-    ready_ops.pop();
+    ready_ops.pop_front();
     auto& instr_node = vec_instruction_.at(instr_id);
     auto* op = instr_node.OpBase();
     platform::RecordEvent instruction_event(op->Type().c_str());
@@ -580,7 +842,12 @@ void InterpreterCore::RunInstructionAsync(size_t instr_id) {
 
     interpreter::RecordEvent(instr_node, place_);
 
-    RunNextInstructions(instr_node, &ready_ops);
+    if (FLAGS_new_executor_use_work_stealing &&
+        instr_node.KernelType() != OpFuncType::kQueueAsync) {
+      RunNextInstructionsLocally(instr_node, &ready_ops);
+    } else {
+      RunNextInstructions(instr_node, &ready_ops);
+    }
   }
 }
 
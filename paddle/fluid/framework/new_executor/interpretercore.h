@@ -13,8 +13,8 @@
 // limitations under the License.
 #pragma once
 
+#include <deque>
 #include <map>
-#include <queue>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -55,6 +55,10 @@ class InterpreterCore {
 
   void SetCopyProgram(std::shared_ptr<ProgramDesc> prog);
 
+  // Whether the instructions are run by the static schedule, only meaningful
+  // after the first Run has built the instructions.
+  bool UseStaticSchedule() const { return use_static_schedule_; }
+
  private:
   void Convert(std::vector<paddle::framework::OpFuncNode>* op_func_nodes);
 
@@ -80,12 +84,20 @@ class InterpreterCore {
 
   void RunInstructionAsync(size_t instr_id);
   void RunNextInstructions(const Instruction& instr_id,
-                           std::queue<size_t>* reserved_next_ops);
+                           std::deque<size_t>* reserved_next_ops);
+  void RunNextInstructionsLocally(const Instruction& instr,
+                                  std::deque<size_t>* reserved_next_ops);
 
   void BuildSkipShareLoDInfo();
 
   void BuildOperatorDependences();
 
+  void BuildLocalityOrder();
+
+  void BuildStaticSchedule();
+  void ExecuteStaticSchedule();
+  void RunStaticChain(size_t chain_id, size_t start, bool start_ready);
+
   void SetFeedVarsInplaceSkip(const std::vector<std::string>& feed_names);
 
   void ClearLoDTensorArrayInLocalScope();
@@ -107,6 +119,22 @@ class InterpreterCore {
   std::vector<size_t> dependecy_count_;
   std::atomic<size_t> unfinished_op_numer_{0};
   std::vector<std::vector<size_t>> input_var2op_info_;
+  // For each instruction, its SyncRun and DirectRun successors sorted by the
+  // number of vars they read from the instruction's outputs, used by the
+  // work-stealing scheduler to keep consumers on the producer's thread.
+  std::vector<std::vector<size_t>> next_instrs_by_locality_;
+
+  // Static schedule of CPU-only and mostly sequential programs, see
+  // BuildStaticSchedule. Every instruction belongs to one serial chain,
+  // chains only synchronize on the instructions where they join.
+  bool use_static_schedule_{false};
+  std::vector<std::vector<size_t>> static_chains_;
+  std::vector<std::pair<size_t, size_t>> instr_chain_pos_;  // chain, index
+  // number of upstream instructions in other chains plus one for the owning
+  // chain, 0 for instructions that only depend on their own chain
+  std::vector<size_t> join_dependecy_count_;
+  std::vector<std::vector<size_t>> cross_chain_next_;
+  std::atomic<size_t> unfinished_chain_num_{0};
 
   StreamAnalyzer stream_analyzer_;
   EventsWaiter main_thread_blocker_;
@@ -40,6 +40,14 @@ void AsyncWorkQueue::AddTask(const OpFuncType& op_func_type,
   }
 }
 
+bool AsyncWorkQueue::HasIdleThreads(const OpFuncType& op_func_type) const {
+  if (FLAGS_new_executor_sequential_run) {
+    return queue_group_->QueueHasIdleThreads(
+        static_cast<size_t>(OpFuncType::kQueueAsync));
+  }
+  return queue_group_->QueueHasIdleThreads(static_cast<size_t>(op_func_type));
+}
+
 using VariableIdMap = std::map<std::string, std::vector<int>>;
 
 AtomicVectorSizeT& AsyncWorkQueue::PrepareAtomicDeps(
@@ -81,6 +81,9 @@ class AsyncWorkQueue {
 
   void AddTask(const OpFuncType& op_func_type, std::function<void()> fn);
 
+  // Whether the queue serving op_func_type has a thread waiting for work
+  bool HasIdleThreads(const OpFuncType& op_func_type) const;
+
   void Cancel() { queue_group_->Cancel(); }
 
   AtomicVectorSizeT& AtomicDeps() { return atomic_deps_; }
@@ -19,6 +19,8 @@
 
 // #include "gperftools/profiler.h"
 
+#include "paddle/fluid/framework/new_executor/interpretercore.h"
+#include "paddle/fluid/framework/new_executor/interpretercore_util.h"
 #include "paddle/fluid/framework/new_executor/standalone_executor.h"
 
 USE_OP(fill_constant);
@@ -59,7 +61,10 @@ USE_OP(sgd);
 USE_OP(squared_l2_norm);
 USE_OP(memcpy_h2d);
 USE_OP(memcpy_d2h);
+USE_OP(fetch_v2);
 DECLARE_double(eager_delete_tensor_gb);
+DECLARE_bool(new_executor_use_static_schedule);
+DECLARE_bool(new_executor_use_work_stealing);
 
 namespace paddle {
 namespace framework {
@@ -125,5 +130,179 @@ TEST(StandaloneExecutor, run) {
   // ASSERT_LT(diff.count(), 30);
 }
 
+void AppendOp(BlockDesc* block, const std::string& type,
+              const VariableNameMap& ins, const std::string& out,
+              const AttributeMap& attrs) {
+  auto* op = block->AppendOp();
+  op->SetType(type);
+  for (auto& in : ins) {
+    op->SetInput(in.first, in.second);
+  }
+  op->SetOutput("Out", {out});
+  op->SetAttrMap(attrs);
+  op->CheckAttrs();
+}
+
+// A mostly sequential CPU program, fill_constant x and y run on two chains
+// that join at elementwise_add, so it is eligible for the static schedule.
+ProgramDesc BuildChainProgram() {
+  ProgramDesc program;
+  auto* block = program.MutableBlock(0);
+  for (auto& name : {"x", "y", "a", "b", "c", "d"}) {
+    auto* var = block->Var(name);
+    var->SetType(proto::VarType::LOD_TENSOR);
+    var->SetDataType(proto::VarType::FP32);
+  }
+
+  AttributeMap fill_attrs = {
+      {"shape", std::vector<int64_t>{4, 8}},
+      {"dtype", static_cast<int>(proto::VarType::FP32)}};
+  fill_attrs["value"] = 0.5f;
+  AppendOp(block, "fill_constant", {}, "x", fill_attrs);
+  fill_attrs["value"] = 0.25f;
+  AppendOp(block, "fill_constant", {}, "y", fill_attrs);
+  AppendOp(block, "elementwise_add", {{"X", {"x"}}, {"Y", {"y"}}}, "a", {});
+  AppendOp(block, "tanh", {{"X", {"a"}}}, "b", {});
+  AppendOp(block, "sigmoid", {{"X", {"b"}}}, "c", {});
+  AppendOp(block, "elementwise_mul", {{"X", {"c"}}, {"Y", {"x"}}}, "d", {});
+  return program;
+}
+
+std::vector<float> RunChainProgram(bool use_static_schedule, size_t run_num,
+                                   bool* static_schedule_used) {
+  FLAGS_new_executor_use_static_schedule = use_static_schedule;
+  auto program = BuildChainProgram();
+  interpreter::add_fetch({"d"}, program.MutableBlock(0));
+
+  Scope scope;
+  VariableScope var_scope(&scope);
+  InterpreterCore core(platform::CPUPlace(), program.Block(0), &var_scope);
+  std::vector<float> result;
+  for (size_t i = 0; i < run_num; ++i) {
+    auto fetch_list = core.Run({}, {});
+    EXPECT_EQ(fetch_list.size(), 1UL);
+    auto& out = BOOST_GET_CONST(LoDTensor, fetch_list[0]);
+    result.assign(out.data<float>(), out.data<float>() + out.numel());
+  }
+  *static_schedule_used = core.UseStaticSchedule();
+  FLAGS_new_executor_use_static_schedule = false;
+  return result;
+}
+
+TEST(StandaloneExecutor, static_schedule_on_cpu) {
+  // The first run builds the instructions, the following ones execute them
+  // through the scheduler.
+  const size_t run_num = 3;
+  bool static_schedule_used = false;
+  auto expected = RunChainProgram(false, run_num, &static_schedule_used);
+  EXPECT_FALSE(static_schedule_used);
+
+  auto actual = RunChainProgram(true, run_num, &static_schedule_used);
+  EXPECT_TRUE(static_schedule_used);
+
+  ASSERT_EQ(actual.size(), 32UL);
+  ASSERT_EQ(actual.size(), expected.size());
+  for (size_t i = 0; i < actual.size(); ++i) {
+    EXPECT_NEAR(actual[i], expected[i], 1e-6);
+  }
+}
+
+// A wide CPU program, every level of branches is made ready at once by the
+// ops before it, so the workers share the ready ops of each level.
+ProgramDesc BuildWideProgram(int branch_num, int level_num) {
+  ProgramDesc program;
+  auto* block = program.MutableBlock(0);
+  auto add_var = [block](const std::string& name) {
+    auto* var = block->Var(name);
+    var->SetType(proto::VarType::LOD_TENSOR);
+    var->SetDataType(proto::VarType::FP32);
+    return name;
+  };
+
+  AttributeMap fill_attrs = {
+      {"shape", std::vector<int64_t>{16, 16}},
+      {"dtype", static_cast<int>(proto::VarType::FP32)}};
+  fill_attrs["value"] = 0.5f;
+  AppendOp(block, "fill_constant", {}, add_var("x"), fill_attrs);
+  fill_attrs["value"] = -0.25f;
+  AppendOp(block, "fill_constant", {}, add_var("y"), fill_attrs);
+
+  const std::vector<std::string> unary_ops = {"tanh", "sigmoid"};
+  const std::vector<std::string> binary_ops = {"elementwise_add",
+                                               "elementwise_mul"};
+  std::vector<std::string> prev = {"x", "y"};
+  for (int l = 0; l < level_num; ++l) {
+    std::vector<std::string> cur;
+    for (int b = 0; b < branch_num; ++b) {
+      auto out = add_var("l" + std::to_string(l) + "_b" + std::to_string(b));
+      auto& in = prev[b % prev.size()];
+      if (b % 2 == 0) {
+        AppendOp(block, unary_ops[(b / 2 + l) % 2], {{"X", {in}}}, out, {});
+      } else {
+        auto& other = prev[(b + 1) % prev.size()];
+        AppendOp(block, binary_ops[(b / 2 + l) % 2],
+                 {{"X", {in}}, {"Y", {other}}}, out, {});
+      }
+      cur.push_back(out);
+    }
+    prev.swap(cur);
+  }
+
+  // join the branches of the last level pairwise into "out"
+  while (prev.size() > 1) {
+    std::vector<std::string> cur;
+    for (size_t i = 0; i + 1 < prev.size(); i += 2) {
+      auto out = add_var(prev[i] + "_" + prev[i + 1]);
+      AppendOp(block, "elementwise_add",
+               {{"X", {prev[i]}}, {"Y", {prev[i + 1]}}}, out, {});
+      cur.push_back(out);
+    }
+    if (prev.size() % 2 == 1) {
+      cur.push_back(prev.back());
+    }
+    prev.swap(cur);
+  }
+  AppendOp(block, "tanh", {{"X", {prev[0]}}}, add_var("out"), {});
+  return program;
+}
+
+std::vector<float> RunWideProgram(bool use_work_stealing, size_t run_num) {
+  FLAGS_new_executor_use_work_stealing = use_work_stealing;
+  auto program = BuildWideProgram(/*branch_num*/ 8, /*level_num*/ 6);
+  interpreter::add_fetch({"out"}, program.MutableBlock(0));
+
+  Scope scope;
+  VariableScope var_scope(&scope);
+  InterpreterCore core(platform::CPUPlace(), program.Block(0), &var_scope);
+  std::vector<float> result;
+  for (size_t i = 0; i < run_num; ++i) {
+    auto fetch_list = core.Run({}, {});
+    EXPECT_EQ(fetch_list.size(), 1UL);
+    auto& out = BOOST_GET_CONST(LoDTensor, fetch_list[0]);
+    std::vector<float> cur(out.data<float>(), out.data<float>() + out.numel());
+    // every run of the same program gives the same output
+    if (!result.empty()) {
+      EXPECT_EQ(cur, result);
+    }
+    result.swap(cur);
+  }
+  FLAGS_new_executor_use_work_stealing = false;
+  return result;
+}
+
+TEST(StandaloneExecutor, work_stealing_on_cpu) {
+  // The first run builds the instructions, the following ones dispatch them
+  // through the work queue, with and without work stealing.
+  const size_t run_num = 5;
+  auto expected = RunWideProgram(false, run_num);
+  auto actual = RunWideProgram(true, run_num);
+
+  ASSERT_EQ(actual.size(), 256UL);
+  ASSERT_EQ(actual.size(), expected.size());
+  for (size_t i = 0; i < actual.size(); ++i) {
+    EXPECT_NEAR(actual[i], expected[i], 1e-6);
+  }
+}
+
 }  // namespace framework
 }  // namespace paddle
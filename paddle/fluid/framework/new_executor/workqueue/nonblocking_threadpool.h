@@ -152,6 +152,15 @@ class ThreadPoolTempl {
 
   size_t NumThreads() const { return num_threads_; }
 
+  // Returns true if some worker has neither a running nor a pending task.
+  // num_tasks_ counts the tasks being executed as well as the queued ones, so
+  // this is a cheap hint for callers that want to keep ready work on the
+  // current worker unless another worker could steal it right now.
+  bool HasIdleThreads() const {
+    return num_tasks_.load(std::memory_order_relaxed) <
+           static_cast<uint64_t>(num_threads_);
+  }
+
   int CurrentThreadId() const {
     const PerThread* pt = const_cast<ThreadPoolTempl*>(this)->GetPerThread();
     if (pt->pool == this) {
@@ -67,6 +67,8 @@ class WorkQueueImpl : public WorkQueue {
 
   size_t NumThreads() const override { return queue_->NumThreads(); }
 
+  bool HasIdleThreads() const override { return queue_->HasIdleThreads(); }
+
  private:
   NonblockingThreadPool* queue_{nullptr};
   TaskTracker* tracker_{nullptr};
@@ -87,6 +89,8 @@ class WorkQueueGroupImpl : public WorkQueueGroup {
 
   size_t QueueGroupNumThreads() const override;
 
+  bool QueueHasIdleThreads(size_t queue_idx) const override;
+
   void Cancel() override;
 
  private:
@@ -169,6 +173,11 @@ size_t WorkQueueGroupImpl::QueueGroupNumThreads() const {
   return total_num;
 }
 
+bool WorkQueueGroupImpl::QueueHasIdleThreads(size_t queue_idx) const {
+  assert(queue_idx < queues_.size());
+  return queues_.at(queue_idx)->HasIdleThreads();
+}
+
 void WorkQueueGroupImpl::Cancel() {
   for (auto queue : queues_) {
     queue->Cancel();
@@ -70,6 +70,9 @@ class WorkQueue {
 
   virtual size_t NumThreads() const = 0;
 
+  // Returns true if some thread of the queue is waiting for work
+  virtual bool HasIdleThreads() const = 0;
+
   virtual void Cancel() = 0;
 
  protected:
@@ -96,6 +99,9 @@ class WorkQueueGroup {
 
   virtual size_t QueueGroupNumThreads() const = 0;
 
+  // Returns true if some thread of the queue is waiting for work
+  virtual bool QueueHasIdleThreads(size_t queue_idx) const = 0;
+
   virtual void Cancel() = 0;
 
  protected:
@@ -0,0 +1,160 @@
+// Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <vector>
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/framework/new_executor/workqueue/workqueue.h"
+#include "paddle/fluid/framework/new_executor/workqueue/workqueue_utils.h"
+
+DEFINE_int32(repeat, 200, "The runs of the graph for each schedule.");
+DEFINE_int32(num_threads, 4, "The threads of the work queue.");
+
+namespace {
+
+// A synthetic wide graph: one source op fans out to kTowers chains of
+// kDepth ops each, all of them joined by one sink op, roughly the shape of a
+// multi-tower CTR model.
+struct WideGraph {
+  static constexpr size_t kTowers = 64;
+  static constexpr size_t kDepth = 32;
+
+  WideGraph() {
+    size_t num_ops = kTowers * kDepth + 2;
+    next.resize(num_ops);
+    deps.resize(num_ops);
+    for (size_t t = 0; t < kTowers; ++t) {
+      size_t head = 1 + t * kDepth;
+      next[0].push_back(head);
+      for (size_t d = 0; d + 1 < kDepth; ++d) {
+        next[head + d].push_back(head + d + 1);
+      }
+      next[head + kDepth - 1].push_back(num_ops - 1);
+    }
+    for (auto& outs : next) {
+      for (auto id : outs) {
+        ++deps[id];
+      }
+    }
+  }
+
+  size_t Size() const { return next.size(); }
+
+  std::vector<std::vector<size_t>> next;
+  std::vector<size_t> deps;
+};
+
+class GraphRunner {
+ public:
+  GraphRunner(const WideGraph& graph, paddle::framework::WorkQueue* queue,
+              bool work_stealing)
+      : graph_(graph), queue_(queue), work_stealing_(work_stealing) {}
+
+  void Run() {
+    deps_.clear();
+    for (auto dep : graph_.deps) {
+      deps_.emplace_back(new std::atomic<size_t>(dep));
+    }
+    unfinished_ = graph_.Size();
+    queue_->AddTask([this] { RunOp(0); });
+  }
+
+  bool Finished() const { return unfinished_.load() == 0; }
+
+ private:
+  void Compute(size_t op) {
+    // a kernel of about a microsecond
+    volatile size_t sum = 0;
+    for (size_t i = 0; i < 256; ++i) {
+      sum += i * op;
+    }
+  }
+
+  // the handoff schedule keeps the first ready successor and hands the others
+  // to the queue, like InterpreterCore::RunNextInstructions
+  void RunOp(size_t op) {
+    std::deque<size_t> ready_ops;
+    ready_ops.push_back(op);
+    while (!ready_ops.empty()) {
+      op = ready_ops.front();
+      ready_ops.pop_front();
+      Compute(op);
+      unfinished_.fetch_sub(1);
+      if (work_stealing_) {
+        paddle::framework::PushReadyTasks(
+            graph_.next[op],
+            [this](size_t id) { return deps_[id]->fetch_sub(1) == 1; },
+            &ready_ops);
+        paddle::framework::ShareReadyTasks(
+            &ready_ops, [this] { return queue_->HasIdleThreads(); },
+            [this](size_t id) { queue_->AddTask([this, id] { RunOp(id); }); });
+      } else {
+        bool keep_first = true;
+        for (auto next_id : graph_.next[op]) {
+          if (deps_[next_id]->fetch_sub(1) == 1) {
+            if (keep_first) {
+              ready_ops.push_back(next_id);
+              keep_first = false;
+              continue;
+            }
+            queue_->AddTask([this, next_id] { RunOp(next_id); });
+          }
+        }
+      }
+    }
+  }
+
+  const WideGraph& graph_;
+  paddle::framework::WorkQueue* queue_;
+  bool work_stealing_;
+  std::vector<std::unique_ptr<std::atomic<size_t>>> deps_;
+  std::atomic<size_t> unfinished_{0};
+};
+
+double RunWideGraph(bool work_stealing, size_t repeat) {
+  using paddle::framework::WorkQueueOptions;
+  using paddle::framework::CreateMultiThreadedWorkQueue;
+  using paddle::framework::EventsWaiter;
+  EventsWaiter events_waiter;
+  WorkQueueOptions options(FLAGS_num_threads, /*allow_spinning*/ true,
+                           /*track_task*/ true, /*detached*/ true,
+                           &events_waiter);
+  auto work_queue = CreateMultiThreadedWorkQueue(options);
+  WideGraph graph;
+  GraphRunner runner(graph, work_queue.get(), work_stealing);
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < repeat; ++i) {
+    runner.Run();
+    events_waiter.WaitEvent();
+  }
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::micro>(end - start).count() /
+         (repeat * graph.Size());
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  ::GFLAGS_NAMESPACE::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  double handoff_us = RunWideGraph(/*work_stealing*/ false, FLAGS_repeat);
+  double stealing_us = RunWideGraph(/*work_stealing*/ true, FLAGS_repeat);
+  LOG(INFO) << "wide graph, us per op: handoff " << handoff_us
+            << ", work stealing " << stealing_us;
+  return 0;
+}
@@ -14,6 +14,9 @@
 
 #include "paddle/fluid/framework/new_executor/workqueue/workqueue.h"
 #include <atomic>
+#include <deque>
+#include <memory>
+#include <vector>
 #include "glog/logging.h"
 #include "gtest/gtest.h"
 #include "paddle/fluid/framework/new_executor/workqueue/workqueue_utils.h"
@@ -151,3 +154,144 @@ TEST(WorkQueue, TestWorkQueueGroup) {
   queue_group.reset();
   EXPECT_EQ(events_waiter.WaitEvent(), paddle::framework::kQueueDestructEvent);
 }
+
+namespace {
+
+// A DAG of a source op fanning out to kTowers chains of kDepth ops, with an
+// edge from each op to the next op of the next chain, all of them joined by
+// a sink op.
+struct TowerGraph {
+  static constexpr size_t kTowers = 16;
+  static constexpr size_t kDepth = 16;
+
+  TowerGraph() {
+    size_t num_ops = kTowers * kDepth + 2;
+    next.resize(num_ops);
+    prev.resize(num_ops);
+    for (size_t t = 0; t < kTowers; ++t) {
+      size_t head = 1 + t * kDepth;
+      next[0].push_back(head);
+      for (size_t d = 0; d + 1 < kDepth; ++d) {
+        next[head + d].push_back(head + d + 1);
+        if (t + 1 < kTowers) {
+          next[head + d].push_back(head + kDepth + d + 1);
+        }
+      }
+      next[head + kDepth - 1].push_back(num_ops - 1);
+    }
+    for (size_t op = 0; op < num_ops; ++op) {
+      for (auto id : next[op]) {
+        prev[id].push_back(op);
+      }
+    }
+  }
+
+  size_t Size() const { return next.size(); }
+
+  std::vector<std::vector<size_t>> next;
+  std::vector<std::vector<size_t>> prev;
+};
+
+// Runs the graph on the work queue by PushReadyTasks and ShareReadyTasks, the
+// work-stealing schedule of InterpreterCore, and checks the ops.
+class StealingGraphRunner {
+ public:
+  StealingGraphRunner(const TowerGraph& graph,
+                      paddle::framework::WorkQueue* queue)
+      : graph_(graph), queue_(queue) {}
+
+  void Run() {
+    deps_.clear();
+    run_counts_.clear();
+    finished_.clear();
+    for (size_t op = 0; op < graph_.Size(); ++op) {
+      deps_.emplace_back(new std::atomic<size_t>(graph_.prev[op].size()));
+      run_counts_.emplace_back(new std::atomic<size_t>(0));
+      finished_.emplace_back(new std::atomic<bool>(false));
+    }
+    unfinished_ = graph_.Size();
+    queue_->AddTask([this] { RunOp(0); });
+  }
+
+  bool Finished() const { return unfinished_.load() == 0; }
+  size_t RunCount(size_t op) const { return run_counts_[op]->load(); }
+  size_t EarlyRuns() const { return early_runs_.load(); }
+
+ private:
+  void RunOp(size_t op) {
+    std::deque<size_t> ready_ops;
+    ready_ops.push_back(op);
+    while (!ready_ops.empty()) {
+      op = ready_ops.front();
+      ready_ops.pop_front();
+      run_counts_[op]->fetch_add(1);
+      for (auto prev_id : graph_.prev[op]) {
+        if (!finished_[prev_id]->load()) {
+          early_runs_.fetch_add(1);
+        }
+      }
+      finished_[op]->store(true);
+      unfinished_.fetch_sub(1);
+
+      paddle::framework::PushReadyTasks(
+          graph_.next[op],
+          [this](size_t id) { return deps_[id]->fetch_sub(1) == 1; },
+          &ready_ops);
+      paddle::framework::ShareReadyTasks(
+          &ready_ops, [this] { return queue_->HasIdleThreads(); },
+          [this](size_t id) { queue_->AddTask([this, id] { RunOp(id); }); });
+    }
+  }
+
+  const TowerGraph& graph_;
+  paddle::framework::WorkQueue* queue_;
+  std::vector<std::unique_ptr<std::atomic<size_t>>> deps_;
+  std::vector<std::unique_ptr<std::atomic<size_t>>> run_counts_;
+  std::vector<std::unique_ptr<std::atomic<bool>>> finished_;
+  std::atomic<size_t> unfinished_{0};
+  std::atomic<size_t> early_runs_{0};
+};
+
+}  // namespace
+
+TEST(WorkQueueUtils, ReadyTasksOrder) {
+  using paddle::framework::PushReadyTasks;
+  using paddle::framework::ShareReadyTasks;
+  std::deque<size_t> ready_tasks = {9};
+  PushReadyTasks({1, 2, 3, 4}, [](size_t id) { return id != 3; },
+                 &ready_tasks);
+  EXPECT_EQ(ready_tasks, std::deque<size_t>({1, 2, 4, 9}));
+
+  std::vector<size_t> shared;
+  int idle_threads = 2;
+  ShareReadyTasks(&ready_tasks, [&] { return idle_threads-- > 0; },
+                  [&](size_t id) { shared.push_back(id); });
+  EXPECT_EQ(shared, std::vector<size_t>({9, 4}));
+  EXPECT_EQ(ready_tasks, std::deque<size_t>({1, 2}));
+
+  ShareReadyTasks(&ready_tasks, [] { return true; },
+                  [&](size_t id) { shared.push_back(id); });
+  EXPECT_EQ(ready_tasks, std::deque<size_t>({1}));
+}
+
+TEST(WorkQueue, WorkStealingSchedule) {
+  using paddle::framework::WorkQueueOptions;
+  using paddle::framework::CreateMultiThreadedWorkQueue;
+  using paddle::framework::EventsWaiter;
+  EventsWaiter events_waiter;
+  WorkQueueOptions options(/*num_threads*/ 4, /*allow_spinning*/ true,
+                           /*track_task*/ true, /*detached*/ true,
+                           &events_waiter);
+  auto work_queue = CreateMultiThreadedWorkQueue(options);
+  TowerGraph graph;
+  StealingGraphRunner runner(graph, work_queue.get());
+  for (int i = 0; i < 20; ++i) {
+    runner.Run();
+    events_waiter.WaitEvent();
+    ASSERT_TRUE(runner.Finished());
+    for (size_t op = 0; op < graph.Size(); ++op) {
+      ASSERT_EQ(runner.RunCount(op), 1UL) << "op " << op;
+    }
+    ASSERT_EQ(runner.EarlyRuns(), 0UL);
+  }
+}
@@ -18,9 +18,11 @@
 #include <cassert>
 #include <cstddef>
 #include <cstdlib>
+#include <deque>
 #include <memory>
 #include <set>
 #include <string>
+#include <vector>
 #include "paddle/fluid/framework/new_executor/workqueue/events_waiter.h"
 #include "paddle/fluid/platform/enforce.h"
 
@@ -98,5 +100,31 @@ class TaskTracker {
   Notifier* notifier_{nullptr};
 };
 
+// The work-stealing schedule keeps the ready tasks of a worker in its local
+// deque, the one to run next at the front. PushReadyTasks puts the ready ones
+// of the ordered successors at the front, in their order.
+template <typename IsReady>
+void PushReadyTasks(const std::vector<size_t>& ordered, IsReady is_ready,
+                    std::deque<size_t>* ready_tasks) {
+  for (auto it = ordered.rbegin(); it != ordered.rend(); ++it) {
+    if (is_ready(*it)) {
+      ready_tasks->push_front(*it);
+    }
+  }
+}
+
+// Hands the tasks at the back of the deque, the least related ones, to the
+// queue while it has idle threads, which steal them. The front one is kept to
+// run locally, so the tasks cost no handoff while all the workers are busy.
+template <typename HasIdleThreads, typename AddTask>
+void ShareReadyTasks(std::deque<size_t>* ready_tasks,
+                     HasIdleThreads has_idle_threads, AddTask add_task) {
+  while (ready_tasks->size() > 1 && has_idle_threads()) {
+    size_t id = ready_tasks->back();
+    ready_tasks->pop_back();
+    add_task(id);
+  }
+}
+
 }  // namespace framework
 }  // namespace paddle
@@ -524,6 +524,10 @@ class OperatorWithKernel : public OperatorBase {
   void RuntimeInferShape(const Scope& scope, const platform::Place& place,
                          const RuntimeContext& ctx) const override;
 
+  // Skip InferShape() in the following runs, for the executors which set the
+  // output dims recorded by a former run with the same input dims.
+  void SetSkipInferShape(bool skip) { skip_infer_shape_ = skip; }
+
   proto::VarType::Type IndicateVarDataType(const ExecutionContext& ctx,
                                            const std::string& name) const;
 
@@ -611,6 +615,7 @@ class OperatorWithKernel : public OperatorBase {
   mutable bool need_prepare_data_ = true;
   mutable bool enable_cache_runtime_context_ = false;
   mutable bool all_kernels_must_compute_runtime_shape_ = false;
+  bool skip_infer_shape_ = false;
   mutable std::mutex cache_update_mutex_;
   mutable bool enable_cache_transfer_scope_ = false;
   // NOTE(chenweihang): Similar op members are used to adapt to
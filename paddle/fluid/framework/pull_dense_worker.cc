@@ -59,6 +59,17 @@ void PullDenseWorker::Initialize(const TrainerDesc& param) {
     current_version_[tid] = 0;
   }
   fleet_ptr_ = FleetWrapper::GetInstance();
+  double_buffer_ = param_.double_buffer();
+#if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP) || \
+    defined(PADDLE_WITH_XPU)
+  // the dense params are pulled into the pinned vars and copied to each place
+  if (double_buffer_) {
+    LOG(WARNING) << "the double buffer of PullDenseWorker only works on CPU";
+    double_buffer_ = false;
+  }
+#endif
+  thread_buffer_version_.assign(thread_num_, 0);
+  thread_buffer_versions_.assign(thread_num_, {});
 #if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
   copy_streams_.clear();
 #endif
@@ -155,15 +166,119 @@ void PullDenseWorker::Stop() {
     running_ = false;
     t_.join();
   }
+  if (double_buffer_) {
+    MergeDenseBuffer();
+    double_buffer_ = false;
+    dense_buffers_.clear();
+  }
+}
+
+void PullDenseWorker::CreateDenseBuffer() {
+  std::lock_guard<std::mutex> lock(mutex_for_buffer_);
+  dense_buffers_.clear();
+  dense_buffers_.emplace_back(new Scope());
+  dense_buffers_.emplace_back(new Scope());
+  front_buffer_.clear();
+  buffer_versions_.clear();
+  buffer_version_ = 0;
+  for (int i = 0; i < dwp_param_.program_config(0).pull_dense_table_id_size();
+       ++i) {
+    uint64_t tid = static_cast<uint64_t>(
+        dwp_param_.program_config(0).pull_dense_table_id(i));
+    for (auto& name : dense_value_names_[tid]) {
+      auto& root_tensor = root_scope_->FindVar(name)->Get<LoDTensor>();
+      for (auto& buffer : dense_buffers_) {
+        auto* tensor = buffer->Var(name)->GetMutable<LoDTensor>();
+        tensor->mutable_data<float>(root_tensor.dims(), platform::CPUPlace());
+      }
+    }
+    front_buffer_[tid] = 0;
+    buffer_versions_[tid] = 0;
+  }
+}
+
+Scope* PullDenseWorker::BackDenseBuffer(uint64_t table_id) {
+  std::lock_guard<std::mutex> lock(mutex_for_buffer_);
+  Scope* buffer = dense_buffers_[1 - front_buffer_[table_id]].get();
+  for (auto& name : dense_value_names_[table_id]) {
+    auto* tensor = buffer->FindVar(name)->GetMutable<LoDTensor>();
+    // still shared by a thread in a batch begun before the last publish, so
+    // the pull goes to a new allocation instead
+    if (tensor->Holder().use_count() > 1) {
+      VLOG(3) << "dense buffer of " << name << " is in use, reallocate it";
+      auto dims = tensor->dims();
+      tensor->clear();
+      tensor->mutable_data<float>(dims, platform::CPUPlace());
+    }
+  }
+  return buffer;
+}
+
+void PullDenseWorker::PublishDenseBuffer(uint64_t table_id) {
+  std::lock_guard<std::mutex> lock(mutex_for_buffer_);
+  front_buffer_[table_id] = 1 - front_buffer_[table_id];
+  ++buffer_versions_[table_id];
+  ++buffer_version_;
+}
+
+void PullDenseWorker::ShareDenseBuffer(int thread_id, Scope* thread_scope) {
+  if (!double_buffer_) {
+    return;
+  }
+  PADDLE_ENFORCE_LT(
+      static_cast<size_t>(thread_id), thread_buffer_version_.size(),
+      platform::errors::OutOfRange(
+          "The thread id %d is out of the %d threads of PullDenseWorker.",
+          thread_id, thread_buffer_version_.size()));
+  if (thread_buffer_version_[thread_id] == buffer_version_.load()) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(mutex_for_buffer_);
+  auto& versions = thread_buffer_versions_[thread_id];
+  for (auto& it : buffer_versions_) {
+    uint64_t tid = it.first;
+    if (versions[tid] == it.second) {
+      continue;
+    }
+    // the var in the thread scope hides the one in the root scope
+    Scope* buffer = dense_buffers_[front_buffer_[tid]].get();
+    for (auto& name : dense_value_names_[tid]) {
+      thread_scope->Var(name)->GetMutable<LoDTensor>()->ShareDataWith(
+          buffer->FindVar(name)->Get<LoDTensor>());
+    }
+    versions[tid] = it.second;
+  }
+  thread_buffer_version_[thread_id] = buffer_version_;
+}
+
+void PullDenseWorker::MergeDenseBuffer() {
+  std::lock_guard<std::mutex> lock(mutex_for_buffer_);
+  for (auto& it : front_buffer_) {
+    Scope* buffer = dense_buffers_[it.second].get();
+    for (auto& name : dense_value_names_[it.first]) {
+      auto* root_tensor = root_scope_->FindVar(name)->GetMutable<LoDTensor>();
+      TensorCopySync(buffer->FindVar(name)->Get<LoDTensor>(),
+                     root_tensor->place(), root_tensor);
+    }
+  }
 }
 
 void PullDenseWorker::PullDense(bool force_update) {
   pull_dense_status_.resize(0);
+  std::vector<uint64_t> pulled_tables;
   for (int i = 0; i < dwp_param_.program_config(0).pull_dense_table_id_size();
        ++i) {
     uint64_t tid = static_cast<uint64_t>(
         dwp_param_.program_config(0).pull_dense_table_id(i));
     if (force_update || CheckUpdateParam(tid)) {
+      if (double_buffer_) {
+        fleet_ptr_->PullDenseVarsAsync(*BackDenseBuffer(tid), tid,
+                                       dense_value_names_[tid],
+                                       &pull_dense_status_, true);
+        pulled_tables.push_back(tid);
+        ResetThreadVersion(tid);
+        continue;
+      }
 #if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP) || \
     defined(PADDLE_WITH_XPU)
       VLOG(3) << "pull dense " << force_update << " " << tid;
@@ -179,10 +294,16 @@ void PullDenseWorker::PullDense(bool force_update) {
   if (pull_dense_status_.size() != 0) {
     Wait(&pull_dense_status_);
   }
+  for (auto tid : pulled_tables) {
+    PublishDenseBuffer(tid);
+  }
 }
 
 int PullDenseWorker::Start() {
   running_ = true;
+  if (double_buffer_) {
+    CreateDenseBuffer();
+  }
   // before training, we can pull dense from pserver first.
   PullDense(true);
   t_ = std::thread(&PullDenseWorker::Run, this);
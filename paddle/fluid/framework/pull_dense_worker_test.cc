@@ -0,0 +1,88 @@
+/* Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <algorithm>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/framework/device_worker.h"
+
+namespace paddle {
+namespace framework {
+
+// The pulls go to pslib, so only the buffers are checked here, whose values
+// are those written through the thread scopes.
+#if !defined(PADDLE_WITH_PSLIB) && !defined(PADDLE_WITH_CUDA) && \
+    !defined(PADDLE_WITH_HIP) && !defined(PADDLE_WITH_XPU)
+TEST(PullDenseWorker, DoubleBuffer) {
+  TrainerDesc desc;
+  auto* pull_param = desc.mutable_pull_dense_param();
+  pull_param->set_device_num(2);
+  pull_param->set_sleep_time_ms(1);
+  pull_param->set_double_buffer(true);
+  auto* table = pull_param->add_dense_table();
+  table->set_table_id(1);
+  table->add_dense_value_name("w");
+  desc.mutable_downpour_param()->add_program_config()->add_pull_dense_table_id(
+      1);
+
+  Scope root_scope;
+  auto* root_tensor = root_scope.Var("w")->GetMutable<LoDTensor>();
+  float* root_w =
+      root_tensor->mutable_data<float>(make_ddim({4}), platform::CPUPlace());
+  std::fill(root_w, root_w + 4, 1.0);
+
+  auto pull_dense_worker = PullDenseWorker::GetInstance();
+  pull_dense_worker->Initialize(desc);
+  pull_dense_worker->SetRootScope(&root_scope);
+  pull_dense_worker->Start();
+
+  // the threads share one buffer, not the params of the root scope
+  Scope& scope0 = root_scope.NewScope();
+  Scope& scope1 = root_scope.NewScope();
+  pull_dense_worker->ShareDenseBuffer(0, &scope0);
+  pull_dense_worker->ShareDenseBuffer(1, &scope1);
+  auto& tensor0 = scope0.FindLocalVar("w")->Get<LoDTensor>();
+  auto& tensor1 = scope1.FindLocalVar("w")->Get<LoDTensor>();
+  ASSERT_EQ(tensor0.dims(), make_ddim({4}));
+  ASSERT_TRUE(tensor0.IsSharedBufferWith(tensor1));
+  ASSERT_FALSE(tensor0.IsSharedBufferWith(*root_tensor));
+
+  // a pull publishes the other buffer, shared from the next batch on
+  const float* first_w = tensor1.data<float>();
+  pull_dense_worker->PullDense(true);
+  pull_dense_worker->ShareDenseBuffer(0, &scope0);
+  ASSERT_NE(tensor0.data<float>(), first_w);
+  ASSERT_EQ(tensor1.data<float>(), first_w);
+
+  // the first buffer is still in use by thread 1, so the next pull does not
+  // write into it
+  pull_dense_worker->PullDense(true);
+  pull_dense_worker->ShareDenseBuffer(0, &scope0);
+  ASSERT_NE(tensor0.data<float>(), first_w);
+  ASSERT_EQ(tensor1.data<float>(), first_w);
+  pull_dense_worker->ShareDenseBuffer(1, &scope1);
+  ASSERT_TRUE(tensor0.IsSharedBufferWith(tensor1));
+
+  // the last buffer is merged into the root scope
+  float* w = scope0.FindLocalVar("w")->GetMutable<LoDTensor>()->data<float>();
+  std::fill(w, w + 4, 3.0);
+  pull_dense_worker->Stop();
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_EQ(root_tensor->data<float>()[i], 3.0);
+  }
+}
+#endif
+
+}  // namespace framework
+}  // namespace paddle
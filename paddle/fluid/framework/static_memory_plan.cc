@@ -0,0 +1,94 @@
+// Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/static_memory_plan.h"
+
+#include <algorithm>
+#include <map>
+
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace framework {
+
+static bool Overlap(const StaticMemoryBlock& a, const StaticMemoryBlock& b) {
+  return a.first_op <= b.last_op && b.first_op <= a.last_op;
+}
+
+size_t PlanStaticMemory(std::vector<StaticMemoryBlock>* blocks,
+                        size_t alignment) {
+  PADDLE_ENFORCE_GT(alignment, 0,
+                    platform::errors::InvalidArgument(
+                        "The alignment of the static memory plan should be "
+                        "greater than 0, but got %d.",
+                        alignment));
+  auto align = [alignment](size_t size) {
+    return (size + alignment - 1) / alignment * alignment;
+  };
+  std::vector<size_t> order(blocks->size());
+  for (size_t i = 0; i < order.size(); ++i) {
+    order[i] = i;
+  }
+  std::stable_sort(order.begin(), order.end(), [blocks](size_t a, size_t b) {
+    return (*blocks)[a].size > (*blocks)[b].size;
+  });
+
+  size_t arena_size = 0;
+  std::vector<size_t> placed;
+  std::vector<const StaticMemoryBlock*> neighbors;
+  for (size_t idx : order) {
+    auto& block = (*blocks)[idx];
+    neighbors.clear();
+    for (size_t other : placed) {
+      if (Overlap(block, (*blocks)[other])) {
+        neighbors.push_back(&(*blocks)[other]);
+      }
+    }
+    std::sort(neighbors.begin(), neighbors.end(),
+              [](const StaticMemoryBlock* a, const StaticMemoryBlock* b) {
+                return a->offset < b->offset;
+              });
+    // take the first gap between the neighbors large enough for the block
+    size_t offset = 0;
+    for (auto* neighbor : neighbors) {
+      if (offset + block.size <= neighbor->offset) {
+        break;
+      }
+      offset = std::max(offset, align(neighbor->offset + neighbor->size));
+    }
+    block.offset = offset;
+    arena_size = std::max(arena_size, offset + block.size);
+    placed.push_back(idx);
+  }
+  return align(arena_size);
+}
+
+size_t StaticMemoryLivePeak(const std::vector<StaticMemoryBlock>& blocks) {
+  // the change of the live bytes at every operator
+  std::map<int, int64_t> deltas;
+  for (auto& block : blocks) {
+    deltas[block.first_op] += block.size;
+    deltas[block.last_op + 1] -= block.size;
+  }
+  int64_t live = 0;
+  int64_t peak = 0;
+  for (auto& delta : deltas) {
+    live += delta.second;
+    peak = std::max(peak, live);
+  }
+  return static_cast<size_t>(peak);
+}
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,47 @@
+// Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace paddle {
+namespace framework {
+
+/*
+ * A buffer to place in the arena, which is alive from the operator first_op
+ * to the operator last_op, both included. Buffers whose lifetimes overlap
+ * get disjoint ranges of the arena.
+ */
+struct StaticMemoryBlock {
+  size_t size{0};
+  int first_op{0};
+  int last_op{0};
+  // Set by PlanStaticMemory.
+  size_t offset{0};
+};
+
+// Sets the offsets of the blocks and returns the size of the arena holding
+// them. The blocks are placed from the largest one, each at the lowest offset
+// aligned by alignment that does not collide with a placed block of an
+// overlapping lifetime.
+size_t PlanStaticMemory(std::vector<StaticMemoryBlock>* blocks,
+                        size_t alignment);
+
+// The most bytes alive at one operator, the lower bound of the arena size.
+size_t StaticMemoryLivePeak(const std::vector<StaticMemoryBlock>& blocks);
+
+}  // namespace framework
+}  // namespace paddle
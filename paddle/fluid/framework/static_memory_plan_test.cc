@@ -0,0 +1,73 @@
+// Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/static_memory_plan.h"
+
+#include <random>
+
+#include "gtest/gtest.h"
+
+namespace paddle {
+namespace framework {
+
+static StaticMemoryBlock Block(size_t size, int first_op, int last_op) {
+  StaticMemoryBlock block;
+  block.size = size;
+  block.first_op = first_op;
+  block.last_op = last_op;
+  return block;
+}
+
+TEST(StaticMemoryPlan, chain) {
+  // a chain of operators, every output is only read by the next operator
+  std::vector<StaticMemoryBlock> blocks = {Block(100, 0, 1), Block(200, 1, 2),
+                                           Block(100, 2, 3), Block(50, 3, 4)};
+  size_t arena_size = PlanStaticMemory(&blocks, 64);
+  ASSERT_EQ(StaticMemoryLivePeak(blocks), 300UL);
+  ASSERT_EQ(arena_size, 384UL);
+  ASSERT_EQ(blocks[1].offset, 0UL);
+  ASSERT_EQ(blocks[0].offset, 256UL);
+  ASSERT_EQ(blocks[2].offset, 256UL);
+  ASSERT_EQ(blocks[3].offset, 0UL);
+}
+
+TEST(StaticMemoryPlan, random) {
+  std::mt19937 rng(0);
+  std::vector<StaticMemoryBlock> blocks;
+  size_t total_size = 0;
+  for (int i = 0; i < 200; ++i) {
+    int first_op = rng() % 100;
+    int last_op = first_op + rng() % 10;
+    blocks.push_back(Block(rng() % 4096 + 1, first_op, last_op));
+    total_size += blocks.back().size;
+  }
+  size_t arena_size = PlanStaticMemory(&blocks, 32);
+  ASSERT_GE(arena_size, StaticMemoryLivePeak(blocks));
+  ASSERT_LT(arena_size, total_size);
+  for (size_t i = 0; i < blocks.size(); ++i) {
+    auto& a = blocks[i];
+    ASSERT_EQ(a.offset % 32, 0UL);
+    ASSERT_LE(a.offset + a.size, arena_size);
+    for (size_t j = i + 1; j < blocks.size(); ++j) {
+      auto& b = blocks[j];
+      bool live_together = a.first_op <= b.last_op && b.first_op <= a.last_op;
+      bool share_memory =
+          a.offset < b.offset + b.size && b.offset < a.offset + a.size;
+      ASSERT_FALSE(live_together && share_memory);
+    }
+  }
+}
+
+}  // namespace framework
+}  // namespace paddle
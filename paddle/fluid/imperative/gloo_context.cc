@@ -53,13 +53,11 @@ void GLOOParallelContext::InitWithRingID(int ring_id) {
       platform::errors::OutOfRange("Still not implement InitWithRingID"));
 }
 
-#define GLOO_CASE(type, T, gw)                                  \
-  case type: {                                                  \
-    std::vector<T> send_vector##T;                              \
-    framework::TensorToVector<T>(src_tensor, &send_vector##T);  \
-    auto recv_vector##T = gw->AllReduce<T>(send_vector##T);     \
-    framework::TensorFromVector<T>(recv_vector##T, dst_tensor); \
-    break;                                                      \
+#define GLOO_CASE(type, T, gw)                                         \
+  case type: {                                                         \
+    gw->AllReduceInPlace<T>(dst_tensor->data<T>(),                     \
+                            static_cast<size_t>(dst_tensor->numel())); \
+    break;                                                             \
   }
 
 void GLOOParallelContext::AllReduceByStream(const framework::Variable &src,
@@ -97,7 +95,11 @@ void GLOOParallelContext::AllReduceByStream(const framework::Variable &src,
 void GLOOParallelContext::AllReduce(const framework::Tensor &src_tensor,
                                     framework::Tensor *dst_tensor) {
   auto gloo_wrapper = framework::GlooWrapper::GetInstance();
-  dst_tensor->Resize(src_tensor.dims());
+  // The fused group buffers are reduced in place, the others are copied to
+  // the dst first.
+  if (dst_tensor != &src_tensor) {
+    framework::TensorCopySync(src_tensor, src_tensor.place(), dst_tensor);
+  }
   switch (src_tensor.type()) {
     GLOO_CASE(framework::proto::VarType::FP32, float, gloo_wrapper);
     GLOO_CASE(framework::proto::VarType::FP64, double, gloo_wrapper);
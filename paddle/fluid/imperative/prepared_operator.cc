@@ -30,6 +30,7 @@ DECLARE_bool(check_nan_inf);
 DECLARE_bool(run_pten_kernel);
 DECLARE_bool(benchmark);
 DECLARE_bool(run_kp_kernel);
+DECLARE_bool(enable_dygraph_dispatch_cache);
 
 namespace paddle {
 namespace imperative {
@@ -101,6 +102,307 @@ static void HandleComplexGradToRealGrad(const NameVarMap<VarType>& outs) {
   }
 }
 
+static size_t HashCombine(size_t seed, size_t value) {
+  return seed ^ (value + 0x9e3779b9 + (seed << 6) + (seed >> 2));
+}
+
+struct AttributeHashVisitor : public boost::static_visitor<size_t> {
+  size_t operator()(const boost::blank&) const { return 0; }
+
+  template <typename T>
+  size_t operator()(const T& value) const {
+    return std::hash<T>()(value);
+  }
+
+  template <typename T>
+  size_t operator()(const std::vector<T>& values) const {
+    size_t seed = values.size();
+    for (const auto& value : values) {
+      seed = HashCombine(seed, (*this)(value));
+    }
+    return seed;
+  }
+
+  size_t operator()(const std::vector<bool>& values) const {
+    return std::hash<std::vector<bool>>()(values);
+  }
+};
+
+size_t HashAttributeMap(const framework::AttributeMap& attrs) {
+  // sums the hashes of the attributes, so that the order of the map does not
+  // matter
+  size_t hash = attrs.size();
+  for (auto& attr : attrs) {
+    size_t value_hash =
+        boost::apply_visitor(AttributeHashVisitor(), attr.second);
+    hash += HashCombine(std::hash<std::string>()(attr.first),
+                        HashCombine(attr.second.which(), value_hash));
+  }
+  return hash;
+}
+
+// The device id of a place, 0 for the places without one.
+struct PlaceDeviceVisitor : public boost::static_visitor<size_t> {
+  template <typename PlaceType>
+  size_t operator()(const PlaceType&) const {
+    return 0;
+  }
+
+  size_t operator()(const platform::CUDAPlace& place) const {
+    return place.GetDeviceId();
+  }
+  size_t operator()(const platform::XPUPlace& place) const {
+    return place.GetDeviceId();
+  }
+  size_t operator()(const platform::NPUPlace& place) const {
+    return place.GetDeviceId();
+  }
+  size_t operator()(const platform::IPUPlace& place) const {
+    return place.GetDeviceId();
+  }
+  size_t operator()(const platform::MLUPlace& place) const {
+    return place.GetDeviceId();
+  }
+};
+
+static size_t HashPlace(const platform::Place& place) {
+  return HashCombine(place.which(),
+                     boost::apply_visitor(PlaceDeviceVisitor(), place));
+}
+
+// The properties of an input variable that its kernel may depend on.
+struct InputSignature {
+  bool is_null{true};
+  int var_type{-1};
+  bool is_initialized{false};
+  int dtype{-1};
+  int layout{-1};
+  platform::Place place;
+  bool is_empty{false};
+
+  bool operator==(const InputSignature& other) const {
+    return is_null == other.is_null && var_type == other.var_type &&
+           is_initialized == other.is_initialized && dtype == other.dtype &&
+           layout == other.layout && place == other.place &&
+           is_empty == other.is_empty;
+  }
+
+  size_t Hash() const {
+    size_t seed = HashCombine(is_null, var_type);
+    if (is_initialized) {
+      seed = HashCombine(seed, dtype);
+      seed = HashCombine(seed, layout);
+      seed = HashCombine(seed, HashPlace(place));
+      seed = HashCombine(seed, is_empty);
+    }
+    return seed;
+  }
+};
+
+// Returns false if the var is neither a LoDTensor nor a SelectedRows, whose
+// kernel is not cached.
+template <typename VarPtr>
+static bool GetInputSignature(const VarPtr& var, InputSignature* signature) {
+  *signature = InputSignature();
+  if (var == nullptr) {
+    return true;
+  }
+  signature->is_null = false;
+  signature->var_type = var->Type();
+  const auto& variable = var->Var();
+  const framework::Tensor* tensor = nullptr;
+  if (variable.template IsType<framework::LoDTensor>()) {
+    tensor = &variable.template Get<framework::LoDTensor>();
+  } else if (variable.template IsType<framework::SelectedRows>()) {
+    tensor = &variable.template Get<framework::SelectedRows>().value();
+  } else if (variable.IsInitialized()) {
+    return false;
+  }
+  if (tensor && tensor->IsInitialized()) {
+    signature->is_initialized = true;
+    signature->dtype = tensor->type();
+    signature->layout = static_cast<int>(tensor->layout());
+    signature->place = tensor->place();
+    signature->is_empty = tensor->numel() == 0;
+  }
+  return true;
+}
+
+// The signature of an op call that its kernel may depend on: the op type, the
+// place, the flags of the kernel choice, the attributes, the variable types of
+// the inputs and outputs, and the dtype, layout, place and emptiness of the
+// input tensors.
+struct PrepareSignature {
+  std::string op_type;
+  platform::Place place;
+  bool use_mkldnn;
+  bool run_pten_kernel;
+  bool run_kp_kernel;
+  std::vector<std::pair<std::string, std::vector<InputSignature>>> ins;
+  std::vector<std::pair<std::string, std::vector<int>>> outs;
+  framework::AttributeMap attrs;
+};
+
+template <typename VarType>
+static bool MakePrepareSignature(const std::string& type,
+                                 const NameVarMap<VarType>& ins,
+                                 const NameVarMap<VarType>& outs,
+                                 const platform::Place& place,
+                                 const framework::AttributeMap& attrs,
+                                 PrepareSignature* signature) {
+  signature->op_type = type;
+  signature->place = place;
+  signature->use_mkldnn = FLAGS_use_mkldnn;
+  signature->run_pten_kernel = FLAGS_run_pten_kernel;
+  signature->run_kp_kernel = FLAGS_run_kp_kernel;
+  signature->ins.clear();
+  for (auto& pair : ins) {
+    signature->ins.emplace_back(pair.first, std::vector<InputSignature>());
+    auto& vars = signature->ins.back().second;
+    for (auto& var : pair.second) {
+      vars.emplace_back();
+      if (!GetInputSignature(var, &vars.back())) {
+        return false;
+      }
+    }
+  }
+  signature->outs.clear();
+  for (auto& pair : outs) {
+    signature->outs.emplace_back(pair.first, std::vector<int>());
+    for (auto& var : pair.second) {
+      signature->outs.back().second.push_back(var ? var->Type() : -1);
+    }
+  }
+  signature->attrs = attrs;
+  return true;
+}
+
+// Hashes the signature of the call without building a PrepareSignature.
+// Returns false if an input is neither a LoDTensor nor a SelectedRows.
+template <typename VarType>
+static bool HashPrepareSignature(const std::string& type,
+                                 const NameVarMap<VarType>& ins,
+                                 const NameVarMap<VarType>& outs,
+                                 const platform::Place& place,
+                                 const framework::AttributeMap& attrs,
+                                 size_t* hash) {
+  size_t seed = std::hash<std::string>()(type);
+  seed = HashCombine(seed, HashPlace(place));
+  seed = HashCombine(seed, FLAGS_use_mkldnn);
+  seed = HashCombine(seed, FLAGS_run_pten_kernel);
+  seed = HashCombine(seed, FLAGS_run_kp_kernel);
+  InputSignature input;
+  for (auto& pair : ins) {
+    seed = HashCombine(seed, std::hash<std::string>()(pair.first));
+    for (auto& var : pair.second) {
+      if (!GetInputSignature(var, &input)) {
+        return false;
+      }
+      seed = HashCombine(seed, input.Hash());
+    }
+  }
+  for (auto& pair : outs) {
+    seed = HashCombine(seed, std::hash<std::string>()(pair.first));
+    for (auto& var : pair.second) {
+      seed = HashCombine(seed, var ? var->Type() : -1);
+    }
+  }
+  *hash = HashCombine(seed, HashAttributeMap(attrs));
+  return true;
+}
+
+// Whether the call matches the signature of a cached kernel, which is
+// checked on every hit since different signatures may share a hash.
+template <typename VarType>
+static bool MatchPrepareSignature(const PrepareSignature& signature,
+                                  const std::string& type,
+                                  const NameVarMap<VarType>& ins,
+                                  const NameVarMap<VarType>& outs,
+                                  const platform::Place& place,
+                                  const framework::AttributeMap& attrs) {
+  if (signature.op_type != type || !(signature.place == place) ||
+      signature.use_mkldnn != FLAGS_use_mkldnn ||
+      signature.run_pten_kernel != FLAGS_run_pten_kernel ||
+      signature.run_kp_kernel != FLAGS_run_kp_kernel ||
+      signature.ins.size() != ins.size() ||
+      signature.outs.size() != outs.size()) {
+    return false;
+  }
+  InputSignature input;
+  auto ins_iter = signature.ins.begin();
+  for (auto& pair : ins) {
+    if (ins_iter->first != pair.first ||
+        ins_iter->second.size() != pair.second.size()) {
+      return false;
+    }
+    size_t i = 0;
+    for (auto& var : pair.second) {
+      if (!GetInputSignature(var, &input) || !(ins_iter->second[i] == input)) {
+        return false;
+      }
+      ++i;
+    }
+    ++ins_iter;
+  }
+  auto outs_iter = signature.outs.begin();
+  for (auto& pair : outs) {
+    if (outs_iter->first != pair.first ||
+        outs_iter->second.size() != pair.second.size()) {
+      return false;
+    }
+    size_t i = 0;
+    for (auto& var : pair.second) {
+      if (outs_iter->second[i] != (var ? var->Type() : -1)) {
+        return false;
+      }
+      ++i;
+    }
+    ++outs_iter;
+  }
+  return signature.attrs == attrs;
+}
+
+// The kernel selected for an op call, shared by the later calls of the thread
+// with the same signature.
+struct CachedKernel {
+  PrepareSignature signature;
+  framework::OpKernelType kernel_type;
+  bool run_pten_kernel;
+  framework::KernelSignature pt_kernel_signature;
+  pten::Kernel pt_kernel;
+  framework::OperatorWithKernel::OpKernelFunc func;
+  platform::DeviceContext* dev_ctx;
+};
+
+// the cache is cleared once full, e.g. when an attribute changes every call
+static constexpr size_t kMaxCachedKernelNum = 4096;
+
+static std::unordered_map<size_t, CachedKernel>& CachedKernels() {
+  static thread_local std::unordered_map<size_t, CachedKernel> kernels;
+  return kernels;
+}
+
+// Caches the kernel of a call, replacing the kernel of another signature with
+// the same hash.
+template <typename VarType>
+static void CacheKernel(size_t hash, const std::string& type,
+                        const NameVarMap<VarType>& ins,
+                        const NameVarMap<VarType>& outs,
+                        const platform::Place& place,
+                        const framework::AttributeMap& attrs,
+                        CachedKernel&& kernel) {
+  if (!MakePrepareSignature<VarType>(type, ins, outs, place, attrs,
+                                     &kernel.signature)) {
+    return;
+  }
+  auto& kernels = CachedKernels();
+  if (kernels.size() >= kMaxCachedKernelNum) {
+    kernels.clear();
+  }
+  kernels.erase(hash);
+  kernels.emplace(hash, std::move(kernel));
+}
+
 PreparedOp::PreparedOp(const framework::OperatorBase& op,
                        const framework::RuntimeContext& ctx,
                        const framework::OpKernelType& kernel_type,
@@ -155,6 +457,28 @@ PreparedOp PrepareImpl(const NameVarMap<VarType>& ins,
   }
 #endif
 
+  size_t signature_hash = 0;
+  bool use_cache =
+      FLAGS_enable_dygraph_dispatch_cache &&
+      HashPrepareSignature<VarType>(op.Type(), ins, outs, place, attrs,
+                                    &signature_hash);
+  if (use_cache) {
+    auto& kernels = CachedKernels();
+    auto iter = kernels.find(signature_hash);
+    if (iter != kernels.end() &&
+        MatchPrepareSignature<VarType>(iter->second.signature, op.Type(),
+                                       ins, outs, place, attrs)) {
+      auto& kernel = iter->second;
+      if (kernel.run_pten_kernel) {
+        return PreparedOp(op, ctx, kernel.kernel_type,
+                          kernel.pt_kernel_signature, kernel.pt_kernel,
+                          pt_kernel_context, kernel.dev_ctx);
+      }
+      return PreparedOp(op, ctx, kernel.kernel_type, kernel.func,
+                        kernel.dev_ctx);
+    }
+  }
+
   // 1. get expected kernel key
   auto dygraph_exe_ctx = DygraphExecutionContext<VarType>(
       op, framework::Scope(), *dev_ctx, ctx, ins, outs, attrs, default_attrs);
@@ -176,6 +500,12 @@ PreparedOp PrepareImpl(const NameVarMap<VarType>& ins,
               << " | kernel key: " << pt_kernel_key
               << " | kernel: " << pt_kernel;
 
+      if (use_cache) {
+        CacheKernel<VarType>(
+            signature_hash, op.Type(), ins, outs, place, attrs,
+            CachedKernel{PrepareSignature(), expected_kernel_key, true,
+                         pt_kernel_signature, pt_kernel, nullptr, dev_ctx});
+      }
       // TODO(chenweihang): using CPUKernel when miss device kernel case
       return PreparedOp(op, ctx, expected_kernel_key, pt_kernel_signature,
                         pt_kernel, pt_kernel_context, dev_ctx);
@@ -238,6 +568,13 @@ PreparedOp PrepareImpl(const NameVarMap<VarType>& ins,
   if (!(expected_kernel_key.place_ == place)) {
     dev_ctx = pool.Get(expected_kernel_key.place_);
   }
+  if (use_cache) {
+    CacheKernel<VarType>(
+        signature_hash, op.Type(), ins, outs, place, attrs,
+        CachedKernel{PrepareSignature(), expected_kernel_key, false,
+                     framework::KernelSignature(), pten::Kernel(),
+                     kernel_iter->second, dev_ctx});
+  }
 
   return PreparedOp(op, ctx, expected_kernel_key, kernel_iter->second, dev_ctx);
 }
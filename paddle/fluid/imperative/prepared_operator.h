@@ -143,6 +143,9 @@ std::shared_ptr<NameVarMap<VarType>> PrepareData(
   return tmp_ins_ptr;
 }
 
+// The hash of the attributes of an op call, regardless of their order.
+size_t HashAttributeMap(const framework::AttributeMap& attrs);
+
 class PreparedOp {
  public:
   PreparedOp(const framework::OperatorBase& op,
@@ -15,6 +15,7 @@
 #pragma once
 #include <ThreadPool.h>
 #include <algorithm>
+#include <exception>
 #include <iostream>
 #include <map>
 #include <memory>
@@ -202,12 +203,15 @@ class Reducer {
   bool find_unused_vars_each_step_{false};
   bool find_unused_vars_once_{true};
   bool groups_need_finalize_{false};
-#ifdef PADDLE_WITH_XPU_BKCL
-  // comm_pool_ is used for scheduling allreduce in multi Kunlun cards training.
+#if defined(PADDLE_WITH_XPU_BKCL) || defined(PADDLE_WITH_GLOO)
+  // comm_pool_ is used for scheduling allreduce in multi Kunlun cards training
+  // and CPU training with Gloo, so that it overlaps the rest of backward.
   std::unique_ptr<::ThreadPool> comm_pool_{nullptr};
   uint32_t comm_op_count_;
   std::mutex mutex_;
   std::condition_variable cv_;
+  // the first exception thrown in comm_pool_, rethrown in FinalizeBackward
+  std::exception_ptr comm_error_{nullptr};
 #endif
 
   // grad_need_hooks_ is used to mark whether gradient synchronization is
@@ -0,0 +1,236 @@
+//   Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <string>
+#include <vector>
+
+#include "paddle/fluid/framework/fleet/gloo_wrapper.h"
+#include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/framework/tensor_util.h"
+#include "paddle/fluid/framework/variable.h"
+#include "paddle/fluid/imperative/basic_engine.h"
+#include "paddle/fluid/imperative/gloo_context.h"
+#include "paddle/fluid/imperative/reducer.h"
+#include "paddle/fluid/imperative/tracer.h"
+
+#include "gtest/gtest.h"
+
+namespace imperative = paddle::imperative;
+namespace platform = paddle::platform;
+namespace framework = paddle::framework;
+
+static const int kNRanks = 2;
+
+imperative::ParallelStrategy GetStrategy(int local_rank) {
+  std::vector<std::string> eps = {"127.0.0.1:37680", "127.0.0.1:37681"};
+  imperative::ParallelStrategy strategy;
+  strategy.trainer_endpoints_ = eps;
+  strategy.current_endpoint_ = eps[local_rank];
+  strategy.nranks_ = eps.size();
+  strategy.local_rank_ = local_rank;
+  return strategy;
+}
+
+// The ranks meet through the files under store_path over loopback, the
+// GLOOParallelContext then reuses the initialized GlooWrapper.
+void InitGloo(int local_rank, const std::string& store_path,
+              const std::string& prefix) {
+  auto gloo_wrapper = framework::GlooWrapper::GetInstance();
+  gloo_wrapper->SetTimeoutSeconds(120, 120);
+  gloo_wrapper->SetSize(kNRanks);
+  gloo_wrapper->SetRank(local_rank);
+  gloo_wrapper->SetPrefix(prefix);
+  gloo_wrapper->SetIface("lo");
+  gloo_wrapper->SetHdfsStore(store_path, "", "");
+  gloo_wrapper->Init();
+}
+
+void AllReduceByStream(int local_rank, const std::string& store_path) {
+  InitGloo(local_rank, store_path, "gloo_context_test");
+  imperative::GLOOParallelContext gpc(GetStrategy(local_rank),
+                                      platform::CPUPlace());
+  gpc.Init();
+
+  // in place, like the fused buffer of a group
+  const int64_t data_size = 1 << 20;
+  framework::Variable var;
+  auto* tensor = var.GetMutable<framework::LoDTensor>();
+  float* data = tensor->mutable_data<float>(framework::make_ddim({data_size}),
+                                            platform::CPUPlace());
+  std::fill(data, data + data_size, 1.0 + local_rank);
+  gpc.AllReduceByStream(var, &var, 0, false);
+  ASSERT_EQ(tensor->data<float>(), data);
+  for (int64_t i = 0; i < data_size; i++) {
+    ASSERT_EQ(data[i], 3.0);
+  }
+
+  // out of place keeps the src and the dims
+  framework::Variable src_var;
+  framework::Variable dst_var;
+  auto* src_tensor = src_var.GetMutable<framework::LoDTensor>();
+  std::vector<int64_t> src_vec(32, local_rank + 1);
+  framework::TensorFromVector(src_vec, src_tensor);
+  src_tensor->Resize(framework::make_ddim({4, 8}));
+  gpc.AllReduceByStream(src_var, &dst_var, 0, false);
+  auto& dst_tensor = dst_var.Get<framework::LoDTensor>();
+  ASSERT_EQ(dst_tensor.dims(), framework::make_ddim({4, 8}));
+  std::vector<int64_t> dst_vec;
+  framework::TensorToVector(dst_tensor, &dst_vec);
+  for (size_t i = 0; i < dst_vec.size(); i++) {
+    ASSERT_EQ(src_vec[i], local_rank + 1);
+    ASSERT_EQ(dst_vec[i], 3);
+  }
+
+  // the in place allreduce against the one through std::vector
+  auto gloo_wrapper = framework::GlooWrapper::GetInstance();
+  const int repeat = 20;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < repeat; i++) {
+    gpc.AllReduceByStream(var, &var, 0, false);
+  }
+  std::chrono::duration<double, std::milli> in_place_cost =
+      std::chrono::steady_clock::now() - start;
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < repeat; i++) {
+    std::vector<float> send_vec;
+    framework::TensorToVector(*tensor, &send_vec);
+    auto recv_vec = gloo_wrapper->AllReduce(send_vec);
+    framework::TensorFromVector(recv_vec, tensor);
+  }
+  std::chrono::duration<double, std::milli> vector_cost =
+      std::chrono::steady_clock::now() - start;
+  LOG(INFO) << "rank " << local_rank << " allreduce of " << data_size
+            << " floats, in place: " << in_place_cost.count() / repeat
+            << " ms, through std::vector: " << vector_cost.count() / repeat
+            << " ms";
+}
+
+// Runs func in one process per rank, each with its own GlooWrapper.
+void RunRanks(void (*func)(int, const std::string&)) {
+  char store_template[] = "/tmp/gloo_context_test_XXXXXX";
+  ASSERT_NE(mkdtemp(store_template), nullptr);
+  std::string store_path(store_template);
+
+  std::vector<pid_t> pids;
+  for (int rank = 0; rank < kNRanks; rank++) {
+    pid_t pid = fork();
+    ASSERT_GE(pid, 0);
+    if (pid == 0) {
+      func(rank, store_path);
+      fflush(nullptr);
+      _exit(::testing::Test::HasFailure() ? 1 : 0);
+    }
+    pids.push_back(pid);
+  }
+  for (auto pid : pids) {
+    int status = 0;
+    ASSERT_EQ(waitpid(pid, &status, 0), pid);
+    EXPECT_TRUE(WIFEXITED(status));
+    EXPECT_EQ(WEXITSTATUS(status), 0);
+  }
+  std::string cmd = "rm -rf " + store_path;
+  ASSERT_EQ(system(cmd.c_str()), 0);
+}
+
+TEST(AllReduceByStream, Run) { RunRanks(AllReduceByStream); }
+
+// A GLOOParallelContext whose allreduce fails, as a broken peer would.
+class FailingGLOOParallelContext : public imperative::GLOOParallelContext {
+ public:
+  using imperative::GLOOParallelContext::GLOOParallelContext;
+
+  void AllReduceByStream(const framework::Variable& src,
+                         framework::Variable* dst, int ring_id,
+                         bool use_calc_stream) override {
+    PADDLE_THROW(platform::errors::Unavailable("The allreduce failed."));
+  }
+};
+
+std::shared_ptr<imperative::VarBase> CreateParameter(
+    const std::string& name, const std::vector<int64_t>& dims, float value) {
+  auto var = std::make_shared<imperative::VarBase>(true, name);
+  var->SetOverridedStopGradient(false);
+  auto* tensor = var->MutableVar()->GetMutable<framework::LoDTensor>();
+  std::vector<float> data(framework::product(framework::make_ddim(dims)),
+                          value);
+  framework::TensorFromVector(data, tensor);
+  tensor->Resize(framework::make_ddim(dims));
+  return var;
+}
+
+// Traces out = mul(x, y) and runs its backward with a Reducer over x and y,
+// each in its own group, so both groups are all-reduced on the comm_pool_
+// of the Reducer while the backward goes on.
+void RunReducerBackward(
+    std::shared_ptr<imperative::ParallelContext> parallel_ctx,
+    const std::shared_ptr<imperative::VarBase>& x,
+    const std::shared_ptr<imperative::VarBase>& y) {
+  imperative::Reducer reducer({x, y}, {{0}, {1}}, {false, false},
+                              parallel_ctx, {25 * 1024 * 1024}, false);
+  auto out = std::make_shared<imperative::VarBase>(true, "out");
+  imperative::NameVarBaseMap ins = {{"X", {x}}, {"Y", {y}}};
+  imperative::NameVarBaseMap outs = {{"Out", {out}}};
+  framework::AttributeMap attrs;
+  attrs["use_mkldnn"] = false;
+  imperative::Tracer tracer;
+  tracer.TraceOp("mul", ins, outs, attrs, platform::CPUPlace(), true);
+
+  reducer.PrepareForBackward({out});
+  imperative::BasicEngine engine;
+  engine.Init({out}, {nullptr});
+  engine.Execute();
+}
+
+void ReducerBackward(int local_rank, const std::string& store_path) {
+  InitGloo(local_rank, store_path, "gloo_context_test_reducer");
+  auto strategy = GetStrategy(local_rank);
+  auto parallel_ctx = std::make_shared<imperative::GLOOParallelContext>(
+      strategy, platform::CPUPlace());
+  parallel_ctx->Init();
+
+  // the grad of x sums the rows of y, 4 * (rank + 1), and the grad of y the
+  // columns of x, 2 * (rank + 1), then they are averaged over the ranks
+  float value = 1.0 + local_rank;
+  auto x = CreateParameter("x", {2, 5}, value);
+  auto y = CreateParameter("y", {5, 2}, 2 * value);
+  RunReducerBackward(parallel_ctx, x, y);
+  std::vector<float> x_grad;
+  framework::TensorToVector(x->GradVar().Get<framework::LoDTensor>(), &x_grad);
+  ASSERT_EQ(x_grad.size(), 10UL);
+  for (auto grad : x_grad) {
+    ASSERT_EQ(grad, 6.0);
+  }
+  std::vector<float> y_grad;
+  framework::TensorToVector(y->GradVar().Get<framework::LoDTensor>(), &y_grad);
+  ASSERT_EQ(y_grad.size(), 10UL);
+  for (auto grad : y_grad) {
+    ASSERT_EQ(grad, 3.0);
+  }
+
+  // the error raised on the comm_pool_ is rethrown by the backward
+  auto failing_ctx = std::make_shared<FailingGLOOParallelContext>(
+      strategy, platform::CPUPlace());
+  failing_ctx->Init();
+  auto failing_x = CreateParameter("failing_x", {2, 5}, value);
+  auto failing_y = CreateParameter("failing_y", {5, 2}, value);
+  ASSERT_THROW(RunReducerBackward(failing_ctx, failing_x, failing_y),
+               platform::EnforceNotMet);
+}
+
+TEST(Reducer, CPUBackward) { RunRanks(ReducerBackward); }
@@ -18,6 +18,7 @@
 
 #include <paddle/fluid/framework/op_registry.h>
 
+#include <chrono>  // NOLINT
 #include <memory>
 #include <set>
 #include <string>
@@ -28,6 +29,8 @@
 #include "paddle/fluid/imperative/tracer.h"
 #include "paddle/fluid/memory/memcpy.h"
 
+DECLARE_bool(enable_dygraph_dispatch_cache);
+
 namespace imperative = paddle::imperative;
 namespace platform = paddle::platform;
 namespace framework = paddle::framework;
@@ -530,6 +533,87 @@ TEST(test_tracer, test_var_op_destruction) {
 #endif
 }
 
+template <typename T>
+static std::shared_ptr<imperative::VarBase> CreateCPUVar(
+    const std::string& name, const std::vector<T>& data) {
+  std::shared_ptr<imperative::VarBase> var(
+      new imperative::VarBase(true, name));
+  auto* tensor = var->MutableVar()->GetMutable<framework::LoDTensor>();
+  tensor->Resize({static_cast<int64_t>(data.size())});
+  std::copy(data.begin(), data.end(),
+            tensor->mutable_data<T>(platform::CPUPlace()));
+  return var;
+}
+
+template <typename T>
+static void TraceElementwiseAdd(imperative::Tracer* tracer, T x, T y) {
+  std::vector<T> x_data(4, x);
+  std::vector<T> y_data(4, y);
+  std::shared_ptr<imperative::VarBase> vout(
+      new imperative::VarBase(true, "vout"));
+  imperative::NameVarBaseMap ins = {
+      {"X", {CreateCPUVar("x", x_data)}}, {"Y", {CreateCPUVar("y", y_data)}}};
+  imperative::NameVarBaseMap outs = {{"Out", {vout}}};
+  tracer->TraceOp("elementwise_add", ins, outs, {}, platform::CPUPlace(),
+                  false);
+  const auto& out_tensor = vout->Var().Get<framework::LoDTensor>();
+  ASSERT_EQ(out_tensor.type(), framework::DataTypeTrait<T>::DataType());
+  for (int64_t i = 0; i < out_tensor.numel(); ++i) {
+    ASSERT_EQ(out_tensor.data<T>()[i], x + y);
+  }
+}
+
+TEST(test_tracer, test_dispatch_cache) {
+  imperative::Tracer tracer;
+  FLAGS_enable_dygraph_dispatch_cache = true;
+  // the calls with another dtype select another kernel
+  for (int i = 0; i < 3; ++i) {
+    TraceElementwiseAdd<float>(&tracer, 1.5f, i);
+    TraceElementwiseAdd<double>(&tracer, 2.5, i);
+    TraceElementwiseAdd<int64_t>(&tracer, 3, i);
+  }
+  // the checked attributes are reused, the invalid ones are still rejected
+  framework::AttributeMap attrs = {{"axis", -1}};
+  auto x = CreateCPUVar<float>("x", {1, 2});
+  std::shared_ptr<imperative::VarBase> vout(
+      new imperative::VarBase(true, "vout"));
+  imperative::NameVarBaseMap ins = {{"X", {x}}, {"Y", {x}}};
+  imperative::NameVarBaseMap outs = {{"Out", {vout}}};
+  tracer.TraceOp("elementwise_add", ins, outs, attrs, platform::CPUPlace(),
+                 false);
+  tracer.TraceOp("elementwise_add", ins, outs, attrs, platform::CPUPlace(),
+                 false);
+  attrs["axis"] = std::string("invalid");
+  ASSERT_ANY_THROW(tracer.TraceOp("elementwise_add", ins, outs, attrs,
+                                  platform::CPUPlace(), false));
+  FLAGS_enable_dygraph_dispatch_cache = false;
+}
+
+TEST(test_tracer, test_dispatch_cache_benchmark) {
+  imperative::Tracer tracer;
+  auto x = CreateCPUVar<float>("x", {1});
+  auto y = CreateCPUVar<float>("y", {2});
+  std::shared_ptr<imperative::VarBase> vout(
+      new imperative::VarBase(true, "vout"));
+  imperative::NameVarBaseMap ins = {{"X", {x}}, {"Y", {y}}};
+  imperative::NameVarBaseMap outs = {{"Out", {vout}}};
+  const int op_num = 20000;
+  for (bool enable_cache : {false, true}) {
+    FLAGS_enable_dygraph_dispatch_cache = enable_cache;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < op_num; ++i) {
+      tracer.TraceOp("elementwise_add", ins, outs, {}, platform::CPUPlace(),
+                     false);
+    }
+    std::chrono::duration<double> cost =
+        std::chrono::steady_clock::now() - start;
+    LOG(INFO) << "elementwise_add of 1 element, dispatch cache "
+              << (enable_cache ? "on" : "off") << ": " << op_num / cost.count()
+              << " ops/sec";
+  }
+  FLAGS_enable_dygraph_dispatch_cache = false;
+}
+
 }  // namespace imperative
 }  // namespace paddle
 
@@ -14,11 +14,13 @@
 #include "paddle/fluid/imperative/tracer.h"
 #include <map>
 #include <set>
+#include <unordered_map>
 #include <unordered_set>
 #include <utility>
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/imperative/amp_auto_cast.h"
 #include "paddle/fluid/imperative/op_base.h"
+#include "paddle/fluid/imperative/prepared_operator.h"
 #include "paddle/fluid/platform/denormal.h"
 #include "paddle/fluid/platform/profiler.h"
 #include "paddle/fluid/string/string_helper.h"
@@ -26,6 +28,7 @@
 DECLARE_bool(use_mkldnn);
 DECLARE_string(tracer_mkldnn_ops_on);
 DECLARE_string(tracer_mkldnn_ops_off);
+DECLARE_bool(enable_dygraph_dispatch_cache);
 
 namespace paddle {
 namespace imperative {
@@ -60,6 +63,36 @@ void PassStopGradient(const NameVarBaseMap& outs, bool generate_grad) {
   }
 }
 
+// The operator of an op type and the attributes that passed its attribute
+// checker unchanged, keyed by their hashes, shared by the op calls of a
+// thread.
+struct TracedOpCache {
+  std::unique_ptr<framework::OperatorBase> op;
+  std::unordered_multimap<size_t, framework::AttributeMap> checked_attrs;
+
+  bool IsChecked(size_t attrs_hash, const framework::AttributeMap& attrs) {
+    auto range = checked_attrs.equal_range(attrs_hash);
+    for (auto iter = range.first; iter != range.second; ++iter) {
+      if (iter->second == attrs) {
+        return true;
+      }
+    }
+    return false;
+  }
+};
+
+// the checked attributes are cleared once full
+static constexpr size_t kMaxCheckedAttrsNum = 1024;
+
+static TracedOpCache* GetTracedOpCache(const std::string& type) {
+  static thread_local std::unordered_map<std::string, TracedOpCache> caches;
+  auto& cache = caches[type];
+  if (cache.op == nullptr) {
+    cache.op = framework::OpRegistry::CreateOp(type, {}, {}, {}, false);
+  }
+  return &cache;
+}
+
 void IncreaseVarbaseReferenceCountUntilCopyComplete(
     const std::shared_ptr<imperative::VarBase>& var,
     const platform::Place& place) {
@@ -173,11 +206,36 @@ void Tracer::TraceOp(const std::string& type, const NameVarBaseMap& ins,
       attrs["use_mkldnn"] = !is_off;
     }
   }
-  auto op = framework::OpRegistry::CreateOp(type, {}, {}, {}, false);
+  // the operator only holds the type, the inputs, outputs and attributes of
+  // the call are passed to it, so it is shared by the calls of the type
+  std::unique_ptr<framework::OperatorBase> uncached_op;
+  TracedOpCache* op_cache = nullptr;
+  if (FLAGS_enable_dygraph_dispatch_cache) {
+    op_cache = GetTracedOpCache(type);
+  } else {
+    uncached_op = framework::OpRegistry::CreateOp(type, {}, {}, {}, false);
+  }
+  const auto& op = op_cache ? op_cache->op : uncached_op;
   const auto& op_info = op->Info();
   auto* attr_checker = op_info.Checker();
   if (attr_checker) {
-    attr_checker->Check(&attrs, true, /*only_check_exist_value=*/true);
+    if (op_cache) {
+      // the checker may convert the attributes, only the ones it leaves
+      // unchanged are skipped later
+      size_t attrs_hash = HashAttributeMap(attrs);
+      if (!op_cache->IsChecked(attrs_hash, attrs)) {
+        framework::AttributeMap origin_attrs = attrs;
+        attr_checker->Check(&attrs, true, /*only_check_exist_value=*/true);
+        if (attrs == origin_attrs) {
+          if (op_cache->checked_attrs.size() >= kMaxCheckedAttrsNum) {
+            op_cache->checked_attrs.clear();
+          }
+          op_cache->checked_attrs.emplace(attrs_hash, std::move(origin_attrs));
+        }
+      }
+    } else {
+      attr_checker->Check(&attrs, true, /*only_check_exist_value=*/true);
+    }
   }
 
   static paddle::framework::AttributeMap empty_attrs_map = {};
@@ -185,14 +243,19 @@ void Tracer::TraceOp(const std::string& type, const NameVarBaseMap& ins,
       attr_checker == nullptr ? empty_attrs_map
                               : attr_checker->GetDefaultAttrMap();
 
-  NameVarBaseMap new_ins = ins;
+  // the inputs are only copied when they are casted
+  NameVarBaseMap casted_ins;
+  const NameVarBaseMap* new_ins_ptr = &ins;
   if (amp_level_ == AmpLevel::O1) {
     VLOG(5) << "Auto mixed precision run operator: " << type;
-    new_ins = AutoCastInputs(type, ins);
+    casted_ins = AutoCastInputs(type, ins);
+    new_ins_ptr = &casted_ins;
   } else if (amp_level_ == AmpLevel::O2) {
     VLOG(5) << "Pure fp16 run operator: " << type;
-    new_ins = CastPureFp16Inputs(type, ins);
+    casted_ins = CastPureFp16Inputs(type, ins);
+    new_ins_ptr = &casted_ins;
   }
+  const NameVarBaseMap& new_ins = *new_ins_ptr;
 
   try {
     if (platform::is_gpu_place(place)) {
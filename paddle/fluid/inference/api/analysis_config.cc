@@ -177,6 +177,8 @@ AnalysisConfig::AnalysisConfig(const AnalysisConfig &other) {
   CP_MEMBER(memory_pool_init_size_mb_);
 
   CP_MEMBER(enable_memory_optim_);
+  CP_MEMBER(shape_cache_capacity_);
+  CP_MEMBER(static_memory_plan_);
   // TensorRT related.
   CP_MEMBER(use_tensorrt_);
   CP_MEMBER(tensorrt_workspace_size_);
@@ -641,6 +643,8 @@ std::string AnalysisConfig::SerializeInfoCache() {
   ss << trt_dla_core_;
 
   ss << enable_memory_optim_;
+  ss << shape_cache_capacity_;
+  ss << static_memory_plan_;
 
   ss << use_mkldnn_;
   ss << mkldnn_cache_capacity_;
@@ -724,6 +728,19 @@ bool AnalysisConfig::enable_memory_optim() const {
   return enable_memory_optim_;
 }
 
+void AnalysisConfig::SetShapeCacheCapacity(int capacity) {
+  PADDLE_ENFORCE_GE(capacity, 0,
+                    platform::errors::InvalidArgument(
+                        "The capacity of the shape cache should be greater "
+                        "than or equal to 0, but got %d.",
+                        capacity));
+  shape_cache_capacity_ = capacity;
+}
+
+void AnalysisConfig::EnableStaticMemoryPlan(bool x) {
+  static_memory_plan_ = x;
+}
+
 void AnalysisConfig::SetModelBuffer(const char *prog_buffer,
                                     size_t prog_buffer_size,
                                     const char *param_buffer,
@@ -890,6 +907,9 @@ std::string AnalysisConfig::Summary() {
   os.InsertRow({"ir_optim", enable_ir_optim_ ? "true" : "false"});
   os.InsertRow({"ir_debug", ir_debug_ ? "true" : "false"});
   os.InsertRow({"memory_optim", enable_memory_optim_ ? "true" : "false"});
+  os.InsertRow(
+      {"shape_cache_capacity", std::to_string(shape_cache_capacity_)});
+  os.InsertRow({"static_memory_plan", static_memory_plan_ ? "true" : "false"});
   os.InsertRow({"enable_profile", with_profile_ ? "true" : "false"});
   os.InsertRow({"enable_log", with_glog_info_ ? "true" : "false"});
   os.InsertRow({"collect_shape_range_info",
@@ -192,6 +192,16 @@ bool AnalysisPredictor::Init(
   // Get the feed_target_names and fetch_target_names
   PrepareFeedFetch();
 
+  // The feed ops write the inputs during the run, so that their dims are not
+  // known before it.
+  if (config_.shape_cache_capacity() > 0 && !config_.use_feed_fetch_ops_) {
+    executor_->EnableShapeCache(GetInputNames(),
+                                config_.shape_cache_capacity());
+  }
+  if (config_.static_memory_plan_enabled()) {
+    executor_->EnableStaticMemoryPlan(GetInputNames(), GetOutputNames());
+  }
+
   return true;
 }
 
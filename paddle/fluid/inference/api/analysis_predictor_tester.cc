@@ -159,6 +159,61 @@ TEST(AnalysisPredictor, ZeroCopy) {
   predictor->TryShrinkMemory();
 }
 
+static std::vector<float> RunWord2vec(PaddlePredictor* predictor,
+                                      int batch_size) {
+  for (auto name : {"firstw", "secondw", "thirdw", "forthw"}) {
+    auto tensor = predictor->GetInputTensor(name);
+    tensor->Reshape({batch_size, 1});
+    auto* data = tensor->mutable_data<int64_t>(PaddlePlace::kCPU);
+    for (int i = 0; i < batch_size; i++) {
+      data[i] = i;
+    }
+  }
+  EXPECT_TRUE(predictor->ZeroCopyRun());
+  auto out = predictor->GetOutputTensor("fc_1.tmp_2");
+  std::vector<float> out_data(out->shape()[0] * out->shape()[1]);
+  out->CopyToCpu(out_data.data());
+  return out_data;
+}
+
+TEST(AnalysisPredictor, ShapeCache) {
+  AnalysisConfig config;
+  config.SetModel(FLAGS_dirname);
+  config.SwitchUseFeedFetchOps(false);
+  auto predictor = CreatePaddlePredictor<AnalysisConfig>(config);
+  config.SetShapeCacheCapacity(2);
+  auto cached_predictor = CreatePaddlePredictor<AnalysisConfig>(config);
+
+  // the cached runs restore the dims of the former runs of the same batch
+  for (int batch_size : {4, 2, 4, 2, 8, 4}) {
+    auto expected = RunWord2vec(predictor.get(), batch_size);
+    auto out = RunWord2vec(cached_predictor.get(), batch_size);
+    ASSERT_EQ(out.size(), expected.size());
+    for (size_t i = 0; i < out.size(); i++) {
+      ASSERT_NEAR(out[i], expected[i], 1e-6);
+    }
+  }
+}
+
+TEST(AnalysisPredictor, StaticMemoryPlan) {
+  AnalysisConfig config;
+  config.SetModel(FLAGS_dirname);
+  config.SwitchUseFeedFetchOps(false);
+  auto predictor = CreatePaddlePredictor<AnalysisConfig>(config);
+  config.EnableStaticMemoryPlan();
+  auto planned_predictor = CreatePaddlePredictor<AnalysisConfig>(config);
+
+  // the third run outgrows the plan of the first two
+  for (int batch_size : {4, 2, 8, 8, 1}) {
+    auto expected = RunWord2vec(predictor.get(), batch_size);
+    auto out = RunWord2vec(planned_predictor.get(), batch_size);
+    ASSERT_EQ(out.size(), expected.size());
+    for (size_t i = 0; i < out.size(); i++) {
+      ASSERT_NEAR(out[i], expected[i], 1e-6);
+    }
+  }
+}
+
 TEST(AnalysisPredictor, CollectShapeRangeInfo) {
   AnalysisConfig config;
   config.SetModel(FLAGS_dirname);
@@ -0,0 +1,647 @@
+// Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <chrono>              // NOLINT
+#include <condition_variable>  // NOLINT
+#include <cstring>
+#include <deque>
+#include <mutex>  // NOLINT
+#include <sstream>
+#include <thread>  // NOLINT
+
+#include "paddle/fluid/inference/api/paddle_batching_predictor.h"
+#include "paddle/fluid/platform/enforce.h"
+#include "paddle/fluid/platform/float16.h"
+
+namespace paddle {
+
+using float16 = paddle::platform::float16;
+using Clock = std::chrono::steady_clock;
+
+static size_t SizeOfDType(PaddleDType dtype) {
+  switch (dtype) {
+    case PaddleDType::FLOAT32:
+      return sizeof(float);
+    case PaddleDType::INT64:
+      return sizeof(int64_t);
+    case PaddleDType::INT32:
+      return sizeof(int32_t);
+    case PaddleDType::UINT8:
+      return sizeof(uint8_t);
+    case PaddleDType::INT8:
+      return sizeof(int8_t);
+    case PaddleDType::FLOAT16:
+      return sizeof(float16);
+    default:
+      PADDLE_THROW(platform::errors::Unimplemented(
+          "Unsupported data type %d in BatchingPredictor.",
+          static_cast<int>(dtype)));
+  }
+}
+
+static int64_t Numel(const std::vector<int>& shape, size_t begin = 0) {
+  int64_t numel = 1;
+  for (size_t i = begin; i < shape.size(); ++i) {
+    numel *= shape[i];
+  }
+  return numel;
+}
+
+static int64_t ElapsedUs(Clock::time_point start, Clock::time_point end) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(end - start)
+      .count();
+}
+
+// Returns the writable host memory of the input, which is the tensor memory
+// itself on CPU.
+static void* MutableCpuData(ZeroCopyTensor* tensor, PaddleDType dtype) {
+  switch (dtype) {
+    case PaddleDType::FLOAT32:
+      return tensor->mutable_data<float>(PaddlePlace::kCPU);
+    case PaddleDType::INT64:
+      return tensor->mutable_data<int64_t>(PaddlePlace::kCPU);
+    case PaddleDType::INT32:
+      return tensor->mutable_data<int32_t>(PaddlePlace::kCPU);
+    case PaddleDType::UINT8:
+      return tensor->mutable_data<uint8_t>(PaddlePlace::kCPU);
+    case PaddleDType::INT8:
+      return tensor->mutable_data<int8_t>(PaddlePlace::kCPU);
+    default:
+      PADDLE_THROW(platform::errors::Unimplemented(
+          "Unsupported input data type %d in BatchingPredictor.",
+          static_cast<int>(dtype)));
+  }
+}
+
+static void CopyFromHost(ZeroCopyTensor* tensor, const void* data,
+                         PaddleDType dtype) {
+  switch (dtype) {
+    case PaddleDType::FLOAT32:
+      return tensor->CopyFromCpu(static_cast<const float*>(data));
+    case PaddleDType::INT64:
+      return tensor->CopyFromCpu(static_cast<const int64_t*>(data));
+    case PaddleDType::INT32:
+      return tensor->CopyFromCpu(static_cast<const int32_t*>(data));
+    case PaddleDType::UINT8:
+      return tensor->CopyFromCpu(static_cast<const uint8_t*>(data));
+    case PaddleDType::INT8:
+      return tensor->CopyFromCpu(static_cast<const int8_t*>(data));
+    case PaddleDType::FLOAT16:
+      return tensor->CopyFromCpu(static_cast<const float16*>(data));
+    default:
+      PADDLE_THROW(platform::errors::Unimplemented(
+          "Unsupported input data type %d in BatchingPredictor.",
+          static_cast<int>(dtype)));
+  }
+}
+
+// Returns the output data on host, which is the tensor memory itself on CPU
+// and a copy in holder otherwise.
+static const char* HostData(const ZeroCopyTensor& tensor, size_t bytes,
+                            std::vector<char>* holder) {
+  PaddlePlace place;
+  int size = 0;
+  if (tensor.place() == PaddlePlace::kCPU) {
+    switch (tensor.type()) {
+      case PaddleDType::FLOAT32:
+        return reinterpret_cast<const char*>(tensor.data<float>(&place, &size));
+      case PaddleDType::INT64:
+        return reinterpret_cast<const char*>(
+            tensor.data<int64_t>(&place, &size));
+      case PaddleDType::INT32:
+        return reinterpret_cast<const char*>(
+            tensor.data<int32_t>(&place, &size));
+      case PaddleDType::UINT8:
+        return reinterpret_cast<const char*>(
+            tensor.data<uint8_t>(&place, &size));
+      case PaddleDType::INT8:
+        return reinterpret_cast<const char*>(
+            tensor.data<int8_t>(&place, &size));
+      default:
+        break;
+    }
+  }
+  holder->resize(bytes);
+  switch (tensor.type()) {
+    case PaddleDType::FLOAT32:
+      tensor.CopyToCpu(reinterpret_cast<float*>(holder->data()));
+      break;
+    case PaddleDType::INT64:
+      tensor.CopyToCpu(reinterpret_cast<int64_t*>(holder->data()));
+      break;
+    case PaddleDType::INT32:
+      tensor.CopyToCpu(reinterpret_cast<int32_t*>(holder->data()));
+      break;
+    case PaddleDType::UINT8:
+      tensor.CopyToCpu(reinterpret_cast<uint8_t*>(holder->data()));
+      break;
+    case PaddleDType::INT8:
+      tensor.CopyToCpu(reinterpret_cast<int8_t*>(holder->data()));
+      break;
+    case PaddleDType::FLOAT16:
+      tensor.CopyToCpu(reinterpret_cast<float16*>(holder->data()));
+      break;
+    default:
+      PADDLE_THROW(platform::errors::Unimplemented(
+          "Unsupported output data type %d in BatchingPredictor.",
+          static_cast<int>(tensor.type())));
+  }
+  return holder->data();
+}
+
+static int BatchSizeOf(const PaddleTensor& tensor) {
+  if (!tensor.lod.empty()) {
+    return static_cast<int>(tensor.lod[0].size()) - 1;
+  }
+  return tensor.shape[0];
+}
+
+void LatencyHistogram::Add(int64_t value) {
+  size_t bucket = 0;
+  for (int64_t v = value; v > 0; v >>= 1) {
+    ++bucket;
+  }
+  if (buckets_.size() <= bucket) {
+    buckets_.resize(bucket + 1, 0);
+  }
+  ++buckets_[bucket];
+  ++count_;
+  sum_ += value;
+  max_ = std::max(max_, value);
+}
+
+void LatencyHistogram::Merge(const LatencyHistogram& other) {
+  if (buckets_.size() < other.buckets_.size()) {
+    buckets_.resize(other.buckets_.size(), 0);
+  }
+  for (size_t i = 0; i < other.buckets_.size(); ++i) {
+    buckets_[i] += other.buckets_[i];
+  }
+  count_ += other.count_;
+  sum_ += other.sum_;
+  max_ = std::max(max_, other.max_);
+}
+
+double LatencyHistogram::mean() const {
+  return count_ == 0 ? 0. : static_cast<double>(sum_) / count_;
+}
+
+int64_t LatencyHistogram::Percentile(double percentile) const {
+  uint64_t rank = static_cast<uint64_t>(percentile / 100. * count_ + 0.5);
+  rank = std::max(rank, static_cast<uint64_t>(1));
+  uint64_t seen = 0;
+  for (size_t i = 0; i < buckets_.size(); ++i) {
+    seen += buckets_[i];
+    if (seen >= rank) {
+      int64_t upper = i == 0 ? 0 : (static_cast<int64_t>(1) << i) - 1;
+      return std::min(upper, max_);
+    }
+  }
+  return max_;
+}
+
+std::string LatencyHistogram::ToString() const {
+  std::stringstream ss;
+  ss << "count " << count_ << ", mean " << mean() << ", p50 " << Percentile(50)
+     << ", p90 " << Percentile(90) << ", p99 " << Percentile(99) << ", max "
+     << max_;
+  return ss.str();
+}
+
+struct BatchingRequest {
+  const std::vector<PaddleTensor>* inputs;
+  std::vector<PaddleTensor>* outputs;
+  std::promise<bool> promise;
+  Clock::time_point enqueue_time;
+  Clock::time_point deadline;
+  int batch_size;
+};
+
+class BatchingPredictor::Impl {
+ public:
+  Impl(std::unique_ptr<PaddlePredictor> predictor,
+       const BatchingConfig& config);
+  ~Impl();
+
+  std::future<bool> Enqueue(const std::vector<PaddleTensor>& inputs,
+                            std::vector<PaddleTensor>* outputs,
+                            int64_t timeout_us);
+
+  BatchingStats GetStats() const {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    return stats_;
+  }
+
+ private:
+  using Batch = std::vector<std::unique_ptr<BatchingRequest>>;
+
+  void WorkerLoop(PaddlePredictor* predictor);
+  // Waits for a batch, returns false once stopped and drained.
+  bool NextBatch(Batch* batch);
+  bool RunBatch(PaddlePredictor* predictor, const Batch& batch);
+  void ConcatInput(const Batch& batch, size_t idx, ZeroCopyTensor* tensor);
+  void ScatterOutput(const ZeroCopyTensor& tensor, const Batch& batch,
+                     size_t idx);
+
+  static bool Compatible(const BatchingRequest& a, const BatchingRequest& b);
+
+  BatchingConfig config_;
+  std::vector<std::unique_ptr<PaddlePredictor>> predictors_;
+  std::vector<std::thread> workers_;
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<std::unique_ptr<BatchingRequest>> queue_;
+  int64_t queued_samples_{0};
+  bool stop_{false};
+
+  mutable std::mutex stats_mutex_;
+  BatchingStats stats_;
+};
+
+BatchingPredictor::Impl::Impl(std::unique_ptr<PaddlePredictor> predictor,
+                              const BatchingConfig& config)
+    : config_(config) {
+  PADDLE_ENFORCE_NOT_NULL(predictor,
+                          platform::errors::InvalidArgument(
+                              "The predictor of BatchingPredictor is null."));
+  PADDLE_ENFORCE_GT(config_.max_batch_size, 0,
+                    platform::errors::InvalidArgument(
+                        "The max batch size of BatchingPredictor should be "
+                        "greater than 0, but got %d.",
+                        config_.max_batch_size));
+  PADDLE_ENFORCE_GT(config_.worker_num, 0,
+                    platform::errors::InvalidArgument(
+                        "The worker number of BatchingPredictor should be "
+                        "greater than 0, but got %d.",
+                        config_.worker_num));
+  predictors_.emplace_back(std::move(predictor));
+  for (int i = 1; i < config_.worker_num; ++i) {
+    predictors_.emplace_back(predictors_[0]->Clone());
+  }
+  for (auto& pred : predictors_) {
+    workers_.emplace_back(&Impl::WorkerLoop, this, pred.get());
+  }
+}
+
+BatchingPredictor::Impl::~Impl() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  for (auto& worker : workers_) {
+    worker.join();
+  }
+}
+
+std::future<bool> BatchingPredictor::Impl::Enqueue(
+    const std::vector<PaddleTensor>& inputs, std::vector<PaddleTensor>* outputs,
+    int64_t timeout_us) {
+  PADDLE_ENFORCE_EQ(inputs.empty(), false,
+                    platform::errors::InvalidArgument(
+                        "The request of BatchingPredictor has no inputs."));
+  PADDLE_ENFORCE_NOT_NULL(
+      outputs, platform::errors::InvalidArgument(
+                   "The outputs of the BatchingPredictor request are null."));
+  int batch_size = BatchSizeOf(inputs[0]);
+  for (auto& input : inputs) {
+    PADDLE_ENFORCE_EQ(input.shape.empty(), false,
+                      platform::errors::InvalidArgument(
+                          "Input %s of a BatchingPredictor request should "
+                          "have a batch dimension.",
+                          input.name));
+    PADDLE_ENFORCE_EQ(
+        BatchSizeOf(input), batch_size,
+        platform::errors::InvalidArgument(
+            "The inputs of a BatchingPredictor request should have the same "
+            "batch size, but input %s has %d and input %s has %d.",
+            input.name, BatchSizeOf(input), inputs[0].name, batch_size));
+  }
+
+  std::unique_ptr<BatchingRequest> request(new BatchingRequest());
+  request->inputs = &inputs;
+  request->outputs = outputs;
+  request->enqueue_time = Clock::now();
+  request->deadline = timeout_us > 0
+                          ? request->enqueue_time +
+                                std::chrono::microseconds(timeout_us)
+                          : Clock::time_point::max();
+  request->batch_size = batch_size;
+  auto future = request->promise.get_future();
+
+  bool notify = false;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    queue_.emplace_back(std::move(request));
+    queued_samples_ += batch_size;
+    // wake the idle workers for a new batch, or the one filling a batch when
+    // it is full or has to be dispatched before the deadline of the request
+    notify = queue_.size() == 1 ||
+             queued_samples_ >= config_.max_batch_size || timeout_us > 0;
+  }
+  if (notify) {
+    cv_.notify_all();
+  }
+  return future;
+}
+
+bool BatchingPredictor::Impl::Compatible(const BatchingRequest& a,
+                                         const BatchingRequest& b) {
+  if (a.inputs->size() != b.inputs->size()) {
+    return false;
+  }
+  for (size_t i = 0; i < a.inputs->size(); ++i) {
+    auto& x = (*a.inputs)[i];
+    auto& y = (*b.inputs)[i];
+    if (x.name != y.name || x.dtype != y.dtype ||
+        x.lod.size() != y.lod.size() || x.shape.size() != y.shape.size() ||
+        !std::equal(x.shape.begin() + std::min<size_t>(1, x.shape.size()),
+                    x.shape.end(),
+                    y.shape.begin() + std::min<size_t>(1, y.shape.size()))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool BatchingPredictor::Impl::NextBatch(Batch* batch) {
+  batch->clear();
+  Batch expired;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      cv_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+      if (queue_.empty()) {
+        return false;
+      }
+      while (!stop_ && !queue_.empty() &&
+             queued_samples_ < config_.max_batch_size) {
+        // dispatch a partial batch before a queued request expires
+        auto dispatch_time =
+            queue_.front()->enqueue_time +
+            std::chrono::microseconds(config_.batch_timeout_us);
+        for (auto& request : queue_) {
+          dispatch_time = std::min(
+              dispatch_time,
+              request->deadline -
+                  std::chrono::microseconds(config_.deadline_margin_us));
+        }
+        if (Clock::now() >= dispatch_time) {
+          break;
+        }
+        cv_.wait_until(lock, dispatch_time);
+      }
+      // another worker took the requests
+      if (!queue_.empty()) {
+        break;
+      }
+    }
+
+    auto now = Clock::now();
+    int64_t batch_size = 0;
+    while (!queue_.empty()) {
+      auto& request = queue_.front();
+      if (request->deadline < now) {
+        queued_samples_ -= request->batch_size;
+        expired.emplace_back(std::move(request));
+        queue_.pop_front();
+        continue;
+      }
+      if (!batch->empty() &&
+          (batch_size + request->batch_size > config_.max_batch_size ||
+           !Compatible(*batch->front(), *request))) {
+        break;
+      }
+      batch_size += request->batch_size;
+      queued_samples_ -= request->batch_size;
+      batch->emplace_back(std::move(request));
+      queue_.pop_front();
+    }
+  }
+  // the rest waits for the next worker
+  cv_.notify_one();
+
+  for (auto& request : expired) {
+    request->promise.set_value(false);
+  }
+  if (!expired.empty()) {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    stats_.expired_num += expired.size();
+  }
+  return true;
+}
+
+void BatchingPredictor::Impl::WorkerLoop(PaddlePredictor* predictor) {
+  Batch batch;
+  while (NextBatch(&batch)) {
+    if (batch.empty()) {
+      continue;
+    }
+    auto start = Clock::now();
+    bool success = false;
+    try {
+      success = RunBatch(predictor, batch);
+    } catch (const std::exception& e) {
+      LOG(ERROR) << "BatchingPredictor failed to run a batch of "
+                 << batch.size() << " requests: " << e.what();
+    }
+    auto end = Clock::now();
+    for (auto& request : batch) {
+      request->promise.set_value(success);
+    }
+
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    int64_t batch_size = 0;
+    for (auto& request : batch) {
+      stats_.queue_latency.Add(ElapsedUs(request->enqueue_time, start));
+      batch_size += request->batch_size;
+    }
+    stats_.run_latency.Add(ElapsedUs(start, end));
+    stats_.batch_size.Add(batch_size);
+    if (!success) {
+      stats_.failed_num += batch.size();
+    }
+  }
+}
+
+bool BatchingPredictor::Impl::RunBatch(PaddlePredictor* predictor,
+                                       const Batch& batch) {
+  auto& inputs = *batch.front()->inputs;
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    auto tensor = predictor->GetInputTensor(inputs[i].name);
+    ConcatInput(batch, i, tensor.get());
+  }
+  if (!predictor->ZeroCopyRun()) {
+    return false;
+  }
+  auto output_names = predictor->GetOutputNames();
+  for (auto& request : batch) {
+    request->outputs->resize(output_names.size());
+  }
+  for (size_t i = 0; i < output_names.size(); ++i) {
+    auto tensor = predictor->GetOutputTensor(output_names[i]);
+    ScatterOutput(*tensor, batch, i);
+  }
+  return true;
+}
+
+void BatchingPredictor::Impl::ConcatInput(const Batch& batch, size_t idx,
+                                          ZeroCopyTensor* tensor) {
+  auto& first = (*batch.front()->inputs)[idx];
+  size_t elem_size = SizeOfDType(first.dtype);
+  size_t row_bytes = Numel(first.shape, 1) * elem_size;
+
+  std::vector<int> shape = first.shape;
+  std::vector<std::vector<size_t>> lod(first.lod.size(), {0});
+  int rows = 0;
+  for (auto& request : batch) {
+    auto& input = (*request->inputs)[idx];
+    rows += input.shape[0];
+    // every level indexes the next one, appending a level shifts it by the
+    // length of the next level merged so far
+    for (size_t level = 0; level < input.lod.size(); ++level) {
+      size_t offset = lod[level].back();
+      for (size_t j = 1; j < input.lod[level].size(); ++j) {
+        lod[level].push_back(offset + input.lod[level][j]);
+      }
+    }
+  }
+  shape[0] = rows;
+  tensor->Reshape(shape);
+  if (!lod.empty()) {
+    tensor->SetLoD(lod);
+  }
+
+  std::vector<char> host_data;
+  char* dst = nullptr;
+  if (tensor->place() == PaddlePlace::kCPU &&
+      first.dtype != PaddleDType::FLOAT16) {
+    dst = static_cast<char*>(MutableCpuData(tensor, first.dtype));
+  } else {
+    host_data.resize(rows * row_bytes);
+    dst = host_data.data();
+  }
+  for (auto& request : batch) {
+    auto& input = (*request->inputs)[idx];
+    size_t bytes = Numel(input.shape) * elem_size;
+    PADDLE_ENFORCE_GE(input.data.length(), bytes,
+                      platform::errors::InvalidArgument(
+                          "The data of input %s has %d bytes, less than the "
+                          "%d bytes of its shape.",
+                          input.name, input.data.length(), bytes));
+    std::memcpy(dst, input.data.data(), bytes);
+    dst += bytes;
+  }
+  if (!host_data.empty()) {
+    CopyFromHost(tensor, host_data.data(), first.dtype);
+  }
+}
+
+void BatchingPredictor::Impl::ScatterOutput(const ZeroCopyTensor& tensor,
+                                            const Batch& batch, size_t idx) {
+  auto shape = tensor.shape();
+  auto lod = tensor.lod();
+  auto dtype = tensor.type();
+  size_t elem_size = SizeOfDType(dtype);
+  size_t row_bytes = Numel(shape, 1) * elem_size;
+  std::vector<char> holder;
+  const char* data = HostData(tensor, Numel(shape) * elem_size, &holder);
+
+  size_t total_batch_size = 0;
+  for (auto& request : batch) {
+    total_batch_size += request->batch_size;
+  }
+  bool shared = std::find(config_.shared_outputs.begin(),
+                          config_.shared_outputs.end(),
+                          tensor.name()) != config_.shared_outputs.end();
+  bool split_by_lod = !shared && !lod.empty();
+  bool split_by_rows = !shared && lod.empty();
+  if (split_by_lod) {
+    PADDLE_ENFORCE_EQ(
+        lod[0].size(), total_batch_size + 1,
+        platform::errors::InvalidArgument(
+            "Output %s of BatchingPredictor is split by its first LoD level, "
+            "which should have one sequence per sample of the batch, %d, "
+            "but has %d. Add it to BatchingConfig::shared_outputs if it is "
+            "not batched.",
+            tensor.name(), total_batch_size, lod[0].size() - 1));
+  }
+  if (split_by_rows) {
+    int64_t rows = shape.empty() ? 0 : shape[0];
+    PADDLE_ENFORCE_EQ(
+        rows, static_cast<int64_t>(total_batch_size),
+        platform::errors::InvalidArgument(
+            "Output %s of BatchingPredictor is split along its first "
+            "dimension, which should be the batch size %d, but is %d. Add it "
+            "to BatchingConfig::shared_outputs if it is not batched.",
+            tensor.name(), total_batch_size, rows));
+  }
+
+  size_t begin = 0;
+  for (auto& request : batch) {
+    auto& output = (*request->outputs)[idx];
+    output.name = tensor.name();
+    output.dtype = dtype;
+    output.shape = shape;
+    output.lod.clear();
+    size_t row_begin = 0;
+    size_t row_end = shape.empty() ? 1 : shape[0];
+    if (split_by_lod) {
+      // slice every level by the range found in the level above
+      size_t level_begin = begin;
+      size_t level_end = begin + request->batch_size;
+      for (auto& level : lod) {
+        std::vector<size_t> sub_level;
+        for (size_t j = level_begin; j <= level_end; ++j) {
+          sub_level.push_back(level[j] - level[level_begin]);
+        }
+        output.lod.emplace_back(std::move(sub_level));
+        size_t next_begin = level[level_begin];
+        level_end = level[level_end];
+        level_begin = next_begin;
+      }
+      row_begin = level_begin;
+      row_end = level_end;
+      output.shape[0] = row_end - row_begin;
+    } else if (split_by_rows) {
+      row_begin = begin;
+      row_end = begin + request->batch_size;
+      output.shape[0] = request->batch_size;
+    }
+    size_t bytes = (row_end - row_begin) * row_bytes;
+    output.data.Resize(bytes);
+    if (bytes > 0) {
+      std::memcpy(output.data.data(), data + row_begin * row_bytes, bytes);
+    }
+    begin += request->batch_size;
+  }
+}
+
+BatchingPredictor::BatchingPredictor(std::unique_ptr<PaddlePredictor> predictor,
+                                     const BatchingConfig& config)
+    : impl_(new Impl(std::move(predictor), config)) {}
+
+BatchingPredictor::~BatchingPredictor() {}
+
+std::future<bool> BatchingPredictor::Run(
+    const std::vector<PaddleTensor>& inputs, std::vector<PaddleTensor>* outputs,
+    int64_t timeout_us) {
+  return impl_->Enqueue(inputs, outputs, timeout_us);
+}
+
+BatchingStats BatchingPredictor::GetStats() const { return impl_->GetStats(); }
+
+}  // namespace paddle
@@ -0,0 +1,193 @@
+// Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+#include <chrono>  // NOLINT
+#include <cmath>
+#include <thread>  // NOLINT
+
+#include "paddle/fluid/inference/api/paddle_batching_predictor.h"
+#include "paddle/fluid/inference/api/paddle_inference_api.h"
+
+DEFINE_string(dirname, "", "dirname to tests.");
+
+namespace paddle {
+
+TEST(LatencyHistogram, Percentile) {
+  LatencyHistogram histogram;
+  for (int i = 1; i <= 100; ++i) {
+    histogram.Add(i);
+  }
+  ASSERT_EQ(histogram.count(), 100UL);
+  ASSERT_EQ(histogram.max(), 100);
+  ASSERT_DOUBLE_EQ(histogram.mean(), 50.5);
+  // 50 falls in [32, 64), 99 in [64, 128) capped by the max
+  ASSERT_EQ(histogram.Percentile(50), 63);
+  ASSERT_EQ(histogram.Percentile(99), 100);
+
+  LatencyHistogram other;
+  other.Add(0);
+  histogram.Merge(other);
+  ASSERT_EQ(histogram.count(), 101UL);
+  ASSERT_EQ(histogram.Percentile(0), 0);
+}
+
+static std::vector<PaddleTensor> Word2vecInputs(int batch_size, int seed,
+                                               bool with_lod) {
+  std::vector<PaddleTensor> inputs;
+  for (auto& name : {"firstw", "secondw", "thirdw", "forthw"}) {
+    PaddleTensor tensor;
+    tensor.name = name;
+    tensor.shape = {batch_size, 1};
+    tensor.dtype = PaddleDType::INT64;
+    tensor.data.Resize(batch_size * sizeof(int64_t));
+    auto* data = static_cast<int64_t*>(tensor.data.data());
+    for (int i = 0; i < batch_size; ++i) {
+      data[i] = (seed * 7 + i * 13 + inputs.size()) % 1000;
+    }
+    // a request of LoD inputs is batched by sequences
+    if (with_lod) {
+      tensor.lod.emplace_back();
+      for (int i = 0; i <= batch_size; ++i) {
+        tensor.lod[0].push_back(i);
+      }
+    }
+    inputs.emplace_back(std::move(tensor));
+  }
+  return inputs;
+}
+
+static std::vector<std::vector<PaddleTensor>> RunRequests(
+    BatchingPredictor* predictor,
+    const std::vector<std::vector<PaddleTensor>>& inputs, int thread_num) {
+  std::vector<std::vector<PaddleTensor>> outputs(inputs.size());
+  std::vector<std::thread> threads;
+  for (int t = 0; t < thread_num; ++t) {
+    threads.emplace_back([&, t] {
+      std::vector<std::future<bool>> futures;
+      for (size_t i = t; i < inputs.size(); i += thread_num) {
+        futures.emplace_back(predictor->Run(inputs[i], &outputs[i]));
+      }
+      for (auto& future : futures) {
+        ASSERT_TRUE(future.get());
+      }
+    });
+  }
+  for (auto& th : threads) {
+    th.join();
+  }
+  return outputs;
+}
+
+TEST(BatchingPredictor, word2vec) {
+  AnalysisConfig config;
+  config.SetModel(FLAGS_dirname);
+  config.SwitchUseFeedFetchOps(false);
+
+  const int request_num = 64;
+  std::vector<std::vector<PaddleTensor>> inputs;
+  for (int i = 0; i < request_num; ++i) {
+    inputs.emplace_back(Word2vecInputs(i % 3 + 1, i, i < request_num / 2));
+  }
+
+  BatchingConfig unbatched_config;
+  unbatched_config.max_batch_size = 1;
+  BatchingPredictor unbatched(CreatePaddlePredictor<AnalysisConfig>(config),
+                              unbatched_config);
+  auto expected = RunRequests(&unbatched, inputs, 1);
+
+  BatchingConfig batching_config;
+  batching_config.max_batch_size = 16;
+  batching_config.batch_timeout_us = 2000;
+  batching_config.worker_num = 2;
+  BatchingPredictor batching(CreatePaddlePredictor<AnalysisConfig>(config),
+                             batching_config);
+  auto outputs = RunRequests(&batching, inputs, 4);
+
+  for (int i = 0; i < request_num; ++i) {
+    ASSERT_EQ(outputs[i].size(), expected[i].size());
+    for (size_t j = 0; j < outputs[i].size(); ++j) {
+      auto& out = outputs[i][j];
+      auto& ref = expected[i][j];
+      ASSERT_EQ(out.shape, ref.shape);
+      ASSERT_EQ(out.shape[0], i % 3 + 1);
+      ASSERT_EQ(out.data.length(), ref.data.length());
+      auto* out_data = static_cast<float*>(out.data.data());
+      auto* ref_data = static_cast<float*>(ref.data.data());
+      for (size_t k = 0; k < out.data.length() / sizeof(float); ++k) {
+        ASSERT_NEAR(out_data[k], ref_data[k], 1e-5);
+      }
+    }
+  }
+
+  auto stats = batching.GetStats();
+  LOG(INFO) << "queue latency: " << stats.queue_latency.ToString();
+  LOG(INFO) << "run latency: " << stats.run_latency.ToString();
+  LOG(INFO) << "batch size: " << stats.batch_size.ToString();
+  ASSERT_EQ(stats.queue_latency.count(), static_cast<uint64_t>(request_num));
+  ASSERT_LT(stats.batch_size.count(), static_cast<uint64_t>(request_num));
+  ASSERT_EQ(stats.failed_num, 0UL);
+}
+
+TEST(BatchingPredictor, deadline) {
+  AnalysisConfig config;
+  config.SetModel(FLAGS_dirname);
+  config.SwitchUseFeedFetchOps(false);
+
+  BatchingConfig batching_config;
+  batching_config.max_batch_size = 64;
+  batching_config.batch_timeout_us = 10000000;
+  batching_config.deadline_margin_us = 1000;
+  BatchingPredictor batching(CreatePaddlePredictor<AnalysisConfig>(config),
+                             batching_config);
+  // the batch is dispatched before the deadline of the request instead of
+  // waiting for the batch timeout
+  auto inputs = Word2vecInputs(1, 1, false);
+  std::vector<PaddleTensor> outputs;
+  auto start = std::chrono::steady_clock::now();
+  ASSERT_TRUE(batching.Run(inputs, &outputs, 50000).get());
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  ASSERT_LT(elapsed,
+            std::chrono::microseconds(batching_config.batch_timeout_us));
+  ASSERT_EQ(outputs[0].shape[0], 1);
+
+  // a later request with an earlier deadline cuts the wait of the batch
+  std::vector<PaddleTensor> waiting_outputs;
+  auto waiting = batching.Run(inputs, &waiting_outputs);
+  ASSERT_TRUE(batching.Run(inputs, &outputs, 50000).get());
+  ASSERT_TRUE(waiting.get());
+
+  auto stats = batching.GetStats();
+  ASSERT_EQ(stats.expired_num, 0UL);
+  ASSERT_EQ(stats.failed_num, 0UL);
+}
+
+TEST(BatchingPredictor, shared_outputs) {
+  AnalysisConfig config;
+  config.SetModel(FLAGS_dirname);
+  config.SwitchUseFeedFetchOps(false);
+
+  // the batched output is not split when it is declared shared
+  auto predictor = CreatePaddlePredictor<AnalysisConfig>(config);
+  BatchingConfig batching_config;
+  batching_config.shared_outputs = predictor->GetOutputNames();
+  BatchingPredictor batching(std::move(predictor), batching_config);
+  auto inputs = Word2vecInputs(2, 1, false);
+  std::vector<PaddleTensor> outputs;
+  ASSERT_TRUE(batching.Run(inputs, &outputs).get());
+  ASSERT_EQ(outputs[0].shape[0], 2);
+}
+
+}  // namespace paddle
@@ -690,6 +690,41 @@ struct PD_INFER_DECL AnalysisConfig {
   ///
   bool enable_memory_optim() const;
 
+  ///
+  /// \brief Cache the output dims of the operators per signature of the input
+  /// dims and LoD, so that the runs with a cached signature skip the shape
+  /// inference. It only works with ZeroCopyRun, i.e. with
+  /// SwitchUseFeedFetchOps(false).
+  ///
+  /// \param capacity The number of cached signatures, the least recently used
+  /// one is evicted first. 0 to disable it.
+  ///
+  void SetShapeCacheCapacity(int capacity);
+  ///
+  /// \brief Get the capacity of the shape cache.
+  ///
+  /// \return int The number of cached signatures, 0 if disabled.
+  ///
+  int shape_cache_capacity() const { return shape_cache_capacity_; }
+
+  ///
+  /// \brief Place the temporary tensors in one buffer per predictor, at
+  /// offsets planned from their lifetimes and their sizes in the former runs,
+  /// so that running the kernels allocates no memory once planned. It plans
+  /// after the first run, and again after a run with larger tensors. Only
+  /// CPU is supported.
+  ///
+  /// \param x Whether to enable the static memory plan.
+  ///
+  void EnableStaticMemoryPlan(bool x = true);
+  ///
+  /// \brief A boolean state telling whether the static memory plan is
+  /// enabled.
+  ///
+  /// \return bool Whether the static memory plan is enabled.
+  ///
+  bool static_memory_plan_enabled() const { return static_memory_plan_; }
+
   ///
   /// \brief Turn on profiling report.
   /// If not turned on, no profiling report will be generated.
@@ -820,6 +855,9 @@ struct PD_INFER_DECL AnalysisConfig {
   // memory reuse related.
   bool enable_memory_optim_{false};
 
+  int shape_cache_capacity_{0};
+  bool static_memory_plan_{false};
+
   bool use_mkldnn_{false};
   std::unordered_set<std::string> mkldnn_enabled_op_types_;
 
@@ -0,0 +1,143 @@
+// Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <future>  // NOLINT
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "paddle_api.h"  // NOLINT
+
+namespace paddle {
+
+///
+/// \brief Configuration of BatchingPredictor.
+///
+struct PD_INFER_DECL BatchingConfig {
+  /// The largest number of samples run at once. A single request larger
+  /// than it still runs, alone.
+  int max_batch_size{32};
+  /// How long the first request of a batch waits for more requests, in
+  /// microseconds.
+  int64_t batch_timeout_us{1000};
+  /// How long before the deadline of a queued request its batch is
+  /// dispatched, even if it is not full, in microseconds.
+  int64_t deadline_margin_us{200};
+  /// The number of worker threads, each runs its own clone of the predictor.
+  int worker_num{1};
+  /// The outputs that are not batched, e.g. a global statistic, copied whole
+  /// to every request of the batch. Any other output must be batched.
+  std::vector<std::string> shared_outputs;
+};
+
+///
+/// \brief Histogram of latencies in microseconds, or of batch sizes, with
+/// buckets growing by a factor of two: bucket i counts the values in
+/// [2^(i-1), 2^i).
+///
+class PD_INFER_DECL LatencyHistogram {
+ public:
+  void Add(int64_t value);
+  void Merge(const LatencyHistogram& other);
+
+  uint64_t count() const { return count_; }
+  double mean() const;
+  int64_t max() const { return max_; }
+  /// \brief Returns the upper bound of the bucket holding the percentile,
+  /// capped by the max value.
+  /// \param percentile A value in [0, 100].
+  int64_t Percentile(double percentile) const;
+  std::string ToString() const;
+
+ private:
+  std::vector<uint64_t> buckets_;
+  uint64_t count_{0};
+  int64_t sum_{0};
+  int64_t max_{0};
+};
+
+struct PD_INFER_DECL BatchingStats {
+  /// Time from enqueueing a request to the start of its batch.
+  LatencyHistogram queue_latency;
+  /// Time to concatenate the inputs, run the batch and scatter the outputs.
+  LatencyHistogram run_latency;
+  /// Samples per batch.
+  LatencyHistogram batch_size;
+  /// Requests dropped because their deadline passed in the queue.
+  uint64_t expired_num{0};
+  /// Requests of batches whose run failed.
+  uint64_t failed_num{0};
+};
+
+///
+/// \class BatchingPredictor
+///
+/// \brief A front end of a predictor for serving many small requests.
+/// Requests are queued, concatenated along the batch dimension up to
+/// max_batch_size samples or until batch_timeout_us passes, run with one
+/// ZeroCopyRun, and the outputs are scattered back to the requests. A batch
+/// is dispatched early when a queued request gets within deadline_margin_us
+/// of its deadline.
+///
+/// The batch dimension of an input without LoD is its first dimension. An
+/// input with LoD is concatenated by sequences: the levels of the LoD are
+/// merged and the rows are appended. Requests are batched only with
+/// requests whose inputs have the same dtype, LoD level number and
+/// dimensions other than the first one.
+///
+/// An output listed in shared_outputs is copied to every request of the
+/// batch. Any other output is split: by its first LoD level if it has LoD,
+/// which must then have one sequence per sample of the batch, otherwise along
+/// its first dimension, which must then be the total batch size. A batch
+/// whose output breaks this fails instead of guessing how to split it.
+///
+/// The predictor must be created with SwitchUseFeedFetchOps(false). It is
+/// used by the first worker, the other workers run clones of it.
+///
+class PD_INFER_DECL BatchingPredictor {
+ public:
+  BatchingPredictor(std::unique_ptr<PaddlePredictor> predictor,
+                    const BatchingConfig& config);
+  ~BatchingPredictor();
+
+  BatchingPredictor(const BatchingPredictor&) = delete;
+  BatchingPredictor& operator=(const BatchingPredictor&) = delete;
+
+  ///
+  /// \brief Enqueues a request.
+  ///
+  /// \param[in] inputs The inputs of one request, named after the inputs of
+  /// the model. They are not copied and must stay valid until the future is
+  /// ready.
+  /// \param[out] outputs The outputs, valid once the future is ready.
+  /// \param[in] timeout_us The deadline of the request relative to now in
+  /// microseconds, a request still queued at its deadline is dropped. No
+  /// deadline if not positive.
+  /// \return A future that turns true if the outputs are written.
+  ///
+  std::future<bool> Run(const std::vector<PaddleTensor>& inputs,
+                        std::vector<PaddleTensor>* outputs,
+                        int64_t timeout_us = 0);
+
+  BatchingStats GetStats() const;
+
+ private:
+  class Impl;
+  std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace paddle
@@ -22,6 +22,7 @@
 #include "paddle/fluid/memory/allocation/cpu_allocator.h"
 #include "paddle/fluid/memory/allocation/naive_best_fit_allocator.h"
 #include "paddle/fluid/memory/allocation/retry_allocator.h"
+#include "paddle/fluid/memory/allocation/thread_cached_allocator.h"
 #include "paddle/fluid/platform/enforce.h"
 #include "paddle/fluid/platform/place.h"
 
@@ -81,6 +82,8 @@ PADDLE_DEFINE_EXPORTED_bool(use_stream_safe_cuda_allocator, false,
                             "Enable StreamSafeCUDAAllocator");
 
 DECLARE_string(allocator_strategy);
+DECLARE_uint64(thread_cached_allocator_max_size);
+DECLARE_uint64(thread_cached_allocator_class_cache_size);
 
 namespace paddle {
 namespace memory {
@@ -144,8 +147,14 @@ class AllocatorFacadePrivate {
   explicit AllocatorFacadePrivate(bool allow_free_idle_chunk = true) {
     strategy_ = GetAllocatorStrategy();
     switch (strategy_) {
+      // thread_cached differs from naive_best_fit in the CPU allocator only
+      case AllocatorStrategy::kThreadCached:
       case AllocatorStrategy::kNaiveBestFit: {
-        InitNaiveBestFitCPUAllocator();
+        if (strategy_ == AllocatorStrategy::kThreadCached) {
+          InitThreadCachedCPUAllocator();
+        } else {
+          InitNaiveBestFitCPUAllocator();
+        }
 #ifdef PADDLE_WITH_IPU
         for (int dev_id = 0; dev_id < platform::GetIPUDeviceCount(); ++dev_id) {
           InitNaiveBestFitIPUAllocator(platform::IPUPlace(dev_id));
@@ -156,7 +165,8 @@ class AllocatorFacadePrivate {
             FLAGS_use_stream_safe_cuda_allocator, false,
             paddle::platform::errors::Unimplemented(
                 "StreamSafeCUDAAllocator is only implemented for auto_growth "
-                "strategy, not support naive_best_fit strategy"));
+                "strategy, not support %s strategy",
+                FLAGS_allocator_strategy));
 
         for (int dev_id = 0; dev_id < platform::GetGPUDeviceCount(); ++dev_id) {
           InitNaiveBestFitCUDAAllocator(platform::CUDAPlace(dev_id));
@@ -424,6 +434,13 @@ class AllocatorFacadePrivate {
         std::make_shared<NaiveBestFitAllocator>(platform::CPUPlace());
   }
 
+  void InitThreadCachedCPUAllocator() {
+    allocators_[platform::CPUPlace()] = std::make_shared<ThreadCachedAllocator>(
+        std::make_shared<NaiveBestFitAllocator>(platform::CPUPlace()),
+        FLAGS_thread_cached_allocator_max_size,
+        FLAGS_thread_cached_allocator_class_cache_size);
+  }
+
 #if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
   void InitNaiveBestFitCUDAPinnedAllocator() {
     allocators_[platform::CUDAPinnedPlace()] =
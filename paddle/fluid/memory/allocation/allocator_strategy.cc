@@ -36,9 +36,13 @@ static AllocatorStrategy GetStrategyFromFlag() {
     return AllocatorStrategy::kThreadLocal;
   }
 
+  if (FLAGS_allocator_strategy == "thread_cached") {
+    return AllocatorStrategy::kThreadCached;
+  }
+
   PADDLE_THROW(platform::errors::InvalidArgument(
       "Unsupported allocator strategy: %s, condicates are naive_best_fit, "
-      "auto_growth or thread_local.",
+      "auto_growth, thread_local or thread_cached.",
       FLAGS_allocator_strategy));
 }
 
@@ -0,0 +1,389 @@
+// Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/memory/allocation/thread_cached_allocator.h"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>  // NOLINT
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "paddle/fluid/memory/allocation/spin_lock.h"
+#include "paddle/fluid/platform/flags.h"
+
+PADDLE_DEFINE_EXPORTED_uint64(
+    thread_cached_allocator_max_size, 256 << 10,
+    "The largest CPU allocation in bytes served from the thread caches "
+    "when FLAGS_allocator_strategy=thread_cached, larger ones go to the "
+    "naive best fit allocator.");
+
+PADDLE_DEFINE_EXPORTED_uint64(
+    thread_cached_allocator_class_cache_size, 1 << 20,
+    "The bytes of free blocks a thread caches per size class when "
+    "FLAGS_allocator_strategy=thread_cached.");
+
+namespace paddle {
+namespace memory {
+namespace allocation {
+
+static constexpr size_t kSmallClassNum = 16;
+static constexpr size_t kSmallClassMaxSize =
+    kSmallClassNum * ThreadCachedAllocator::kAlignment;
+static constexpr size_t kSubClassNum = 4;
+static constexpr size_t kMinChunkSize = 1 << 20;
+static constexpr size_t kMinBlocksPerChunk = 8;
+static constexpr size_t kMinCachedBlocks = 4;
+static constexpr size_t kMaxCachedBlocks = 512;
+static constexpr size_t kLargeSizeClass = static_cast<size_t>(-1);
+
+// The counters of a thread cache are only written by its thread, a relaxed
+// load and store avoids the locked add of fetch_add.
+template <typename T>
+static inline void AddCounter(std::atomic<T> *counter, T value) {
+  counter->store(counter->load(std::memory_order_relaxed) + value,
+                 std::memory_order_relaxed);
+}
+
+constexpr size_t ThreadCachedAllocator::kAlignment;
+
+static std::atomic<uint64_t> g_thread_cached_id{0};
+
+class ThreadCachedAllocation : public Allocation {
+ public:
+  ThreadCachedAllocation(void *ptr, size_t size, size_t request_size,
+                         size_t size_class, uint64_t owner)
+      : Allocation(ptr, size, platform::CPUPlace()),
+        request_size_(request_size),
+        size_class_(size_class),
+        owner_(owner) {}
+
+  explicit ThreadCachedAllocation(AllocationPtr underlying_allocation)
+      : Allocation(underlying_allocation->ptr(), underlying_allocation->size(),
+                   underlying_allocation->place()),
+        request_size_(underlying_allocation->size()),
+        size_class_(kLargeSizeClass),
+        owner_(0),
+        underlying_allocation_(std::move(underlying_allocation)) {}
+
+  size_t request_size() const { return request_size_; }
+  size_t size_class() const { return size_class_; }
+  uint64_t owner() const { return owner_; }
+
+ private:
+  size_t request_size_;
+  size_t size_class_;
+  uint64_t owner_;
+  AllocationPtr underlying_allocation_;
+};
+
+class ThreadCachedAllocator::CentralPool {
+ public:
+  CentralPool(const std::shared_ptr<Allocator> &underlying_allocator,
+              size_t max_cached_size, size_t class_cache_size)
+      : underlying_allocator_(underlying_allocator) {
+    size_class_num_ = SizeClassOf(max_cached_size) + 1;
+    max_cached_size_ = ClassSize(size_class_num_ - 1);
+    free_lists_.resize(size_class_num_);
+    max_cached_num_.resize(size_class_num_);
+    for (size_t i = 0; i < size_class_num_; ++i) {
+      free_lists_[i].reset(new FreeList());
+      max_cached_num_[i] =
+          std::min(std::max(class_cache_size / ClassSize(i), kMinCachedBlocks),
+                   kMaxCachedBlocks);
+    }
+  }
+
+  size_t size_class_num() const { return size_class_num_; }
+  size_t max_cached_size() const { return max_cached_size_; }
+  size_t max_cached_num(size_t size_class) const {
+    return max_cached_num_[size_class];
+  }
+
+  AllocationPtr AllocateLarge(size_t size) {
+    return underlying_allocator_->Allocate(size);
+  }
+
+  // Moves up to num blocks of the class to blocks, a new chunk is carved
+  // when the free list of the pool is empty.
+  void Fetch(size_t size_class, size_t num, std::vector<void *> *blocks) {
+    auto &free_list = *free_lists_[size_class];
+    {
+      std::lock_guard<SpinLock> guard(free_list.lock);
+      size_t fetch_num = std::min(num, free_list.blocks.size());
+      if (fetch_num > 0) {
+        blocks->insert(blocks->end(), free_list.blocks.end() - fetch_num,
+                       free_list.blocks.end());
+        free_list.blocks.resize(free_list.blocks.size() - fetch_num);
+        return;
+      }
+    }
+
+    size_t block_size = ClassSize(size_class);
+    size_t block_num = std::max(
+        std::max(kMinChunkSize / block_size, kMinBlocksPerChunk), num);
+    auto chunk = underlying_allocator_->Allocate(block_num * block_size +
+                                                 kAlignment);
+    char *ptr = static_cast<char *>(chunk->ptr());
+    ptr += AlignedPtrOffset(ptr, kAlignment);
+    VLOG(10) << "Carve chunk " << chunk->ptr() << " into " << block_num
+             << " blocks of " << block_size << " bytes";
+    for (size_t i = 0; i < num; ++i, ptr += block_size) {
+      blocks->push_back(ptr);
+    }
+    {
+      std::lock_guard<SpinLock> guard(free_list.lock);
+      for (size_t i = num; i < block_num; ++i, ptr += block_size) {
+        free_list.blocks.push_back(ptr);
+      }
+    }
+    reserved_size_.fetch_add(chunk->size(), std::memory_order_relaxed);
+    std::lock_guard<std::mutex> guard(chunk_mutex_);
+    chunks_.emplace_back(std::move(chunk));
+  }
+
+  void Return(size_t size_class, void *const *blocks, size_t num) {
+    auto &free_list = *free_lists_[size_class];
+    std::lock_guard<SpinLock> guard(free_list.lock);
+    free_list.blocks.insert(free_list.blocks.end(), blocks, blocks + num);
+  }
+
+  void Register(ThreadCache *cache) {
+    std::lock_guard<std::mutex> guard(cache_mutex_);
+    caches_.insert(cache);
+  }
+
+  // The counters of a dead thread are kept in retired_stats_.
+  void Unregister(ThreadCache *cache);
+
+  ThreadCachedAllocatorStats GetStats();
+
+ private:
+  struct FreeList {
+    SpinLock lock;
+    std::vector<void *> blocks;
+  };
+
+  std::shared_ptr<Allocator> underlying_allocator_;
+  size_t size_class_num_;
+  size_t max_cached_size_;
+  std::vector<size_t> max_cached_num_;
+  std::vector<std::unique_ptr<FreeList>> free_lists_;
+
+  std::mutex chunk_mutex_;
+  std::vector<AllocationPtr> chunks_;
+  std::atomic<uint64_t> reserved_size_{0};
+
+  std::mutex cache_mutex_;
+  std::unordered_set<ThreadCache *> caches_;
+  ThreadCachedAllocatorStats retired_stats_;
+};
+
+class ThreadCachedAllocator::ThreadCache {
+ public:
+  explicit ThreadCache(const std::shared_ptr<CentralPool> &pool)
+      : pool_(pool), id_(++g_thread_cached_id) {
+    free_lists_.resize(pool_->size_class_num());
+    pool_->Register(this);
+  }
+
+  ~ThreadCache() {
+    Flush();
+    pool_->Unregister(this);
+  }
+
+  uint64_t id() const { return id_; }
+
+  ThreadCachedAllocation *Allocate(size_t size) {
+    if (size > pool_->max_cached_size()) {
+      AddCounter(&large_num_, uint64_t(1));
+      return new ThreadCachedAllocation(pool_->AllocateLarge(size));
+    }
+    size_t size_class = SizeClassOf(size);
+    auto &free_list = free_lists_[size_class];
+    if (free_list.empty()) {
+      AddCounter(&miss_num_, uint64_t(1));
+      pool_->Fetch(size_class, BatchNum(size_class), &free_list);
+    } else {
+      AddCounter(&hit_num_, uint64_t(1));
+    }
+    void *ptr = free_list.back();
+    free_list.pop_back();
+    size_t block_size = ClassSize(size_class);
+    AddCounter(&block_size_, static_cast<int64_t>(block_size));
+    AddCounter(&request_size_, static_cast<int64_t>(size));
+    return new ThreadCachedAllocation(ptr, block_size, size, size_class, id_);
+  }
+
+  void Free(ThreadCachedAllocation *allocation) {
+    size_t size_class = allocation->size_class();
+    if (allocation->owner() != id_) {
+      AddCounter(&remote_free_num_, uint64_t(1));
+    }
+    AddCounter(&block_size_, -static_cast<int64_t>(allocation->size()));
+    AddCounter(&request_size_,
+               -static_cast<int64_t>(allocation->request_size()));
+    auto &free_list = free_lists_[size_class];
+    free_list.push_back(allocation->ptr());
+    if (free_list.size() > pool_->max_cached_num(size_class)) {
+      size_t num = BatchNum(size_class);
+      pool_->Return(size_class, free_list.data() + free_list.size() - num,
+                    num);
+      free_list.resize(free_list.size() - num);
+    }
+  }
+
+  void Flush() {
+    for (size_t i = 0; i < free_lists_.size(); ++i) {
+      if (!free_lists_[i].empty()) {
+        pool_->Return(i, free_lists_[i].data(), free_lists_[i].size());
+        free_lists_[i].clear();
+      }
+    }
+  }
+
+  void AddStats(ThreadCachedAllocatorStats *stats) const {
+    stats->hit_num += hit_num_.load(std::memory_order_relaxed);
+    stats->miss_num += miss_num_.load(std::memory_order_relaxed);
+    stats->large_num += large_num_.load(std::memory_order_relaxed);
+    stats->remote_free_num += remote_free_num_.load(std::memory_order_relaxed);
+    // a thread may free more than it allocates, only the sum is meaningful
+    stats->block_size += block_size_.load(std::memory_order_relaxed);
+    stats->request_size += request_size_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  size_t BatchNum(size_t size_class) const {
+    return std::max(pool_->max_cached_num(size_class) / 2, size_t(1));
+  }
+
+  std::shared_ptr<CentralPool> pool_;
+  uint64_t id_;
+  std::vector<std::vector<void *>> free_lists_;
+
+  std::atomic<uint64_t> hit_num_{0};
+  std::atomic<uint64_t> miss_num_{0};
+  std::atomic<uint64_t> large_num_{0};
+  std::atomic<uint64_t> remote_free_num_{0};
+  std::atomic<int64_t> block_size_{0};
+  std::atomic<int64_t> request_size_{0};
+};
+
+void ThreadCachedAllocator::CentralPool::Unregister(ThreadCache *cache) {
+  std::lock_guard<std::mutex> guard(cache_mutex_);
+  cache->AddStats(&retired_stats_);
+  caches_.erase(cache);
+}
+
+ThreadCachedAllocatorStats ThreadCachedAllocator::CentralPool::GetStats() {
+  std::lock_guard<std::mutex> guard(cache_mutex_);
+  ThreadCachedAllocatorStats stats = retired_stats_;
+  for (auto *cache : caches_) {
+    cache->AddStats(&stats);
+  }
+  stats.reserved_size = reserved_size_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+size_t ThreadCachedAllocator::SizeClassOf(size_t size) {
+  if (size <= kSmallClassMaxSize) {
+    return std::max((size + kAlignment - 1) / kAlignment, size_t(1)) - 1;
+  }
+  // size is in (2^p, 2^(p+1)], which is split into kSubClassNum classes
+  size_t p = 0;
+  for (size_t s = size - 1; s > 1; s >>= 1) {
+    ++p;
+  }
+  size_t base = size_t(1) << p;
+  size_t step = base / kSubClassNum;
+  size_t log_small = 0;
+  for (size_t s = kSmallClassMaxSize; s > 1; s >>= 1) {
+    ++log_small;
+  }
+  return kSmallClassNum + (p - log_small) * kSubClassNum +
+         (size - base + step - 1) / step - 1;
+}
+
+size_t ThreadCachedAllocator::ClassSize(size_t size_class) {
+  if (size_class < kSmallClassNum) {
+    return (size_class + 1) * kAlignment;
+  }
+  size_t i = size_class - kSmallClassNum;
+  size_t base = kSmallClassMaxSize << (i / kSubClassNum);
+  return base + (i % kSubClassNum + 1) * (base / kSubClassNum);
+}
+
+ThreadCachedAllocator::ThreadCachedAllocator(
+    const std::shared_ptr<Allocator> &underlying_allocator,
+    size_t max_cached_size, size_t class_cache_size)
+    : pool_(std::make_shared<CentralPool>(
+          underlying_allocator, std::max(max_cached_size, kAlignment),
+          class_cache_size)),
+      id_(++g_thread_cached_id) {}
+
+ThreadCachedAllocator::ThreadCache *ThreadCachedAllocator::GetThreadCache() {
+  // The caches of a thread live until the thread exits, and keep the pool of
+  // their allocator alive.
+  struct ThreadCacheMap {
+    uint64_t last_id{0};
+    ThreadCache *last_cache{nullptr};
+    std::unordered_map<uint64_t, std::unique_ptr<ThreadCache>> caches;
+  };
+  static thread_local ThreadCacheMap cache_map;
+  if (LIKELY(cache_map.last_id == id_)) {
+    return cache_map.last_cache;
+  }
+  auto &cache = cache_map.caches[id_];
+  if (cache == nullptr) {
+    cache.reset(new ThreadCache(pool_));
+  }
+  cache_map.last_id = id_;
+  cache_map.last_cache = cache.get();
+  return cache.get();
+}
+
+Allocation *ThreadCachedAllocator::AllocateImpl(size_t size) {
+  return GetThreadCache()->Allocate(size);
+}
+
+void ThreadCachedAllocator::FreeImpl(Allocation *allocation) {
+  auto *cached_allocation = static_cast<ThreadCachedAllocation *>(allocation);
+  if (cached_allocation->size_class() != kLargeSizeClass) {
+    GetThreadCache()->Free(cached_allocation);
+  }
+  delete cached_allocation;
+}
+
+uint64_t ThreadCachedAllocator::ReleaseImpl(const platform::Place &place) {
+  GetThreadCache()->Flush();
+  if (VLOG_IS_ON(3)) {
+    auto stats = GetStats();
+    VLOG(3) << "ThreadCachedAllocator hit " << stats.hit_num << ", miss "
+            << stats.miss_num << ", large " << stats.large_num
+            << ", remote free " << stats.remote_free_num << ", reserved "
+            << stats.reserved_size << ", fragmentation "
+            << stats.Fragmentation();
+  }
+  return 0;
+}
+
+ThreadCachedAllocatorStats ThreadCachedAllocator::GetStats() const {
+  return pool_->GetStats();
+}
+
+}  // namespace allocation
+}  // namespace memory
+}  // namespace paddle
@@ -0,0 +1,101 @@
+// Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <memory>
+
+#include "paddle/fluid/memory/allocation/allocator.h"
+
+namespace paddle {
+namespace memory {
+namespace allocation {
+
+struct ThreadCachedAllocatorStats {
+  // allocations served by the cache of the calling thread
+  uint64_t hit_num{0};
+  // allocations that refilled the thread cache from the central pool
+  uint64_t miss_num{0};
+  // allocations larger than the max cached size, which are passed to the
+  // underlying allocator
+  uint64_t large_num{0};
+  // frees of blocks allocated by another thread
+  uint64_t remote_free_num{0};
+  // bytes of the chunks taken from the underlying allocator
+  uint64_t reserved_size{0};
+  // bytes of the size-classed blocks in use, and the bytes requested for them
+  uint64_t block_size{0};
+  uint64_t request_size{0};
+
+  // the part of the reserved bytes not requested by any live allocation,
+  // i.e. class rounding plus blocks cached in free lists
+  double Fragmentation() const {
+    return reserved_size == 0
+               ? 0.
+               : 1. - static_cast<double>(request_size) / reserved_size;
+  }
+  // the part of the blocks in use lost to class rounding
+  double InternalFragmentation() const {
+    return block_size == 0
+               ? 0.
+               : 1. - static_cast<double>(request_size) / block_size;
+  }
+};
+
+// ThreadCachedAllocator serves small CPU allocations from per-thread free
+// lists of size-classed blocks, so that the executor threads do not meet on
+// the lock of the underlying allocator. The blocks are carved from chunks of
+// the underlying allocator and move between the thread caches and a central
+// pool in batches: a thread refills an empty list with half a cache at once,
+// and a list that overflows, e.g. because the thread frees blocks allocated
+// elsewhere, returns half of it in one go.
+//
+// Allocations larger than max_cached_size go to the underlying allocator.
+// Chunks are kept until the allocator and all the thread caches are gone.
+class ThreadCachedAllocator : public Allocator {
+ public:
+  // A thread caches up to class_cache_size bytes of free blocks per class.
+  ThreadCachedAllocator(const std::shared_ptr<Allocator> &underlying_allocator,
+                        size_t max_cached_size, size_t class_cache_size);
+
+  bool IsAllocThreadSafe() const override { return true; }
+
+  ThreadCachedAllocatorStats GetStats() const;
+
+  // Size classes are multiples of kAlignment up to 1KB, then four classes
+  // per power of two.
+  static size_t SizeClassOf(size_t size);
+  static size_t ClassSize(size_t size_class);
+
+  static constexpr size_t kAlignment = 64;
+
+ protected:
+  Allocation *AllocateImpl(size_t size) override;
+  void FreeImpl(Allocation *allocation) override;
+  // Returns the blocks cached by the calling thread to the central pool.
+  uint64_t ReleaseImpl(const platform::Place &place) override;
+
+ private:
+  class CentralPool;
+  class ThreadCache;
+
+  ThreadCache *GetThreadCache();
+
+  std::shared_ptr<CentralPool> pool_;
+  uint64_t id_;
+};
+
+}  // namespace allocation
+}  // namespace memory
+}  // namespace paddle
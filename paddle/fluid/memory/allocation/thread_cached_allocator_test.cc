@@ -0,0 +1,141 @@
+// Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/memory/allocation/thread_cached_allocator.h"
+
+#include <cstring>
+#include <random>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/memory/allocation/cpu_allocator.h"
+
+namespace paddle {
+namespace memory {
+namespace allocation {
+
+static std::shared_ptr<ThreadCachedAllocator> CreateAllocator() {
+  return std::make_shared<ThreadCachedAllocator>(
+      std::make_shared<CPUAllocator>(), 256 << 10, 64 << 10);
+}
+
+TEST(ThreadCachedAllocator, size_class) {
+  size_t size_class = ThreadCachedAllocator::SizeClassOf(1);
+  ASSERT_EQ(size_class, 0UL);
+  for (size_t size = 1; size <= (1 << 20); size += 7) {
+    size_t next_class = ThreadCachedAllocator::SizeClassOf(size);
+    size_t class_size = ThreadCachedAllocator::ClassSize(next_class);
+    ASSERT_GE(class_size, size);
+    ASSERT_EQ(class_size % ThreadCachedAllocator::kAlignment, 0UL);
+    // the class is the smallest one holding the size
+    if (next_class > 0) {
+      ASSERT_LT(ThreadCachedAllocator::ClassSize(next_class - 1), size);
+    }
+    ASSERT_LE(class_size - size, std::max(size / 4, size_t(64)));
+    ASSERT_TRUE(next_class == size_class || next_class == size_class + 1);
+    size_class = next_class;
+  }
+}
+
+TEST(ThreadCachedAllocator, reuse) {
+  auto allocator = CreateAllocator();
+  void *ptr = nullptr;
+  {
+    auto allocation = allocator->Allocate(100);
+    ptr = allocation->ptr();
+    ASSERT_EQ(allocation->size(), 128UL);
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(ptr) %
+                  ThreadCachedAllocator::kAlignment,
+              0UL);
+    memset(ptr, 0, 100);
+  }
+  auto allocation = allocator->Allocate(120);
+  ASSERT_EQ(allocation->ptr(), ptr);
+  auto large_allocation = allocator->Allocate(1 << 20);
+  ASSERT_EQ(large_allocation->size(), 1UL << 20);
+
+  auto stats = allocator->GetStats();
+  ASSERT_EQ(stats.miss_num, 1UL);
+  ASSERT_EQ(stats.hit_num, 1UL);
+  ASSERT_EQ(stats.large_num, 1UL);
+  ASSERT_EQ(stats.block_size, 128UL);
+  ASSERT_EQ(stats.request_size, 120UL);
+  ASSERT_GT(stats.reserved_size, 0UL);
+  ASSERT_GT(stats.Fragmentation(), 0.);
+}
+
+TEST(ThreadCachedAllocator, multi_thread) {
+  auto allocator = CreateAllocator();
+  const int thread_num = 8;
+  const int alloc_num = 10000;
+  // every thread frees the allocations of the next one, so that the blocks
+  // move between the thread caches through the central pool
+  std::vector<std::vector<AllocationPtr>> allocations(thread_num);
+  auto allocate = [&](int i) {
+    std::mt19937 rng(i);
+    std::uniform_int_distribution<size_t> distrib(1, 8192);
+    for (int j = 0; j < alloc_num; ++j) {
+      size_t size = distrib(rng);
+      auto allocation = allocator->Allocate(size);
+      memset(allocation->ptr(), i, size);
+      if (j % 2 == 0) {
+        allocations[i].emplace_back(std::move(allocation));
+      }
+    }
+  };
+  std::vector<std::thread> threads;
+  for (int i = 0; i < thread_num; ++i) {
+    threads.emplace_back(allocate, i);
+  }
+  for (auto &th : threads) {
+    th.join();
+  }
+  for (int i = 0; i < thread_num; ++i) {
+    for (auto &allocation : allocations[i]) {
+      auto *data = static_cast<unsigned char *>(allocation->ptr());
+      ASSERT_EQ(data[0], i);
+    }
+  }
+
+  threads.clear();
+  for (int i = 0; i < thread_num; ++i) {
+    threads.emplace_back([&, i] { allocations[(i + 1) % thread_num].clear(); });
+  }
+  for (auto &th : threads) {
+    th.join();
+  }
+  threads.clear();
+  for (int i = 0; i < thread_num; ++i) {
+    threads.emplace_back([&, i] {
+      allocate(i);
+      allocations[i].clear();
+    });
+  }
+  for (auto &th : threads) {
+    th.join();
+  }
+
+  auto stats = allocator->GetStats();
+  ASSERT_EQ(stats.hit_num + stats.miss_num, 2UL * thread_num * alloc_num);
+  ASSERT_GT(stats.hit_num, stats.miss_num);
+  ASSERT_GT(stats.remote_free_num, 0UL);
+  ASSERT_EQ(stats.block_size, 0UL);
+  ASSERT_EQ(stats.request_size, 0UL);
+  ASSERT_EQ(stats.Fragmentation(), 1.);
+}
+
+}  // namespace allocation
+}  // namespace memory
+}  // namespace paddle
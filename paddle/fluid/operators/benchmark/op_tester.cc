@@ -13,23 +13,113 @@ See the License for the specific language governing permissions and
 limitations under the License. */
 
 #include "paddle/fluid/operators/benchmark/op_tester.h"
+#include <algorithm>
+#include <cmath>
 #include <fstream>
+#include <map>
+#include <numeric>
+#include <utility>
 #include "gflags/gflags.h"
 #include "gtest/gtest.h"
 #include "paddle/fluid/framework/op_info.h"
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/framework/variable_helper.h"
+#include "paddle/fluid/platform/cpu_helper.h"
 #include "paddle/fluid/platform/init.h"
 #include "paddle/fluid/platform/profiler.h"
 #include "paddle/fluid/platform/timer.h"
 #include "paddle/fluid/pybind/pybind.h"
 
+DECLARE_int32(paddle_num_threads);
+
 namespace paddle {
 namespace operators {
 namespace benchmark {
 
-DEFINE_string(op_config_list, "", "Path of op config file.");
+DEFINE_string(op_config_list, "",
+              "Path of op config file, or comma separated paths.");
 DEFINE_int32(specified_config_id, -1, "Test the specified op config.");
+DEFINE_string(op_threads, "",
+              "Comma separated CPU threads to run the op configs with, "
+              "used by the configs without threads.");
+DEFINE_string(op_benchmark_json, "", "Path to write the results as JSON.");
+DEFINE_string(op_benchmark_baseline, "",
+              "Path of the JSON results to compare the p50 latencies with.");
+DEFINE_double(op_benchmark_regression_threshold, 0.1,
+              "The test fails if a p50 latency is more than (1 + threshold) "
+              "times of the baseline.");
+
+std::string OpBenchmarkResult::ToJson() const {
+  std::stringstream ss;
+  ss << "{\"name\": \"" << name << "\", \"op_type\": \"" << op_type
+     << "\", \"threads\": " << threads << ", \"repeat\": " << repeat
+     << ", \"mean_ms\": " << mean_ms << ", \"min_ms\": " << min_ms
+     << ", \"p50_ms\": " << p50_ms << ", \"p99_ms\": " << p99_ms
+     << ", \"gbps\": " << gbps << ", \"gflops\": " << gflops << "}";
+  return ss.str();
+}
+
+double Percentile(const std::vector<double> &sorted, double p) {
+  if (sorted.empty()) {
+    return 0.0;
+  }
+  size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * sorted.size()));
+  rank = std::min(std::max<size_t>(rank, 1), sorted.size());
+  return sorted[rank - 1];
+}
+
+void WriteBenchmarkResults(const std::vector<OpBenchmarkResult> &results,
+                           std::ostream &os) {
+  os << "[\n";
+  for (size_t i = 0; i < results.size(); ++i) {
+    os << results[i].ToJson() << (i + 1 < results.size() ? ",\n" : "\n");
+  }
+  os << "]\n";
+}
+
+std::unordered_map<std::string, double> ReadBenchmarkBaseline(
+    std::istream &is) {
+  const std::string name_key = "\"name\": \"";
+  const std::string p50_key = "\"p50_ms\": ";
+  std::unordered_map<std::string, double> baseline;
+  std::string line;
+  while (std::getline(is, line)) {
+    size_t name_pos = line.find(name_key);
+    size_t p50_pos = line.find(p50_key);
+    if (name_pos == std::string::npos || p50_pos == std::string::npos) {
+      continue;
+    }
+    name_pos += name_key.length();
+    size_t name_end = line.find('"', name_pos);
+    if (name_end == std::string::npos) {
+      continue;
+    }
+    baseline[line.substr(name_pos, name_end - name_pos)] =
+        StringTo<double>(line.substr(p50_pos + p50_key.length()));
+  }
+  return baseline;
+}
+
+std::vector<std::string> CheckBenchmarkRegression(
+    const std::vector<OpBenchmarkResult> &results,
+    const std::unordered_map<std::string, double> &baseline,
+    double threshold) {
+  std::vector<std::string> regressions;
+  for (auto &result : results) {
+    auto it = baseline.find(result.name);
+    if (it == baseline.end()) {
+      VLOG(3) << "No baseline of " << result.name;
+      continue;
+    }
+    if (result.p50_ms > it->second * (1.0 + threshold)) {
+      std::stringstream ss;
+      ss << result.name << ": p50 " << result.p50_ms << " ms, baseline "
+         << it->second << " ms";
+      regressions.push_back(ss.str());
+    }
+  }
+  return regressions;
+}
 
 void OpTester::Init(const std::string &filename) {
   Init(OpTesterConfig(filename));
@@ -69,10 +159,16 @@ void OpTester::Run() {
     LOG(INFO) << DebugString();
   }
 
-  // Warm up
-  RunImpl();
+  std::vector<int> threads = config_.threads;
+  if (threads.empty()) {
+    threads = ParseIntList(FLAGS_op_threads);
+  }
+  if (!platform::is_cpu_place(place_)) {
+    threads = {0};
+  } else if (threads.empty()) {
+    threads = {FLAGS_paddle_num_threads};
+  }
 
-  platform::Timer timer;
   if (config_.profile) {
     if (platform::is_cpu_place(place_)) {
       platform::EnableProfiler(platform::ProfilerState::kCPU);
@@ -85,24 +181,48 @@ void OpTester::Run() {
           "'CUDAPlace' is not supported in CPU only device."));
 #endif
     }
+  }
+
+  results_.clear();
+  for (int num_threads : threads) {
+    if (num_threads > 0) {
+      platform::SetNumThreads(num_threads);
+    }
 
-    timer.Start();
-    for (int i = config_.repeat; i > 0; --i) {
+    // Warm up
+    for (int i = 0; i < config_.warmup; ++i) {
       RunImpl();
     }
-    timer.Pause();
-    platform::DisableProfiler(platform::EventSortingKey::kDefault,
-                              "op_tester_profiler");
-  } else {
-    timer.Start();
-    for (int i = config_.repeat; i > 0; --i) {
+
+    std::vector<double> latencies;
+    latencies.reserve(config_.repeat);
+    platform::Timer timer;
+    for (int i = 0; i < config_.repeat; ++i) {
+      timer.Start();
       RunImpl();
+      timer.Pause();
+      latencies.push_back(timer.ElapsedMS());
     }
-    timer.Pause();
+    results_.push_back(Summarize(std::move(latencies), num_threads));
+
+    const auto &result = results_.back();
+    LOG(INFO) << "=== Run " << result.name << " " << config_.repeat
+              << " times, latency: " << result.mean_ms
+              << " ms, p50: " << result.p50_ms << " ms, p99: "
+              << result.p99_ms << " ms, " << result.gbps << " GB/s, "
+              << result.gflops << " GFLOP/s ===";
+  }
+
+  // Restore the default set by InitDevices for the following configs.
+  if (platform::is_cpu_place(place_)) {
+    platform::SetNumThreads(FLAGS_paddle_num_threads);
+  }
+
+  if (config_.profile) {
+    platform::DisableProfiler(platform::EventSortingKey::kDefault,
+                              "op_tester_profiler");
   }
-  config_.runtime = timer.ElapsedMS() / config_.repeat;
-  LOG(INFO) << "=== Run " << config_.repeat
-            << " times, latency: " << config_.runtime << " ms ===";
+  config_.runtime = results_.back().mean_ms;
 }
 
 void OpTester::RunImpl() {
@@ -111,15 +231,68 @@ void OpTester::RunImpl() {
   scope_->DropKids();
 }
 
-std::vector<std::string> OpTester::GetOpProtoInputNames() {
-  std::vector<std::string> input_names;
-  const framework::proto::OpProto &proto =
-      framework::OpInfoMap::Instance().Get(type_).Proto();
-  for (int i = 0; i != proto.inputs_size(); ++i) {
-    const auto &input = proto.inputs(i);
-    input_names.push_back(input.name());
+std::string OpTester::BenchmarkName(int threads) {
+  std::stringstream ss;
+  ss << config_.op_type << "[";
+  for (size_t i = 0; i < config_.inputs.size(); ++i) {
+    const auto &input = config_.inputs[i];
+    ss << (i > 0 ? "," : "") << input.name << "=";
+    for (size_t j = 0; j < input.dims.size(); ++j) {
+      ss << (j > 0 ? "x" : "") << input.dims[j];
+    }
+  }
+  ss << "]";
+  // sorted by the names to be the same in every run
+  std::map<std::string, std::string> attrs(config_.attrs.begin(),
+                                           config_.attrs.end());
+  if (!attrs.empty()) {
+    ss << "{";
+    for (auto it = attrs.begin(); it != attrs.end(); ++it) {
+      ss << (it != attrs.begin() ? "," : "") << it->first << "=" << it->second;
+    }
+    ss << "}";
+  }
+  ss << " threads=" << threads;
+  return ss.str();
+}
+
+size_t OpTester::MemorySize() {
+  size_t size = 0;
+  for (auto &item : vars_) {
+    auto *var = scope_->FindVar(item.first);
+    if (var != nullptr && var->IsType<framework::LoDTensor>()) {
+      const auto &tensor = var->Get<framework::LoDTensor>();
+      if (tensor.IsInitialized()) {
+        size += tensor.memory_size();
+      }
+    }
   }
-  return input_names;
+  return size;
+}
+
+OpBenchmarkResult OpTester::Summarize(std::vector<double> latencies,
+                                      int threads) {
+  std::sort(latencies.begin(), latencies.end());
+  OpBenchmarkResult result;
+  result.name = BenchmarkName(threads);
+  result.op_type = config_.op_type;
+  result.threads = threads;
+  result.repeat = static_cast<int>(latencies.size());
+  if (latencies.empty()) {
+    return result;
+  }
+  result.mean_ms =
+      std::accumulate(latencies.begin(), latencies.end(), 0.0) /
+      latencies.size();
+  result.min_ms = latencies.front();
+  result.p50_ms = Percentile(latencies, 50);
+  result.p99_ms = Percentile(latencies, 99);
+  if (result.p50_ms > 0) {
+    double seconds = result.p50_ms / 1000.0;
+    result.gbps = MemorySize() / seconds / 1e9;
+    result.gflops = config_.flops / seconds / 1e9;
+  }
+  return result;
 }
 
 std::vector<std::string> OpTester::GetOpProtoOutputNames() {
@@ -170,38 +343,67 @@ framework::proto::VarType::Type OpTester::TransToVarType(std::string str) {
 }
 
 void OpTester::CreateInputVarDesc() {
-  std::vector<std::string> input_names = GetOpProtoInputNames();
-  for (auto &name : input_names) {
-    const OpInputConfig *input = config_.GetInput(name);
-    PADDLE_ENFORCE_NOT_NULL(
-        input, platform::errors::NotFound(
-                   "The input %s of operator %s is not correctlly provided.",
-                   name, config_.op_type));
-
-    std::string var_name = config_.op_type + "." + name;
-    framework::VarDesc *var = Var(var_name);
-    // Need to support more type
-    var->SetType(framework::proto::VarType::LOD_TENSOR);
-    var->SetPersistable(false);
-    var->SetDataType(TransToVarType(input->dtype));
-    var->SetShape(input->dims);
-
-    op_desc_.SetInput(name, {var_name});
-    inputs_[var_name] = *input;
+  const framework::proto::OpProto &proto =
+      framework::OpInfoMap::Instance().Get(type_).Proto();
+  for (int i = 0; i != proto.inputs_size(); ++i) {
+    const auto &proto_input = proto.inputs(i);
+    const std::string &name = proto_input.name();
+    std::vector<const OpInputConfig *> inputs = config_.GetInputs(name);
+    if (inputs.empty() && proto_input.dispensable()) {
+      continue;
+    }
+    PADDLE_ENFORCE_EQ(
+        inputs.empty(), false,
+        platform::errors::NotFound(
+            "The input %s of operator %s is not correctlly provided.", name,
+            config_.op_type));
+    PADDLE_ENFORCE_EQ(
+        inputs.size() == 1 || proto_input.duplicable(), true,
+        platform::errors::InvalidArgument(
+            "The input %s of operator %s is not duplicable, but %d inputs "
+            "are provided.",
+            name, config_.op_type, inputs.size()));
+
+    std::vector<std::string> var_names;
+    for (size_t j = 0; j < inputs.size(); ++j) {
+      std::string var_name = config_.op_type + "." + name;
+      if (inputs.size() > 1) {
+        var_name += "." + std::to_string(j);
+      }
+      framework::VarDesc *var = Var(var_name);
+      // Need to support more type
+      var->SetType(framework::proto::VarType::LOD_TENSOR);
+      var->SetPersistable(false);
+      var->SetDataType(TransToVarType(inputs[j]->dtype));
+      var->SetShape(inputs[j]->dims);
+
+      var_names.push_back(var_name);
+      inputs_[var_name] = *inputs[j];
+    }
+    op_desc_.SetInput(name, var_names);
   }
 }
 
 void OpTester::CreateOutputVarDesc() {
   std::vector<std::string> output_names = GetOpProtoOutputNames();
   for (auto &name : output_names) {
-    std::string var_name = config_.op_type + "." + name;
-    framework::VarDesc *var = Var(var_name);
-    // Need to support more type
-    var->SetType(framework::proto::VarType::LOD_TENSOR);
-    var->SetPersistable(false);
-    var->SetDataType(framework::proto::VarType::FP32);
+    auto it = config_.output_nums.find(name);
+    int num = it != config_.output_nums.end() ? it->second : 1;
+    std::vector<std::string> var_names;
+    for (int j = 0; j < num; ++j) {
+      std::string var_name = config_.op_type + "." + name;
+      if (num > 1) {
+        var_name += "." + std::to_string(j);
+      }
+      framework::VarDesc *var = Var(var_name);
+      // Need to support more type
+      var->SetType(framework::proto::VarType::LOD_TENSOR);
+      var->SetPersistable(false);
+      var->SetDataType(framework::proto::VarType::FP32);
 
-    op_desc_.SetOutput(name, {var_name});
+      var_names.push_back(var_name);
+    }
+    op_desc_.SetOutput(name, var_names);
   }
 }
 
@@ -219,8 +421,10 @@ void OpTester::CreateOpDesc() {
     const std::string &value_str = item.second;
     const framework::proto::AttrType &type = attr_types[name];
     switch (type) {
-      case framework::proto::AttrType::BOOLEAN:
-        break;
+      case framework::proto::AttrType::BOOLEAN: {
+        bool value = value_str == "true" || value_str == "1";
+        op_desc_.SetAttr(name, value);
+      } break;
       case framework::proto::AttrType::INT: {
         int value = StringTo<int>(value_str);
         op_desc_.SetAttr(name, {value});
@@ -283,20 +487,20 @@ void OpTester::SetupTensor(framework::LoDTensor *tensor,
   }
 
   if (initializer == "random") {
-    for (int i = 0; i < cpu_tensor.numel(); ++i) {
+    for (int i = 0; i < tensor->numel(); ++i) {
       cpu_ptr[i] = static_cast<T>(uniform_dist(rng) * (upper - lower) + lower);
     }
   } else if (initializer == "natural") {
-    for (int i = 0; i < cpu_tensor.numel(); ++i) {
+    for (int i = 0; i < tensor->numel(); ++i) {
       cpu_ptr[i] = static_cast<T>(lower + i);
     }
   } else if (initializer == "zeros") {
-    for (int i = 0; i < cpu_tensor.numel(); ++i) {
+    for (int i = 0; i < tensor->numel(); ++i) {
       cpu_ptr[i] = static_cast<T>(0);
     }
   } else if (initializer == "file") {
     std::ifstream is(filename);
-    for (int i = 0; i < cpu_tensor.numel(); ++i) {
+    for (int i = 0; i < tensor->numel(); ++i) {
       T value;
       is >> value;
       cpu_ptr[i] = static_cast<T>(value);
@@ -413,15 +617,17 @@ std::string OpTester::DebugString() {
   for (auto &name : op_desc_.InputNames()) {
     ss << GenSpaces(count++) << "inputs {\n";
     ss << GenSpaces(count) << "parameters: \"" << name << "\"\n";
-    ss << GenSpaces(count) << "arguments: \"" << op_desc_.Input(name)[0]
-       << "\"\n";
+    for (auto &argument : op_desc_.Input(name)) {
+      ss << GenSpaces(count) << "arguments: \"" << argument << "\"\n";
+    }
     ss << GenSpaces(--count) << "}\n";
   }
   for (auto &name : op_desc_.OutputNames()) {
     ss << GenSpaces(count++) << "outputs {\n";
     ss << GenSpaces(count) << "parameters: \"" << name << "\"\n";
-    ss << GenSpaces(count) << "arguments: \"" << op_desc_.Output(name)[0]
-       << "\"\n";
+    for (auto &argument : op_desc_.Output(name)) {
+      ss << GenSpaces(count) << "arguments: \"" << argument << "\"\n";
+    }
     ss << GenSpaces(--count) << "}\n";
   }
   ss << GenSpaces(count) << "type: " << op_desc_.Type() << "\n";
@@ -488,36 +694,48 @@ std::string OpTester::DebugString() {
   return ss.str();
 }
 
+static void ReadConfigs(const std::string &filename,
+                        std::vector<OpTesterConfig> *op_configs) {
+  std::ifstream fin(filename, std::ios::in | std::ios::binary);
+  PADDLE_ENFORCE_EQ(static_cast<bool>(fin), true,
+                    platform::errors::InvalidArgument(
+                        "OpTester cannot open file %s", filename.c_str()));
+  while (!fin.eof()) {
+    VLOG(4) << "Reading config " << op_configs->size() << "...";
+    OpTesterConfig config;
+    bool result = config.Init(fin);
+    if (result) {
+      op_configs->push_back(config);
+    }
+  }
+}
+
 TEST(op_tester, base) {
+  std::vector<OpBenchmarkResult> results;
+  auto run = [&results](const OpTesterConfig &config) {
+    OpTester tester;
+    tester.Init(config);
+    tester.Run();
+    results.insert(results.end(), tester.Results().begin(),
+                   tester.Results().end());
+  };
+
   if (!FLAGS_op_config_list.empty()) {
-    std::ifstream fin(FLAGS_op_config_list, std::ios::in | std::ios::binary);
-    PADDLE_ENFORCE_EQ(
-        static_cast<bool>(fin), true,
-        platform::errors::InvalidArgument("OpTester cannot open file %s",
-                                          FLAGS_op_config_list.c_str()));
     std::vector<OpTesterConfig> op_configs;
-    while (!fin.eof()) {
-      VLOG(4) << "Reading config " << op_configs.size() << "...";
-      OpTesterConfig config;
-      bool result = config.Init(fin);
-      if (result) {
-        op_configs.push_back(config);
-      }
+    std::string filename;
+    std::istringstream filenames(FLAGS_op_config_list);
+    while (std::getline(filenames, filename, ',')) {
+      ReadConfigs(filename, &op_configs);
     }
     if (FLAGS_specified_config_id >= 0 &&
         FLAGS_specified_config_id < static_cast<int>(op_configs.size())) {
-      OpTester tester;
-      tester.Init(op_configs[FLAGS_specified_config_id]);
-      tester.Run();
+      run(op_configs[FLAGS_specified_config_id]);
     } else {
       for (size_t i = 0; i < op_configs.size(); ++i) {
-        OpTester tester;
-        tester.Init(op_configs[i]);
-        tester.Run();
+        run(op_configs[i]);
       }
     }
   } else {
-    OpTester tester;
     OpTesterConfig config;
     config.op_type = "elementwise_add";
     config.inputs.resize(2);
@@ -525,11 +743,62 @@ TEST(op_tester, base) {
     config.inputs[0].dims = {64, 64};
     config.inputs[1].name = "Y";
     config.inputs[1].dims = {64, 1};
-    tester.Init(config);
-    tester.Run();
+    run(config);
+  }
+
+  if (!FLAGS_op_benchmark_json.empty()) {
+    std::ofstream fout(FLAGS_op_benchmark_json);
+    PADDLE_ENFORCE_EQ(static_cast<bool>(fout), true,
+                      platform::errors::InvalidArgument(
+                          "OpTester cannot open file %s",
+                          FLAGS_op_benchmark_json.c_str()));
+    WriteBenchmarkResults(results, fout);
+  }
+  if (!FLAGS_op_benchmark_baseline.empty()) {
+    std::ifstream fin(FLAGS_op_benchmark_baseline);
+    PADDLE_ENFORCE_EQ(static_cast<bool>(fin), true,
+                      platform::errors::InvalidArgument(
+                          "OpTester cannot open file %s",
+                          FLAGS_op_benchmark_baseline.c_str()));
+    std::vector<std::string> regressions = CheckBenchmarkRegression(
+        results, ReadBenchmarkBaseline(fin),
+        FLAGS_op_benchmark_regression_threshold);
+    for (auto &regression : regressions) {
+      LOG(ERROR) << "Regression of " << regression;
+    }
+    EXPECT_TRUE(regressions.empty());
   }
 }
 
+TEST(op_tester, benchmark_result) {
+  std::vector<double> latencies = {1.0, 2.0, 3.0, 4.0};
+  EXPECT_EQ(Percentile(latencies, 50), 2.0);
+  EXPECT_EQ(Percentile(latencies, 99), 4.0);
+  EXPECT_EQ(Percentile(latencies, 0), 1.0);
+  EXPECT_EQ(Percentile({}, 50), 0.0);
+
+  std::vector<OpBenchmarkResult> results(2);
+  results[0].name = "fc[Input=64x1024] threads=1";
+  results[0].p50_ms = 0.5;
+  results[1].name = "fc[Input=64x1024] threads=4";
+  results[1].p50_ms = 0.25;
+  std::stringstream ss;
+  WriteBenchmarkResults(results, ss);
+  auto baseline = ReadBenchmarkBaseline(ss);
+  ASSERT_EQ(baseline.size(), 2UL);
+  EXPECT_EQ(baseline[results[0].name], 0.5);
+  EXPECT_EQ(baseline[results[1].name], 0.25);
+
+  EXPECT_TRUE(CheckBenchmarkRegression(results, baseline, 0.1).empty());
+  results[1].p50_ms = 0.3;
+  results.emplace_back();
+  results.back().name = "softmax[X=64x1024] threads=1";
+  results.back().p50_ms = 1.0;
+  auto regressions = CheckBenchmarkRegression(results, baseline, 0.1);
+  ASSERT_EQ(regressions.size(), 1UL);
+  EXPECT_EQ(regressions[0].find(results[1].name), 0UL);
+}
+
 }  // namespace benchmark
 }  // namespace operators
 }  // namespace paddle
@@ -14,6 +14,7 @@ limitations under the License. */
 
 #pragma once
 
+#include <istream>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -27,6 +28,40 @@ namespace paddle {
 namespace operators {
 namespace benchmark {
 
+// The statistics of the runs of an op config with a number of threads.
+struct OpBenchmarkResult {
+  std::string name;  // the op, its inputs, its attrs and the threads
+  std::string op_type;
+  int threads{0};  // 0: the default threads
+  int repeat{0};
+  double mean_ms{0.0};
+  double min_ms{0.0};
+  double p50_ms{0.0};
+  double p99_ms{0.0};
+  double gbps{0.0};    // the bytes of the inputs and outputs per second
+  double gflops{0.0};  // 0 if the flops of the config are not given
+
+  std::string ToJson() const;
+};
+
+// The p-th percentile, by the nearest rank, of the sorted latencies.
+double Percentile(const std::vector<double> &sorted, double p);
+
+// Writes the results as a JSON array with an object per line.
+void WriteBenchmarkResults(const std::vector<OpBenchmarkResult> &results,
+                           std::ostream &os);
+
+// Reads the p50 latencies by the names from the results of
+// WriteBenchmarkResults.
+std::unordered_map<std::string, double> ReadBenchmarkBaseline(
+    std::istream &is);
+
+// The results whose p50 latency is more than (1 + threshold) times of the
+// baseline, with a message each.
+std::vector<std::string> CheckBenchmarkRegression(
+    const std::vector<OpBenchmarkResult> &results,
+    const std::unordered_map<std::string, double> &baseline, double threshold);
+
 class OpTester {
  public:
   OpTester() {}
@@ -38,8 +73,9 @@ class OpTester {
 
   std::string DebugString();
 
+  const std::vector<OpBenchmarkResult> &Results() const { return results_; }
+
  private:
-  std::vector<std::string> GetOpProtoInputNames();
   std::vector<std::string> GetOpProtoOutputNames();
   std::unordered_map<std::string, framework::proto::AttrType>
   GetOpProtoAttrNames();
@@ -59,6 +95,10 @@ class OpTester {
 
   void RunImpl();
 
+  std::string BenchmarkName(int threads);
+  size_t MemorySize();
+  OpBenchmarkResult Summarize(std::vector<double> latencies, int threads);
+
  private:
   OpTesterConfig config_;
   std::string type_;
@@ -68,6 +108,7 @@ class OpTester {
   std::unique_ptr<framework::OperatorBase> op_;
   platform::Place place_;
   std::unique_ptr<framework::Scope> scope_;
+  std::vector<OpBenchmarkResult> results_;
 };
 
 }  // namespace benchmark
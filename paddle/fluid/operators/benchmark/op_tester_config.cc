@@ -179,8 +179,17 @@ bool OpTesterConfig::Init(std::istream& is) {
         is >> op_type;
       } else if (sep == "device_id" || sep == "device_id:") {
         is >> device_id;
+      } else if (sep == "warmup" || sep == "warmup:") {
+        is >> warmup;
       } else if (sep == "repeat" || sep == "repeat:") {
         is >> repeat;
+      } else if (sep == "threads" || sep == "threads:") {
+        std::string threads_str;
+        is >> threads_str;
+        EraseEndSep(&threads_str);
+        threads = ParseIntList(threads_str);
+      } else if (sep == "flops" || sep == "flops:") {
+        is >> flops;
       } else if (sep == "profile" || sep == "profile:") {
         is >> profile;
       } else if (sep == "print_debug_string" || sep == "print_debug_string:") {
@@ -190,6 +199,8 @@ bool OpTesterConfig::Init(std::istream& is) {
         inputs.push_back(input_config);
       } else if (sep == "attrs" || sep == "attrs:") {
         ParseAttrs(is);
+      } else if (sep == "outputs" || sep == "outputs:") {
+        ParseOutputs(is);
       } else {
         if (sep != kEndSeparator) {
           return false;
@@ -225,6 +236,34 @@ bool OpTesterConfig::ParseAttrs(std::istream& is) {
   return true;
 }
 
+bool OpTesterConfig::ParseOutputs(std::istream& is) {
+  std::string sep;
+  is >> sep;
+  if (sep == kStartSeparator) {
+    while (true) {
+      std::string name;
+      is >> name;
+      if (name == kEndSeparator) {
+        break;
+      }
+
+      std::string num;
+      is >> num;
+      EraseEndSep(&name, ":");
+      EraseEndSep(&num);
+      VLOG(4) << "outputs: " << name << ", " << num;
+
+      output_nums[name] = StringTo<int>(num);
+      PADDLE_ENFORCE_GT(output_nums[name], 0,
+                        platform::errors::InvalidArgument(
+                            "The number of the output %s should be larger "
+                            "than 0. But received %s.",
+                            name, num));
+    }
+  }
+  return true;
+}
+
 const OpInputConfig* OpTesterConfig::GetInput(const std::string& name) {
   for (size_t i = 0; i < inputs.size(); ++i) {
     if (inputs[i].name == name) {
@@ -234,6 +273,29 @@ const OpInputConfig* OpTesterConfig::GetInput(const std::string& name) {
   return nullptr;
 }
 
+std::vector<const OpInputConfig*> OpTesterConfig::GetInputs(
+    const std::string& name) {
+  std::vector<const OpInputConfig*> result;
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    if (inputs[i].name == name) {
+      result.push_back(&inputs[i]);
+    }
+  }
+  return result;
+}
+
+std::vector<int> ParseIntList(const std::string& str) {
+  std::vector<int> values;
+  std::string token;
+  std::istringstream token_stream(str);
+  while (std::getline(token_stream, token, ',')) {
+    if (!token.empty()) {
+      values.push_back(std::stoi(token));
+    }
+  }
+  return values;
+}
+
 }  // namespace benchmark
 }  // namespace operators
 }  // namespace paddle
@@ -48,14 +48,22 @@ struct OpTesterConfig {
   bool Init(std::istream& is);
 
   bool ParseAttrs(std::istream& is);
+  bool ParseOutputs(std::istream& is);
 
   const OpInputConfig* GetInput(const std::string& name);
+  // All the inputs of the name, more than one for a duplicable input.
+  std::vector<const OpInputConfig*> GetInputs(const std::string& name);
 
   std::string op_type;
   std::vector<OpInputConfig> inputs;
   std::unordered_map<std::string, std::string> attrs;
+  // The number of the variables of a duplicable output, 1 if not given.
+  std::unordered_map<std::string, int> output_nums;
   int device_id{-1};  // CPU: -1
+  int warmup{1};
   int repeat{1};
+  std::vector<int> threads;  // CPU threads to run with, e.g. 1,4,8
+  double flops{0.0};         // floating-point operations of a run
   int profile{0};
   int print_debug_string{0};
   double runtime{0.0};
@@ -70,6 +78,9 @@ static bool Has(const std::vector<std::string>& vec, const std::string& item) {
   return false;
 }
 
+// Parses the comma separated integers, e.g. 1,4,8.
+std::vector<int> ParseIntList(const std::string& str);
+
 template <typename T>
 T StringTo(const std::string& str) {
   std::istringstream is(str);
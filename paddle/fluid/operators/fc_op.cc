@@ -81,10 +81,11 @@ class FCOp : public framework::OperatorWithKernel {
 
     auto& activation_type = ctx->Attrs().Get<std::string>("activation_type");
     if (!activation_type.empty()) {
-      PADDLE_ENFORCE_EQ(activation_type, "relu",
+      PADDLE_ENFORCE_EQ(activation_type == "relu" || activation_type == "gelu",
+                        true,
                         platform::errors::InvalidArgument(
                             "The attribute activation_type of fc is expected "
-                            "to be \"relu\", but received %s.",
+                            "to be \"relu\" or \"gelu\", but received %s.",
                             activation_type.c_str()));
     }
 
@@ -145,7 +146,9 @@ class FCOpMaker : public framework::OpProtoAndCheckerMaker {
         .SetDefault(1)
         .EqualGreaterThan(1);
     AddAttr<std::string>("activation_type",
-                         "Activation type used in fully connected operator.")
+                         "Activation type used in fully connected operator, "
+                         "\"relu\" or \"gelu\". The gelu is the exact one "
+                         "computed with erf, and only supported on CPU.")
         .SetDefault("");
     AddAttr<bool>("use_mkldnn",
                   "(bool, default false) Only used in mkldnn kernel")
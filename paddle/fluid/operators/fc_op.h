@@ -60,6 +60,8 @@ class FCOpKernel : public framework::OpKernel<T> {
     int in_num_col_dims = ctx.Attr<int>("in_num_col_dims");
     bool with_relu =
         (ctx.Attr<std::string>("activation_type") == "relu") ? true : false;
+    bool with_gelu =
+        (ctx.Attr<std::string>("activation_type") == "gelu") ? true : false;
 
     auto w_dims = w->dims();
     bool padding_weights = ctx.Attr<bool>("padding_weights");
@@ -82,7 +84,7 @@ class FCOpKernel : public framework::OpKernel<T> {
     auto& dev_ctx = ctx.template device_context<DeviceContext>();
     math::FCFunctor<DeviceContext, T> fc;
     fc(dev_ctx, M, w_dims1, w_dims0, input_data, w_data, output_data,
-       bias ? bias->data<T>() : NULL, with_relu, padding_weights);
+       bias ? bias->data<T>() : NULL, with_relu, padding_weights, with_gelu);
   }
 };
 
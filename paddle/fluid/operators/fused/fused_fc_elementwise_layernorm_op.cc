@@ -12,7 +12,12 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License. */
 
+#include <algorithm>
+#include <string>
+
 #include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/operators/jit/kernels.h"
+#include "paddle/fluid/operators/math/blas.h"
 
 namespace paddle {
 namespace operators {
@@ -243,6 +248,83 @@ add_out <= elementwise_add(fc_out, Y)
   }
 };
 
+template <typename T>
+class FusedFCElementwiseLayerNormCPUKernel : public framework::OpKernel<T> {
+ public:
+  void Compute(const framework::ExecutionContext &ctx) const override {
+    auto *x = ctx.Input<framework::Tensor>("X");
+    auto *w = ctx.Input<framework::Tensor>("W");
+    auto *y = ctx.Input<framework::Tensor>("Y");
+    auto *bias_0 = ctx.Input<framework::Tensor>("Bias0");
+    auto *bias_1 = ctx.Input<framework::Tensor>("Bias1");
+    auto *scale = ctx.Input<framework::Tensor>("Scale");
+    auto *out = ctx.Output<framework::Tensor>("Out");
+    auto *mean = ctx.Output<framework::Tensor>("Mean");
+    auto *variance = ctx.Output<framework::Tensor>("Variance");
+
+    auto w_dims = w->dims();
+    int N = w_dims[1];
+    int K = w_dims[0];
+    int M = framework::product(x->dims()) / K;
+
+    auto &dev_ctx = ctx.template device_context<platform::CPUDeviceContext>();
+    framework::Tensor fc_out;
+    T *fc_out_data = fc_out.mutable_data<T>({M, N}, ctx.GetPlace());
+    auto blas = math::GetBlas<platform::CPUDeviceContext, T>(dev_ctx);
+    blas.GEMM(false, false, M, N, K, static_cast<T>(1.0), x->data<T>(), K,
+              w->data<T>(), N, static_cast<T>(0.0), fc_out_data, N);
+
+    // fc_out = act(fc_out + bias_0) + y, of the rows in blocks
+    bool with_relu =
+        (ctx.Attr<std::string>("activation_type") == "relu") ? true : false;
+    const T *bias_0_data = bias_0 ? bias_0->data<T>() : nullptr;
+    const T *y_data = y->data<T>();
+    auto vadd =
+        jit::KernelFuncs<jit::VAddTuple<T>, platform::CPUPlace>::Cache().At(N);
+    auto vrelu =
+        jit::KernelFuncs<jit::VReluTuple<T>, platform::CPUPlace>::Cache().At(N);
+    auto bias_relu = jit::KernelFuncs<jit::VAddBiasReluTuple<T>,
+                                      platform::CPUPlace>::Cache()
+                         .At(N);
+    constexpr int block_rows = 8;
+    int block_num = (M + block_rows - 1) / block_rows;
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+    for (int i = 0; i < block_num; ++i) {
+      int begin = i * block_rows;
+      int end = std::min(M, begin + block_rows);
+      T *block_data = fc_out_data + begin * N;
+      if (bias_0_data && with_relu) {
+        bias_relu(bias_0_data, block_data, block_data, end - begin, N);
+      }
+      for (int j = begin; j < end; ++j) {
+        T *row = fc_out_data + j * N;
+        if (bias_0_data && !with_relu) {
+          vadd(bias_0_data, row, row, N);
+        } else if (!bias_0_data && with_relu) {
+          vrelu(row, row, N);
+        }
+        vadd(y_data + j * N, row, row, N);
+      }
+    }
+
+    framework::Tensor mean_tmp, variance_tmp;
+    T *mean_data = mean ? mean->mutable_data<T>(ctx.GetPlace())
+                        : mean_tmp.mutable_data<T>({M}, ctx.GetPlace());
+    T *variance_data =
+        variance ? variance->mutable_data<T>(ctx.GetPlace())
+                 : variance_tmp.mutable_data<T>({M}, ctx.GetPlace());
+    auto layer_norm =
+        jit::KernelFuncs<jit::LayerNormTuple<T>, platform::CPUPlace>::Cache()
+            .At(N);
+    layer_norm(fc_out_data, out->mutable_data<T>(ctx.GetPlace()), mean_data,
+               variance_data, scale ? scale->data<T>() : nullptr,
+               bias_1 ? bias_1->data<T>() : nullptr, M,
+               ctx.Attr<float>("epsilon"), N);
+  }
+};
+
 }  // namespace operators
 }  // namespace paddle
 
@@ -252,3 +334,6 @@ REGISTER_OPERATOR(
     ops::FusedFCElementwiseLayerNormOpMaker,
     paddle::framework::EmptyGradOpMaker<paddle::framework::OpDesc>,
     paddle::framework::EmptyGradOpMaker<paddle::imperative::OpBase>);
+REGISTER_OP_CPU_KERNEL(fused_fc_elementwise_layernorm,
+                       ops::FusedFCElementwiseLayerNormCPUKernel<float>,
+                       ops::FusedFCElementwiseLayerNormCPUKernel<double>);
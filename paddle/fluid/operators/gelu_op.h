@@ -20,6 +20,7 @@ limitations under the License. */
 #include <cmath>
 #include "paddle/fluid/framework/eigen.h"
 #include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/operators/jit/kernels.h"
 #include "paddle/fluid/operators/math/blas.h"
 #include "paddle/fluid/platform/float16.h"
 
@@ -187,6 +188,46 @@ struct GeluGradFunctor {
   }
 };
 
+// Only the CPU gelu runs with the jit kernels.
+template <typename DeviceContext, typename T>
+static inline bool GeluWithJit(const DeviceContext& dev_ctx, const T* x, T* y,
+                               int64_t numel, bool approximate) {
+  return false;
+}
+
+template <typename T>
+static inline bool GeluWithJit(const platform::CPUDeviceContext& dev_ctx,
+                               const T* x, T* y, int64_t numel,
+                               bool approximate) {
+  // the kernels are generated for the size of a chunk and the rest
+  constexpr int chunk_size = 256;
+  auto get_gelu = [approximate](int n) {
+    return approximate
+               ? jit::KernelFuncs<jit::VGeluTanhTuple<T>,
+                                  platform::CPUPlace>::Cache()
+                     .At(n)
+               : jit::KernelFuncs<jit::VGeluTuple<T>,
+                                  platform::CPUPlace>::Cache()
+                     .At(n);
+  };
+  int64_t chunk_num = numel / chunk_size;
+  if (chunk_num > 0) {
+    auto gelu = get_gelu(chunk_size);
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+    for (int64_t i = 0; i < chunk_num; ++i) {
+      gelu(x + i * chunk_size, y + i * chunk_size, chunk_size);
+    }
+  }
+  int rest = static_cast<int>(numel % chunk_size);
+  if (rest > 0) {
+    int64_t offset = chunk_num * chunk_size;
+    get_gelu(rest)(x + offset, y + offset, rest);
+  }
+  return true;
+}
+
 template <typename DeviceContext, typename T>
 class GeluKernel : public framework::OpKernel<T> {
  public:
@@ -195,6 +236,10 @@ class GeluKernel : public framework::OpKernel<T> {
     auto* in = context.Input<framework::Tensor>("X");
     auto approximate = context.Attr<bool>("approximate");
     out->mutable_data<T>(in->place());
+    if (GeluWithJit(context.template device_context<DeviceContext>(),
+                    in->data<T>(), out->data<T>(), in->numel(), approximate)) {
+      return;
+    }
 
     auto eigen_out = framework::EigenVector<T>::Flatten(*out);
     auto eigen_in = framework::EigenVector<T>::Flatten(*in);
@@ -196,6 +196,24 @@ void BenchKernelXYN() {
   }
 }
 
+template <typename KernelTuple, typename PlaceType>
+void BenchKernelBXYRW() {
+  using T = typename KernelTuple::data_type;
+  for (int64_t rows : {1, 128}) {
+    for (int w : TestSizes()) {
+      Tensor bias, x, y;
+      bias.Resize({w});
+      x.Resize({rows * w});
+      y.Resize({rows * w});
+      RandomVec<T>(w, bias.mutable_data<T>(PlaceType()));
+      RandomVec<T>(rows * w, x.mutable_data<T>(PlaceType()));
+      T* y_data = y.mutable_data<T>(PlaceType());
+      BenchAllImpls<KernelTuple, PlaceType>(w, bias.data<T>(), x.data<T>(),
+                                            y_data, rows, w);
+    }
+  }
+}
+
 template <typename KernelTuple, typename PlaceType>
 void BenchKernelLSTM() {
   using T = typename KernelTuple::data_type;
@@ -361,6 +379,83 @@ void BenchKernelSgd() {
   }
 }
 
+template <typename T, typename PlaceType>
+void RandomAdamStates(int64_t numel, Tensor* grad, Tensor* mom1, Tensor* mom2,
+                      Tensor* param) {
+  for (auto* t : {grad, mom1, mom2, param}) {
+    t->Resize({numel});
+  }
+  RandomVec<T>(numel, grad->mutable_data<T>(PlaceType()), -2.f, 2.f);
+  RandomVec<T>(numel, mom1->mutable_data<T>(PlaceType()), -2.f, 2.f);
+  RandomVec<T>(numel, mom2->mutable_data<T>(PlaceType()), 0.f, 2.f);
+  RandomVec<T>(numel, param->mutable_data<T>(PlaceType()), -2.f, 2.f);
+}
+
+template <typename KernelTuple, typename PlaceType>
+void BenchKernelAdam() {
+  using T = typename KernelTuple::data_type;
+  const T lr = 0.001;
+  const T eps = 1e-8;
+  const jit::adam_attr_t attr(0.9, 0.999);
+  for (int64_t numel : {16, 255, 1024, 100000, 1000000}) {
+    // only benchmark inplace
+    Tensor grad, mom1, mom2, param;
+    RandomAdamStates<T, PlaceType>(numel, &grad, &mom1, &mom2, &param);
+    T* mom1_data = mom1.data<T>();
+    T* mom2_data = mom2.data<T>();
+    T* param_data = param.data<T>();
+    BenchAllImpls<KernelTuple, PlaceType>(
+        attr, lr, eps, numel, grad.data<T>(), mom1_data, mom2_data, param_data,
+        mom1_data, mom2_data, param_data, &attr);
+  }
+}
+
+template <typename KernelTuple, typename PlaceType>
+void BenchKernelAdamW() {
+  using T = typename KernelTuple::data_type;
+  const T lr = 0.001;
+  const T eps = 1e-8;
+  const T decay = 0.001 * 0.01;
+  const jit::adam_attr_t attr(0.9, 0.999);
+  for (int64_t numel : {16, 255, 1024, 100000, 1000000}) {
+    Tensor grad, mom1, mom2, param;
+    RandomAdamStates<T, PlaceType>(numel, &grad, &mom1, &mom2, &param);
+    T* mom1_data = mom1.data<T>();
+    T* mom2_data = mom2.data<T>();
+    T* param_data = param.data<T>();
+    BenchAllImpls<KernelTuple, PlaceType>(
+        attr, lr, eps, decay, numel, grad.data<T>(), mom1_data, mom2_data,
+        param_data, mom1_data, mom2_data, param_data, &attr);
+  }
+}
+
+template <typename KernelTuple, typename PlaceType>
+void BenchKernelSparseAdam() {
+  using T = typename KernelTuple::data_type;
+  const T lr = 0.001;
+  const T eps = 1e-8;
+  const int64_t param_h = 100000;
+  for (int64_t width : {1, 8, 11, 64, 256}) {
+    Tensor grad, mom1, mom2, param;
+    RandomAdamStates<T, PlaceType>(param_h * width, &grad, &mom1, &mom2,
+                                   &param);
+    T* mom1_data = mom1.data<T>();
+    T* mom2_data = mom2.data<T>();
+    T* param_data = param.data<T>();
+    for (int64_t rows_size : {1, 100, 10000}) {
+      // sorted and spread rows, like the merged rows of an embedding grad
+      std::vector<int64_t> rows(rows_size);
+      for (int64_t i = 0; i < rows_size; ++i) {
+        rows[i] = i * (param_h / rows_size);
+      }
+      const jit::sparse_adam_attr_t attr(0.9, 0.999, width, rows_size);
+      BenchAllImpls<KernelTuple, PlaceType>(
+          attr, lr, eps, grad.data<T>(), rows.data(), mom1_data, mom2_data,
+          param_data, mom1_data, mom2_data, param_data, &attr);
+    }
+  }
+}
+
 template <typename KernelTuple, typename PlaceType>
 void BenchKernelMatMul() {
   using T = typename KernelTuple::data_type;
@@ -493,6 +588,9 @@ void BenchKernelVBroadcast() {
 #define BenchKernelVScal BenchKernelAXYN
 #define BenchKernelVAddBias BenchKernelAXYN
 
+#define BenchKernelVAddBiasGelu BenchKernelBXYRW
+#define BenchKernelVAddBiasRelu BenchKernelBXYRW
+
 #define BenchKernelVRelu BenchKernelXYN
 #define BenchKernelVIdentity BenchKernelXYN
 #define BenchKernelVSquare BenchKernelXYN
@@ -500,6 +598,9 @@ void BenchKernelVBroadcast() {
 #define BenchKernelVSigmoid BenchKernelXYN
 #define BenchKernelVTanh BenchKernelXYN
 #define BenchKernelVCopy BenchKernelXYN
+#define BenchKernelVErf BenchKernelXYN
+#define BenchKernelVGelu BenchKernelXYN
+#define BenchKernelVGeluTanh BenchKernelXYN
 
 #define BenchKernelHMax BenchKernelXRN
 #define BenchKernelHSum BenchKernelXRN
@@ -527,6 +628,8 @@ BENCH_FP32_CPU(VSub);
 // axyn
 BENCH_FP32_CPU(VScal);
 BENCH_FP32_CPU(VAddBias);
+BENCH_FP32_CPU(VAddBiasGelu);
+BENCH_FP32_CPU(VAddBiasRelu);
 
 // xyn
 BENCH_FP32_CPU(VRelu);
@@ -536,6 +639,9 @@ BENCH_FP32_CPU(VExp);
 BENCH_FP32_CPU(VSigmoid);
 BENCH_FP32_CPU(VTanh);
 BENCH_FP32_CPU(VCopy);
+BENCH_FP32_CPU(VErf);
+BENCH_FP32_CPU(VGelu);
+BENCH_FP32_CPU(VGeluTanh);
 
 // xrn
 BENCH_FP32_CPU(HMax);
@@ -560,6 +666,11 @@ BENCH_FP32_CPU(Softmax);
 BENCH_FP32_CPU(Sgd);
 BENCH_FP32_CPU(VBroadcast);
 
+// optimizers
+BENCH_FP32_CPU(Adam);
+BENCH_FP32_CPU(AdamW);
+BENCH_FP32_CPU(SparseAdam);
+
 // Benchmark all jit kernels including jitcode, mkl and refer.
 // To use this tool, run command: ./benchmark [options...]
 // Options:
@@ -39,7 +39,17 @@ const float ALIGN32_BEG exp_float_consts[] ALIGN32_END = {
     REPEAT_8TIMES(CEPHES_EXP_P5),
     REPEAT_8TIMES(EXP_MAX_INPUT),
     REPEAT_8TIMES(SIGMOID_THRESHOLD_MAX),
-    REPEAT_8TIMES(SIGMOID_THRESHOLD_MIN)};
+    REPEAT_8TIMES(SIGMOID_THRESHOLD_MIN),
+    REPEAT_8TIMES(-0.f),
+    REPEAT_8TIMES(ERF_P),
+    REPEAT_8TIMES(ERF_A1),
+    REPEAT_8TIMES(ERF_A2),
+    REPEAT_8TIMES(ERF_A3),
+    REPEAT_8TIMES(ERF_A4),
+    REPEAT_8TIMES(ERF_A5),
+    REPEAT_8TIMES(GELU_SQRT1_2),
+    REPEAT_8TIMES(GELU_TANH_C),
+    REPEAT_8TIMES(GELU_TANH_K)};
 
 const int ALIGN32_BEG exp_int_0x7f[] ALIGN32_END = {REPEAT_8TIMES(0x7f)};
 int ALIGN32_BEG g_tmp_mem[16] ALIGN32_END = {0};
@@ -79,6 +89,65 @@ void VActJitCode::genCode() {
   ret();
 }
 
+void VAddBiasActJitCode::genCode() {
+  const int num_blocks = w_ / YMM_FLOAT_BLOCK;
+  const int rest = w_ % YMM_FLOAT_BLOCK;
+  Label l_next_row, l_blocks, l_end;
+  test(param_rows, param_rows);
+  jle(l_end, T_NEAR);
+  L(l_next_row);
+  {
+    xor_(reg_offset, reg_offset);
+    if (num_blocks > 0) {
+      mov(reg_blocks, num_blocks);
+      L(l_blocks);
+      vmovups(ymm_src, ptr[param_x + reg_offset]);
+      vaddps(ymm_src, ymm_src, ptr[param_bias + reg_offset]);
+      act<ymm_t>(ymm_dst, ymm_src, type_);
+      vmovups(ptr[param_y + reg_offset], ymm_dst);
+      add(reg_offset, sizeof(float) * YMM_FLOAT_BLOCK);
+      dec(reg_blocks);
+      jnz(l_blocks, T_NEAR);
+    }
+    int offset = 0;
+    int left = rest;
+    while (left > 0) {
+      int block = XMM_FLOAT_BLOCK;
+      if (left >= 4) {
+        block = 4;
+        vmovups(xmm_src, ptr[param_x + reg_offset + offset]);
+        vmovups(xmm_bias, ptr[param_bias + reg_offset + offset]);
+      } else if (left >= 2) {
+        block = 2;
+        vmovq(xmm_src, ptr[param_x + reg_offset + offset]);
+        vmovq(xmm_bias, ptr[param_bias + reg_offset + offset]);
+      } else {
+        block = 1;
+        vmovss(xmm_src, ptr[param_x + reg_offset + offset]);
+        vmovss(xmm_bias, ptr[param_bias + reg_offset + offset]);
+      }
+      vaddps(xmm_src, xmm_src, xmm_bias);
+      act<xmm_t>(xmm_dst, xmm_src, type_);
+      if (left >= 4) {
+        vmovups(ptr[param_y + reg_offset + offset], xmm_dst);
+      } else if (left >= 2) {
+        vmovq(ptr[param_y + reg_offset + offset], xmm_dst);
+      } else {
+        vmovss(ptr[param_y + reg_offset + offset], xmm_dst);
+      }
+      offset += sizeof(float) * block;
+      left -= block;
+    }
+    add(param_x, static_cast<int>(w_ * sizeof(float)));
+    add(param_y, static_cast<int>(w_ * sizeof(float)));
+    dec(param_rows);
+    jnz(l_next_row, T_NEAR);
+  }
+  L(l_end);
+  vzeroupper();
+  ret();
+}
+
 #define DECLARE_ACT_CREATOR(name)                                            \
   class name##Creator : public JitCodeCreator<int> {                         \
    public:                                                                   \
@@ -95,6 +164,9 @@ DECLARE_ACT_CREATOR(VIdentity);
 DECLARE_ACT_CREATOR(VExp);
 DECLARE_ACT_CREATOR(VSigmoid);
 DECLARE_ACT_CREATOR(VTanh);
+DECLARE_ACT_CREATOR(VErf);
+DECLARE_ACT_CREATOR(VGelu);
+DECLARE_ACT_CREATOR(VGeluTanh);
 
 // TODO(TJ): tuning use me
 bool VReluCreator::CanBeUsed(const int& d) const {
@@ -121,6 +193,18 @@ bool VTanhCreator::CanBeUsed(const int& d) const {
   return platform::MayIUse(platform::avx);
 }
 
+bool VErfCreator::CanBeUsed(const int& d) const {
+  return platform::MayIUse(platform::avx);
+}
+
+bool VGeluCreator::CanBeUsed(const int& d) const {
+  return platform::MayIUse(platform::avx);
+}
+
+bool VGeluTanhCreator::CanBeUsed(const int& d) const {
+  return platform::MayIUse(platform::avx);
+}
+
 size_t VReluCreator::CodeSize(const int& d) const {
   return 96 /* init size */ +
          (d / YMM_FLOAT_BLOCK + 3) * 4 /* instructions */ *
@@ -147,8 +231,40 @@ size_t VTanhCreator::CodeSize(const int& d) const {
   return 96 + (d / YMM_FLOAT_BLOCK + 3) * 84 * 8;
 }
 
+size_t VErfCreator::CodeSize(const int& d) const {
+  return 96 + (d / YMM_FLOAT_BLOCK + 3) * 100 * 8;
+}
+
+size_t VGeluCreator::CodeSize(const int& d) const {
+  return 96 + (d / YMM_FLOAT_BLOCK + 3) * 112 * 8;
+}
+
+size_t VGeluTanhCreator::CodeSize(const int& d) const {
+  return 96 + (d / YMM_FLOAT_BLOCK + 3) * 100 * 8;
+}
+
 #undef DECLARE_ACT_CREATOR
 
+#define DECLARE_BIAS_ACT_CREATOR(name, act_size)                             \
+  class name##Creator : public JitCodeCreator<int> {                         \
+   public:                                                                   \
+    bool CanBeUsed(const int& w) const override {                            \
+      return platform::MayIUse(platform::avx);                               \
+    }                                                                        \
+    size_t CodeSize(const int& w) const override {                           \
+      /* a block in the loop and at most 3 rest blocks */                    \
+      return 96 + 4 * (act_size + 8) * 8;                                    \
+    }                                                                        \
+    std::unique_ptr<GenBase> CreateJitCode(const int& attr) const override { \
+      return make_unique<name##JitCode>(attr, CodeSize(attr));               \
+    }                                                                        \
+  }
+
+DECLARE_BIAS_ACT_CREATOR(VAddBiasGelu, 112);
+DECLARE_BIAS_ACT_CREATOR(VAddBiasRelu, 4);
+
+#undef DECLARE_BIAS_ACT_CREATOR
+
 }  // namespace gen
 }  // namespace jit
 }  // namespace operators
@@ -162,3 +278,8 @@ REGISTER_JITKERNEL_GEN(kVIdentity, gen::VIdentityCreator);
 REGISTER_JITKERNEL_GEN(kVExp, gen::VExpCreator);
 REGISTER_JITKERNEL_GEN(kVSigmoid, gen::VSigmoidCreator);
 REGISTER_JITKERNEL_GEN(kVTanh, gen::VTanhCreator);
+REGISTER_JITKERNEL_GEN(kVErf, gen::VErfCreator);
+REGISTER_JITKERNEL_GEN(kVGelu, gen::VGeluCreator);
+REGISTER_JITKERNEL_GEN(kVGeluTanh, gen::VGeluTanhCreator);
+REGISTER_JITKERNEL_GEN(kVAddBiasGelu, gen::VAddBiasGeluCreator);
+REGISTER_JITKERNEL_GEN(kVAddBiasRelu, gen::VAddBiasReluCreator);
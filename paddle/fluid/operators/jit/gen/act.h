@@ -40,6 +40,13 @@ extern int g_tmp_mem[];
 #define CEPHES_EXP_P3 4.1665795894E-2
 #define CEPHES_EXP_P4 1.6666665459E-1
 #define CEPHES_EXP_P5 5.0000001201E-1
+// the formula 7.1.26 of Abramowitz and Stegun
+#define ERF_P 0.3275911
+#define ERF_A1 0.254829592
+#define ERF_A2 -0.284496736
+#define ERF_A3 1.421413741
+#define ERF_A4 -1.453152027
+#define ERF_A5 1.061405429
 
 #define REPEAT_8TIMES(val) val, val, val, val, val, val, val, val
 
@@ -60,6 +67,16 @@ extern int g_tmp_mem[];
 #define OFFSET_EXP_MAX_INPUT 14 * YMM_FLOAT_BLOCK * sizeof(float)
 #define OFFSET_SIGMOID_MAX 15 * YMM_FLOAT_BLOCK * sizeof(float)
 #define OFFSET_SIGMOID_MIN 16 * YMM_FLOAT_BLOCK * sizeof(float)
+#define OFFSET_SIGN_MASK 17 * YMM_FLOAT_BLOCK * sizeof(float)
+#define OFFSET_ERF_P 18 * YMM_FLOAT_BLOCK * sizeof(float)
+#define OFFSET_ERF_A1 19 * YMM_FLOAT_BLOCK * sizeof(float)
+#define OFFSET_ERF_A2 20 * YMM_FLOAT_BLOCK * sizeof(float)
+#define OFFSET_ERF_A3 21 * YMM_FLOAT_BLOCK * sizeof(float)
+#define OFFSET_ERF_A4 22 * YMM_FLOAT_BLOCK * sizeof(float)
+#define OFFSET_ERF_A5 23 * YMM_FLOAT_BLOCK * sizeof(float)
+#define OFFSET_GELU_SQRT1_2 24 * YMM_FLOAT_BLOCK * sizeof(float)
+#define OFFSET_GELU_TANH_C 25 * YMM_FLOAT_BLOCK * sizeof(float)
+#define OFFSET_GELU_TANH_K 26 * YMM_FLOAT_BLOCK * sizeof(float)
 
 class VActFunc : public JitCode {
  public:
@@ -218,6 +235,83 @@ class VActFunc : public JitCode {
     pop(reg_ptr_global);
   }
 
+  // compute ERF with ymm, xmm, use 2~5 and 11~15, dst can be src
+  template <typename JMM>
+  void erf_jmm(JMM& dst, JMM& src, int sign_idx = 2,  // NOLINT
+               int abs_idx = 3, int t_idx = 4, int poly_idx = 5) {
+    // y = sign(x) * (1 - (a1*t + a2*t^2 + ... + a5*t^5) * e^(-x^2)),
+    // t = 1 / (1 + p*|x|), whose error is less than 1.5e-7
+    JMM jmm_sign = JMM(sign_idx);
+    JMM jmm_abs = JMM(abs_idx);
+    JMM jmm_t = JMM(t_idx);
+    JMM jmm_poly = JMM(poly_idx);
+    reg64_t reg_ptr_global = rax;
+    push(reg_ptr_global);
+    mov(reg_ptr_global, reinterpret_cast<size_t>(exp_float_consts));
+    vmovaps(jmm_sign, ptr[reg_ptr_global + OFFSET_SIGN_MASK]);
+    vandnps(jmm_abs, jmm_sign, src);
+    vandps(jmm_sign, jmm_sign, src);
+    vmulps(jmm_t, jmm_abs, ptr[reg_ptr_global + OFFSET_ERF_P]);
+    vaddps(jmm_t, jmm_t, ptr[reg_ptr_global + OFFSET_EXP_ONE]);
+    vmovaps(jmm_poly, ptr[reg_ptr_global + OFFSET_EXP_ONE]);
+    vdivps(jmm_t, jmm_poly, jmm_t);
+    vmovaps(jmm_poly, ptr[reg_ptr_global + OFFSET_ERF_A5]);
+    for (size_t i = OFFSET_ERF_A4; i >= OFFSET_ERF_A1;
+         i -= (YMM_FLOAT_BLOCK * sizeof(float))) {
+      vmulps(jmm_poly, jmm_poly, jmm_t);
+      vaddps(jmm_poly, jmm_poly, ptr[reg_ptr_global + i]);  // A4~A1
+    }
+    vmulps(jmm_poly, jmm_poly, jmm_t);
+    // -x^2
+    vmulps(jmm_abs, jmm_abs, jmm_abs);
+    vxorps(jmm_abs, jmm_abs, ptr[reg_ptr_global + OFFSET_SIGN_MASK]);
+    exp_jmm<JMM>(dst, jmm_abs, 11, 12, 13, 14, 15);
+    vmulps(dst, dst, jmm_poly);
+    vmovaps(jmm_t, ptr[reg_ptr_global + OFFSET_EXP_ONE]);
+    vsubps(dst, jmm_t, dst);
+    vorps(dst, dst, jmm_sign);
+    pop(reg_ptr_global);
+  }
+
+  // compute GELU with ymm, xmm, use 2~6 and 11~15, dst can be src
+  template <typename JMM>
+  void gelu_jmm(JMM& dst, JMM& src, int x_idx = 6) {  // NOLINT
+    // y = 0.5 * x * (1 + erf(x / sqrt(2)))
+    JMM jmm_x = JMM(x_idx);
+    reg64_t reg_ptr_global = rax;
+    push(reg_ptr_global);
+    mov(reg_ptr_global, reinterpret_cast<size_t>(exp_float_consts));
+    vmovaps(jmm_x, src);
+    vmulps(dst, jmm_x, ptr[reg_ptr_global + OFFSET_GELU_SQRT1_2]);
+    erf_jmm<JMM>(dst, dst, 2, 3, 4, 5);
+    vaddps(dst, dst, ptr[reg_ptr_global + OFFSET_EXP_ONE]);
+    vmulps(dst, dst, jmm_x);
+    vmulps(dst, dst, ptr[reg_ptr_global + OFFSET_EXP_0P5]);
+    pop(reg_ptr_global);
+  }
+
+  // compute GELU of the tanh form with ymm, xmm, use 6 and 11~15, dst can
+  // be src
+  template <typename JMM>
+  void gelu_tanh_jmm(JMM& dst, JMM& src, int x_idx = 6) {  // NOLINT
+    // y = 0.5 * x * (1 + tanh(sqrt(2 / pi) * (x + 0.044715 * x^3)))
+    JMM jmm_x = JMM(x_idx);
+    reg64_t reg_ptr_global = rax;
+    push(reg_ptr_global);
+    mov(reg_ptr_global, reinterpret_cast<size_t>(exp_float_consts));
+    vmovaps(jmm_x, src);
+    vmulps(dst, jmm_x, jmm_x);
+    vmulps(dst, dst, ptr[reg_ptr_global + OFFSET_GELU_TANH_K]);
+    vmulps(dst, dst, jmm_x);
+    vaddps(dst, dst, jmm_x);
+    vmulps(dst, dst, ptr[reg_ptr_global + OFFSET_GELU_TANH_C]);
+    tanh_jmm<JMM>(dst, dst, 11, 12, 13, 14, 15);
+    vaddps(dst, dst, ptr[reg_ptr_global + OFFSET_EXP_ONE]);
+    vmulps(dst, dst, jmm_x);
+    vmulps(dst, dst, ptr[reg_ptr_global + OFFSET_EXP_0P5]);
+    pop(reg_ptr_global);
+  }
+
   // compute IDENTITY with ymm, xmm
   template <typename JMM>
   void identity_jmm(JMM& dst, JMM& src, int zero_idx) {  // NOLINT
@@ -230,7 +324,7 @@ class VActFunc : public JitCode {
 
   template <typename JMM>
   void act(JMM& dst, JMM& src, operand_type type) {  // NOLINT
-    // use 11~15
+    // use 11~15, and 2~6 for ERF and GELU
     switch (type) {
       case operand_type::RELU:
         relu_jmm<JMM>(dst, src, 15);
@@ -250,6 +344,15 @@ class VActFunc : public JitCode {
       case operand_type::IDENTITY:
         identity_jmm<JMM>(dst, src, 15);
         break;
+      case operand_type::ERF:
+        erf_jmm<JMM>(dst, src, 2, 3, 4, 5);
+        break;
+      case operand_type::GELU:
+        gelu_jmm<JMM>(dst, src, 6);
+        break;
+      case operand_type::GELU_TANH:
+        gelu_tanh_jmm<JMM>(dst, src, 6);
+        break;
       default:
         PADDLE_THROW(platform::errors::Unimplemented(
             "Do not support operand type code: %d.", type));
@@ -265,7 +368,9 @@ class VActJitCode : public VActFunc {
       : VActFunc(code_size, code_ptr), num_(d), type_(type) {
     if (!(type_ == operand_type::RELU || type_ == operand_type::EXP ||
           type_ == operand_type::SIGMOID || type_ == operand_type::TANH ||
-          type_ == operand_type::IDENTITY || type_ == operand_type::SQUARE)) {
+          type_ == operand_type::IDENTITY || type_ == operand_type::SQUARE ||
+          type_ == operand_type::ERF || type_ == operand_type::GELU ||
+          type_ == operand_type::GELU_TANH)) {
       PADDLE_THROW(platform::errors::Unimplemented(
           "Do not support operand type code: %d.", type));
     }
@@ -293,6 +398,15 @@ class VActJitCode : public VActFunc {
       case operand_type::IDENTITY:
         base += "_Identity";
         break;
+      case operand_type::ERF:
+        base += "_Erf";
+        break;
+      case operand_type::GELU:
+        base += "_Gelu";
+        break;
+      case operand_type::GELU_TANH:
+        base += "_GeluTanh";
+        break;
       default:
         break;
     }
@@ -326,9 +440,64 @@ DECLARE_ACT_JITCODE(VIdentity, operand_type::IDENTITY);
 DECLARE_ACT_JITCODE(VExp, operand_type::EXP);
 DECLARE_ACT_JITCODE(VSigmoid, operand_type::SIGMOID);
 DECLARE_ACT_JITCODE(VTanh, operand_type::TANH);
+DECLARE_ACT_JITCODE(VErf, operand_type::ERF);
+DECLARE_ACT_JITCODE(VGelu, operand_type::GELU);
+DECLARE_ACT_JITCODE(VGeluTanh, operand_type::GELU_TANH);
 
 #undef DECLARE_ACT_JITCODE
 
+// y = act(x + bias) of each row, with the width in the code and the rows
+// looped in the code.
+class VAddBiasActJitCode : public VActFunc {
+ public:
+  explicit VAddBiasActJitCode(int w, operand_type type, size_t code_size,
+                              void* code_ptr = nullptr)
+      : VActFunc(code_size, code_ptr), w_(w), type_(type) {
+    if (!(type_ == operand_type::RELU || type_ == operand_type::GELU)) {
+      PADDLE_THROW(platform::errors::Unimplemented(
+          "Do not support operand type code: %d.", type));
+    }
+    this->genCode();
+  }
+
+  std::string name() const override {
+    std::string base = "VAddBiasActJitCode";
+    base += (type_ == operand_type::RELU ? "_Relu" : "_Gelu");
+    return base;
+  }
+  void genCode() override;
+
+ protected:
+  int w_;
+  operand_type type_;
+  reg64_t param_bias{abi_param1};
+  reg64_t param_x{abi_param2};
+  reg64_t param_y{abi_param3};
+  reg64_t param_rows{abi_param4};
+  reg64_t reg_offset{r9};
+  reg64_t reg_blocks{r10};
+
+  xmm_t xmm_src = xmm_t(0);
+  ymm_t ymm_src = ymm_t(0);
+
+  xmm_t xmm_dst = xmm_t(1);
+  ymm_t ymm_dst = ymm_t(1);
+
+  xmm_t xmm_bias = xmm_t(7);
+};
+
+#define DECLARE_BIAS_ACT_JITCODE(name, op_type)                               \
+  class name##JitCode : public VAddBiasActJitCode {                           \
+   public:                                                                    \
+    explicit name##JitCode(int w, size_t code_size, void* code_ptr = nullptr) \
+        : VAddBiasActJitCode(w, op_type, code_size, code_ptr) {}              \
+  };
+
+DECLARE_BIAS_ACT_JITCODE(VAddBiasGelu, operand_type::GELU);
+DECLARE_BIAS_ACT_JITCODE(VAddBiasRelu, operand_type::RELU);
+
+#undef DECLARE_BIAS_ACT_JITCODE
+
 }  // namespace gen
 }  // namespace jit
 }  // namespace operators
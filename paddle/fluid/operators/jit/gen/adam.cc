@@ -0,0 +1,180 @@
+/* Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#include "paddle/fluid/operators/jit/gen/adam.h"
+
+#include <stddef.h>  // offsetof
+
+#include "paddle/fluid/operators/jit/registry.h"
+#include "paddle/fluid/platform/cpu_info.h"
+
+namespace paddle {
+namespace operators {
+namespace jit {
+namespace gen {
+
+void AdamJitCode::genCode() {
+  preCode();
+  mov(reg_mom2_out, qword[rsp + stack_args_offset]);
+  mov(reg_param_out, qword[rsp + stack_args_offset + 8]);
+
+  // the ends of the blocks and of all, in bytes
+  mov(reg_end, param_numel);
+  shl(reg_end, 2);
+  mov(reg_blocks_end, param_numel);
+  and_(reg_blocks_end, ~static_cast<int>(YMM_FLOAT_BLOCK - 1));
+  shl(reg_blocks_end, 2);
+  mov(reg_grad, param_grad);
+
+  broadcastFloat(ymm_lr, xmm_t(0));
+  broadcastFloat(ymm_eps, xmm_t(1));
+  if (with_decay_) {
+    broadcastFloat(ymm_decay, xmm_t(2));
+  }
+  loadBetas();
+
+  xor_(reg_offset, reg_offset);
+  Label l_blocks, l_rest, l_end;
+  L(l_blocks);
+  {
+    cmp(reg_offset, reg_blocks_end);
+    jae(l_rest, T_NEAR);
+    updateCode<ymm_t>(reg_offset, reg_offset, 0, with_decay_);
+    add(reg_offset, YMM_FLOAT_BLOCK * sizeof(float));
+    jmp(l_blocks, T_NEAR);
+  }
+  L(l_rest);
+  {
+    cmp(reg_offset, reg_end);
+    jae(l_end, T_NEAR);
+    updateCode<xmm_t>(reg_offset, reg_offset, 0, with_decay_);
+    add(reg_offset, sizeof(float));
+    jmp(l_rest, T_NEAR);
+  }
+  L(l_end);
+  vzeroupper();
+  postCode();
+}
+
+void SparseAdamJitCode::genCode() {
+  preCode();
+  constexpr size_t block_size = sizeof(float) * YMM_FLOAT_BLOCK;
+  const int num_blocks = w_ / YMM_FLOAT_BLOCK;
+  const int rest = w_ % YMM_FLOAT_BLOCK;
+  const size_t width_size = w_ * sizeof(float);
+
+  mov(reg_mom2_out, qword[rsp + stack_args_offset]);
+  mov(reg_param_out, qword[rsp + stack_args_offset + 8]);
+  mov(rax, qword[rsp + stack_args_offset + 16]);
+  mov(reg_rows_end,
+      qword[rax + offsetof(sparse_adam_attr_t, selected_rows_size)]);
+  shl(reg_rows_end, 3);
+  add(reg_rows_end, reg_rows);
+
+  broadcastFloat(ymm_lr, xmm_t(0));
+  broadcastFloat(ymm_eps, xmm_t(1));
+  loadBetas();
+
+  xor_(reg_grad_offset, reg_grad_offset);
+  Label l_next_row, l_end;
+  L(l_next_row);
+  {
+    cmp(reg_rows, reg_rows_end);
+    jae(l_end, T_NEAR);
+    mov(rax, qword[reg_rows]);
+    imul(reg_offset, rax, static_cast<int>(width_size));
+
+    if (num_blocks > 0) {
+      Label l_blocks;
+      mov(reg_blocks, num_blocks);
+      L(l_blocks);
+      updateCode<ymm_t>(reg_offset, reg_grad_offset, 0, false);
+      add(reg_offset, block_size);
+      add(reg_grad_offset, block_size);
+      dec(reg_blocks);
+      jnz(l_blocks, T_NEAR);
+    }
+    for (int i = 0; i < rest; ++i) {
+      updateCode<xmm_t>(reg_offset, reg_grad_offset, i * sizeof(float),
+                        false);
+    }
+    add(reg_grad_offset, rest * sizeof(float));
+
+    add(reg_rows, sizeof(int64_t));
+    jmp(l_next_row, T_NEAR);
+  }
+  L(l_end);
+  vzeroupper();
+  postCode();
+}
+
+class AdamCreator : public JitCodeCreator<adam_attr_t> {
+ public:
+  bool CanBeUsed(const adam_attr_t& attr) const override {
+    return platform::MayIUse(platform::avx);
+  }
+  size_t CodeSize(const adam_attr_t& attr) const override {
+    return 96 + 256 * 2;
+  }
+  std::unique_ptr<GenBase> CreateJitCode(
+      const adam_attr_t& attr) const override {
+    return make_unique<AdamJitCode>(attr, false, CodeSize(attr));
+  }
+};
+
+class AdamWCreator : public JitCodeCreator<adam_attr_t> {
+ public:
+  bool CanBeUsed(const adam_attr_t& attr) const override {
+    return platform::MayIUse(platform::avx);
+  }
+  size_t CodeSize(const adam_attr_t& attr) const override {
+    return 96 + 256 * 2;
+  }
+  std::unique_ptr<GenBase> CreateJitCode(
+      const adam_attr_t& attr) const override {
+    return make_unique<AdamJitCode>(attr, true, CodeSize(attr));
+  }
+};
+
+class SparseAdamCreator : public JitCodeCreator<sparse_adam_attr_t> {
+ public:
+  bool CanBeUsed(const sparse_adam_attr_t& attr) const override {
+    return platform::MayIUse(platform::avx) && attr.width > 0;
+  }
+  size_t CodeSize(const sparse_adam_attr_t& attr) const override {
+    // the update of a block and of each rest float are less than 256 bytes
+    return 96 + 256 * (1 + attr.width % YMM_FLOAT_BLOCK);
+  }
+  std::unique_ptr<GenBase> CreateJitCode(
+      const sparse_adam_attr_t& attr) const override {
+    PADDLE_ENFORCE_GE(
+        attr.selected_rows_size, 0,
+        platform::errors::InvalidArgument(
+            "The attribute selected_rows_size of SparseAdam should be "
+            "equal to or larger than 0. But selected_rows_size is %d.",
+            attr.selected_rows_size));
+    return make_unique<SparseAdamJitCode>(attr, CodeSize(attr));
+  }
+};
+
+}  // namespace gen
+}  // namespace jit
+}  // namespace operators
+}  // namespace paddle
+
+namespace gen = paddle::operators::jit::gen;
+
+REGISTER_JITKERNEL_GEN(kAdam, gen::AdamCreator);
+REGISTER_JITKERNEL_GEN(kAdamW, gen::AdamWCreator);
+REGISTER_JITKERNEL_GEN(kSparseAdam, gen::SparseAdamCreator);
@@ -0,0 +1,190 @@
+/* Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#pragma once
+
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+#include "glog/logging.h"
+#include "paddle/fluid/operators/jit/gen/jitcode.h"
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace operators {
+namespace jit {
+namespace gen {
+
+// The Adam update of 8 floats with ymm, or of one float with xmm, with the
+// betas in the code and the lr, eps and decay broadcast from the arguments.
+class AdamBaseJitCode : public JitCode {
+ public:
+  AdamBaseJitCode(float beta1, float beta2, size_t code_size, void* code_ptr)
+      : JitCode(code_size, code_ptr), beta1_(beta1), beta2_(beta2) {}
+  virtual void genCode() = 0;
+
+ protected:
+  // broadcasts the lowest float of src to all of dst, with AVX only
+  void broadcastFloat(const Xbyak::Ymm& dst, const Xbyak::Xmm& src) {
+    vshufps(xmm_t(dst.getIdx()), src, src, 0);
+    vinsertf128(dst, dst, xmm_t(dst.getIdx()), 1);
+  }
+
+  void loadBetas() {
+    auto load_float = [this](const Xbyak::Ymm& dst, float value) {
+      int32_t bits;
+      std::memcpy(&bits, &value, sizeof(bits));
+      mov(eax, bits);
+      vmovd(xmm_t(dst.getIdx()), eax);
+      broadcastFloat(dst, xmm_t(dst.getIdx()));
+    };
+    load_float(ymm_beta1, beta1_);
+    load_float(ymm_one_sub_beta1, 1.f);
+    vsubps(ymm_one_sub_beta1, ymm_one_sub_beta1, ymm_beta1);
+    load_float(ymm_beta2, beta2_);
+    load_float(ymm_one_sub_beta2, 1.f);
+    vsubps(ymm_one_sub_beta2, ymm_one_sub_beta2, ymm_beta2);
+  }
+
+  // updates the floats at reg_offset + disp of the moments and the param,
+  // with the grad at reg_grad_offset + disp
+  template <typename JMM>
+  void updateCode(const Xbyak::Reg64& reg_offset,
+                  const Xbyak::Reg64& reg_grad_offset, int disp,
+                  bool with_decay) {
+    constexpr bool scalar = std::is_same<JMM, xmm_t>::value;
+    auto load = [&](const JMM& dst, const Xbyak::Address& src) {
+      scalar ? vmovss(dst, src) : vmovups(dst, src);
+    };
+    auto store = [&](const Xbyak::Address& dst, const JMM& src) {
+      scalar ? vmovss(dst, src) : vmovups(dst, src);
+    };
+    auto mul = [&](const JMM& dst, const JMM& a, const JMM& b) {
+      scalar ? vmulss(dst, a, b) : vmulps(dst, a, b);
+    };
+    auto add = [&](const JMM& dst, const JMM& a, const JMM& b) {
+      scalar ? vaddss(dst, a, b) : vaddps(dst, a, b);
+    };
+    auto sub = [&](const JMM& dst, const JMM& a, const JMM& b) {
+      scalar ? vsubss(dst, a, b) : vsubps(dst, a, b);
+    };
+    JMM grad(0), mom1(1), mom2(2), tmp(3), param(4), decayed(5);
+    JMM beta1(ymm_beta1.getIdx()), one_sub_beta1(ymm_one_sub_beta1.getIdx());
+    JMM beta2(ymm_beta2.getIdx()), one_sub_beta2(ymm_one_sub_beta2.getIdx());
+    JMM lr(ymm_lr.getIdx()), eps(ymm_eps.getIdx()), decay(ymm_decay.getIdx());
+
+    load(grad, ptr[reg_grad + reg_grad_offset + disp]);
+    // mom1 = beta1 * mom1 + (1 - beta1) * grad
+    load(mom1, ptr[reg_mom1 + reg_offset + disp]);
+    mul(mom1, beta1, mom1);
+    mul(tmp, one_sub_beta1, grad);
+    add(mom1, mom1, tmp);
+    store(ptr[reg_mom1_out + reg_offset + disp], mom1);
+    // mom2 = beta2 * mom2 + (1 - beta2) * grad * grad
+    load(mom2, ptr[reg_mom2 + reg_offset + disp]);
+    mul(mom2, beta2, mom2);
+    mul(tmp, one_sub_beta2, grad);
+    mul(tmp, tmp, grad);
+    add(mom2, mom2, tmp);
+    store(ptr[reg_mom2_out + reg_offset + disp], mom2);
+    // param = param - lr * (mom1 / (sqrt(mom2) + eps))
+    scalar ? vsqrtss(tmp, mom2, mom2) : vsqrtps(tmp, mom2);
+    add(tmp, tmp, eps);
+    scalar ? vdivss(tmp, mom1, tmp) : vdivps(tmp, mom1, tmp);
+    mul(tmp, lr, tmp);
+    load(param, ptr[reg_param + reg_offset + disp]);
+    if (with_decay) {
+      mul(decayed, decay, param);
+      sub(param, param, decayed);
+    }
+    sub(param, param, tmp);
+    store(ptr[reg_param_out + reg_offset + disp], param);
+  }
+
+  float beta1_;
+  float beta2_;
+
+  // the offset of the stack arguments after preCode
+  static constexpr int stack_args_offset = (num_g_abi_regs + 1) * 8;
+
+  reg64_t reg_grad{abi_param1};
+  reg64_t reg_mom1{abi_param3};
+  reg64_t reg_mom2{abi_param4};
+  reg64_t reg_param{abi_param5};
+  reg64_t reg_mom1_out{abi_param6};
+  reg64_t reg_mom2_out{r10};
+  reg64_t reg_param_out{r11};
+
+  ymm_t ymm_beta1 = ymm_t(15);
+  ymm_t ymm_one_sub_beta1 = ymm_t(14);
+  ymm_t ymm_beta2 = ymm_t(13);
+  ymm_t ymm_one_sub_beta2 = ymm_t(12);
+  ymm_t ymm_lr = ymm_t(11);
+  ymm_t ymm_eps = ymm_t(10);
+  ymm_t ymm_decay = ymm_t(9);
+};
+
+// Adam and AdamW of any numel.
+class AdamJitCode : public AdamBaseJitCode {
+ public:
+  explicit AdamJitCode(const adam_attr_t& attr, bool with_decay,
+                       size_t code_size = 256 * 1024, void* code_ptr = nullptr)
+      : AdamBaseJitCode(attr.beta1, attr.beta2, code_size, code_ptr),
+        with_decay_(with_decay) {
+    this->genCode();
+  }
+
+  std::string name() const override {
+    return with_decay_ ? "AdamWJitCode" : "AdamJitCode";
+  }
+  void genCode() override;
+
+ private:
+  bool with_decay_;
+  // the numel comes in rdi and the grad in rsi, the grad is moved to rdi
+  reg64_t param_numel{abi_param1};
+  reg64_t param_grad{abi_param2};
+  reg64_t reg_offset{r12};
+  reg64_t reg_blocks_end{rbx};
+  reg64_t reg_end{r13};
+};
+
+// Lazy sparse Adam of the selected rows, with the width in the code.
+class SparseAdamJitCode : public AdamBaseJitCode {
+ public:
+  explicit SparseAdamJitCode(const sparse_adam_attr_t& attr,
+                             size_t code_size = 256 * 1024,
+                             void* code_ptr = nullptr)
+      : AdamBaseJitCode(attr.beta1, attr.beta2, code_size, code_ptr),
+        w_(attr.width) {
+    this->genCode();
+  }
+
+  DECLARE_JIT_CODE(SparseAdamJitCode);
+  void genCode() override;
+
+ private:
+  int64_t w_;
+  reg64_t reg_rows{abi_param2};
+  reg64_t reg_rows_end{r14};
+  reg64_t reg_offset{r12};
+  reg64_t reg_grad_offset{rbx};
+  reg64_t reg_blocks{r13};
+};
+
+}  // namespace gen
+}  // namespace jit
+}  // namespace operators
+}  // namespace paddle
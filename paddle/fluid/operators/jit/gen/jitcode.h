@@ -57,7 +57,10 @@ typedef enum {
   SQUARE,
   SIGMOID,
   TANH,
-  IDENTITY
+  IDENTITY,
+  ERF,
+  GELU,
+  GELU_TANH
 } operand_type;
 
 #define DECLARE_JIT_CODE(codename) \
@@ -39,6 +39,8 @@ const char* to_string(KernelType kt) {
     ONE_CASE(kVScal);
     ONE_CASE(kStrideScal);
     ONE_CASE(kVAddBias);
+    ONE_CASE(kVAddBiasGelu);
+    ONE_CASE(kVAddBiasRelu);
     ONE_CASE(kVRelu);
     ONE_CASE(kVBroadcast);
     ONE_CASE(kVCopy);
@@ -47,6 +49,9 @@ const char* to_string(KernelType kt) {
     ONE_CASE(kVSquare);
     ONE_CASE(kVSigmoid);
     ONE_CASE(kVTanh);
+    ONE_CASE(kVErf);
+    ONE_CASE(kVGelu);
+    ONE_CASE(kVGeluTanh);
     ONE_CASE(kLSTMCtHt);
     ONE_CASE(kLSTMC1H1);
     ONE_CASE(kGRUH1);
@@ -63,6 +68,9 @@ const char* to_string(KernelType kt) {
     ONE_CASE(kSoftmax);
     ONE_CASE(kEmbSeqPool);
     ONE_CASE(kSgd);
+    ONE_CASE(kAdam);
+    ONE_CASE(kAdamW);
+    ONE_CASE(kSparseAdam);
     default:
       PADDLE_THROW(platform::errors::Unimplemented(
           "JIT kernel do not support type: %d.", kt));
@@ -288,6 +288,19 @@ inline std::ostream& operator<<(std::ostream& os, const matmul_attr_t& attr) {
   return os;
 }
 
+inline std::ostream& operator<<(std::ostream& os, const adam_attr_t& attr) {
+  os << "beta1[" << attr.beta1 << "],beta2[" << attr.beta2 << "]";
+  return os;
+}
+
+inline std::ostream& operator<<(std::ostream& os,
+                                const sparse_adam_attr_t& attr) {
+  os << "beta1[" << attr.beta1 << "],beta2[" << attr.beta2 << "],width["
+     << attr.width << "],selected_rows_size[" << attr.selected_rows_size
+     << "]";
+  return os;
+}
+
 // expose the method to pack matmul weight
 template <typename T>
 void pack_weights(const T* src, T* dst, int n, int k);
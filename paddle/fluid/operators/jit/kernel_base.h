@@ -24,8 +24,10 @@ namespace jit {
 typedef enum {
   kNone = 0,
   // sort by alphabet
-  kCRFDecoding = 1,
-  kEmbSeqPool = 2,
+  kAdam = 1,
+  kAdamW,
+  kCRFDecoding,
+  kEmbSeqPool,
   kGRUH1,
   kGRUHtPart1,
   kGRUHtPart2,
@@ -38,14 +40,20 @@ typedef enum {
   kNCHW16CMulNC,
   kSeqPool,
   kSoftmax,
+  kSparseAdam,
   kStrideASum,
   kStrideScal,
   kVAdd,
   kVAddBias,
+  kVAddBiasGelu,
+  kVAddBiasRelu,
   kVAddRelu,
   kVBroadcast,
   kVCopy,
+  kVErf,
   kVExp,
+  kVGelu,
+  kVGeluTanh,
   kVIdentity,
   kVMul,
   kVRelu,
@@ -104,6 +112,14 @@ struct XRNSTuple {
   typedef void (*func_type)(const T*, T*, int, int);
 };
 
+// bias, x, y, rows, width: each of the rows of x added by the bias
+template <typename T>
+struct BXYRWTuple {
+  typedef T data_type;
+  typedef int attr_type;
+  typedef void (*func_type)(const T*, const T*, T*, int64_t, int);
+};
+
 #define DECLARE_KERNELTUPLE(kernel_tuple, type)        \
   template <typename T>                                \
   struct type##Tuple : public kernel_tuple<T> {        \
@@ -121,12 +137,18 @@ DECLARE_KERNELTUPLE(AXYNTuple, VAddBias);
 
 DECLARE_KERNELTUPLE(AXYNSTuple, StrideScal);
 
+DECLARE_KERNELTUPLE(BXYRWTuple, VAddBiasGelu);
+DECLARE_KERNELTUPLE(BXYRWTuple, VAddBiasRelu);
+
 DECLARE_KERNELTUPLE(XYNTuple, VRelu);
 DECLARE_KERNELTUPLE(XYNTuple, VIdentity);
 DECLARE_KERNELTUPLE(XYNTuple, VSquare);
 DECLARE_KERNELTUPLE(XYNTuple, VExp);
 DECLARE_KERNELTUPLE(XYNTuple, VSigmoid);
 DECLARE_KERNELTUPLE(XYNTuple, VTanh);
+DECLARE_KERNELTUPLE(XYNTuple, VErf);
+DECLARE_KERNELTUPLE(XYNTuple, VGelu);
+DECLARE_KERNELTUPLE(XYNTuple, VGeluTanh);
 DECLARE_KERNELTUPLE(XYNTuple, VCopy);
 
 DECLARE_KERNELTUPLE(XRNTuple, HMax);
@@ -269,6 +291,60 @@ struct SgdTuple {
                             const sgd_attr_t*);
 };
 
+typedef struct adam_attr_s {
+  float beta1, beta2;
+  adam_attr_s() = default;
+  explicit adam_attr_s(float beta1_, float beta2_)
+      : beta1(beta1_), beta2(beta2_) {}
+} adam_attr_t;
+
+// lr, eps, numel, grad, mom1, mom2, param, mom1_out, mom2_out, param_out, attr
+// the lr and eps are corrected by the beta pows
+template <typename T>
+struct AdamTuple {
+  static constexpr KernelType kernel_type = kAdam;
+  typedef T data_type;
+  typedef adam_attr_t attr_type;
+  typedef void (*func_type)(T, T, int64_t, const T*, const T*, const T*,
+                            const T*, T*, T*, T*, const adam_attr_t*);
+};
+
+// lr, eps, decay, numel, grad, mom1, mom2, param, mom1_out, mom2_out,
+// param_out, attr
+// the param is decayed by param * decay before the adam update
+template <typename T>
+struct AdamWTuple {
+  static constexpr KernelType kernel_type = kAdamW;
+  typedef T data_type;
+  typedef adam_attr_t attr_type;
+  typedef void (*func_type)(T, T, T, int64_t, const T*, const T*, const T*,
+                            const T*, T*, T*, T*, const adam_attr_t*);
+};
+
+typedef struct sparse_adam_attr_s {
+  float beta1, beta2;
+  int64_t width;
+  int64_t selected_rows_size;
+  sparse_adam_attr_s() = default;
+  explicit sparse_adam_attr_s(float beta1_, float beta2_, int64_t width_,
+                              int64_t selected_rows_sz)
+      : beta1(beta1_),
+        beta2(beta2_),
+        width(width_),
+        selected_rows_size(selected_rows_sz) {}
+} sparse_adam_attr_t;
+
+// lr, eps, grad, rows, mom1, mom2, param, mom1_out, mom2_out, param_out, attr
+// only the selected rows are updated, as the lazy mode of adam
+template <typename T>
+struct SparseAdamTuple {
+  static constexpr KernelType kernel_type = kSparseAdam;
+  typedef T data_type;
+  typedef sparse_adam_attr_t attr_type;
+  typedef void (*func_type)(T, T, const T*, const int64_t*, const T*, const T*,
+                            const T*, T*, T*, T*, const sparse_adam_attr_t*);
+};
+
 typedef struct matmul_attr_s {
   int m, n, k;
   void* packed_weight{nullptr};
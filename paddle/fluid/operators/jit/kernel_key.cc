@@ -63,6 +63,17 @@ int64_t JitCodeKey<sgd_attr_t>(const sgd_attr_t& attr) {
   return attr.grad_width;
 }
 
+template <>
+int64_t JitCodeKey<adam_attr_t>(const adam_attr_t& attr) {
+  return XXH64(&attr, sizeof(adam_attr_t), 0);
+}
+
+template <>
+int64_t JitCodeKey<sparse_adam_attr_t>(const sparse_adam_attr_t& attr) {
+  // beta1, beta2, width; the selected_rows_size is read when running
+  return XXH64(&attr, sizeof(float) * 2 + sizeof(int64_t), 0);
+}
+
 }  // namespace jit
 }  // namespace operators
 }  // namespace paddle
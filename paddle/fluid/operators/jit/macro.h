@@ -23,6 +23,10 @@ namespace jit {
 #define SIGMOID_THRESHOLD_MAX 13.0
 #define EXP_MAX_INPUT 40.0
 
+#define GELU_SQRT1_2 0.70710678118654752440  // 1 / sqrt(2)
+#define GELU_TANH_C 0.79788456080286535588   // sqrt(2 / pi)
+#define GELU_TANH_K 0.044715
+
 #define XMM_FLOAT_BLOCK 4
 #define YMM_FLOAT_BLOCK 8
 #define ZMM_FLOAT_BLOCK 16
@@ -29,6 +29,8 @@ REGISTER_REFER_KERNEL(VSub);
 REGISTER_REFER_KERNEL(VScal);
 REGISTER_REFER_KERNEL(StrideScal);
 REGISTER_REFER_KERNEL(VAddBias);
+REGISTER_REFER_KERNEL(VAddBiasGelu);
+REGISTER_REFER_KERNEL(VAddBiasRelu);
 
 REGISTER_REFER_KERNEL(VRelu);
 REGISTER_REFER_KERNEL(VCopy);
@@ -37,6 +39,9 @@ REGISTER_REFER_KERNEL(VSquare);
 REGISTER_REFER_KERNEL(VExp);
 REGISTER_REFER_KERNEL(VSigmoid);
 REGISTER_REFER_KERNEL(VTanh);
+REGISTER_REFER_KERNEL(VErf);
+REGISTER_REFER_KERNEL(VGelu);
+REGISTER_REFER_KERNEL(VGeluTanh);
 
 REGISTER_REFER_KERNEL(LSTMCtHt);
 REGISTER_REFER_KERNEL(LSTMC1H1);
@@ -57,5 +62,8 @@ REGISTER_REFER_KERNEL(Softmax);
 REGISTER_REFER_KERNEL(EmbSeqPool);
 REGISTER_REFER_KERNEL(Sgd);
 REGISTER_REFER_KERNEL(VBroadcast);
+REGISTER_REFER_KERNEL(Adam);
+REGISTER_REFER_KERNEL(AdamW);
+REGISTER_REFER_KERNEL(SparseAdam);
 
 #undef REGISTER_REFER_KERNEL
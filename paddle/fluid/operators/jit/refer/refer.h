@@ -136,6 +136,58 @@ void VTanh(const T* x, T* y, int n) {
   }
 }
 
+template <typename T>
+void VErf(const T* x, T* y, int n) {
+  for (int i = 0; i < n; ++i) {
+    y[i] = std::erf(x[i]);
+  }
+}
+
+template <typename T>
+void VGelu(const T* x, T* y, int n) {
+  // y = 0.5 * x * (1 + erf(x / sqrt(2)))
+  for (int i = 0; i < n; ++i) {
+    T erf_x = std::erf(x[i] * static_cast<T>(GELU_SQRT1_2));
+    y[i] = static_cast<T>(0.5) * x[i] * (static_cast<T>(1) + erf_x);
+  }
+}
+
+template <typename T>
+void VGeluTanh(const T* x, T* y, int n) {
+  // y = 0.5 * x * (1 + tanh(sqrt(2 / pi) * (x + 0.044715 * x^3)))
+  for (int i = 0; i < n; ++i) {
+    T inner = static_cast<T>(GELU_TANH_C) *
+              (x[i] + static_cast<T>(GELU_TANH_K) * x[i] * x[i] * x[i]);
+    y[i] = static_cast<T>(0.5) * x[i] * (static_cast<T>(1) + std::tanh(inner));
+  }
+}
+
+// y = gelu(x + bias) of each row
+template <typename T>
+void VAddBiasGelu(const T* bias, const T* x, T* y, int64_t rows, int width) {
+  for (int64_t i = 0; i < rows; ++i) {
+    const T* x_row = x + i * width;
+    T* y_row = y + i * width;
+    for (int j = 0; j < width; ++j) {
+      y_row[j] = x_row[j] + bias[j];
+    }
+    VGelu(y_row, y_row, width);
+  }
+}
+
+// y = relu(x + bias) of each row
+template <typename T>
+void VAddBiasRelu(const T* bias, const T* x, T* y, int64_t rows, int width) {
+  for (int64_t i = 0; i < rows; ++i) {
+    const T* x_row = x + i * width;
+    T* y_row = y + i * width;
+    for (int j = 0; j < width; ++j) {
+      T v = x_row[j] + bias[j];
+      y_row[j] = v > 0 ? v : 0;
+    }
+  }
+}
+
 template <typename T>
 void (*getActFunc(KernelType type))(const T*, T*, int) {  // NOLINT
   if (type == kVSigmoid) {
@@ -552,6 +604,72 @@ void Sgd(const T* lr, const T* param, const T* grad, const int64_t* rows,
   }
 }
 
+// Adam algorithm, with the lr and eps corrected by the beta pows:
+// mom1_out = beta1 * mom1 + (1 - beta1) * grad
+// mom2_out = beta2 * mom2 + (1 - beta2) * grad * grad
+// param_out = param - lr * mom1_out / (sqrt(mom2_out) + eps)
+template <typename T>
+inline void AdamUpdate(T beta1, T beta2, T lr, T eps, T grad, T mom1, T mom2,
+                       T param, T* mom1_out, T* mom2_out, T* param_out) {
+  mom1 = beta1 * mom1 + (1 - beta1) * grad;
+  mom2 = beta2 * mom2 + (1 - beta2) * grad * grad;
+  *mom1_out = mom1;
+  *mom2_out = mom2;
+  *param_out = param - lr * (mom1 / (std::sqrt(mom2) + eps));
+}
+
+template <typename T>
+void Adam(T lr, T eps, int64_t numel, const T* grad, const T* mom1,
+          const T* mom2, const T* param, T* mom1_out, T* mom2_out,
+          T* param_out, const adam_attr_t* attr) {
+  T beta1 = static_cast<T>(attr->beta1);
+  T beta2 = static_cast<T>(attr->beta2);
+  for (int64_t i = 0; i < numel; ++i) {
+    AdamUpdate<T>(beta1, beta2, lr, eps, grad[i], mom1[i], mom2[i], param[i],
+                  mom1_out + i, mom2_out + i, param_out + i);
+  }
+}
+
+// AdamW algorithm: the Adam on the param decayed by param -= decay * param
+template <typename T>
+void AdamW(T lr, T eps, T decay, int64_t numel, const T* grad, const T* mom1,
+           const T* mom2, const T* param, T* mom1_out, T* mom2_out,
+           T* param_out, const adam_attr_t* attr) {
+  T beta1 = static_cast<T>(attr->beta1);
+  T beta2 = static_cast<T>(attr->beta2);
+  for (int64_t i = 0; i < numel; ++i) {
+    AdamUpdate<T>(beta1, beta2, lr, eps, grad[i], mom1[i], mom2[i],
+                  param[i] - decay * param[i], mom1_out + i, mom2_out + i,
+                  param_out + i);
+  }
+}
+
+// Lazy sparse Adam: only the rows of param selected by rows are updated by
+// the rows of grad, with the width of attr; the other rows of the outputs are
+// not changed.
+template <typename T>
+void SparseAdam(T lr, T eps, const T* grad, const int64_t* rows,
+                const T* mom1, const T* mom2, const T* param, T* mom1_out,
+                T* mom2_out, T* param_out, const sparse_adam_attr_t* attr) {
+  T beta1 = static_cast<T>(attr->beta1);
+  T beta2 = static_cast<T>(attr->beta2);
+  int64_t width = attr->width;
+  for (int64_t i = 0; i < attr->selected_rows_size; ++i) {
+    PADDLE_ENFORCE_GE(rows[i], 0, platform::errors::InvalidArgument(
+                                      "The rows of SparseAdam should be "
+                                      "larger than 0. But %dth of rows "
+                                      "is %d.",
+                                      i, rows[i]));
+    int64_t offset = rows[i] * width;
+    for (int64_t j = 0; j < width; ++j) {
+      AdamUpdate<T>(beta1, beta2, lr, eps, grad[i * width + j],
+                    mom1[offset + j], mom2[offset + j], param[offset + j],
+                    mom1_out + offset + j, mom2_out + offset + j,
+                    param_out + offset + j);
+    }
+  }
+}
+
 #define DECLARE_REFER_KERNEL(name)                          \
   template <typename T>                                     \
   class name##Kernel : public ReferKernel<name##Tuple<T>> { \
@@ -572,6 +690,10 @@ DECLARE_REFER_KERNEL(VAddBias);
 // const T* a, const T* x, T* y, int n, int stride
 DECLARE_REFER_KERNEL(StrideScal);
 
+// const T* bias, const T* x, T* y, int64_t rows, int width
+DECLARE_REFER_KERNEL(VAddBiasGelu);
+DECLARE_REFER_KERNEL(VAddBiasRelu);
+
 // const T* x, T* y, int n
 DECLARE_REFER_KERNEL(VRelu);
 DECLARE_REFER_KERNEL(VIdentity);
@@ -580,6 +702,9 @@ DECLARE_REFER_KERNEL(VSigmoid);
 DECLARE_REFER_KERNEL(VTanh);
 DECLARE_REFER_KERNEL(VSquare);
 DECLARE_REFER_KERNEL(VCopy);
+DECLARE_REFER_KERNEL(VErf);
+DECLARE_REFER_KERNEL(VGelu);
+DECLARE_REFER_KERNEL(VGeluTanh);
 
 // lstm_t*, const lstm_attr_t*
 DECLARE_REFER_KERNEL(LSTMCtHt);
@@ -605,6 +730,9 @@ DECLARE_REFER_KERNEL(Softmax);
 DECLARE_REFER_KERNEL(EmbSeqPool);
 DECLARE_REFER_KERNEL(Sgd);
 DECLARE_REFER_KERNEL(VBroadcast);
+DECLARE_REFER_KERNEL(Adam);
+DECLARE_REFER_KERNEL(AdamW);
+DECLARE_REFER_KERNEL(SparseAdam);
 
 #undef DECLARE_REFER_KERNEL
 
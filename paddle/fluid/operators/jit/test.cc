@@ -12,7 +12,9 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License. */
 
+#include <algorithm>
 #include <iostream>
+#include <numeric>
 #include <random>
 
 #include "gflags/gflags.h"
@@ -217,6 +219,41 @@ void TestKernelXYN() {
   }
 }
 
+template <typename KernelTuple, typename PlaceType>
+void TestKernelBXYRW() {
+  using T = typename KernelTuple::data_type;
+  VLOG(10) << "Test JITKernel: " << jit::to_string(KernelTuple::kernel_type);
+  for (int w : TestSizes()) {
+    for (int64_t rows : {1, 5}) {
+      auto ref = jit::GetReferFunc<KernelTuple>();
+      EXPECT_TRUE(ref != nullptr);
+      std::vector<T> bias(w), x(rows * w), yref(rows * w);
+      RandomVec<T>(w, bias.data());
+      RandomVec<T>(rows * w, x.data());
+      std::vector<T> xinp(x);  // inplace test
+      ref(bias.data(), x.data(), yref.data(), rows, w);
+      ref(bias.data(), xinp.data(), xinp.data(), rows, w);
+      ExpectEQ<T>(xinp.data(), yref.data(), rows * w);
+
+      auto verifier = [](const typename KernelTuple::func_type tgt,
+                         const std::vector<T>& bias, const std::vector<T>& x,
+                         const std::vector<T>& yref, int64_t rows) {
+        EXPECT_TRUE(tgt != nullptr);
+        const int w = bias.size();
+        std::vector<T> ytgt(yref.size());
+        // test normal
+        tgt(bias.data(), x.data(), ytgt.data(), rows, w);
+        ExpectEQ<T>(ytgt.data(), yref.data(), yref.size());
+        // test inplace x
+        std::copy(x.begin(), x.end(), ytgt.begin());
+        tgt(bias.data(), ytgt.data(), ytgt.data(), rows, w);
+        ExpectEQ<T>(ytgt.data(), yref.data(), yref.size());
+      };
+      TestAllImpls<KernelTuple, PlaceType>(w, verifier, bias, x, yref, rows);
+    }
+  }
+}
+
 template <typename KernelTuple, typename PlaceType>
 void TestKernelXRN() {
   using T = typename KernelTuple::data_type;
@@ -939,6 +976,190 @@ void TestKernelSgd() {
   }
 }
 
+// the grad, moments and param of an adam update
+template <typename T>
+struct AdamStates {
+  explicit AdamStates(int numel)
+      : grad(numel), mom1(numel), mom2(numel), param(numel) {
+    RandomVec<T>(numel, grad.data());
+    RandomVec<T>(numel, mom1.data());
+    RandomVec<T>(numel, mom2.data(), static_cast<T>(0.5), static_cast<T>(2.));
+    RandomVec<T>(numel, param.data());
+  }
+  std::vector<T> grad, mom1, mom2, param;
+};
+
+template <typename T>
+void ExpectAdamEQ(const std::vector<T>& mom1, const std::vector<T>& mom2,
+                  const std::vector<T>& param, const AdamStates<T>& ref) {
+  ExpectEQ<T>(mom1.data(), ref.mom1.data(), ref.mom1.size());
+  ExpectEQ<T>(mom2.data(), ref.mom2.data(), ref.mom2.size());
+  ExpectEQ<T>(param.data(), ref.param.data(), ref.param.size());
+}
+
+template <typename KernelTuple, typename PlaceType>
+void TestKernelAdam() {
+  using T = typename KernelTuple::data_type;
+  VLOG(10) << "Test JITKernel: " << jit::to_string(KernelTuple::kernel_type);
+  const T lr = 0.1;
+  const T eps = 1e-3;
+  const jit::adam_attr_t attr(0.9, 0.999);
+  for (int numel : TestSizes()) {
+    AdamStates<T> in(numel);
+    AdamStates<T> out(numel);
+    auto ref = jit::GetReferFunc<KernelTuple>();
+    EXPECT_TRUE(ref != nullptr);
+    ref(lr, eps, numel, in.grad.data(), in.mom1.data(), in.mom2.data(),
+        in.param.data(), out.mom1.data(), out.mom2.data(), out.param.data(),
+        &attr);
+
+    auto verifier = [](const typename KernelTuple::func_type tgt, const T lr,
+                       const T eps, const AdamStates<T>& in,
+                       const AdamStates<T>& out_ref,
+                       const typename KernelTuple::attr_type& attr) {
+      EXPECT_TRUE(tgt != nullptr);
+      const int64_t numel = in.param.size();
+      std::vector<T> mom1(numel), mom2(numel), param(numel);
+      tgt(lr, eps, numel, in.grad.data(), in.mom1.data(), in.mom2.data(),
+          in.param.data(), mom1.data(), mom2.data(), param.data(), &attr);
+      ExpectAdamEQ<T>(mom1, mom2, param, out_ref);
+
+      // inplace
+      mom1 = in.mom1;
+      mom2 = in.mom2;
+      param = in.param;
+      tgt(lr, eps, numel, in.grad.data(), mom1.data(), mom2.data(),
+          param.data(), mom1.data(), mom2.data(), param.data(), &attr);
+      ExpectAdamEQ<T>(mom1, mom2, param, out_ref);
+    };
+    TestAllImpls<KernelTuple, PlaceType>(attr, verifier, lr, eps, in, out,
+                                         attr);
+  }
+}
+
+template <typename KernelTuple, typename PlaceType>
+void TestKernelAdamW() {
+  using T = typename KernelTuple::data_type;
+  VLOG(10) << "Test JITKernel: " << jit::to_string(KernelTuple::kernel_type);
+  const T lr = 0.1;
+  const T eps = 1e-3;
+  const T decay = 0.1 * 0.01;
+  const jit::adam_attr_t attr(0.9, 0.999);
+  for (int numel : TestSizes()) {
+    AdamStates<T> in(numel);
+    AdamStates<T> out(numel);
+    auto ref = jit::GetReferFunc<KernelTuple>();
+    EXPECT_TRUE(ref != nullptr);
+    ref(lr, eps, decay, numel, in.grad.data(), in.mom1.data(), in.mom2.data(),
+        in.param.data(), out.mom1.data(), out.mom2.data(), out.param.data(),
+        &attr);
+
+    // the same as adam on the decayed param
+    AdamStates<T> decayed(in);
+    for (auto& p : decayed.param) {
+      p -= decay * p;
+    }
+    AdamStates<T> adam_out(numel);
+    auto adam_ref = jit::GetReferFunc<jit::AdamTuple<T>>();
+    adam_ref(lr, eps, numel, decayed.grad.data(), decayed.mom1.data(),
+             decayed.mom2.data(), decayed.param.data(), adam_out.mom1.data(),
+             adam_out.mom2.data(), adam_out.param.data(), &attr);
+    ExpectAdamEQ<T>(out.mom1, out.mom2, out.param, adam_out);
+
+    auto verifier = [](const typename KernelTuple::func_type tgt, const T lr,
+                       const T eps, const T decay, const AdamStates<T>& in,
+                       const AdamStates<T>& out_ref,
+                       const typename KernelTuple::attr_type& attr) {
+      EXPECT_TRUE(tgt != nullptr);
+      const int64_t numel = in.param.size();
+      std::vector<T> mom1(numel), mom2(numel), param(numel);
+      tgt(lr, eps, decay, numel, in.grad.data(), in.mom1.data(),
+          in.mom2.data(), in.param.data(), mom1.data(), mom2.data(),
+          param.data(), &attr);
+      ExpectAdamEQ<T>(mom1, mom2, param, out_ref);
+
+      // inplace
+      mom1 = in.mom1;
+      mom2 = in.mom2;
+      param = in.param;
+      tgt(lr, eps, decay, numel, in.grad.data(), mom1.data(), mom2.data(),
+          param.data(), mom1.data(), mom2.data(), param.data(), &attr);
+      ExpectAdamEQ<T>(mom1, mom2, param, out_ref);
+    };
+    TestAllImpls<KernelTuple, PlaceType>(attr, verifier, lr, eps, decay, in,
+                                         out, attr);
+  }
+}
+
+template <typename KernelTuple, typename PlaceType>
+void TestKernelSparseAdam() {
+  using T = typename KernelTuple::data_type;
+  VLOG(10) << "Test JITKernel: " << jit::to_string(KernelTuple::kernel_type);
+  const T lr = 0.1;
+  const T eps = 1e-3;
+  for (int param_h : {1, 10}) {
+    for (int width : TestSizes()) {
+      AdamStates<T> in(param_h * width);
+      for (int rows_size = 0; rows_size <= param_h; ++rows_size) {
+        // the unselected rows of the outputs are kept
+        AdamStates<T> out(in);
+        std::vector<int64_t> rows(param_h);
+        std::iota(rows.begin(), rows.end(), 0);
+        std::shuffle(rows.begin(), rows.end(), std::mt19937(rows_size));
+        rows.resize(rows_size);
+        std::sort(rows.begin(), rows.end());
+        std::vector<T> grad(rows_size * width);
+        RandomVec<T>(rows_size * width, grad.data());
+
+        const jit::sparse_adam_attr_t attr(0.9, 0.999, width, rows_size);
+        auto ref = jit::GetReferFunc<KernelTuple>();
+        EXPECT_TRUE(ref != nullptr);
+        ref(lr, eps, grad.data(), rows.data(), in.mom1.data(), in.mom2.data(),
+            in.param.data(), out.mom1.data(), out.mom2.data(),
+            out.param.data(), &attr);
+        // the selected rows are updated like the dense adam
+        auto dense_ref = jit::GetReferFunc<jit::AdamTuple<T>>();
+        const jit::adam_attr_t dense_attr(0.9, 0.999);
+        for (int i = 0; i < rows_size; ++i) {
+          std::vector<T> mom1(width), mom2(width), param(width);
+          int64_t offset = rows[i] * width;
+          dense_ref(lr, eps, width, grad.data() + i * width,
+                    in.mom1.data() + offset, in.mom2.data() + offset,
+                    in.param.data() + offset, mom1.data(), mom2.data(),
+                    param.data(), &dense_attr);
+          ExpectEQ<T>(out.mom1.data() + offset, mom1.data(), width);
+          ExpectEQ<T>(out.mom2.data() + offset, mom2.data(), width);
+          ExpectEQ<T>(out.param.data() + offset, param.data(), width);
+        }
+
+        auto verifier = [](const typename KernelTuple::func_type tgt,
+                           const T lr, const T eps, const std::vector<T>& grad,
+                           const std::vector<int64_t>& rows,
+                           const AdamStates<T>& in,
+                           const AdamStates<T>& out_ref,
+                           const typename KernelTuple::attr_type& attr) {
+          EXPECT_TRUE(tgt != nullptr);
+          std::vector<T> mom1(in.mom1), mom2(in.mom2), param(in.param);
+          tgt(lr, eps, grad.data(), rows.data(), in.mom1.data(),
+              in.mom2.data(), in.param.data(), mom1.data(), mom2.data(),
+              param.data(), &attr);
+          ExpectAdamEQ<T>(mom1, mom2, param, out_ref);
+
+          // inplace
+          mom1 = in.mom1;
+          mom2 = in.mom2;
+          param = in.param;
+          tgt(lr, eps, grad.data(), rows.data(), mom1.data(), mom2.data(),
+              param.data(), mom1.data(), mom2.data(), param.data(), &attr);
+          ExpectAdamEQ<T>(mom1, mom2, param, out_ref);
+        };
+        TestAllImpls<KernelTuple, PlaceType>(attr, verifier, lr, eps, grad,
+                                             rows, in, out, attr);
+      }
+    }
+  }
+}
+
 template <typename KernelTuple, typename PlaceType>
 void TestKernelVBroadcast() {
   using T = typename KernelTuple::data_type;
@@ -1148,8 +1369,12 @@ TEST(JITKernel_helper, attr) {
       << jit::to_string(jit::kVMul) << jit::to_string(jit::kVRelu)
       << jit::to_string(jit::kVScal) << jit::to_string(jit::kSgd)
       << jit::to_string(jit::kVSigmoid) << jit::to_string(jit::kVSquare)
-      << jit::to_string(jit::kVSub) << jit::to_string(jit::kVTanh);
-  EXPECT_EQ(out.str().size(), 234UL);
+      << jit::to_string(jit::kVSub) << jit::to_string(jit::kVTanh)
+      << jit::to_string(jit::kAdam) << jit::to_string(jit::kAdamW)
+      << jit::to_string(jit::kSparseAdam) << jit::to_string(jit::kVAddBiasGelu)
+      << jit::to_string(jit::kVAddBiasRelu) << jit::to_string(jit::kVErf)
+      << jit::to_string(jit::kVGelu) << jit::to_string(jit::kVGeluTanh);
+  EXPECT_EQ(out.str().size(), 303UL);
 
   // SeqPoolTypes
   out.str("");
@@ -1325,6 +1550,9 @@ TEST(JITKernel_key, sgd) {
 #define TestKernelVScal TestKernelAXYN
 #define TestKernelVAddBias TestKernelAXYN
 
+#define TestKernelVAddBiasGelu TestKernelBXYRW
+#define TestKernelVAddBiasRelu TestKernelBXYRW
+
 #define TestKernelVRelu TestKernelXYN
 #define TestKernelVIdentity TestKernelXYN
 #define TestKernelVSquare TestKernelXYN
@@ -1332,6 +1560,9 @@ TEST(JITKernel_key, sgd) {
 #define TestKernelVSigmoid TestKernelXYN
 #define TestKernelVTanh TestKernelXYN
 #define TestKernelVCopy TestKernelXYN
+#define TestKernelVErf TestKernelXYN
+#define TestKernelVGelu TestKernelXYN
+#define TestKernelVGeluTanh TestKernelXYN
 
 #define TestKernelHMax TestKernelXRN
 #define TestKernelHSum TestKernelXRN
@@ -1356,6 +1587,8 @@ TEST_CPU_KERNEL(VSub);
 
 TEST_CPU_KERNEL(VScal);
 TEST_CPU_KERNEL(VAddBias);
+TEST_CPU_KERNEL(VAddBiasGelu);
+TEST_CPU_KERNEL(VAddBiasRelu);
 
 TEST_CPU_KERNEL(VRelu);
 TEST_CPU_KERNEL(VIdentity);
@@ -1364,6 +1597,9 @@ TEST_CPU_KERNEL(VExp);
 TEST_CPU_KERNEL(VSigmoid);
 TEST_CPU_KERNEL(VTanh);
 TEST_CPU_KERNEL(VCopy);
+TEST_CPU_KERNEL(VErf);
+TEST_CPU_KERNEL(VGelu);
+TEST_CPU_KERNEL(VGeluTanh);
 
 TEST_CPU_KERNEL(HMax);
 TEST_CPU_KERNEL(HSum);
@@ -1386,5 +1622,9 @@ TEST_CPU_KERNEL(Softmax);
 TEST_CPU_KERNEL(Sgd);
 TEST_CPU_KERNEL(VBroadcast);
 
+TEST_CPU_KERNEL(Adam);
+TEST_CPU_KERNEL(AdamW);
+TEST_CPU_KERNEL(SparseAdam);
+
 TEST_CPU_KERNEL(StrideASum);
 TEST_CPU_KERNEL(StrideScal);
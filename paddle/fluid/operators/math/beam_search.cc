@@ -13,6 +13,7 @@ See the License for the specific language governing permissions and
 limitations under the License. */
 
 #include "paddle/fluid/operators/math/beam_search.h"
+#include "paddle/fluid/operators/math/top_k_cpu.h"
 
 namespace paddle {
 namespace framework {
@@ -262,13 +263,32 @@ class BeamSearchFunctor<platform::CPUDeviceContext, T> {
           Insert(&top_beam, item, beam_size);
         } else {
           size_t index = offset * seq_width;
-          for (size_t d = 0; d < seq_width; d++, index++) {
-            int64_t id = ids_data ? ids_data[index] : static_cast<int64_t>(d);
-            float score = is_accumulated
-                              ? scores_data[index]
-                              : pre_score + std::log(scores_data[index]);
-            Item item(offset, id, score);
-            Insert(&top_beam, item, beam_size);
+          const float *row_scores = scores_data + index;
+          if (!is_accumulated) {
+            auto &values = GetTopKScratch<float>()->values;
+            values.resize(seq_width);
+            for (size_t d = 0; d < seq_width; d++) {
+              values[d] = pre_score + std::log(row_scores[d]);
+            }
+            row_scores = values.data();
+          }
+          auto insert = [&](int64_t j) {
+            int64_t id = ids_data ? ids_data[index + j] : j;
+            Insert(&top_beam, Item(offset, id, row_scores[j]), beam_size);
+          };
+          size_t d = 0;
+          for (; d < seq_width && top_beam.size() < beam_size; d++) {
+            insert(d);
+          }
+          // once the beam is full, only the scores not less than the last of
+          // it can be inserted
+          if (d < seq_width && beam_size > 0) {
+            float threshold = top_beam.back().score;
+            ForEachTopKCandidate(row_scores, d, seq_width, /*largest=*/true,
+                                 &threshold, [&](int64_t j) {
+                                   insert(j);
+                                   threshold = top_beam.back().score;
+                                 });
           }
         }
       }
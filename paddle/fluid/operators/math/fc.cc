@@ -14,6 +14,8 @@ limitations under the License. */
 
 #include "paddle/fluid/operators/math/fc.h"
 
+#include <algorithm>
+
 #include "paddle/fluid/operators/jit/kernels.h"
 #include "paddle/fluid/operators/math/blas.h"
 
@@ -27,7 +29,7 @@ class FCFunctor<platform::CPUDeviceContext, T> {
   void operator()(const platform::CPUDeviceContext& context, const int M,
                   const int N, const int K, const T* X, const T* W, T* Y,
                   const T* B = nullptr, bool relu = false,
-                  bool padding_weights = false) {
+                  bool padding_weights = false, bool gelu = false) {
     auto blas = math::GetBlas<platform::CPUDeviceContext, T>(context);
     framework::Tensor Y1;
     T* Y1_data = nullptr;
@@ -60,6 +62,38 @@ class FCFunctor<platform::CPUDeviceContext, T> {
       PADDLE_ENFORCE_EQ(relu, false,
                         platform::errors::PermissionDenied(
                             "When bias is NULL, relu can not be true."));
+      PADDLE_ENFORCE_EQ(gelu, false,
+                        platform::errors::PermissionDenied(
+                            "When bias is NULL, gelu can not be true."));
+      return;
+    }
+    if (gelu && padding_weights) {
+      // gelu has no row kernel reading the padded rows, unpad them first
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+      for (int i = 0; i < M; i++) {
+        memcpy(Y + i * N, Y1_data + i * (N + 4), N * sizeof(T));
+      }
+    }
+    if (gelu || (relu && !padding_weights)) {
+      // the rows of Y in blocks of the fused bias and activation
+      constexpr int block_rows = 8;
+      auto bias_act =
+          gelu ? jit::KernelFuncs<jit::VAddBiasGeluTuple<T>,
+                                  platform::CPUPlace>::Cache()
+                     .At(N)
+               : jit::KernelFuncs<jit::VAddBiasReluTuple<T>,
+                                  platform::CPUPlace>::Cache()
+                     .At(N);
+      int block_num = (M + block_rows - 1) / block_rows;
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+      for (int i = 0; i < block_num; i++) {
+        T* dst = Y + i * block_rows * N;
+        bias_act(B, dst, dst, std::min(block_rows, M - i * block_rows), N);
+      }
       return;
     }
     auto compute =
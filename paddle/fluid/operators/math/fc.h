@@ -27,7 +27,7 @@ class FCFunctor {
   void operator()(const DeviceContext& context, const int M, const int N,
                   const int K, const T* X, const T* W, T* Y,
                   const T* B = nullptr, bool relu = false,
-                  bool weight_pass = false);
+                  bool weight_pass = false, bool gelu = false);
 };
 
 }  // namespace math
@@ -0,0 +1,261 @@
+/* Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+// the kernels of CUDA and HIP include this header by top_k_op.h
+#if defined(__AVX__) && !defined(__NVCC__) && !defined(__HIPCC__)
+#define PADDLE_TOPK_CPU_AVX
+#include <immintrin.h>
+#endif
+#ifdef PADDLE_WITH_MKLML
+#include <omp.h>
+#endif
+
+#include "paddle/fluid/platform/cpu_info.h"
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace operators {
+namespace math {
+
+/*
+ * The CPU top-k of the rows of a matrix, shared by top_k, top_k_v2 and
+ * beam_search.
+ *
+ * For a small k, a row is scanned with a heap of the k values selected so
+ * far, and only the values that may come before the worst of them, found by
+ * a SIMD compare against it, are checked and pushed. For a large k, the row
+ * is selected by nth_element. The rows run in parallel, and a single row is
+ * split by columns, whose top-k are then merged.
+ */
+
+// The order of the top-k: the larger (or smaller) values first, and the
+// smaller index first among the equal values. With nan_as_max NaN is larger
+// than every number, like top_k_v2; otherwise NaN is not ordered against the
+// numbers, like the comparison of top_k.
+template <typename T>
+struct TopKOrder {
+  TopKOrder(bool largest, bool nan_as_max)
+      : largest(largest), nan_as_max(nan_as_max) {}
+
+  // whether the value a at index ai comes before the value b at index bi
+  inline bool Before(T a, int64_t ai, T b, int64_t bi) const {
+    if (nan_as_max) {
+      bool a_nan = std::isnan(static_cast<double>(a));
+      bool b_nan = std::isnan(static_cast<double>(b));
+      if (a_nan || b_nan) {
+        if (a_nan && b_nan) {
+          return ai < bi;
+        }
+        return largest ? a_nan : b_nan;
+      }
+    }
+    if (a != b) {
+      return largest ? a > b : a < b;
+    }
+    return ai < bi;
+  }
+
+  bool largest;
+  bool nan_as_max;
+};
+
+// The buffers of the selection, reused by the rows of a thread.
+template <typename T>
+struct TopKScratch {
+  std::vector<std::pair<T, int64_t>> items;
+  std::vector<T> values;
+};
+
+template <typename T>
+inline TopKScratch<T>* GetTopKScratch() {
+  static thread_local TopKScratch<T> scratch;
+  return &scratch;
+}
+
+// the heap is used while k is this much smaller than the row
+static constexpr int64_t kTopKHeapRatio = 64;
+// the least columns of a part of a single row split among the threads
+static constexpr int64_t kTopKMinSplitCols = 1 << 14;
+
+// Calls visit(j) for the j in [begin, end) whose x[j] is not ordered after
+// *threshold: x[j] >= *threshold for the largest, x[j] <= *threshold for the
+// smallest, or either is NaN. visit may update *threshold, and visit has to
+// check its x[j] again as it may have been compared to an older threshold.
+template <typename T, typename Visit>
+inline void ForEachTopKCandidate(const T* x, int64_t begin, int64_t end,
+                                 bool largest, const T* threshold,
+                                 Visit visit) {
+  for (int64_t j = begin; j < end; ++j) {
+    T thr = *threshold;
+    if (!(largest ? x[j] < thr : x[j] > thr)) {
+      visit(j);
+    }
+  }
+}
+
+#ifdef PADDLE_TOPK_CPU_AVX
+template <typename Visit>
+inline void ForEachTopKCandidate(const float* x, int64_t begin, int64_t end,
+                                 bool largest, const float* threshold,
+                                 Visit visit) {
+  int64_t j = begin;
+  if (platform::MayIUse(platform::avx)) {
+    constexpr int kBlock = 8;
+    for (; j + kBlock <= end; j += kBlock) {
+      __m256 values = _mm256_loadu_ps(x + j);
+      __m256 thr = _mm256_set1_ps(*threshold);
+      int mask = _mm256_movemask_ps(
+          largest ? _mm256_cmp_ps(values, thr, _CMP_NLT_UQ)
+                  : _mm256_cmp_ps(values, thr, _CMP_NGT_UQ));
+      while (mask != 0) {
+        int bit = __builtin_ctz(mask);
+        mask &= mask - 1;
+        visit(j + bit);
+      }
+    }
+  }
+  for (; j < end; ++j) {
+    float thr = *threshold;
+    if (!(largest ? x[j] < thr : x[j] > thr)) {
+      visit(j);
+    }
+  }
+}
+#endif
+
+// Selects the top k of the n values of x into out and indices in the order.
+template <typename T, typename IndexT>
+void TopKRow(const T* x, int64_t n, int64_t k, const TopKOrder<T>& order,
+             T* out, IndexT* indices, TopKScratch<T>* scratch) {
+  using Item = std::pair<T, int64_t>;
+  auto before = [&order](const Item& a, const Item& b) {
+    return order.Before(a.first, a.second, b.first, b.second);
+  };
+  auto& items = scratch->items;
+  items.clear();
+  if (k * kTopKHeapRatio < n) {
+    // the worst of the k selected is on the top of the heap
+    for (int64_t j = 0; j < k; ++j) {
+      items.emplace_back(x[j], j);
+    }
+    std::make_heap(items.begin(), items.end(), before);
+    T threshold = items.front().first;
+    ForEachTopKCandidate(
+        x, k, n, order.largest, &threshold, [&](int64_t j) {
+          // a later index never comes before an equal value
+          if (order.Before(x[j], j, items.front().first,
+                           items.front().second)) {
+            std::pop_heap(items.begin(), items.end(), before);
+            items.back() = Item(x[j], j);
+            std::push_heap(items.begin(), items.end(), before);
+            threshold = items.front().first;
+          }
+        });
+    std::sort_heap(items.begin(), items.end(), before);
+  } else {
+    for (int64_t j = 0; j < n; ++j) {
+      items.emplace_back(x[j], j);
+    }
+    std::nth_element(items.begin(), items.begin() + k - 1, items.end(),
+                     before);
+    std::sort(items.begin(), items.begin() + k, before);
+  }
+  for (int64_t j = 0; j < k; ++j) {
+    out[j] = items[j].first;
+    indices[j] = static_cast<IndexT>(items[j].second);
+  }
+}
+
+// Selects the top k of the single row by the parts of its columns in
+// parallel, and merges the top k of the parts.
+template <typename T, typename IndexT>
+void TopKSplitRow(const T* x, int64_t n, int64_t k, const TopKOrder<T>& order,
+                  int part_num, T* out, IndexT* indices) {
+  int64_t part_cols = (n + part_num - 1) / part_num;
+  std::vector<T> part_out(part_num * k);
+  std::vector<int64_t> part_indices(part_num * k);
+  std::vector<int64_t> part_k(part_num, 0);
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+  for (int p = 0; p < part_num; ++p) {
+    int64_t begin = p * part_cols;
+    int64_t end = std::min(n, begin + part_cols);
+    if (begin >= end) {
+      continue;
+    }
+    part_k[p] = std::min(k, end - begin);
+    TopKRow(x + begin, end - begin, part_k[p], order, part_out.data() + p * k,
+            part_indices.data() + p * k, GetTopKScratch<T>());
+    for (int64_t j = 0; j < part_k[p]; ++j) {
+      part_indices[p * k + j] += begin;
+    }
+  }
+
+  std::vector<std::pair<T, int64_t>> items;
+  for (int p = 0; p < part_num; ++p) {
+    for (int64_t j = 0; j < part_k[p]; ++j) {
+      items.emplace_back(part_out[p * k + j], part_indices[p * k + j]);
+    }
+  }
+  std::partial_sort(
+      items.begin(), items.begin() + k, items.end(),
+      [&order](const std::pair<T, int64_t>& a, const std::pair<T, int64_t>& b) {
+        return order.Before(a.first, a.second, b.first, b.second);
+      });
+  for (int64_t j = 0; j < k; ++j) {
+    out[j] = items[j].first;
+    indices[j] = static_cast<IndexT>(items[j].second);
+  }
+}
+
+// Selects the top k of each of the rows of the row-major rows x n matrix x
+// into the rows x k matrices out and indices, sorted in the order.
+template <typename T, typename IndexT>
+void TopK(const T* x, int64_t rows, int64_t n, int64_t k,
+          const TopKOrder<T>& order, T* out, IndexT* indices) {
+  PADDLE_ENFORCE_LE(k, n, platform::errors::InvalidArgument(
+                              "The k of top-k (%d) should not be larger than "
+                              "the number of the columns (%d).",
+                              k, n));
+  if (k <= 0 || rows <= 0) {
+    return;
+  }
+#ifdef PADDLE_WITH_MKLML
+  if (rows == 1 && k * kTopKHeapRatio < n) {
+    int part_num = static_cast<int>(std::min<int64_t>(
+        omp_get_max_threads(), n / kTopKMinSplitCols));
+    if (part_num > 1) {
+      TopKSplitRow(x, n, k, order, part_num, out, indices);
+      return;
+    }
+  }
+#pragma omp parallel for
+#endif
+  for (int64_t i = 0; i < rows; ++i) {
+    TopKRow(x + i * n, n, k, order, out + i * k, indices + i * k,
+            GetTopKScratch<T>());
+  }
+}
+
+}  // namespace math
+}  // namespace operators
+}  // namespace paddle
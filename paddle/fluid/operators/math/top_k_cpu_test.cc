@@ -0,0 +1,179 @@
+/* Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/operators/math/top_k_cpu.h"
+
+namespace math = paddle::operators::math;
+
+// the top k of each row by sorting the whole row
+template <typename T>
+void RefTopK(const std::vector<T>& x, int64_t rows, int64_t n, int64_t k,
+             const math::TopKOrder<T>& order, std::vector<T>* out,
+             std::vector<int64_t>* indices) {
+  out->clear();
+  indices->clear();
+  for (int64_t i = 0; i < rows; ++i) {
+    std::vector<int64_t> idx(n);
+    for (int64_t j = 0; j < n; ++j) {
+      idx[j] = j;
+    }
+    const T* row = x.data() + i * n;
+    std::sort(idx.begin(), idx.end(), [&](int64_t a, int64_t b) {
+      return order.Before(row[a], a, row[b], b);
+    });
+    for (int64_t j = 0; j < k; ++j) {
+      out->push_back(row[idx[j]]);
+      indices->push_back(idx[j]);
+    }
+  }
+}
+
+template <typename T>
+void ExpectSameTopK(const std::vector<T>& x, int64_t rows, int64_t n,
+                    int64_t k, const math::TopKOrder<T>& order,
+                    const std::vector<T>& out,
+                    const std::vector<int64_t>& indices) {
+  std::vector<T> ref_out;
+  std::vector<int64_t> ref_indices;
+  RefTopK(x, rows, n, k, order, &ref_out, &ref_indices);
+  ASSERT_EQ(indices.size(), ref_indices.size());
+  for (size_t i = 0; i < indices.size(); ++i) {
+    ASSERT_EQ(indices[i], ref_indices[i]) << "at " << i;
+    if (std::isnan(static_cast<double>(ref_out[i]))) {
+      ASSERT_TRUE(std::isnan(static_cast<double>(out[i])));
+    } else {
+      ASSERT_EQ(out[i], ref_out[i]);
+    }
+  }
+}
+
+// values in [0, range), with many ties for a small range
+template <typename T>
+std::vector<T> RandomValues(size_t num, int range, unsigned seed) {
+  std::mt19937 rng(seed);
+  std::uniform_int_distribution<int> dist(0, range - 1);
+  std::vector<T> x(num);
+  for (auto& v : x) {
+    v = static_cast<T>(dist(rng)) / static_cast<T>(range > 1000 ? 7 : 1);
+  }
+  return x;
+}
+
+template <typename T>
+void TestTopK(int64_t rows, int64_t n, int64_t k, int range) {
+  auto x = RandomValues<T>(rows * n, range, rows * 31 + n + k);
+  for (bool largest : {true, false}) {
+    for (bool nan_as_max : {true, false}) {
+      math::TopKOrder<T> order(largest, nan_as_max);
+      std::vector<T> out(rows * k);
+      std::vector<int64_t> indices(rows * k);
+      math::TopK(x.data(), rows, n, k, order, out.data(), indices.data());
+      ExpectSameTopK(x, rows, n, k, order, out, indices);
+    }
+  }
+}
+
+TEST(TopK, heap) {
+  TestTopK<float>(4, 10000, 10, 100000);
+  TestTopK<float>(3, 1003, 1, 100000);
+  TestTopK<double>(4, 10000, 10, 100000);
+  TestTopK<int64_t>(4, 10000, 10, 100000);
+  TestTopK<int>(4, 10000, 10, 100000);
+}
+
+TEST(TopK, ties) {
+  TestTopK<float>(4, 10000, 10, 3);
+  TestTopK<float>(4, 100, 30, 3);
+  TestTopK<int>(4, 10000, 10, 3);
+}
+
+TEST(TopK, large_k) {
+  TestTopK<float>(8, 100, 60, 100000);
+  TestTopK<float>(8, 100, 100, 100000);
+  TestTopK<double>(8, 1000, 500, 10);
+  TestTopK<int64_t>(8, 1000, 500, 10);
+}
+
+TEST(TopK, nan) {
+  const float nan = std::numeric_limits<float>::quiet_NaN();
+  for (int64_t n : {100, 10000}) {
+    auto x = RandomValues<float>(2 * n, 100000, n);
+    x[3] = nan;
+    x[n - 1] = nan;
+    x[n + 50] = nan;
+    for (int64_t k : {1, 5, 80}) {
+      for (bool largest : {true, false}) {
+        // NaN is the maximum value
+        math::TopKOrder<float> order(largest, /*nan_as_max=*/true);
+        std::vector<float> out(2 * k);
+        std::vector<int64_t> indices(2 * k);
+        math::TopK(x.data(), 2, n, k, order, out.data(), indices.data());
+        ExpectSameTopK(x, 2, n, k, order, out, indices);
+      }
+    }
+  }
+}
+
+TEST(TopK, split_row) {
+  const int64_t n = 100003;
+  for (int range : {100000, 5}) {
+    auto x = RandomValues<float>(n, range, range);
+    for (bool largest : {true, false}) {
+      math::TopKOrder<float> order(largest, /*nan_as_max=*/true);
+      for (int part_num : {2, 3, 8}) {
+        std::vector<float> out(10);
+        std::vector<int64_t> indices(10);
+        math::TopKSplitRow(x.data(), n, 10, order, part_num, out.data(),
+                           indices.data());
+        ExpectSameTopK(x, 1, n, 10, order, out, indices);
+      }
+    }
+  }
+}
+
+TEST(TopK, k_larger_than_n) {
+  std::vector<float> x(10, 1.f);
+  std::vector<float> out(11);
+  std::vector<int64_t> indices(11);
+  EXPECT_ANY_THROW(math::TopK(x.data(), 1, 10, 11,
+                              math::TopKOrder<float>(true, false), out.data(),
+                              indices.data()));
+}
+
+TEST(TopK, candidates) {
+  auto x = RandomValues<float>(1000, 100, 7);
+  x[17] = std::numeric_limits<float>::quiet_NaN();
+  for (bool largest : {true, false}) {
+    for (int64_t begin : {0, 3}) {
+      float threshold = 50.f;
+      std::vector<int64_t> visited;
+      math::ForEachTopKCandidate(x.data(), begin, 997, largest, &threshold,
+                                 [&](int64_t j) { visited.push_back(j); });
+      std::vector<int64_t> expected;
+      for (int64_t j = begin; j < 997; ++j) {
+        if (!(largest ? x[j] < threshold : x[j] > threshold)) {
+          expected.push_back(j);
+        }
+      }
+      EXPECT_EQ(visited, expected);
+    }
+  }
+}
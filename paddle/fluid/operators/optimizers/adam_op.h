@@ -15,11 +15,13 @@ limitations under the License. */
 #pragma once
 #include <math.h>  // for sqrt in CPU and CUDA
 #include <Eigen/Dense>
+#include <algorithm>
 #include <string>
 #include <unordered_map>
 #include <vector>
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/framework/threadpool.h"
+#include "paddle/fluid/operators/jit/kernels.h"
 #include "paddle/fluid/operators/math/algorithm.h"
 #include "paddle/fluid/operators/math/selected_rows_functor.h"
 #include "paddle/fluid/platform/for_range.h"
@@ -389,10 +391,39 @@ class SparseAdamFunctor<T, CPUAdam, T> {
   }
 };
 
+// The lr and eps of the jit adam kernels, corrected by the beta pows like
+// AdamFunctor.
+template <typename T>
+static inline void CorrectAdamLrEps(T beta1_pow, T beta2_pow, T* lr, T* eps) {
+  *lr *= sqrt(1 - beta2_pow) / (1 - beta1_pow);
+  *eps *= sqrt(1 - beta2_pow);
+}
+
+// Runs func(offset, size) on the chunks of numel in parallel.
+template <typename Func>
+static inline void ParallelForAdamChunks(int64_t numel, Func func) {
+  constexpr int64_t chunk_size = 4096;
+  int64_t chunk_num = (numel + chunk_size - 1) / chunk_size;
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+  for (int64_t i = 0; i < chunk_num; ++i) {
+    int64_t offset = i * chunk_size;
+    func(offset, std::min(chunk_size, numel - offset));
+  }
+}
+
 template <typename DeviceContext, typename T>
 class AdamOpKernel : public framework::OpKernel<T> {
  public:
   void Compute(const framework::ExecutionContext& ctx) const override {
+    Update(ctx, static_cast<T>(0));
+  }
+
+ protected:
+  // Runs adam, on the param decayed by param -= decay * param like adamw if
+  // decay is not 0, which only the dense grad supports.
+  void Update(const framework::ExecutionContext& ctx, T decay) const {
     const auto* param_var = ctx.InputVar("Param");
     PADDLE_ENFORCE_EQ(param_var->IsType<framework::LoDTensor>(), true,
                       platform::errors::InvalidArgument(
@@ -506,13 +537,40 @@ class AdamOpKernel : public framework::OpKernel<T> {
     if (grad_var->IsType<framework::LoDTensor>()) {
       auto* grad = ctx.Input<LoDTensor>("Grad");
 
-      AdamFunctor<T, CPUAdam> functor(
-          beta1, beta2, epsilon, beta1_pow->data<T>(), beta2_pow->data<T>(),
-          mom1->data<T>(), mom1_out->mutable_data<T>(ctx.GetPlace()),
-          mom2->data<T>(), mom2_out->mutable_data<T>(ctx.GetPlace()),
-          lr->data<T>(), grad->data<T>(), param->data<T>(),
-          param_out->mutable_data<T>(ctx.GetPlace()));
-      functor(param->numel());
+      T learning_rate = lr->data<T>()[0];
+      T eps = epsilon;
+      CorrectAdamLrEps(beta1_pow->data<T>()[0], beta2_pow->data<T>()[0],
+                       &learning_rate, &eps);
+      const T* grad_data = grad->data<T>();
+      const T* mom1_data = mom1->data<T>();
+      const T* mom2_data = mom2->data<T>();
+      const T* param_data = param->data<T>();
+      T* mom1_out_data = mom1_out->mutable_data<T>(ctx.GetPlace());
+      T* mom2_out_data = mom2_out->mutable_data<T>(ctx.GetPlace());
+      T* param_out_data = param_out->mutable_data<T>(ctx.GetPlace());
+      jit::adam_attr_t attr(beta1, beta2);
+      if (decay == static_cast<T>(0)) {
+        auto adam =
+            jit::KernelFuncs<jit::AdamTuple<T>, platform::CPUPlace>::Cache().At(
+                attr);
+        ParallelForAdamChunks(param->numel(), [&](int64_t offset,
+                                                  int64_t size) {
+          adam(learning_rate, eps, size, grad_data + offset, mom1_data + offset,
+               mom2_data + offset, param_data + offset, mom1_out_data + offset,
+               mom2_out_data + offset, param_out_data + offset, &attr);
+        });
+      } else {
+        auto adamw =
+            jit::KernelFuncs<jit::AdamWTuple<T>, platform::CPUPlace>::Cache()
+                .At(attr);
+        ParallelForAdamChunks(param->numel(), [&](int64_t offset,
+                                                  int64_t size) {
+          adamw(learning_rate, eps, decay, size, grad_data + offset,
+                mom1_data + offset, mom2_data + offset, param_data + offset,
+                mom1_out_data + offset, mom2_out_data + offset,
+                param_out_data + offset, &attr);
+        });
+      }
       if (!use_global_beta_pow) {
         beta1_pow_out->mutable_data<T>(ctx.GetPlace())[0] =
             beta1 * beta1_pow->data<T>()[0];
@@ -520,6 +578,10 @@ class AdamOpKernel : public framework::OpKernel<T> {
             beta2 * beta2_pow->data<T>()[0];
       }
     } else if (grad_var->IsType<framework::SelectedRows>()) {
+      PADDLE_ENFORCE_EQ(decay, static_cast<T>(0),
+                        platform::errors::InvalidArgument(
+                            "The decayed adam update does not support the "
+                            "SelectedRows grad."));
       auto* grad = ctx.Input<framework::SelectedRows>("Grad");
       if (grad->rows().size() == 0) {
         VLOG(3) << "grad row size is 0!!";
@@ -554,6 +616,11 @@ class AdamOpKernel : public framework::OpKernel<T> {
       const int64_t* rows = grad_merge.rows().Data(ctx.GetPlace());
       auto row_numel = grad_tensor.numel() / grad_merge.rows().size();
 
+      // corrected by the beta pows before they may be updated in place
+      T learning_rate = lr->data<T>()[0];
+      T eps = epsilon;
+      CorrectAdamLrEps(beta1_pow->data<T>()[0], beta2_pow->data<T>()[0],
+                       &learning_rate, &eps);
       SparseAdamFunctor<T, CPUAdam> functor(
           beta1, beta2, epsilon, beta1_pow->data<T>(), beta2_pow->data<T>(),
           mom1->data<T>(), mom1_out->mutable_data<T>(ctx.GetPlace()),
@@ -570,14 +637,15 @@ class AdamOpKernel : public framework::OpKernel<T> {
       }
       if (lazy_mode) {
         VLOG(3) << "run cpu lazy mode";
-        size_t row_count = grad_merge.rows().size();
-        std::vector<int64_t> cpu_rows(grad_merge.rows());
-        for (size_t row_index = 0; row_index < row_count; ++row_index) {
-          for (size_t offset = 0; offset < row_numel; ++offset) {
-            size_t i = cpu_rows[row_index] * row_numel + offset;
-            functor.adam_update(i, grad_data[row_index * row_numel + offset]);
-          }
-        }
+        jit::sparse_adam_attr_t attr(beta1, beta2, row_numel,
+                                     grad_merge.rows().size());
+        auto sparse_adam =
+            jit::KernelFuncs<jit::SparseAdamTuple<T>,
+                             platform::CPUPlace>::Cache()
+                .At(attr);
+        sparse_adam(learning_rate, eps, grad_data, rows, mom1->data<T>(),
+                    mom2->data<T>(), param->data<T>(), mom1_out->data<T>(),
+                    mom2_out->data<T>(), param_out->data<T>(), &attr);
       }
 #ifndef _WIN32
       else if (FLAGS_inner_op_parallelism > 1 &&  // NOLINT
@@ -193,6 +193,13 @@ class AdamWOpKernel : public AdamOpKernel<DeviceContext, T> {
     T lr_ratio = static_cast<T>(ctx.Attr<float>("lr_ratio"));
     auto* lr = ctx.Input<LoDTensor>("LearningRate");
 
+    // decays the param in the fused kernel of the dense grad
+    if (!ctx.HasInput("MasterParam") &&
+        ctx.InputVar("Grad")->IsType<framework::LoDTensor>()) {
+      this->Update(ctx, lr->data<T>()[0] * lr_ratio * coeff);
+      return;
+    }
+
     LoDTensor* param;
 
     if (ctx.HasInput("MasterParam")) {
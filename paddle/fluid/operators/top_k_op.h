@@ -19,6 +19,7 @@ limitations under the License. */
 #include <vector>
 #include "paddle/fluid/framework/eigen.h"
 #include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/operators/math/top_k_cpu.h"
 
 namespace paddle {
 namespace operators {
@@ -52,38 +53,10 @@ class TopkKernel : public framework::OpKernel<T> {
     const size_t row = framework::product(
         framework::slice_ddim(inputdims, 0, inputdims.size() - 1));
     const size_t col = inputdims[inputdims.size() - 1];
-    Eigen::DSizes<int, 2> flat2dims(row, col);
-// NOTE: eigen shape doesn't affect paddle tensor.
-#ifdef PADDLE_WITH_MKLML
-#pragma omp parallel for
-#endif
-    for (size_t i = 0; i < row; i++) {
-      std::vector<std::pair<T, size_t>> vec;
-      vec.reserve(col);
-      // 1D vector
-      if (inputdims.size() == 1) {
-        auto eg_input = framework::EigenVector<T>::Flatten(*input);
-        for (size_t j = 0; j < col; j++) {
-          vec.push_back(std::pair<T, size_t>(eg_input(j), j));
-        }
-      } else {
-        auto eg_input =
-            framework::EigenMatrix<T>::Reshape(*input, inputdims.size() - 1);
-        for (size_t j = 0; j < col; j++) {
-          vec.push_back(std::pair<T, size_t>(eg_input(i, j), j));
-        }
-      }
-
-      std::partial_sort(
-          vec.begin(), vec.begin() + k, vec.end(),
-          [](const std::pair<T, size_t>& l, const std::pair<T, size_t>& r) {
-            return l.first > r.first;
-          });
-      for (size_t j = 0; j < k; j++) {
-        output_data[i * k + j] = vec[j].first;
-        indices_data[i * k + j] = int64_t(vec[j].second);
-      }
-    }
+    math::TopK<T, int64_t>(input->data<T>(), row, col, k,
+                           math::TopKOrder<T>(/*largest=*/true,
+                                              /*nan_as_max=*/false),
+                           output_data, indices_data);
   }
 };
 
@@ -54,6 +54,8 @@ class RecordEvent {
 
   bool is_enabled_{false};
   bool is_pushed_{false};
+  // Whether it goes to HostEventRecorder or HostEventStats
+  bool is_hooked_{false};
   // Event name
   std::string* name_{nullptr};
   const char* shallow_copy_name_{nullptr};
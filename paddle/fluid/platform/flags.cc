@@ -356,8 +356,8 @@ PADDLE_DEFINE_EXPORTED_double(
  * Allocator related FLAG
  * Name: FLAGS_allocator_strategy
  * Since Version: 1.2
- * Value Range: string, {naive_best_fit, auto_growth, thread_local},
- * default=auto_growth
+ * Value Range: string, {naive_best_fit, auto_growth, thread_local,
+ *              thread_cached}, default=auto_growth
  * Example:
  * Note: For selecting allocator policy of PaddlePaddle.
  */
@@ -378,7 +378,9 @@ PADDLE_DEFINE_EXPORTED_string(
     "size of models may be larger). auto_growth strategy would allocate "
     "GPU memory on demand, which allows users to start several Paddle jobs "
     "on the same GPU card but may lead to more memory fragmentation "
-    "(i.e., maximum batch size of models may be smaller).");
+    "(i.e., maximum batch size of models may be smaller). thread_cached "
+    "is naive_best_fit with per-thread caches for small CPU allocations, "
+    "which reduces lock contention of multi-threaded CPU inference.");
 
 /**
  * Memory related FLAG
@@ -694,6 +696,23 @@ PADDLE_DEFINE_EXPORTED_bool(
 PADDLE_DEFINE_EXPORTED_bool(run_pten_kernel, true,
                             "It controls whether to use pten kernel");
 
+/**
+ * Dygraph related FLAG
+ * Name: FLAGS_enable_dygraph_dispatch_cache
+ * Since Version: 2.3.0
+ * Value Range: bool, default=false
+ * Example: FLAGS_enable_dygraph_dispatch_cache=true would share the operator,
+ * the checked attributes and the selected kernel between the op calls with
+ * the same op type, place, input dtypes, layouts and attributes in dygraph
+ * mode.
+ * Note: They are created, checked and selected again for every op call
+ * otherwise.
+ */
+PADDLE_DEFINE_EXPORTED_bool(
+    enable_dygraph_dispatch_cache, false,
+    "It controls whether the dygraph op calls with the same signature share "
+    "their operator, checked attributes and kernel");
+
 /**
  * Pt kernel related FLAG
  * Name: FLAGS_run_kp_kernel
@@ -765,5 +784,28 @@ DEFINE_bool(enable_slotpool_wait_release, false,
             "enable slotrecord obejct wait release, default false");
 DEFINE_bool(enable_slotrecord_reset_shrink, false,
             "enable slotrecord obejct reset shrink memory, default false");
+DEFINE_bool(enable_slotrecord_batch_cache, false,
+            "SlotRecordDataset caches the batches of the first pass and feeds "
+            "later passes of the same filelist from the cache without "
+            "loading, in the recorded order. A local or global shuffle of "
+            "the dataset drops the cache for good, default false");
+DEFINE_string(slotrecord_batch_cache_path, "",
+              "directory of the SlotRecordDataset batch cache files, the "
+              "cache is kept in memory if empty");
+DEFINE_bool(enable_streaming_global_shuffle, false,
+            "MultiSlotDataset::GlobalShuffle sends the records in chunks as "
+            "soon as they are serialized instead of by send batches. It does "
+            "not shuffle all the local records first, a record only moves "
+            "within the shuffle buffer of global_shuffle_buffer_records and "
+            "the chunk it is received in, default false");
+DEFINE_int64(global_shuffle_chunk_bytes, 4 << 20,
+             "the bytes a thread of the streaming global shuffle buffers "
+             "for all trainers before it sends the largest chunk");
+DEFINE_int32(global_shuffle_max_inflight, 8,
+             "the max chunks in flight of a thread of the streaming global "
+             "shuffle");
+DEFINE_int32(global_shuffle_buffer_records, 65536,
+             "the records in the shuffle buffer of a thread of the streaming "
+             "global shuffle, a larger buffer mixes the records further");
 DEFINE_bool(enable_ins_parser_file, false,
             "enable parser ins file , default false");
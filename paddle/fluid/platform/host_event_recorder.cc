@@ -10,8 +10,21 @@ See the License for the specific language governing permissions and
 limitations under the License. */
 
 #include "paddle/fluid/platform/host_event_recorder.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include "gflags/gflags.h"
 #include "paddle/fluid/platform/os_info.h"
 
+DEFINE_int32(host_event_stats_export_interval_s, 60,
+             "The seconds between the exports of the stats of the host "
+             "events, no exporting thread if it is not positive");
+DEFINE_string(host_event_stats_export_file, "",
+              "The file the stats of the host events are exported to, "
+              "besides StatRegistry");
+
 namespace paddle {
 namespace platform {
 
@@ -29,5 +42,153 @@ HostEventSection HostEventRecorder::GatherEvents() {
   return std::move(host_sec);
 }
 
+constexpr int EventDurationHistogram::kNumBuckets;
+constexpr size_t ThreadEventStats::kMaxPtrIndexSize;
+
+void EventStats::Merge(const EventDurationHistogram &histogram) {
+  for (int i = 0; i < EventDurationHistogram::kNumBuckets; ++i) {
+    uint64_t num = histogram.Bucket(i);
+    buckets[i] += num;
+    count += num;
+  }
+  total_ns += histogram.TotalNs();
+}
+
+void EventStats::Merge(const EventStats &other) {
+  for (int i = 0; i < EventDurationHistogram::kNumBuckets; ++i) {
+    buckets[i] += other.buckets[i];
+  }
+  count += other.count;
+  total_ns += other.total_ns;
+}
+
+uint64_t EventStats::PercentileNs(double p) const {
+  if (count == 0) {
+    return 0;
+  }
+  // the rank of the event, from 1
+  uint64_t rank = static_cast<uint64_t>(std::ceil(p / 100.0 * count));
+  rank = std::min(std::max<uint64_t>(rank, 1), count);
+  uint64_t seen = 0;
+  for (int i = 0; i < EventDurationHistogram::kNumBuckets; ++i) {
+    seen += buckets[i];
+    if (seen >= rank) {
+      return EventDurationHistogram::BucketValue(i);
+    }
+  }
+  return EventDurationHistogram::BucketValue(
+      EventDurationHistogram::kNumBuckets - 1);
+}
+
+ThreadEventStats::ThreadEventStats() {
+  HostEventStats::GetInstance().RegisterThreadStats(this);
+}
+
+ThreadEventStats::~ThreadEventStats() {
+  HostEventStats::GetInstance().UnregisterThreadStats(this);
+}
+
+void ThreadEventStats::MergeTo(std::map<std::string, EventStats> *stats) const {
+  const std::lock_guard<std::mutex> guard(histograms_lock_);
+  for (auto &kv : histograms_) {
+    (*stats)[kv.first].Merge(*kv.second);
+  }
+}
+
+std::map<std::string, EventStats> HostEventStats::Snapshot() {
+  const std::lock_guard<std::mutex> guard(thread_stats_lock_);
+  std::map<std::string, EventStats> stats = exited_stats_;
+  for (auto *thread_stats : thread_stats_) {
+    thread_stats->MergeTo(&stats);
+  }
+  return stats;
+}
+
+void HostEventStats::PublishStat(const std::string &name, int64_t value) {
+  const std::lock_guard<std::mutex> guard(stat_values_lock_);
+  auto &stat = stat_values_[name];
+  if (stat == nullptr) {
+    stat.reset(new StatValue<int64_t>(name));
+  }
+  stat->reset(value);
+}
+
+void HostEventStats::Export(const std::string &filename) {
+  auto stats = Snapshot();
+  for (auto &kv : stats) {
+    const std::string prefix = "STAT_host_event_" + kv.first;
+    PublishStat(prefix + "_count", kv.second.count);
+    PublishStat(prefix + "_total_ns", kv.second.total_ns);
+    PublishStat(prefix + "_p50_ns", kv.second.PercentileNs(50));
+    PublishStat(prefix + "_p99_ns", kv.second.PercentileNs(99));
+  }
+  if (filename.empty()) {
+    return;
+  }
+  // written to a temporary file first, so the readers never see a part
+  std::string tmp_filename = filename + ".tmp";
+  {
+    std::ofstream fout(tmp_filename);
+    if (!fout) {
+      LOG(WARNING) << "Cannot open " << tmp_filename
+                   << " to export the stats of the host events.";
+      return;
+    }
+    fout << "name\tcount\ttotal_ns\tmean_ns\tp50_ns\tp99_ns\n";
+    for (auto &kv : stats) {
+      fout << kv.first << "\t" << kv.second.count << "\t"
+           << kv.second.total_ns << "\t" << kv.second.MeanNs() << "\t"
+           << kv.second.PercentileNs(50) << "\t" << kv.second.PercentileNs(99)
+           << "\n";
+    }
+  }
+  if (std::rename(tmp_filename.c_str(), filename.c_str()) != 0) {
+    LOG(WARNING) << "Cannot rename " << tmp_filename << " to " << filename;
+  }
+}
+
+void HostEventStats::StartExporter(int interval_s, const std::string &filename) {
+  const std::lock_guard<std::mutex> guard(exporter_lock_);
+  if (exporter_started_ || interval_s <= 0) {
+    return;
+  }
+  exporter_started_ = true;
+  exporter_ = std::thread([this, interval_s, filename]() {
+    std::unique_lock<std::mutex> lock(exporter_lock_);
+    while (!exporter_cv_.wait_for(lock, std::chrono::seconds(interval_s),
+                                  [this]() { return exporter_stop_; })) {
+      lock.unlock();
+      Export(filename);
+      lock.lock();
+    }
+  });
+}
+
+void HostEventStats::StopExporter() {
+  {
+    const std::lock_guard<std::mutex> guard(exporter_lock_);
+    exporter_stop_ = true;
+  }
+  exporter_cv_.notify_all();
+  if (exporter_.joinable()) {
+    exporter_.join();
+  }
+}
+
+void HostEventStats::RegisterThreadStats(ThreadEventStats *stats) {
+  {
+    const std::lock_guard<std::mutex> guard(thread_stats_lock_);
+    thread_stats_.insert(stats);
+  }
+  StartExporter(FLAGS_host_event_stats_export_interval_s,
+                FLAGS_host_event_stats_export_file);
+}
+
+void HostEventStats::UnregisterThreadStats(ThreadEventStats *stats) {
+  const std::lock_guard<std::mutex> guard(thread_stats_lock_);
+  stats->MergeTo(&exited_stats_);
+  thread_stats_.erase(stats);
+}
+
 }  // namespace platform
 }  // namespace paddle
@@ -14,13 +14,23 @@ limitations under the License. */
 
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
 #include <cstring>
+#include <map>
+#include <memory>
 #include <mutex>
 #include <string>
+#include <thread>
 #include <type_traits>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
 #include "paddle/fluid/platform/event.h"
+#include "paddle/fluid/platform/monitor.h"
 
 namespace paddle {
 namespace platform {
@@ -257,5 +267,210 @@ class HostEventRecorder {
   std::unordered_map<uint64_t, ThreadEventRecorder *> thread_recorders_;
 };
 
+// The histogram of the durations of an event in a thread. Only the thread
+// updates it, without atomic read-modify-writes, and the other threads may
+// read it at any time.
+class EventDurationHistogram {
+ public:
+  // The durations in [2^e, 2^(e+1)) ns are split into 2^kSubBucketBits
+  // buckets, so a bucket is at most 1/4 of its values wide. The durations
+  // longer than 2^kMaxExponent ns fall in the last bucket.
+  static constexpr int kSubBucketBits = 2;
+  static constexpr int kSubBuckets = 1 << kSubBucketBits;
+  static constexpr int kMaxExponent = 40;
+  static constexpr int kNumBuckets = (kMaxExponent - kSubBucketBits + 2)
+                                     << kSubBucketBits;
+
+  EventDurationHistogram() {
+    for (auto &bucket : buckets_) {
+      bucket.store(0, std::memory_order_relaxed);
+    }
+  }
+  DISABLE_COPY_AND_ASSIGN(EventDurationHistogram);
+
+  static int BucketIndex(uint64_t duration_ns) {
+    if (duration_ns < kSubBuckets) {
+      return static_cast<int>(duration_ns);
+    }
+#ifdef _MSC_VER
+    unsigned long exponent;  // NOLINT
+    _BitScanReverse64(&exponent, duration_ns);
+#else
+    int exponent = 63 - __builtin_clzll(duration_ns);
+#endif
+    if (exponent > kMaxExponent) {
+      return kNumBuckets - 1;
+    }
+    int sub = (duration_ns >> (exponent - kSubBucketBits)) & (kSubBuckets - 1);
+    return ((exponent - kSubBucketBits + 1) << kSubBucketBits) + sub;
+  }
+
+  // The middle of the durations of the bucket
+  static uint64_t BucketValue(int index) {
+    if (index < kSubBuckets) {
+      return index;
+    }
+    int exponent = (index >> kSubBucketBits) + kSubBucketBits - 1;
+    uint64_t width = 1ULL << (exponent - kSubBucketBits);
+    uint64_t lower = (kSubBuckets + (index & (kSubBuckets - 1))) * width;
+    return lower + width / 2;
+  }
+
+  // Called by the owner thread only
+  void Add(uint64_t duration_ns) {
+    auto &bucket = buckets_[BucketIndex(duration_ns)];
+    bucket.store(bucket.load(std::memory_order_relaxed) + 1,
+                 std::memory_order_relaxed);
+    total_ns_.store(total_ns_.load(std::memory_order_relaxed) + duration_ns,
+                    std::memory_order_relaxed);
+  }
+
+  uint64_t Bucket(int index) const {
+    return buckets_[index].load(std::memory_order_relaxed);
+  }
+  uint64_t TotalNs() const { return total_ns_.load(std::memory_order_relaxed); }
+
+ private:
+  std::atomic<uint64_t> buckets_[kNumBuckets];
+  std::atomic<uint64_t> total_ns_{0};
+};
+
+// The merged stats of an event, of the histograms of one or more threads.
+struct EventStats {
+  EventStats() : buckets(EventDurationHistogram::kNumBuckets, 0) {}
+
+  void Merge(const EventDurationHistogram &histogram);
+  void Merge(const EventStats &other);
+
+  // The duration in ns that p percent of the events are not longer than,
+  // within the width of its bucket.
+  uint64_t PercentileNs(double p) const;
+  double MeanNs() const { return count > 0 ? 1.0 * total_ns / count : 0.0; }
+
+  uint64_t count = 0;
+  uint64_t total_ns = 0;
+  std::vector<uint64_t> buckets;
+};
+
+// The histograms of the events of a thread by the event names.
+class ThreadEventStats {
+ public:
+  ThreadEventStats();
+  ~ThreadEventStats();
+  DISABLE_COPY_AND_ASSIGN(ThreadEventStats);
+
+ public:
+  // Looks the histogram up by the address of the name first. The name is
+  // compared on a hit, since the address may be reused for another name
+  // once the string it points to is freed, e.g. the c_str() of a string.
+  void Record(const char *name, uint64_t duration_ns) {
+    auto it = ptr_index_.find(name);
+    if (UNLIKELY(it == ptr_index_.end() ||
+                 std::strcmp(it->second->first.c_str(), name) != 0)) {
+      // the addresses of short-lived names would grow it without bound
+      if (ptr_index_.size() >= kMaxPtrIndexSize) {
+        ptr_index_.clear();
+      }
+      it = ptr_index_.emplace(name, nullptr).first;
+      it->second = &GetHistogram(name);
+    }
+    it->second->second->Add(duration_ns);
+  }
+
+  void Record(const std::string &name, uint64_t duration_ns) {
+    GetHistogram(name).second->Add(duration_ns);
+  }
+
+  // Merges the histograms into the stats by the names, thread-safe
+  void MergeTo(std::map<std::string, EventStats> *stats) const;
+
+ private:
+  using HistogramMap =
+      std::unordered_map<std::string, std::unique_ptr<EventDurationHistogram>>;
+
+  static constexpr size_t kMaxPtrIndexSize = 4096;
+
+  // The entries of histograms_ never move, so the index keeps their addresses
+  const HistogramMap::value_type &GetHistogram(const std::string &name) {
+    // only this thread inserts, so it finds without the lock
+    auto it = histograms_.find(name);
+    if (LIKELY(it != histograms_.end())) {
+      return *it;
+    }
+    const std::lock_guard<std::mutex> guard(histograms_lock_);
+    it = histograms_.emplace(name, new EventDurationHistogram).first;
+    return *it;
+  }
+
+  std::unordered_map<const char *, const HistogramMap::value_type *>
+      ptr_index_;
+  // guards the insertions into and the reads of other threads of histograms_
+  mutable std::mutex histograms_lock_;
+  HistogramMap histograms_;
+};
+
+// The always-on aggregating mode of the host events, which keeps a histogram
+// of the durations per event name and thread instead of the events, and
+// exports the merged stats periodically by a background thread.
+class HostEventStats {
+ public:
+  // singleton
+  static HostEventStats &GetInstance() {
+    static HostEventStats instance;
+    return instance;
+  }
+
+  ~HostEventStats() { StopExporter(); }
+
+  template <typename NameType>
+  void Record(const NameType &name, uint64_t duration_ns) {
+    GetThreadLocalStats().Record(name, duration_ns);
+  }
+
+  // The stats of all the threads, including the exited ones, by the names
+  std::map<std::string, EventStats> Snapshot();
+
+  // Writes a snapshot to the file if it is not empty, and publishes it
+  // through StatRegistry<int64_t> as STAT_host_event_<name>_<count, total_ns,
+  // p50_ns, p99_ns>.
+  void Export(const std::string &filename);
+
+  // Starts the thread exporting every interval_s seconds, once. It is started
+  // by the first thread recording an event, by the flags
+  // host_event_stats_export_interval_s and host_event_stats_export_file.
+  void StartExporter(int interval_s, const std::string &filename);
+  void StopExporter();
+
+  void RegisterThreadStats(ThreadEventStats *stats);
+  // Keeps the stats of an exiting thread
+  void UnregisterThreadStats(ThreadEventStats *stats);
+
+ private:
+  // The registry is created before, to be destroyed after, the exporter.
+  HostEventStats() { StatRegistry<int64_t>::Instance(); }
+  DISABLE_COPY_AND_ASSIGN(HostEventStats);
+
+  ThreadEventStats &GetThreadLocalStats() {
+    static thread_local ThreadEventStats tls_stats;
+    return tls_stats;
+  }
+
+  void PublishStat(const std::string &name, int64_t value);
+
+  std::mutex thread_stats_lock_;
+  std::unordered_set<ThreadEventStats *> thread_stats_;
+  std::map<std::string, EventStats> exited_stats_;
+
+  std::mutex stat_values_lock_;
+  std::unordered_map<std::string, std::unique_ptr<StatValue<int64_t>>>
+      stat_values_;
+
+  std::mutex exporter_lock_;
+  std::condition_variable exporter_cv_;
+  bool exporter_started_ = false;
+  bool exporter_stop_ = false;
+  std::thread exporter_;
+};
+
 }  // namespace platform
 }  // namespace paddle
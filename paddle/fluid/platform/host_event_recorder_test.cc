@@ -0,0 +1,123 @@
+/* Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/platform/host_event_recorder.h"
+
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+using paddle::platform::EventDurationHistogram;
+using paddle::platform::EventStats;
+using paddle::platform::HostEventStats;
+using paddle::platform::StatRegistry;
+
+TEST(EventDurationHistogram, bucket) {
+  int last = -1;
+  for (uint64_t ns : {0ULL, 1ULL, 3ULL, 4ULL, 7ULL, 8ULL, 100ULL, 1000ULL,
+                      123456789ULL, 1ULL << 40}) {
+    int index = EventDurationHistogram::BucketIndex(ns);
+    EXPECT_GT(index, last);
+    EXPECT_LT(index, EventDurationHistogram::kNumBuckets);
+    last = index;
+    // the value of the bucket is within 1/8 of the durations in it
+    double value = EventDurationHistogram::BucketValue(index);
+    EXPECT_LE(std::abs(value - ns), ns / 8.0 + 0.5) << ns;
+  }
+  EXPECT_EQ(EventDurationHistogram::BucketIndex(~0ULL),
+            EventDurationHistogram::kNumBuckets - 1);
+}
+
+TEST(EventStats, percentile) {
+  EventDurationHistogram histogram;
+  for (uint64_t ns = 1; ns <= 1000; ++ns) {
+    histogram.Add(ns * 1000);
+  }
+  EventStats stats;
+  stats.Merge(histogram);
+  EXPECT_EQ(stats.count, 1000UL);
+  EXPECT_EQ(stats.total_ns, 500500000UL);
+  EXPECT_NEAR(stats.MeanNs(), 500500, 1e-6);
+  EXPECT_NEAR(stats.PercentileNs(50), 500000, 500000 / 8);
+  EXPECT_NEAR(stats.PercentileNs(99), 990000, 990000 / 8);
+  EXPECT_EQ(EventStats().PercentileNs(50), 0UL);
+}
+
+TEST(HostEventStats, threads) {
+  auto &host_stats = HostEventStats::GetInstance();
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([&host_stats]() {
+      for (int j = 0; j < 100; ++j) {
+        host_stats.Record("host_event_stats_test", 1000);
+        host_stats.Record(std::string("host_event_stats_test_str"), 2000);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  // the stats of the exited threads are kept
+  auto stats = host_stats.Snapshot();
+  EXPECT_EQ(stats["host_event_stats_test"].count, 400UL);
+  EXPECT_EQ(stats["host_event_stats_test"].total_ns, 400000UL);
+  EXPECT_EQ(stats["host_event_stats_test_str"].count, 400UL);
+
+  host_stats.Record("host_event_stats_test", 1000);
+  std::string filename = "host_event_stats_test.txt";
+  host_stats.Export(filename);
+  auto *count = StatRegistry<int64_t>::Instance().get(
+      "STAT_host_event_host_event_stats_test_count");
+  ASSERT_NE(count, nullptr);
+  EXPECT_EQ(count->get(), 401);
+
+  std::ifstream fin(filename);
+  std::string line;
+  bool found = false;
+  while (std::getline(fin, line)) {
+    found = found || line.find("host_event_stats_test\t401\t") == 0;
+  }
+  EXPECT_TRUE(found);
+}
+
+TEST(HostEventStats, reused_name_address) {
+  auto &host_stats = HostEventStats::GetInstance();
+  // the same buffer holds another name, like the c_str() of a freed string
+  // whose memory is reused
+  char name[32];
+  std::strcpy(name, "host_event_stats_reused_a");  // NOLINT
+  host_stats.Record(static_cast<const char *>(name), 1000);
+  std::strcpy(name, "host_event_stats_reused_b");  // NOLINT
+  host_stats.Record(static_cast<const char *>(name), 1000);
+  host_stats.Record(static_cast<const char *>(name), 1000);
+
+  // many short-lived names keep being told apart
+  for (int i = 0; i < 10000; ++i) {
+    std::string temp_name = "host_event_stats_temp_" + std::to_string(i % 10);
+    host_stats.Record(temp_name.c_str(), 1000);
+  }
+
+  auto stats = host_stats.Snapshot();
+  EXPECT_EQ(stats["host_event_stats_reused_a"].count, 1UL);
+  EXPECT_EQ(stats["host_event_stats_reused_b"].count, 2UL);
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_EQ(stats["host_event_stats_temp_" + std::to_string(i)].count,
+              1000UL);
+  }
+}
@@ -34,11 +34,21 @@ PADDLE_DEFINE_EXPORTED_bool(enable_rpc_profiler, false,
 DEFINE_bool(enable_host_event_recorder_hook, false,
             "enable HostEventRecorder, hook Profiler");
 
+DEFINE_bool(enable_host_event_stats, false,
+            "enable the histograms of the durations of the host events by "
+            "names, low-overhead to be always on, hook Profiler");
+
 namespace paddle {
 namespace platform {
 
 MemEvenRecorder MemEvenRecorder::recorder;
 
+// Whether RecordEvent goes to HostEventRecorder or HostEventStats instead of
+// the Profiler.
+static inline bool HostEventHooked() {
+  return FLAGS_enable_host_event_recorder_hook || FLAGS_enable_host_event_stats;
+}
+
 Event::Event(EventType type, std::string name, uint32_t thread_id,
              EventRole role, std::string attr)
     : type_(type),
@@ -73,10 +83,11 @@ RecordEvent::RecordEvent(const char *name, const EventRole role) {
   }
 #endif
 #endif
-  if (UNLIKELY(FLAGS_enable_host_event_recorder_hook == false)) {
+  if (UNLIKELY(HostEventHooked() == false)) {
     OriginalConstruct(name, role, "none");
     return;
   }
+  is_hooked_ = true;
   shallow_copy_name_ = name;
   role_ = role;
   start_ns_ = PosixInNsec();
@@ -91,10 +102,11 @@ RecordEvent::RecordEvent(const std::string &name, const EventRole role) {
   }
 #endif
 #endif
-  if (UNLIKELY(FLAGS_enable_host_event_recorder_hook == false)) {
+  if (UNLIKELY(HostEventHooked() == false)) {
     OriginalConstruct(name, role, "none");
     return;
   }
+  is_hooked_ = true;
   name_ = new std::string(name);
   role_ = role;
   start_ns_ = PosixInNsec();
@@ -110,10 +122,11 @@ RecordEvent::RecordEvent(const std::string &name, const EventRole role,
   }
 #endif
 #endif
-  if (UNLIKELY(FLAGS_enable_host_event_recorder_hook == false)) {
+  if (UNLIKELY(HostEventHooked() == false)) {
     OriginalConstruct(name, role, attr);
     return;
   }
+  is_hooked_ = true;
   name_ = new std::string(name);
   start_ns_ = PosixInNsec();
   attr_ = new std::string(attr);
@@ -150,21 +163,31 @@ void RecordEvent::End() {
 #endif
 #endif
   uint64_t end_ns = PosixInNsec();
-  if (LIKELY(FLAGS_enable_host_event_recorder_hook)) {
-    if (LIKELY(shallow_copy_name_ != nullptr)) {
-      HostEventRecorder::GetInstance().RecordEvent(shallow_copy_name_,
-                                                   start_ns_, end_ns, role_);
-    } else if (name_ != nullptr) {
-      if (attr_ == nullptr) {
-        HostEventRecorder::GetInstance().RecordEvent(*name_, start_ns_, end_ns,
-                                                     role_);
-      } else {
-        HostEventRecorder::GetInstance().RecordEvent(*name_, start_ns_, end_ns,
-                                                     role_, *attr_);
-        delete attr_;
+  if (LIKELY(is_hooked_)) {
+    if (FLAGS_enable_host_event_stats) {
+      if (LIKELY(shallow_copy_name_ != nullptr)) {
+        HostEventStats::GetInstance().Record(shallow_copy_name_,
+                                             end_ns - start_ns_);
+      } else if (name_ != nullptr) {
+        HostEventStats::GetInstance().Record(*name_, end_ns - start_ns_);
       }
-      delete name_;
     }
+    if (FLAGS_enable_host_event_recorder_hook) {
+      if (LIKELY(shallow_copy_name_ != nullptr)) {
+        HostEventRecorder::GetInstance().RecordEvent(shallow_copy_name_,
+                                                     start_ns_, end_ns, role_);
+      } else if (name_ != nullptr) {
+        if (attr_ == nullptr) {
+          HostEventRecorder::GetInstance().RecordEvent(*name_, start_ns_,
+                                                       end_ns, role_);
+        } else {
+          HostEventRecorder::GetInstance().RecordEvent(*name_, start_ns_,
+                                                       end_ns, role_, *attr_);
+        }
+      }
+    }
+    delete name_;
+    delete attr_;
     return;
   }
 
@@ -468,6 +491,8 @@ void NvprofDisableRecordEvent() { g_enable_nvprof_hook = false; }
 
 void EnableHostEventRecorder() { FLAGS_enable_host_event_recorder_hook = true; }
 
+void EnableHostEventStats() { FLAGS_enable_host_event_stats = true; }
+
 std::string PrintHostEvents() {
   std::ostringstream oss;
   auto host_evt_sec = HostEventRecorder::GetInstance().GatherEvents();
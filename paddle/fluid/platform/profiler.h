@@ -217,6 +217,10 @@ void NvprofDisableRecordEvent();
 
 void EnableHostEventRecorder();
 
+// Keep the histograms of the durations of the host events by the names, see
+// HostEventStats.
+void EnableHostEventStats();
+
 // Defined for UT
 std::string PrintHostEvents();
 
@@ -16,7 +16,11 @@ limitations under the License. */
 
 #include <string>
 
+#include "gflags/gflags.h"
 #include "gtest/gtest.h"
+#include "paddle/fluid/platform/host_event_recorder.h"
+
+DECLARE_bool(enable_host_event_stats);
 
 TEST(Event, CpuElapsedTime) {
   using paddle::platform::Event;
@@ -137,6 +141,23 @@ TEST(RecordEvent, RecordEvent) {
   DisableProfiler(EventSortingKey::kTotal, "/tmp/profiler");
 }
 
+TEST(RecordEvent, HostEventStats) {
+  using paddle::platform::HostEventStats;
+  using paddle::platform::RecordEvent;
+
+  paddle::platform::EnableHostEventStats();
+  for (int i = 0; i < 10; ++i) {
+    RecordEvent record_event("host_event_stats_op");
+    std::string name = "host_event_stats_op_" + std::to_string(i % 2);
+    RecordEvent nested_record_event(name);
+  }
+  auto stats = HostEventStats::GetInstance().Snapshot();
+  EXPECT_EQ(stats["host_event_stats_op"].count, 10UL);
+  EXPECT_EQ(stats["host_event_stats_op_0"].count, 5UL);
+  EXPECT_EQ(stats["host_event_stats_op_1"].count, 5UL);
+  FLAGS_enable_host_event_stats = false;
+}
+
 #ifdef PADDLE_WITH_CUDA
 TEST(TMP, stream_wait) {
   cudaStream_t stream;
@@ -33,6 +33,7 @@ def conv_indent(indent):
 
 
 PSERVER_SAVE_SUFFIX = ".shard"
+MEMORY_SPARSE_TABLES = ("MemorySparseTable", "MemorySlabSparseTable")
 
 
 def parse_table_class(varname, o_main_program):
@@ -953,7 +954,7 @@ class TheOnePSRuntime(RuntimeBase):
                         else:
                             table.table_class = parse_table_class(
                                 common.table_name, self.origin_main_program)
-                        if table.table_class != 'MemorySparseTable':
+                        if table.table_class not in MEMORY_SPARSE_TABLES:
                             table.table_class = 'MemorySparseTable'
                             warnings.warn(
                                 "The PS mode must use MemorySparseTable.")
@@ -1002,7 +1003,7 @@ class TheOnePSRuntime(RuntimeBase):
                     common.sync = "false"
                 table.common = common
 
-                if table.table_class != 'MemorySparseTable':
+                if table.table_class not in MEMORY_SPARSE_TABLES:
                     accessor = _build_merge_accessor(ctx)
                     table.accessor = accessor
                 tables.append(table)
@@ -870,6 +870,8 @@ class DistributedAdam(DistributedOptimizerImplBase):
         gpus_env = os.getenv("FLAGS_selected_gpus", "0")
         opt_info["worker_places"] = [int(s) for s in gpus_env.split(",")]
         opt_info["use_ps_gpu"] = strategy.get("use_ps_gpu", False)
+        opt_info["pull_dense_double_buffer"] = strategy.get(
+            "pull_dense_double_buffer", False)
         if server._server.downpour_server_param.downpour_table_param[
                 0].accessor.accessor_class in [
                     "DownpourCtrAccessor", "DownpourCtrDoubleAccessor",
@@ -15,6 +15,7 @@
 import unittest
 import paddle
 import numpy as np
+from scipy.special import erf
 from op_test import OpTest
 import paddle.fluid as fluid
 from paddle.fluid import Program, program_guard, core
@@ -22,7 +23,7 @@ from paddle.fluid import Program, program_guard, core
 SEED = 2020
 
 
-def fc_refer(matrix, with_bias, with_relu=False):
+def fc_refer(matrix, with_bias, with_relu=False, with_gelu=False):
     in_n, in_c, in_h, in_w = matrix.input.shape
     w_i, w_o = matrix.weights.shape
 
@@ -38,6 +39,8 @@ def fc_refer(matrix, with_bias, with_relu=False):
 
     if with_relu:
         return np.maximum(result, 0)
+    elif with_gelu:
+        return 0.5 * result * (1 + erf(result / np.sqrt(2)))
     else:
         return result
 
@@ -134,6 +137,26 @@ class TestFCOpWithPadding(TestFCOp):
         self.matrix = MatrixGenerate(1, 4, 3, 128, 128, 2)
 
 
+class TestFCOpWithGelu(OpTest):
+    def setUp(self):
+        self.op_type = "fc"
+        # a width above the blocks of the jit kernel and a tail
+        self.matrix = MatrixGenerate(3, 7, 37, 2, 2, 1)
+        self.matrix.input = self.matrix.input * 2 - 1
+        self.matrix.weights = self.matrix.weights * 2 - 1
+        self.inputs = {
+            'Input': self.matrix.input,
+            'W': self.matrix.weights,
+            'Bias': self.matrix.bias
+        }
+        self.attrs = {'use_mkldnn': False, 'activation_type': "gelu"}
+        self.outputs = {'Out': fc_refer(self.matrix, True, with_gelu=True)}
+
+    def test_check_output(self):
+        # the gelu activation of fc is only supported on CPU
+        self.check_output_with_place(core.CPUPlace(), atol=1e-5)
+
+
 class TestFcOp_NumFlattenDims_NegOne(unittest.TestCase):
     def test_api(self):
         def run_program(num_flatten_dims):
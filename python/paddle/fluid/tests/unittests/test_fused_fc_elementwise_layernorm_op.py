@@ -24,8 +24,6 @@ from test_layer_norm_op import _reference_layer_norm_naive
 np.random.random(123)
 
 
-@unittest.skipIf(not core.is_compiled_with_cuda(),
-                 "Paddle core is not compiled with CUDA")
 class TestFusedFCElementwiseLayerNormOp(OpTest):
     def config(self):
         self.matrix = MatrixGenerate(1, 10, 15, 3, 3, 2)
@@ -66,10 +64,15 @@ class TestFusedFCElementwiseLayerNormOp(OpTest):
         }
         self.outputs = {"Out": out, "Mean": mean, "Variance": variance}
 
+    @unittest.skipIf(not core.is_compiled_with_cuda(),
+                     "Paddle core is not compiled with CUDA")
     def test_check_output(self):
         place = core.CUDAPlace(0)
         self.check_output_with_place(place, atol=2e-3)
 
+    def test_check_output_cpu(self):
+        self.check_output_with_place(core.CPUPlace(), atol=2e-3)
+
 
 class TestFusedFCElementwiseLayerNormOp2(TestFusedFCElementwiseLayerNormOp):
     def config(self):
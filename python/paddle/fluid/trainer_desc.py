@@ -186,6 +186,9 @@ class TrainerDesc(object):
     def _set_thread_barrier(self, thread_barrier):
         self.proto_desc.thread_barrier = thread_barrier
 
+    def _set_pull_dense_double_buffer(self, double_buffer=False):
+        self.proto_desc.pull_dense_param.double_buffer = double_buffer
+
     def _set_check_nan_var_names(self, check_nan_var_names):
         for var in check_nan_var_names:
             self.proto_desc.check_nan_var_names.append(var)
@@ -91,6 +91,9 @@ class TrainerFactory(object):
                 if opt_info.get("random_with_lineid") is not None:
                     trainer._set_random_with_lineid(opt_info[
                         "random_with_lineid"])
+                if opt_info.get("pull_dense_double_buffer") is not None:
+                    trainer._set_pull_dense_double_buffer(opt_info[
+                        "pull_dense_double_buffer"])
 
             if "fleet_desc" in opt_info:
                 device_worker._set_fleet_desc(opt_info["fleet_desc"])